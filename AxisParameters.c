@@ -0,0 +1,697 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file AxisParameters.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: AxisParameters.c
+ *         Description: Table driven access to the axis parameters (SAP/GAP)
+ *
+ *                      Most axis parameters are just a bit field of a
+ *                      TMC5130 register plus a unit conversion. These are
+ *                      described by the constant table below and handled
+ *                      by a generic read/write function. Parameters that
+ *                      need more than that use hook functions.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include "max32660.h"
+#include "gpio.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "Globals.h"
+#include "TMC5130.h"
+#include "TMCL.h"
+#include "AxisParameters.h"
+#include "MotionQueue.h"
+#include "PVT.h"
+#include "FixedPoint.h"
+
+#define RW (PB_READ|PB_WRITE)
+#define RO PB_READ
+#define RWS (PB_READ|PB_WRITE|PB_STORE)
+#define ANY INT32_MIN, INT32_MAX
+#define POSITIVE 0, INT32_MAX
+
+#define VMAX_LIMIT 0x7fffff   //!< highest value of VMAX (23 bits)
+#define AMAX_LIMIT 0xffff     //!< highest value of AMAX (16 bits)
+#define TSTEP_OFF  0xfffff    //!< THIGH/TCOOLTHRS/TPWMTHRS value for "off" (user value 0)
+
+extern gpio_cfg_t enable_out;            //<! Output for TMC5130 ENABLE pin
+
+static const TFixedFactor TPowerDownFactor=FIXED_FACTOR(TPOWERDOWN_FACTOR, 53);   //!< for the TPOWERDOWN conversion
+
+//! Unit conversion functions
+typedef struct
+{
+  int (*ToInternal)(int Value);   //!< user unit => register value
+  int (*ToUser)(int Value);       //!< register value => user unit
+} TConversion;
+
+static uint8_t SetTargetVelocity(uint8_t Motor, int Value);
+static int GetTargetVelocity(uint8_t Motor);
+static uint8_t SetMaxVelocity(uint8_t Motor, int Value);
+static int GetMaxVelocity(uint8_t Motor);
+static uint8_t SetMaxAcceleration(uint8_t Motor, int Value);
+static int GetMaxAcceleration(uint8_t Motor);
+static uint8_t SetTOff(uint8_t Motor, int Value);
+static int GetTOff(uint8_t Motor);
+static uint8_t SetStallVMin(uint8_t Motor, int Value);
+static int GetStallVMin(uint8_t Motor);
+static uint8_t SetPWMGrad(uint8_t Motor, int Value);
+static uint8_t SetRefSearchStallThreshold(uint8_t Motor, int Value);
+static int GetRefSearchStallThreshold(uint8_t Motor);
+static uint8_t SetRefSearchVelocity(uint8_t Motor, int Value);
+static int GetRefSearchVelocity(uint8_t Motor);
+static uint8_t SetRefSearchStallVMin(uint8_t Motor, int Value);
+static int GetRefSearchStallVMin(uint8_t Motor);
+static int GetRefSearchDistance(uint8_t Motor);
+static int GetPositionReachedFlag(uint8_t Motor);
+static int GetRightStopFlag(uint8_t Motor);
+static int GetLeftStopFlag(uint8_t Motor);
+static int GetStallFlag(uint8_t Motor);
+static int GetQueueDepth(uint8_t Motor);
+static int GetQueueLevel(uint8_t Motor);
+static uint8_t SetQueueUnderruns(uint8_t Motor, int Value);
+static int GetQueueUnderruns(uint8_t Motor);
+static uint8_t SetBlendDistance(uint8_t Motor, int Value);
+static int GetBlendDistance(uint8_t Motor);
+static uint8_t SetDriverEnable(uint8_t Motor, int Value);
+static int GetDriverEnable(uint8_t Motor);
+
+static int ConvertBoolToInternal(int Value);
+static int ConvertBoolToUser(int Value);
+static int ConvertBoolInvToInternal(int Value);
+static int ConvertBoolInvToUser(int Value);
+static int ConvertCurrentToInternal(int Value);
+static int ConvertCurrentToUser(int Value);
+static int ConvertTHighToInternal(int Value);
+static int ConvertTHighToUser(int Value);
+static int ConvertTStepToInternal(int Value);
+static int ConvertTStepToUser(int Value);
+static int ConvertMResToInternal(int Value);
+static int ConvertSigned8ToInternal(int Value);
+static int ConvertSigned8ToUser(int Value);
+static int ConvertTPowerDownToInternal(int Value);
+static int ConvertTPowerDownToUser(int Value);
+
+//! Unit conversions (indexed by CONV_xxx)
+static const TConversion Conversions[]=
+{
+  [CONV_NONE]         = {ConvertInternalToInternal, ConvertInternalToInternal},
+  [CONV_VELOCITY]     = {ConvertVelocityUserToInternal, ConvertVelocityInternalToUser},
+  [CONV_ACCELERATION] = {ConvertAccelerationUserToInternal, ConvertAccelerationInternalToUser},
+  [CONV_BOOL]         = {ConvertBoolToInternal, ConvertBoolToUser},
+  [CONV_BOOL_INV]     = {ConvertBoolInvToInternal, ConvertBoolInvToUser},
+  [CONV_CURRENT]      = {ConvertCurrentToInternal, ConvertCurrentToUser},
+  [CONV_THIGH]        = {ConvertTHighToInternal, ConvertTHighToUser},
+  [CONV_TSTEP]        = {ConvertTStepToInternal, ConvertTStepToUser},
+  [CONV_MRES]         = {ConvertMResToInternal, ConvertMResToInternal},
+  [CONV_SIGNED8]      = {ConvertSigned8ToInternal, ConvertSigned8ToUser},
+  [CONV_TPOWERDOWN]   = {ConvertTPowerDownToInternal, ConvertTPowerDownToUser},
+};
+
+//! Axis parameter table (must be sorted by parameter number)
+static const TAxisParameter AxisParameters[]=
+{
+  //No.  Access  Register             Shift Width Conversion         Range          Set hook                    Get hook
+  {  0,  RW,  TMC5130_XTARGET,          0, 32, CONV_NONE,         ANY,           NULL,                       NULL},
+  {  1,  RW,  TMC5130_XACTUAL,          0, 32, CONV_NONE,         ANY,           NULL,                       NULL},
+  {  2,  RW,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           SetTargetVelocity,          GetTargetVelocity},
+  {  3,  RO,  TMC5130_VACTUAL,          0, 32, CONV_VELOCITY,     ANY,           NULL,                       NULL},
+  {  4,  RWS, AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           SetMaxVelocity,             GetMaxVelocity},
+  {  5,  RWS, AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           SetMaxAcceleration,         GetMaxAcceleration},
+  {  6,  RWS, TMC5130_IHOLD_IRUN,       8,  8, CONV_CURRENT,      0, 255,        NULL,                       NULL},
+  {  7,  RWS, TMC5130_IHOLD_IRUN,       0,  8, CONV_CURRENT,      0, 255,        NULL,                       NULL},
+  {  8,  RO,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           NULL,                       GetPositionReachedFlag},
+  { 10,  RO,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           NULL,                       GetRightStopFlag},
+  { 11,  RO,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           NULL,                       GetLeftStopFlag},
+  { 12,  RWS, TMC5130_SWMODE,           1,  1, CONV_BOOL_INV,     ANY,           NULL,                       NULL},
+  { 13,  RWS, TMC5130_SWMODE,           0,  1, CONV_BOOL_INV,     ANY,           NULL,                       NULL},
+  { 14,  RWS, TMC5130_SWMODE,           4,  1, CONV_BOOL,         ANY,           NULL,                       NULL},
+  { 15,  RWS, TMC5130_A1,               0, 16, CONV_ACCELERATION, ANY,           NULL,                       NULL},
+  { 16,  RWS, TMC5130_V1,               0, 20, CONV_VELOCITY,     ANY,           NULL,                       NULL},
+  { 17,  RWS, TMC5130_DMAX,             0, 16, CONV_ACCELERATION, ANY,           NULL,                       NULL},
+  { 18,  RWS, TMC5130_D1,               0, 16, CONV_ACCELERATION, ANY,           NULL,                       NULL},
+  { 19,  RWS, TMC5130_VSTART,           0, 18, CONV_VELOCITY,     ANY,           NULL,                       NULL},
+  { 20,  RWS, TMC5130_VSTOP,            0, 18, CONV_VELOCITY,     ANY,           NULL,                       NULL},
+  { 21,  RWS, TMC5130_TZEROWAIT,        0, 16, CONV_NONE,         ANY,           NULL,                       NULL},
+  { 22,  RWS, TMC5130_THIGH,            0, 20, CONV_THIGH,        POSITIVE,      NULL,                       NULL},
+  { 23,  RWS, TMC5130_VDCMIN,           0, 23, CONV_VELOCITY,     ANY,           NULL,                       NULL},
+  { 24,  RWS, TMC5130_SWMODE,           3,  1, CONV_BOOL,         ANY,           NULL,                       NULL},
+  { 25,  RWS, TMC5130_SWMODE,           2,  1, CONV_BOOL,         ANY,           NULL,                       NULL},
+  { 26,  RWS, TMC5130_SWMODE,          11,  1, CONV_BOOL,         ANY,           NULL,                       NULL},
+  { 27,  RWS, TMC5130_CHOPCONF,        19,  1, CONV_BOOL,         ANY,           NULL,                       NULL},
+  { 28,  RWS, TMC5130_CHOPCONF,        18,  1, CONV_BOOL,         ANY,           NULL,                       NULL},
+  { 30,  RO,  TMC5130_IHOLD_IRUN,      16,  4, CONV_NONE,         ANY,           NULL,                       NULL},
+  { 31,  RWS, TMC5130_IHOLD_IRUN,      16,  4, CONV_NONE,         0, 15,         NULL,                       NULL},
+  { 32,  RWS, TMC5130_DCCTRL,           0, 10, CONV_NONE,         0, 1023,       NULL,                       NULL},
+  { 33,  RWS, TMC5130_DCCTRL,          16,  8, CONV_NONE,         0, 255,        NULL,                       NULL},
+  {140,  RWS, TMC5130_CHOPCONF,        24,  4, CONV_MRES,         0, 8,          NULL,                       NULL},
+  {167,  RWS, AP_NO_REGISTER,           0,  0, CONV_NONE,         0, 15,         SetTOff,                    GetTOff},
+  {168,  RWS, TMC5130_COOLCONF,        15,  1, CONV_BOOL,         0, 1,          NULL,                       NULL},
+  {169,  RWS, TMC5130_COOLCONF,        13,  2, CONV_NONE,         0, 3,          NULL,                       NULL},
+  {170,  RWS, TMC5130_COOLCONF,         8,  4, CONV_NONE,         0, 15,         NULL,                       NULL},
+  {171,  RWS, TMC5130_COOLCONF,         5,  2, CONV_NONE,         0, 3,          NULL,                       NULL},
+  {172,  RWS, TMC5130_COOLCONF,         0,  4, CONV_NONE,         0, 15,         NULL,                       NULL},
+  {173,  RWS, TMC5130_COOLCONF,        24,  1, CONV_BOOL,         0, 1,          NULL,                       NULL},
+  {174,  RWS, TMC5130_COOLCONF,        16,  8, CONV_SIGNED8,      -64, 63,       NULL,                       NULL},
+  {179,  RWS, TMC5130_CHOPCONF,        17,  1, CONV_BOOL,         0, 1,          NULL,                       NULL},
+  {180,  RO,  TMC5130_DRVSTATUS,       16,  5, CONV_NONE,         ANY,           NULL,                       NULL},
+  {181,  RWS, AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           SetStallVMin,               GetStallVMin},
+  {182,  RWS, TMC5130_TCOOLTHRS,        0, 20, CONV_TSTEP,        POSITIVE,      NULL,                       NULL},
+  {186,  RWS, TMC5130_TPWMTHRS,         0, 20, CONV_TSTEP,        POSITIVE,      NULL,                       NULL},
+  {187,  RWS, TMC5130_PWMCONF,          8,  8, CONV_NONE,         0, 255,        SetPWMGrad,                 NULL},
+  {188,  RWS, TMC5130_PWMCONF,          0,  8, CONV_NONE,         0, 255,        NULL,                       NULL},
+  {189,  RO,  TMC5130_PWMSCALE,         0, 32, CONV_NONE,         ANY,           NULL,                       NULL},
+  {191,  RWS, TMC5130_PWMCONF,         16,  2, CONV_NONE,         0, 3,          NULL,                       NULL},
+  {192,  RWS, TMC5130_PWMCONF,         18,  1, CONV_BOOL,         0, 1,          NULL,                       NULL},
+  {193,  RWS, AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           SetRefSearchStallThreshold, GetRefSearchStallThreshold},
+  {194,  RWS, AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           SetRefSearchVelocity,       GetRefSearchVelocity},
+  {195,  RWS, AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           SetRefSearchStallVMin,      GetRefSearchStallVMin},
+  {196,  RO,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           NULL,                       GetRefSearchDistance},
+  {206,  RO,  TMC5130_DRVSTATUS,        0, 10, CONV_NONE,         ANY,           NULL,                       NULL},
+  {207,  RO,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           NULL,                       GetStallFlag},
+  {208,  RO,  TMC5130_DRVSTATUS,       24,  8, CONV_NONE,         ANY,           NULL,                       NULL},
+  {214,  RWS, TMC5130_TPOWERDOWN,       0,  8, CONV_TPOWERDOWN,   POSITIVE,      NULL,                       NULL},
+  {220,  RO,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           NULL,                       GetQueueDepth},
+  {221,  RO,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           NULL,                       GetQueueLevel},
+  {222,  RW,  AP_NO_REGISTER,           0,  0, CONV_NONE,         0, 0,          SetQueueUnderruns,          GetQueueUnderruns},
+  {223,  RWS, AP_NO_REGISTER,           0,  0, CONV_NONE,         POSITIVE,      SetBlendDistance,           GetBlendDistance},
+  {251,  RWS, TMC5130_GCONF,            4,  1, CONV_BOOL,         ANY,           NULL,                       NULL},
+  {255,  RW,  AP_NO_REGISTER,           0,  0, CONV_NONE,         ANY,           SetDriverEnable,            GetDriverEnable},
+};
+
+
+/***************************************************************//**
+   \fn FindAxisParameter(uint8_t Number)
+   \brief Look up an axis parameter
+   \param Number: axis parameter number
+   \return Pointer to the descriptor or NULL if not found.
+
+   Binary search in the axis parameter table.
+********************************************************************/
+const TAxisParameter *FindAxisParameter(uint8_t Number)
+{
+  int Low, High, Middle;
+
+  Low=0;
+  High=sizeof(AxisParameters)/sizeof(AxisParameters[0])-1;
+  while(Low<=High)
+  {
+    Middle=(Low+High)/2;
+    if(AxisParameters[Middle].Number==Number)
+      return &AxisParameters[Middle];
+    else if(AxisParameters[Middle].Number<Number)
+      Low=Middle+1;
+    else
+      High=Middle-1;
+  }
+
+  return NULL;
+}
+
+
+/***************************************************************//**
+   \fn WriteAxisParameter(uint8_t Motor, uint8_t Number, int Value)
+   \brief Write an axis parameter
+   \param Motor: axis number
+   \param Number: axis parameter number
+   \param Value: new value (user unit)
+   \return TMCL status code (REPLY_OK if successful)
+
+   Generic write function used by the SAP command. Values whose
+   register value does not fit into the bit field are rejected
+   with REPLY_INVALID_VALUE.
+********************************************************************/
+uint8_t WriteAxisParameter(uint8_t Motor, uint8_t Number, int Value)
+{
+  const TAxisParameter *Parameter;
+  uint32_t Mask;
+  int RegisterValue;
+
+  if(Motor>=N_O_MOTORS) return REPLY_INVALID_VALUE;
+
+  Parameter=FindAxisParameter(Number);
+  if(Parameter==NULL || !(Parameter->Access & PB_WRITE)) return REPLY_WRONG_TYPE;
+  if(Value<Parameter->Min || Value>Parameter->Max) return REPLY_INVALID_VALUE;
+
+  if(Parameter->SetHook!=NULL) return Parameter->SetHook(Motor, Value);
+
+  Value=Conversions[Parameter->Conversion].ToInternal(Value);
+  if(Parameter->Width<32)
+  {
+    //Values that do not fit into the bit field are rejected (instead of being truncated)
+    if((uint32_t) Value >> Parameter->Width) return REPLY_INVALID_VALUE;
+
+    Mask=((1<<Parameter->Width)-1) << Parameter->Shift;
+    RegisterValue=ReadTMC5130Int(WHICH_5130(Motor), Parameter->Register) & ~Mask;
+    Value=RegisterValue | ((Value << Parameter->Shift) & Mask);
+  }
+  WriteTMC5130Int(WHICH_5130(Motor), Parameter->Register, Value);
+
+  return REPLY_OK;
+}
+
+
+/***************************************************************//**
+   \fn ExtractAxisParameter(const TAxisParameter *Parameter, int RegisterValue)
+   \brief Get an axis parameter from a register value
+   \param Parameter: axis parameter descriptor
+   \param RegisterValue: value of the TMC5130 register
+   \return Value of the parameter (user unit)
+********************************************************************/
+static int ExtractAxisParameter(const TAxisParameter *Parameter, int RegisterValue)
+{
+  if(Parameter->Width<32)
+    RegisterValue=(RegisterValue >> Parameter->Shift) & ((1<<Parameter->Width)-1);
+
+  return Conversions[Parameter->Conversion].ToUser(RegisterValue);
+}
+
+
+/***************************************************************//**
+   \fn ReadAxisParameter(uint8_t Motor, uint8_t Number, int *Value)
+   \brief Read an axis parameter
+   \param Motor: axis number
+   \param Number: axis parameter number
+   \param Value: pointer to variable for the value (user unit)
+   \return TMCL status code (REPLY_OK if successful)
+
+   Generic read function used by the GAP command.
+********************************************************************/
+uint8_t ReadAxisParameter(uint8_t Motor, uint8_t Number, int *Value)
+{
+  const TAxisParameter *Parameter;
+  int RegisterValue;
+
+  if(Motor>=N_O_MOTORS) return REPLY_INVALID_VALUE;
+
+  Parameter=FindAxisParameter(Number);
+  if(Parameter==NULL || !(Parameter->Access & PB_READ)) return REPLY_WRONG_TYPE;
+
+  if(Parameter->GetHook!=NULL)
+  {
+    *Value=Parameter->GetHook(Motor);
+    return REPLY_OK;
+  }
+
+  RegisterValue=ReadTMC5130Int(WHICH_5130(Motor), Parameter->Register);
+  *Value=ExtractAxisParameter(Parameter, RegisterValue);
+
+  return REPLY_OK;
+}
+
+
+/***************************************************************//**
+   \fn ReadAxisParameterList(uint8_t Motor, const uint8_t *Numbers, int *Values, uint8_t *Status, uint32_t Count)
+   \brief Read several axis parameters
+   \param Motor: axis number
+   \param Numbers: axis parameter numbers
+   \param Values: array for the values (user unit)
+   \param Status: array for the TMCL status codes of the single parameters
+   \param Count: number of parameters (max. AP_MAX_LIST)
+
+   Like ReadAxisParameter(), but all needed TMC5130 registers are
+   read only once and with pipelined SPI accesses.
+********************************************************************/
+void ReadAxisParameterList(uint8_t Motor, const uint8_t *Numbers, int *Values, uint8_t *Status, uint32_t Count)
+{
+  const TAxisParameter *Parameters[AP_MAX_LIST];
+  uint8_t Registers[AP_MAX_LIST];
+  int RegisterValues[AP_MAX_LIST];
+  uint32_t RegisterCount;
+  uint32_t i, j;
+
+  if(Count>AP_MAX_LIST) Count=AP_MAX_LIST;
+
+  //Collect the registers needed (each only once)
+  RegisterCount=0;
+  for(i=0; i<Count; i++)
+  {
+    Parameters[i]=FindAxisParameter(Numbers[i]);
+    if(Motor>=N_O_MOTORS)
+      Status[i]=REPLY_INVALID_VALUE;
+    else if(Parameters[i]==NULL || !(Parameters[i]->Access & PB_READ))
+      Status[i]=REPLY_WRONG_TYPE;
+    else
+    {
+      Status[i]=REPLY_OK;
+      if(Parameters[i]->GetHook==NULL)
+      {
+        for(j=0; j<RegisterCount && Registers[j]!=Parameters[i]->Register; j++);
+        if(j==RegisterCount) Registers[RegisterCount++]=Parameters[i]->Register;
+      }
+    }
+  }
+
+  if(RegisterCount>0) ReadTMC5130Multiple(WHICH_5130(Motor), Registers, RegisterValues, RegisterCount);
+
+  for(i=0; i<Count; i++)
+  {
+    if(Status[i]!=REPLY_OK) continue;
+
+    if(Parameters[i]->GetHook!=NULL)
+      Values[i]=Parameters[i]->GetHook(Motor);
+    else
+    {
+      for(j=0; Registers[j]!=Parameters[i]->Register; j++);
+      Values[i]=ExtractAxisParameter(Parameters[i], RegisterValues[j]);
+    }
+  }
+}
+
+
+//Hook functions for parameters that are not just a register bit field
+
+static uint8_t SetTargetVelocity(uint8_t Motor, int Value)
+{
+  uint32_t Velocity;
+
+  Velocity=ConvertVelocityUserToInternal(abs(Value));
+  if(Velocity>VMAX_LIMIT) return REPLY_INVALID_VALUE;
+
+  ClearMotionQueue(Motor);
+  StopPVT(Motor);
+  if(Value>0)
+    WriteTMC5130Int(WHICH_5130(Motor), TMC5130_RAMPMODE, TMC5130_MODE_VELPOS);
+  else
+    WriteTMC5130Int(WHICH_5130(Motor), TMC5130_RAMPMODE, TMC5130_MODE_VELNEG);
+
+  VMaxModified[Motor]=TRUE;
+  WriteTMC5130Int(WHICH_5130(Motor), TMC5130_VMAX, Velocity);
+
+  return REPLY_OK;
+}
+
+static int GetTargetVelocity(uint8_t Motor)
+{
+  if(ReadTMC5130Int(WHICH_5130(Motor), TMC5130_RAMPMODE)==TMC5130_MODE_VELPOS)
+    return ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(Motor), TMC5130_VMAX));
+  else
+    return -ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(Motor), TMC5130_VMAX));
+}
+
+static uint8_t SetMaxVelocity(uint8_t Motor, int Value)
+{
+  uint32_t Velocity;
+
+  Velocity=ConvertVelocityUserToInternal(abs(Value));
+  if(Velocity>VMAX_LIMIT) return REPLY_INVALID_VALUE;
+
+  VMax[Motor]=Velocity;
+  if(ReadTMC5130Int(WHICH_5130(Motor), TMC5130_RAMPMODE)==TMC5130_MODE_POSITION)
+    WriteTMC5130Int(WHICH_5130(Motor), TMC5130_VMAX, VMax[Motor]);
+
+  return REPLY_OK;
+}
+
+static int GetMaxVelocity(uint8_t Motor)
+{
+  return ConvertVelocityInternalToUser(VMax[Motor]);
+}
+
+static uint8_t SetMaxAcceleration(uint8_t Motor, int Value)
+{
+  uint32_t Acceleration;
+
+  Acceleration=ConvertAccelerationUserToInternal(Value);
+  if(Acceleration>AMAX_LIMIT) return REPLY_INVALID_VALUE;
+
+  AMaxModified[Motor]=FALSE;
+  AMax[Motor]=Acceleration;
+  WriteTMC5130Int(WHICH_5130(Motor), TMC5130_AMAX, AMax[Motor]);
+
+  return REPLY_OK;
+}
+
+static int GetMaxAcceleration(uint8_t Motor)
+{
+  return ConvertAccelerationInternalToUser(AMax[Motor]);
+}
+
+static uint8_t SetTOff(uint8_t Motor, int Value)
+{
+  SetTMC5130ChopperTOff(Motor, Value);
+
+  return REPLY_OK;
+}
+
+static int GetTOff(uint8_t Motor)
+{
+  return GetTMC5130ChopperTOff(Motor);
+}
+
+static uint8_t SetStallVMin(uint8_t Motor, int Value)
+{
+  StallVMin[Motor]=ConvertVelocityUserToInternal(Value);
+
+  return REPLY_OK;
+}
+
+static int GetStallVMin(uint8_t Motor)
+{
+  return ConvertVelocityInternalToUser(StallVMin[Motor]);
+}
+
+static uint8_t SetPWMGrad(uint8_t Motor, int Value)
+{
+  uint32_t GConf;
+
+  SetTMC5130PWMGrad(Motor, Value);
+  GConf=ReadTMC5130Int(WHICH_5130(Motor), TMC5130_GCONF);
+  if(Value!=0)  //PWMGrad=0 => completely switch off StealthChop
+    WriteTMC5130Int(WHICH_5130(Motor), TMC5130_GCONF, GConf|TMC5130_GCONF_EN_PWM_MODE);
+  else
+    WriteTMC5130Int(WHICH_5130(Motor), TMC5130_GCONF, GConf & ~TMC5130_GCONF_EN_PWM_MODE);
+
+  return REPLY_OK;
+}
+
+static uint8_t SetRefSearchStallThreshold(uint8_t Motor, int Value)
+{
+  RefSearchStallThreshold[Motor]=Value;
+
+  return REPLY_OK;
+}
+
+static int GetRefSearchStallThreshold(uint8_t Motor)
+{
+  return RefSearchStallThreshold[Motor];
+}
+
+static uint8_t SetRefSearchVelocity(uint8_t Motor, int Value)
+{
+  RefSearchVelocity[Motor]=Value;
+
+  return REPLY_OK;
+}
+
+static int GetRefSearchVelocity(uint8_t Motor)
+{
+  return RefSearchVelocity[Motor];
+}
+
+static uint8_t SetRefSearchStallVMin(uint8_t Motor, int Value)
+{
+  RefSearchStallVMin[Motor]=Value;
+
+  return REPLY_OK;
+}
+
+static int GetRefSearchStallVMin(uint8_t Motor)
+{
+  return RefSearchStallVMin[Motor];
+}
+
+static int GetRefSearchDistance(uint8_t Motor)
+{
+  return RefSearchDistance[Motor];
+}
+
+/***************************************************************//**
+   \fn GetRampStatusFlag(uint8_t Motor, uint8_t SPIStatusBit, uint32_t RampStatBit)
+   \brief Read a status flag that is also part of the SPI status byte
+   \param Motor: axis number
+   \param SPIStatusBit: flag in the SPI status byte (TMC5130_SPI_xxx)
+   \param RampStatBit: same flag in RAMPSTAT (TMC5130_RS_xxx)
+   \return 1 if the flag is set, else 0
+
+   RAMPSTAT is only read if the SPI status byte is not recent enough
+   or the driver has been written to since (see GetTMC5130SPIStatus()).
+********************************************************************/
+static int GetRampStatusFlag(uint8_t Motor, uint8_t SPIStatusBit, uint32_t RampStatBit)
+{
+  uint8_t Status;
+
+  if(GetTMC5130SPIStatus(WHICH_5130(Motor), TMC5130_STATUS_MAX_AGE, &Status))
+    return (Status & SPIStatusBit) ? 1:0;
+  else
+    return (ReadTMC5130Int(WHICH_5130(Motor), TMC5130_RAMPSTAT) & RampStatBit) ? 1:0;
+}
+
+static int GetPositionReachedFlag(uint8_t Motor)
+{
+  return GetRampStatusFlag(Motor, TMC5130_SPI_POSREACHED, TMC5130_RS_POSREACHED);
+}
+
+static int GetRightStopFlag(uint8_t Motor)
+{
+  return GetRampStatusFlag(Motor, TMC5130_SPI_STOPR, TMC5130_RS_STOPR);
+}
+
+static int GetLeftStopFlag(uint8_t Motor)
+{
+  return GetRampStatusFlag(Motor, TMC5130_SPI_STOPL, TMC5130_RS_STOPL);
+}
+
+static int GetStallFlag(uint8_t Motor)
+{
+  return StallFlag[Motor];
+}
+
+static int GetQueueDepth(uint8_t Motor)
+{
+  (void) Motor;
+
+  return MQ_DEPTH;
+}
+
+static int GetQueueLevel(uint8_t Motor)
+{
+  return GetMotionQueueLevel(Motor);
+}
+
+static uint8_t SetQueueUnderruns(uint8_t Motor, int Value)
+{
+  (void) Value;  //only 0 is allowed
+
+  ResetMotionQueueUnderruns(Motor);
+
+  return REPLY_OK;
+}
+
+static int GetQueueUnderruns(uint8_t Motor)
+{
+  return GetMotionQueueUnderruns(Motor);
+}
+
+static uint8_t SetBlendDistance(uint8_t Motor, int Value)
+{
+  SetMotionQueueBlendDistance(Motor, Value);
+
+  return REPLY_OK;
+}
+
+static int GetBlendDistance(uint8_t Motor)
+{
+  return GetMotionQueueBlendDistance(Motor);
+}
+
+static uint8_t SetDriverEnable(uint8_t Motor, int Value)
+{
+  (void) Motor;  //same enable pin for all axes
+
+  if(Value!=0)
+    GPIO_OutClr(&enable_out);
+  else
+    GPIO_OutSet(&enable_out);
+
+  return REPLY_OK;
+}
+
+static int GetDriverEnable(uint8_t Motor)
+{
+  (void) Motor;
+
+  return GPIO_OutGet(&enable_out) ? 0:1;
+}
+
+
+//Unit conversion functions used by the table
+
+static int ConvertBoolToInternal(int Value)
+{
+  return Value!=0;
+}
+
+static int ConvertBoolToUser(int Value)
+{
+  return Value;
+}
+
+static int ConvertBoolInvToInternal(int Value)
+{
+  return Value==0;
+}
+
+static int ConvertBoolInvToUser(int Value)
+{
+  return Value==0;
+}
+
+static int ConvertCurrentToInternal(int Value)
+{
+  return (Value & 0xff)/8;
+}
+
+static int ConvertCurrentToUser(int Value)
+{
+  return Value*8;
+}
+
+static int ConvertTHighToInternal(int Value)
+{
+  return (Value>0) ? 13000000 / Value : TSTEP_OFF;
+}
+
+static int ConvertTHighToUser(int Value)
+{
+  if(Value==TSTEP_OFF) return 0;
+
+  return (Value!=0) ? 13000000 / (uint32_t) Value : 16777215;
+}
+
+static int ConvertTStepToInternal(int Value)
+{
+  return (Value>0) ? 12500000 / Value : TSTEP_OFF;
+}
+
+static int ConvertTStepToUser(int Value)
+{
+  if(Value==TSTEP_OFF) return 0;
+
+  return (Value!=0) ? 12500000 / (uint32_t) Value : 16777215;
+}
+
+static int ConvertMResToInternal(int Value)
+{
+  return 8-Value;
+}
+
+static int ConvertSigned8ToInternal(int Value)
+{
+  return Value & 0xff;
+}
+
+static int ConvertSigned8ToUser(int Value)
+{
+  if(Value & BIT7) Value|=0xffffff00;
+
+  return Value;
+}
+
+static int ConvertTPowerDownToInternal(int Value)
+{
+  return FixedDivide(Value, &TPowerDownFactor, FX_FLOOR);
+}
+
+static int ConvertTPowerDownToUser(int Value)
+{
+  return FixedMultiply(Value, &TPowerDownFactor, FX_CEIL);
+}
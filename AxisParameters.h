@@ -0,0 +1,56 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file AxisParameters.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: AxisParameters.h
+ *         Description: Table driven access to the axis parameters (SAP/GAP)
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __AXIS_PARAMETERS_H
+#define __AXIS_PARAMETERS_H
+
+#define AP_NO_REGISTER 0xff    //!< parameter is not mapped to a TMC5130 register
+#define AP_MAX_LIST    32      //!< maximum number of parameters for ReadAxisParameterList()
+
+//Unit conversions used by the axis parameter table
+#define CONV_NONE         0    //!< no conversion
+#define CONV_VELOCITY     1    //!< pps <=> TMC5130 velocity unit
+#define CONV_ACCELERATION 2    //!< pps/s <=> TMC5130 acceleration unit
+#define CONV_BOOL         3    //!< 0/1 <=> bit
+#define CONV_BOOL_INV     4    //!< 0/1 <=> inverted bit
+#define CONV_CURRENT      5    //!< 0..255 <=> 0..31
+#define CONV_THIGH        6    //!< pps <=> TSTEP threshold (THIGH)
+#define CONV_TSTEP        7    //!< pps <=> TSTEP threshold (TCOOLTHRS, TPWMTHRS)
+#define CONV_MRES         8    //!< 0..8 (full step..256 microsteps) <=> MRES
+#define CONV_SIGNED8      9    //!< signed 8 bit field
+#define CONV_TPOWERDOWN  10    //!< ms <=> TPOWERDOWN unit
+
+//! Descriptor of an axis parameter
+typedef struct
+{
+  uint8_t Number;        //!< axis parameter number (type of the SAP/GAP command)
+  uint8_t Access;        //!< access rights (PB_READ, PB_WRITE, PB_STORE)
+  uint8_t Register;      //!< TMC5130 register (or AP_NO_REGISTER)
+  uint8_t Shift;         //!< position of the bit field in the register
+  uint8_t Width;         //!< width of the bit field (32: entire register)
+  uint8_t Conversion;    //!< unit conversion (CONV_xxx)
+  int32_t Min;           //!< lowest allowed value (user unit)
+  int32_t Max;           //!< highest allowed value (user unit)
+  uint8_t (*SetHook)(uint8_t Motor, int Value);  //!< special write function (or NULL)
+  int (*GetHook)(uint8_t Motor);                 //!< special read function (or NULL)
+} TAxisParameter;
+
+const TAxisParameter *FindAxisParameter(uint8_t Number);
+uint8_t WriteAxisParameter(uint8_t Motor, uint8_t Number, int Value);
+uint8_t ReadAxisParameter(uint8_t Motor, uint8_t Number, int *Value);
+void ReadAxisParameterList(uint8_t Motor, const uint8_t *Numbers, int *Values, uint8_t *Status, uint32_t Count);
+
+#endif
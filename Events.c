@@ -0,0 +1,90 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file Events.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: Events.c
+ *         Description: Event flags (reported to the master instead of polling)
+ *
+ *                      Events that are enabled in the event mask are latched
+ *                      until the master clears them. As long as there are
+ *                      pending events every REPLY_OK status is replaced by
+ *                      REPLY_OK_EVENT, so the master only has to read the
+ *                      events of nodes that have news.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include "max32660.h"
+#include "Events.h"
+
+static uint32_t EventMask;        //!< enabled events
+static uint32_t PendingEvents;    //!< latched events
+
+
+/***************************************************************//**
+   \fn SetEventMask(uint32_t Mask)
+   \brief Select the events to be latched
+   \param Mask: enabled events (EV_xxx), 0: event reporting off
+
+   Pending events that are no longer enabled are cleared.
+********************************************************************/
+void SetEventMask(uint32_t Mask)
+{
+  EventMask=Mask;
+  PendingEvents&=Mask;
+}
+
+
+/***************************************************************//**
+   \fn GetEventMask(void)
+   \return Enabled events
+********************************************************************/
+uint32_t GetEventMask(void)
+{
+  return EventMask;
+}
+
+
+/***************************************************************//**
+   \fn SignalEvent(uint32_t Event)
+   \brief Latch an event
+   \param Event: event flag(s) (EV_xxx)
+
+   Called when an event occurs. Only enabled events are latched.
+********************************************************************/
+void SignalEvent(uint32_t Event)
+{
+  PendingEvents|=Event & EventMask;
+}
+
+
+/***************************************************************//**
+   \fn GetPendingEvents(void)
+   \return Latched events
+********************************************************************/
+uint32_t GetPendingEvents(void)
+{
+  return PendingEvents;
+}
+
+
+/***************************************************************//**
+   \fn ClearPendingEvents(void)
+   \brief Read and clear all latched events
+   \return Latched events (before clearing)
+********************************************************************/
+uint32_t ClearPendingEvents(void)
+{
+  uint32_t Events;
+
+  Events=PendingEvents;
+  PendingEvents=0;
+
+  return Events;
+}
@@ -0,0 +1,44 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file Events.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: Events.h
+ *         Description: Event flags (reported to the master instead of polling)
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __EVENTS_H
+#define __EVENTS_H
+
+//Axis events (shifted by EV_AXIS_SHIFT*axis)
+#define EV_POS_REACHED   0x01        //!< target position reached
+#define EV_STALL         0x02        //!< motor stopped by stallGuard
+#define EV_RFS_DONE      0x04        //!< reference search finished
+#define EV_AXIS_SHIFT    4           //!< number of event bits per axis
+
+//Module events
+#define EV_TEMPERATURE   0x80000000  //!< temperature limit exceeded
+#define EV_WAIT_DONE     0x40000000  //!< WAIT command in direct mode finished (see command 135, type 6)
+
+#define EV_AXIS(Event, Axis) ((Event) << (EV_AXIS_SHIFT*(Axis)))
+
+//Type codes of the SetEvent command
+#define SE_SET_MASK     0    //!< set event mask (value)
+#define SE_GET_MASK     1    //!< read event mask
+#define SE_GET_EVENTS   2    //!< read pending events
+#define SE_CLEAR_EVENTS 3    //!< read and clear pending events
+
+void SetEventMask(uint32_t Mask);
+uint32_t GetEventMask(void);
+void SignalEvent(uint32_t Event);
+uint32_t GetPendingEvents(void);
+uint32_t ClearPendingEvents(void);
+
+#endif
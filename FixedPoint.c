@@ -0,0 +1,190 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file FixedPoint.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: FixedPoint.c
+ *         Description: Unit conversions with constant factors (integer only)
+ *
+ *                      The results are identical to the double precision
+ *                      calculation (int) floor((double) Value/Factor) or
+ *                      (int) ceil((double) Value*Factor) etc., including
+ *                      the rounding of the double result and the saturation
+ *                      of the conversion to int, but need only a few
+ *                      integer multiplications instead of soft-float
+ *                      arithmetic:
+ *
+ *                      The exact quotient or product q=n+R/Den is
+ *                      calculated with integer arithmetic. The double
+ *                      result can only differ from q in its integer part
+ *                      if q is closer than half a unit in the last place
+ *                      (2^(e-53) for 2^e<=q<2^(e+1)) to an integer, which
+ *                      is checked using the remainder R.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include "max32660.h"
+#include "FixedPoint.h"
+
+
+/***************************************************************//**
+   \fn HalfUlpLimit(uint64_t n, uint64_t Den)
+   \brief Remainder limit for the rounding of a double
+   \param n: integer part of a positive value q=n+R/Den
+   \param Den: denominator of the fractional part
+   \return Limit L: a distance d/Den from q to an integer is within
+           half a unit in the last place of the double q if d<=L
+********************************************************************/
+static uint64_t HalfUlpLimit(uint64_t n, uint64_t Den)
+{
+  //0<q<1 only matters when rounding up to 1 (half ULP below 1 is 2^-54)
+  if(n==0) return Den>>54;
+
+  return Den>>(53-(63-__builtin_clzll(n)));
+}
+
+
+/***************************************************************//**
+   \fn RoundResult(uint64_t n, uint64_t R, uint64_t Den, uint8_t Negative, uint8_t Rounding)
+   \brief Round a value like a double followed by floor() or ceil()
+   \param n: integer part of the magnitude
+   \param R: remainder of the magnitude (fractional part is R/Den)
+   \param Den: denominator of the fractional part
+   \param Negative: TRUE if the value is negative
+   \param Rounding: FX_FLOOR, FX_CEIL, FX_TRUNC or FX_AWAY
+   \return Rounded value (saturated to the int range)
+********************************************************************/
+static int RoundResult(uint64_t n, uint64_t R, uint64_t Den, uint8_t Negative, uint8_t Rounding)
+{
+  uint8_t Up;
+
+  //Saturate (also keeps HalfUlpLimit() in range)
+  if(n>0xffffffff)
+  {
+    n=0x100000000ULL;
+    R=0;
+  }
+
+  //Round the magnitude up or down?
+  switch(Rounding & 0x03)
+  {
+    case FX_FLOOR:
+      Up=Negative;
+      break;
+
+    case FX_CEIL:
+      Up=!Negative;
+      break;
+
+    case FX_AWAY:
+      Up=TRUE;
+      break;
+
+    default:
+      Up=FALSE;
+      break;
+  }
+
+  if(R!=0)
+  {
+    if(Up)
+    {
+      //Ceiling, unless the double is rounded down to n (ties go to the even value n)
+      if(n==0 || R>HalfUlpLimit(n, Den)) n++;
+    }
+    else
+    {
+      //Floor, unless the double is rounded up to n+1
+      if(Den-R<=HalfUlpLimit(n, Den)) n++;
+    }
+  }
+
+  if(Negative)
+    return (n>=0x80000000) ? INT32_MIN : -(int) n;
+  else
+    return (n>=0x7fffffff) ? INT32_MAX : (int) n;
+}
+
+
+/***************************************************************//**
+   \fn FixedDivide(int Value, const TFixedFactor *Factor, uint8_t Rounding)
+   \brief Divide by a constant factor
+   \param Value: dividend
+   \param Factor: divisor (see FIXED_FACTOR())
+   \param Rounding: FX_FLOOR, FX_CEIL, FX_TRUNC or FX_AWAY
+   \return Value/Factor, rounded like the double calculation
+
+   The reciprocal gives the quotient with an error of at most one,
+   which is then corrected using the exact remainder.
+********************************************************************/
+int FixedDivide(int Value, const TFixedFactor *Factor, uint8_t Rounding)
+{
+  uint32_t Magnitude;
+  uint64_t n;
+  int64_t R;
+
+  Magnitude=(Value<0) ? -(uint32_t) Value : (uint32_t) Value;
+
+  n=((uint64_t) Magnitude*Factor->Reciprocal)>>32;
+  R=(int64_t) (((uint64_t) Magnitude<<Factor->Shift)-n*Factor->Mantissa);
+  if(R<0)
+  {
+    n--;
+    R+=Factor->Mantissa;
+  }
+  else if((uint64_t) R>=Factor->Mantissa)
+  {
+    n++;
+    R-=Factor->Mantissa;
+  }
+
+  return RoundResult(n, R, Factor->Mantissa, Value<0, Rounding);
+}
+
+
+/***************************************************************//**
+   \fn FixedMultiply(int Value, const TFixedFactor *Factor, uint8_t Rounding)
+   \brief Multiply by a constant factor
+   \param Value: value to be multiplied
+   \param Factor: factor (see FIXED_FACTOR())
+   \param Rounding: FX_FLOOR, FX_CEIL, FX_TRUNC or FX_AWAY, optionally
+                    combined with FX_FLOAT_INPUT
+   \return Value*Factor, rounded like the double calculation
+
+   With FX_FLOAT_INPUT the value is rounded to float precision first
+   (like (float) Value*Factor).
+********************************************************************/
+int FixedMultiply(int Value, const TFixedFactor *Factor, uint8_t Rounding)
+{
+  uint32_t Magnitude;
+  uint32_t Shift;
+  uint32_t Drop;
+  uint32_t Rest;
+  uint64_t Low, High;
+
+  Magnitude=(Value<0) ? -(uint32_t) Value : (uint32_t) Value;
+  Shift=Factor->Shift;
+
+  //Round to 24 significant bits (nearest, ties to even)
+  if((Rounding & FX_FLOAT_INPUT) && Magnitude>=(1<<24))
+  {
+    Drop=8-__builtin_clz(Magnitude);
+    Rest=Magnitude & ((1<<Drop)-1);
+    Magnitude>>=Drop;
+    if(Rest>(1U<<(Drop-1)) || (Rest==(1U<<(Drop-1)) && (Magnitude & 1))) Magnitude++;
+    Shift-=Drop;
+  }
+
+  //Magnitude*Mantissa = High*2^32+(uint32_t) Low
+  Low=(uint64_t) Magnitude*(uint32_t) Factor->Mantissa;
+  High=(uint64_t) Magnitude*(uint32_t) (Factor->Mantissa>>32)+(Low>>32);
+
+  return RoundResult(High>>(Shift-32), ((High & ((1ULL<<(Shift-32))-1))<<32) | (uint32_t) Low,
+                     1ULL<<Shift, Value<0, Rounding);
+}
@@ -0,0 +1,46 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file FixedPoint.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: FixedPoint.h
+ *         Description: Unit conversions with constant factors (integer only)
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __FIXED_POINT_H
+#define __FIXED_POINT_H
+
+//Rounding of the conversion result
+#define FX_FLOOR  0    //!< towards minus infinity
+#define FX_CEIL   1    //!< towards plus infinity
+#define FX_TRUNC  2    //!< towards zero
+#define FX_AWAY   3    //!< away from zero
+#define FX_FLOAT_INPUT 0x80   //!< FixedMultiply(): round the input to float precision first
+
+//! Constant conversion factor
+typedef struct
+{
+  uint64_t Mantissa;     //!< factor*2^Shift (exact binary value of the factor)
+  uint8_t Shift;         //!< 32..63
+  uint64_t Reciprocal;   //!< approximately 2^32/factor
+} TFixedFactor;
+
+/**
+  Initialiser for a TFixedFactor (evaluated by the compiler).
+  Factor*2^Shift must be an integer below 2^62, so that the factor
+  is represented exactly (Shift 53: factors 0.5..511, Shift 54:
+  factors 0.25..255).
+*/
+#define FIXED_FACTOR(Factor, Shift) {(uint64_t) ((Factor)*(double) (1ULL<<(Shift))), (Shift), (uint64_t) (4294967296.0/(Factor))}
+
+int FixedDivide(int Value, const TFixedFactor *Factor, uint8_t Rounding);
+int FixedMultiply(int Value, const TFixedFactor *Factor, uint8_t Rounding);
+
+#endif
@@ -0,0 +1,390 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file GlobalParameters.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: GlobalParameters.c
+ *         Description: Global parameters and user variables (SGP/GGP)
+ *
+ *                      Bank 0: module settings (address, baud rate, ...)
+ *                      Bank 2: user variables (the first
+ *                              TMCL_EEPROM_USER_VARS can be stored)
+ *                      Bank 3: diagnostic values (read only)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include "max32660.h"
+#include "HomebusSlave.h"
+#include "Globals.h"
+#include "SysTick.h"
+#include "Homebus.h"
+#include "TMC5130.h"
+#include "TMCL.h"
+#include "ParamStore.h"
+#include "GlobalParameters.h"
+
+//! Baud rates selectable by GP_BAUDRATE
+static const uint32_t Baudrates[]={9600, 14400, 19200, 28800, 38400, 57600, 76800,
+                                   115200, 230400, 250000, 500000, 1000000};
+
+static int UserVariables[TMCL_RAM_USER_VARS];  //!< user variables (bank 2)
+static uint8_t BaudrateIndex;                  //!< selected baud rate (index into Baudrates[])
+static uint8_t LineCode;                       //!< selected Homebus line code
+static int TemperatureLimit;                   //!< temperature limit (°C)
+static uint8_t ShadowVerify;                   //!< TRUE: verify the TMC5130 registers periodically
+static uint32_t PollIntervalFast;              //!< RAMPSTAT read interval (ms) during reference search and StallGuard
+static uint32_t PollIntervalMoving;            //!< RAMPSTAT read interval (ms) while moving
+static uint32_t PollIntervalIdle;              //!< RAMPSTAT read interval (ms) at standstill
+
+
+/***************************************************************//**
+   \fn InitGlobalParameters(void)
+   \brief Initialise the global parameters
+
+   Set all global parameters to their defaults and then restore
+   the values stored in the flash. InitParamStore() must have been
+   called before.
+********************************************************************/
+void InitGlobalParameters(void)
+{
+  uint32_t i;
+  const TParamEntry *Entry;
+
+  ModuleAddress=DEFAULT_MODULE_ADDRESS;
+  HostAddress=DEFAULT_HOST_ADDRESS;
+  BaudrateIndex=DEFAULT_BAUDRATE_INDEX;
+  LineCode=HB_LINE_ENCODED;
+  TemperatureLimit=DEFAULT_TEMP_LIMIT;
+  ShadowVerify=DEFAULT_SHADOW_VERIFY;
+  PollIntervalFast=DEFAULT_POLL_FAST;
+  PollIntervalMoving=DEFAULT_POLL_MOVING;
+  PollIntervalIdle=DEFAULT_POLL_IDLE;
+
+  for(i=0; (Entry=GetParamStoreEntry(i))!=NULL; i++)
+  {
+    if(Entry->Kind==PS_KIND_GLOBAL)
+      WriteGlobalParameter(Entry->Bank, Entry->Index, Entry->Value);
+  }
+}
+
+
+/***************************************************************//**
+   \fn GlobalParameterAccess(uint8_t Bank, uint8_t Number)
+   \brief Access rights of a global parameter
+   \param Bank: bank number
+   \param Number: parameter number
+   \return PB_READ, PB_WRITE and PB_STORE bits (0: not existing)
+********************************************************************/
+uint8_t GlobalParameterAccess(uint8_t Bank, uint8_t Number)
+{
+  switch(Bank)
+  {
+    case GP_BANK_MODULE:
+      switch(Number)
+      {
+        case GP_BAUDRATE:
+        case GP_ADDRESS:
+        case GP_HOST_ADDRESS:
+        case GP_LINE_CODE:
+        case GP_TEMP_LIMIT:
+        case GP_SHADOW_VERIFY:
+        case GP_POLL_FAST:
+        case GP_POLL_MOVING:
+        case GP_POLL_IDLE:
+          return PB_READ|PB_WRITE|PB_STORE;
+
+        default:
+          return 0;
+      }
+
+    case GP_BANK_USER_VARS:
+      if(Number<TMCL_EEPROM_USER_VARS)
+        return PB_READ|PB_WRITE|PB_STORE;
+      else
+        return PB_READ|PB_WRITE;
+
+    case GP_BANK_DIAGNOSTICS:
+      return (Number<=GP_DIAG_RX_OVERRUNS) ? PB_READ : 0;
+
+    default:
+      return 0;
+  }
+}
+
+
+/***************************************************************//**
+   \fn WriteGlobalParameter(uint8_t Bank, uint8_t Number, int Value)
+   \brief Write a global parameter
+   \param Bank: bank number
+   \param Number: parameter number
+   \param Value: new value
+   \return TMCL status code (REPLY_OK if successful)
+
+   A new module address is used immediately (also for the reply
+   of this command). Baud rate and line code become active after
+   the next reset, so they have to be stored (STGP).
+********************************************************************/
+uint8_t WriteGlobalParameter(uint8_t Bank, uint8_t Number, int Value)
+{
+  if(!(GlobalParameterAccess(Bank, Number) & PB_WRITE)) return REPLY_WRONG_TYPE;
+
+  switch(Bank)
+  {
+    case GP_BANK_MODULE:
+      switch(Number)
+      {
+        case GP_BAUDRATE:
+          if(Value<0 || Value>=(int) (sizeof(Baudrates)/sizeof(Baudrates[0]))) return REPLY_INVALID_VALUE;
+          BaudrateIndex=Value;
+          break;
+
+        case GP_ADDRESS:
+          if(Value<1 || Value>255) return REPLY_INVALID_VALUE;
+          ModuleAddress=Value;
+          break;
+
+        case GP_HOST_ADDRESS:
+          if(Value<0 || Value>255) return REPLY_INVALID_VALUE;
+          HostAddress=Value;
+          break;
+
+        case GP_LINE_CODE:
+          if(Value!=HB_LINE_ENCODED && Value!=HB_LINE_RAW) return REPLY_INVALID_VALUE;
+          LineCode=Value;
+          break;
+
+        case GP_TEMP_LIMIT:
+          if(Value<-40 || Value>150) return REPLY_INVALID_VALUE;
+          TemperatureLimit=Value;
+          break;
+
+        case GP_SHADOW_VERIFY:
+          if(Value<0 || Value>1) return REPLY_INVALID_VALUE;
+          ShadowVerify=Value;
+          break;
+
+        case GP_POLL_FAST:
+          if(Value<0 || Value>MAX_POLL_INTERVAL) return REPLY_INVALID_VALUE;
+          PollIntervalFast=Value;
+          break;
+
+        case GP_POLL_MOVING:
+          if(Value<0 || Value>MAX_POLL_INTERVAL) return REPLY_INVALID_VALUE;
+          PollIntervalMoving=Value;
+          break;
+
+        case GP_POLL_IDLE:
+          if(Value<0 || Value>MAX_POLL_INTERVAL) return REPLY_INVALID_VALUE;
+          PollIntervalIdle=Value;
+          break;
+      }
+      break;
+
+    case GP_BANK_USER_VARS:
+      UserVariables[Number]=Value;
+      break;
+  }
+
+  return REPLY_OK;
+}
+
+
+/***************************************************************//**
+   \fn ReadGlobalParameter(uint8_t Bank, uint8_t Number, int *Value)
+   \brief Read a global parameter
+   \param Bank: bank number
+   \param Number: parameter number
+   \param Value: pointer to variable for the value
+   \return TMCL status code (REPLY_OK if successful)
+********************************************************************/
+uint8_t ReadGlobalParameter(uint8_t Bank, uint8_t Number, int *Value)
+{
+  if(!(GlobalParameterAccess(Bank, Number) & PB_READ)) return REPLY_WRONG_TYPE;
+
+  switch(Bank)
+  {
+    case GP_BANK_MODULE:
+      switch(Number)
+      {
+        case GP_BAUDRATE:
+          *Value=BaudrateIndex;
+          break;
+
+        case GP_ADDRESS:
+          *Value=ModuleAddress;
+          break;
+
+        case GP_HOST_ADDRESS:
+          *Value=HostAddress;
+          break;
+
+        case GP_LINE_CODE:
+          *Value=LineCode;
+          break;
+
+        case GP_TEMP_LIMIT:
+          *Value=TemperatureLimit;
+          break;
+
+        case GP_SHADOW_VERIFY:
+          *Value=ShadowVerify;
+          break;
+
+        case GP_POLL_FAST:
+          *Value=PollIntervalFast;
+          break;
+
+        case GP_POLL_MOVING:
+          *Value=PollIntervalMoving;
+          break;
+
+        case GP_POLL_IDLE:
+          *Value=PollIntervalIdle;
+          break;
+      }
+      break;
+
+    case GP_BANK_USER_VARS:
+      *Value=UserVariables[Number];
+      break;
+
+    case GP_BANK_DIAGNOSTICS:
+      switch(Number)
+      {
+        case GP_DIAG_UPTIME:
+          *Value=GetSysTimer();
+          break;
+
+        case GP_DIAG_COMMANDS:
+          *Value=CommandCount;
+          break;
+
+        case GP_DIAG_CHKERR:
+          *Value=ChecksumErrorCount;
+          break;
+
+        case GP_DIAG_FLASH_ERASE:
+          *Value=GetParamStoreEraseCount();
+          break;
+
+        case GP_DIAG_SPI_TRANSFERS:
+          *Value=GetTMC5130TransferCount();
+          break;
+
+        case GP_DIAG_SPI_SAVED:
+          *Value=GetTMC5130SavedWriteCount();
+          break;
+
+        case GP_DIAG_RESTORES:
+          *Value=GetTMC5130RestoreCount();
+          break;
+
+        case GP_DIAG_SPI_WAIT:
+          *Value=GetTMC5130SPIWaitTime();
+          break;
+
+        case GP_DIAG_DIAG_PINS:
+          *Value=GetDiagInterruptCount();
+          break;
+
+        case GP_DIAG_POLL_RATE:
+          *Value=GetPollRate();
+          break;
+
+        case GP_DIAG_LOOP_RATE:
+          *Value=GetLoopRate();
+          break;
+
+        case GP_DIAG_SPI_FALLBACK:
+          *Value=GetTMC5130AsyncFallbackCount();
+          break;
+
+        case GP_DIAG_RX_OVERRUNS:
+          *Value=GetHomebusOverrunCount();
+          break;
+      }
+      break;
+  }
+
+  return REPLY_OK;
+}
+
+
+/***************************************************************//**
+   \fn GetHomebusBaudrate(void)
+   \return Baud rate selected by global parameter GP_BAUDRATE
+********************************************************************/
+uint32_t GetHomebusBaudrate(void)
+{
+  return Baudrates[BaudrateIndex];
+}
+
+
+/***************************************************************//**
+   \fn GetHomebusLineCode(void)
+   \return Line code selected by global parameter GP_LINE_CODE
+********************************************************************/
+uint8_t GetHomebusLineCode(void)
+{
+  return LineCode;
+}
+
+
+/***************************************************************//**
+   \fn GetTemperatureLimit(void)
+   \return Temperature limit (°C) selected by global parameter GP_TEMP_LIMIT
+********************************************************************/
+int GetTemperatureLimit(void)
+{
+  return TemperatureLimit;
+}
+
+
+/***************************************************************//**
+   \fn GetShadowVerify(void)
+   \return TRUE if the TMC5130 registers are to be verified
+           periodically (global parameter GP_SHADOW_VERIFY)
+********************************************************************/
+uint8_t GetShadowVerify(void)
+{
+  return ShadowVerify;
+}
+
+
+/***************************************************************//**
+   \fn GetPollIntervalFast(void)
+   \return RAMPSTAT read interval (ms) during reference search and
+           StallGuard (global parameter GP_POLL_FAST)
+********************************************************************/
+uint32_t GetPollIntervalFast(void)
+{
+  return PollIntervalFast;
+}
+
+
+/***************************************************************//**
+   \fn GetPollIntervalMoving(void)
+   \return RAMPSTAT read interval (ms) while moving (global
+           parameter GP_POLL_MOVING)
+********************************************************************/
+uint32_t GetPollIntervalMoving(void)
+{
+  return PollIntervalMoving;
+}
+
+
+/***************************************************************//**
+   \fn GetPollIntervalIdle(void)
+   \return RAMPSTAT read interval (ms) at standstill (global
+           parameter GP_POLL_IDLE)
+********************************************************************/
+uint32_t GetPollIntervalIdle(void)
+{
+  return PollIntervalIdle;
+}
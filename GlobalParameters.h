@@ -0,0 +1,73 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file GlobalParameters.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: GlobalParameters.h
+ *         Description: Global parameters and user variables (SGP/GGP)
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __GLOBAL_PARAMETERS_H
+#define __GLOBAL_PARAMETERS_H
+
+//Banks of global parameters
+#define GP_BANK_MODULE       0    //!< module settings
+#define GP_BANK_USER_VARS    2    //!< user variables
+#define GP_BANK_DIAGNOSTICS  3    //!< diagnostic values (read only)
+
+//Module settings (bank 0)
+#define GP_BAUDRATE     65    //!< baud rate index (see Baudrates[], active after reset)
+#define GP_ADDRESS      66    //!< module address
+#define GP_HOST_ADDRESS 76    //!< host address
+#define GP_LINE_CODE   128    //!< Homebus line code (HB_LINE_xxx, active after reset)
+#define GP_TEMP_LIMIT  129    //!< temperature limit for the EV_TEMPERATURE event (°C)
+#define GP_SHADOW_VERIFY 130  //!< periodically verify the TMC5130 registers (0/1)
+#define GP_POLL_FAST   131    //!< RAMPSTAT read interval (ms) during reference search and StallGuard
+#define GP_POLL_MOVING 132    //!< RAMPSTAT read interval (ms) while moving
+#define GP_POLL_IDLE   133    //!< RAMPSTAT read interval (ms) at standstill
+
+//Diagnostic values (bank 3)
+#define GP_DIAG_UPTIME       0    //!< time since reset (ms)
+#define GP_DIAG_COMMANDS     1    //!< number of received commands
+#define GP_DIAG_CHKERR       2    //!< number of received commands with checksum error
+#define GP_DIAG_FLASH_ERASE  3    //!< number of flash page erase cycles of the parameter store
+#define GP_DIAG_SPI_TRANSFERS 4   //!< number of SPI datagrams sent to the TMC5130
+#define GP_DIAG_SPI_SAVED    5    //!< number of TMC5130 register writes skipped (value already set)
+#define GP_DIAG_RESTORES     6    //!< number of TMC5130 register restores (driver reset detected)
+#define GP_DIAG_SPI_WAIT     7    //!< CPU time spent waiting for SPI transfers (µs)
+#define GP_DIAG_DIAG_PINS    8    //!< number of DIAG pin interrupts (stall, driver error)
+#define GP_DIAG_POLL_RATE    9    //!< RAMPSTAT reads (all axes) in the last second
+#define GP_DIAG_LOOP_RATE   10    //!< main loop passes in the last second
+#define GP_DIAG_SPI_FALLBACK 11   //!< posted TMC5130 write frames sent blocking (SPIMSS driver error)
+#define GP_DIAG_RX_OVERRUNS 12    //!< Homebus receive data lost (UART FIFO overrun, e.g. during a flash page erase)
+
+#define DEFAULT_MODULE_ADDRESS 1
+#define DEFAULT_HOST_ADDRESS   2
+#define DEFAULT_BAUDRATE_INDEX 8    //!< 230400 bps
+#define DEFAULT_TEMP_LIMIT     80   //!< °C
+#define DEFAULT_SHADOW_VERIFY  1
+#define DEFAULT_POLL_FAST      0    //!< ms (every main loop pass)
+#define DEFAULT_POLL_MOVING    5    //!< ms
+#define DEFAULT_POLL_IDLE      100  //!< ms
+#define MAX_POLL_INTERVAL      1000 //!< ms
+
+void InitGlobalParameters(void);
+uint8_t GlobalParameterAccess(uint8_t Bank, uint8_t Number);
+uint8_t WriteGlobalParameter(uint8_t Bank, uint8_t Number, int Value);
+uint8_t ReadGlobalParameter(uint8_t Bank, uint8_t Number, int *Value);
+uint32_t GetHomebusBaudrate(void);
+uint8_t GetHomebusLineCode(void);
+int GetTemperatureLimit(void);
+uint8_t GetShadowVerify(void);
+uint32_t GetPollIntervalFast(void);
+uint32_t GetPollIntervalMoving(void);
+uint32_t GetPollIntervalIdle(void);
+
+#endif
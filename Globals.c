@@ -30,3 +30,9 @@ int32_t RefSearchVelocity[N_O_MOTORS];
 int32_t RefSearchStallThreshold[N_O_MOTORS];
 uint32_t RefSearchStallVMin[N_O_MOTORS];
 int RefSearchDistance[N_O_MOTORS];
+uint32_t RampStatCache[N_O_MOTORS];        //!< RAMPSTAT as last read by ProcessStallGuard()
+uint8_t RampStatValid[N_O_MOTORS];         //!< TRUE when RampStatCache[] has been updated
+uint8_t ModuleAddress;
+uint8_t HostAddress;
+uint32_t CommandCount;
+uint32_t ChecksumErrorCount;
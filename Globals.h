@@ -30,5 +30,11 @@ extern int32_t RefSearchStallThreshold[N_O_MOTORS];
 extern int32_t RefSearchVelocity[N_O_MOTORS];
 extern uint32_t RefSearchStallVMin[N_O_MOTORS];
 extern int RefSearchDistance[N_O_MOTORS];
+extern uint32_t RampStatCache[N_O_MOTORS];
+extern uint8_t RampStatValid[N_O_MOTORS];
+extern uint8_t ModuleAddress;
+extern uint8_t HostAddress;
+extern uint32_t CommandCount;
+extern uint32_t ChecksumErrorCount;
 
 #endif
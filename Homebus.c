@@ -22,10 +22,11 @@
 #include "mxc_sys.h"
 #include "uart.h"
 #include "gpio.h"
+#include "Homebus.h"
 
 #define TMCL_COMMAND_LENGTH      9                           //!< Length of a TMCL command: 9 bytes
 #define HBS_TMCL_COMMAND_LENGTH  2*TMCL_COMMAND_LENGTH       //!< Length of a homebus encoder TMCL command
-#define HBS_RX_THRESHOLD         3     //!< Threshold value for Rx FIFO. HBS_TMCL_COMMAND_LENGTH must be dividable by HBS_RX_THRESHOLD.
+#define HBS_RX_THRESHOLD         3     //!< Threshold value for Rx FIFO. HBS_TMCL_COMMAND_LENGTH and TMCL_COMMAND_LENGTH must be dividable by HBS_RX_THRESHOLD.
 
 static const sys_cfg_uart_t sys_uart0_cfg = {
         MAP_A,
@@ -36,7 +37,10 @@ static gpio_cfg_t HomebusTxPin;  //!< Pin for switching between send and receive
 static uint8_t HomebusRawRxData[HBS_TMCL_COMMAND_LENGTH];   //!< Buffer for incoming homebus data
 static uint8_t HomebusRawTxData[HBS_TMCL_COMMAND_LENGTH];   //!< Buffer for outgoing homebus data
 static volatile uint8_t HomebusRawRxCount;                           //!< Counter for incoming homebus data
+static uint8_t HomebusLineCode;                             //!< Line code (HB_LINE_ENCODED or HB_LINE_RAW)
+static uint8_t HomebusFrameLength;                          //!< Length of a frame on the line (depends on the line code)
 static uint8_t Command[TMCL_COMMAND_LENGTH];                //!< Buffer for received TMCL command
+static volatile uint32_t HomebusOverrunCount;               //!< Number of Rx FIFO overruns (received data lost)
 
 
 /***************************************************************//**
@@ -115,13 +119,17 @@ void UART0_IRQHandler(void)
     //Copy these bytes from the FIFO into our Homebus data buffer.
     for(i=0; i<HBS_RX_THRESHOLD; i++)
     {
-      if(HomebusRawRxCount<HBS_TMCL_COMMAND_LENGTH) HomebusRawRxData[HomebusRawRxCount++]=MXC_UART0->fifo;
+      if(HomebusRawRxCount<HomebusFrameLength) HomebusRawRxData[HomebusRawRxCount++]=MXC_UART0->fifo;
     }
 
-    if(HomebusRawRxCount==HBS_TMCL_COMMAND_LENGTH)
+    if(HomebusRawRxCount==HomebusFrameLength)
     {
       //Entire TMCL command received => decode the data
-      Homebus_data_decode(HomebusRawRxData, Command, TMCL_COMMAND_LENGTH);
+      if(HomebusLineCode==HB_LINE_RAW)
+      {
+        for(i=0; i<TMCL_COMMAND_LENGTH; i++) Command[i]=HomebusRawRxData[i];
+      }
+      else Homebus_data_decode(HomebusRawRxData, Command, TMCL_COMMAND_LENGTH);
     }
 
     //Reset the interrupt
@@ -140,7 +148,9 @@ void UART0_IRQHandler(void)
   //Receive FIFO overrun interrupt
   if(irq_flags & MXC_F_UART_INT_FL_RX_OVERRUN)
   {
-    //An Rx FIFO overrun has occured (hardly possible) => discard everything
+    //An Rx FIFO overrun has occured (only when interrupts have been blocked
+    //for a long time, e.g. by a flash page erase) => discard everything
+    HomebusOverrunCount++;
     MXC_UART0->int_fl=MXC_F_UART_INT_FL_RX_OVERRUN;
     MXC_UART0->ctrl |= MXC_F_UART_CTRL_RX_FLUSH;
     HomebusRawRxCount=0;
@@ -170,15 +180,19 @@ void UART0_IRQHandler(void)
 /***************************************************************//**
    \fn HomebusInit()
    \param Baudrate: Baud rate to be used (mostly 230400)
+   \param LineCode: HB_LINE_ENCODED (Homebus) or HB_LINE_RAW (plain UART)
    \brief Initalize everything for Homebus communication
 
    Initialize the Homebus communication.
 ********************************************************************/
-void HomebusInit(uint32_t Baudrate)
+void HomebusInit(uint32_t Baudrate, uint8_t LineCode)
 {
   uart_cfg_t cfg;
   gpio_cfg_t rxIn;
 
+  HomebusLineCode=LineCode;
+  HomebusFrameLength=(LineCode==HB_LINE_RAW) ? TMCL_COMMAND_LENGTH : HBS_TMCL_COMMAND_LENGTH;
+
   //Initialize port pin P0.6 for switching between transmit and receive
   //mode. This pin is connected to the MAX22088 RST pin.
   HomebusTxPin.port = PORT_0;
@@ -244,10 +258,14 @@ void HomebusSendData(uint8_t *data)
   MXC_UART0->int_en|=MXC_F_UART_INT_EN_TX_FIFO_ALMOST_EMPTY;
 
   //Encode the data for Homebus
-  Homebus_data_encode(HomebusRawTxData, data, TMCL_COMMAND_LENGTH);
+  if(HomebusLineCode==HB_LINE_RAW)
+  {
+    for(i=0; i<TMCL_COMMAND_LENGTH; i++) HomebusRawTxData[i]=data[i];
+  }
+  else Homebus_data_encode(HomebusRawTxData, data, TMCL_COMMAND_LENGTH);
 
   //Send out the data
-  for(i=0; i<HBS_TMCL_COMMAND_LENGTH; i++)
+  for(i=0; i<HomebusFrameLength; i++)
   {
     while(MXC_UART0->status & MXC_F_UART_STATUS_TX_FULL);
     MXC_UART0->fifo=HomebusRawTxData[i];
@@ -270,7 +288,7 @@ uint8_t HomebusGetData(uint8_t *data)
 {
   uint8_t i;
 
-  if(HomebusRawRxCount==HBS_TMCL_COMMAND_LENGTH)
+  if(HomebusRawRxCount==HomebusFrameLength)
   {
     __disable_irq();
     for(i=0; i<TMCL_COMMAND_LENGTH; i++) data[i]=Command[i];
@@ -282,3 +300,30 @@ uint8_t HomebusGetData(uint8_t *data)
 
   return FALSE;
 }
+
+
+/***************************************************************//**
+   \fn HomebusSendBusy()
+   \return TRUE while a frame is being sent
+
+   The transmit interrupt stays enabled until the last bit of the
+   frame passed to HomebusSendData() has been sent out. Calling
+   HomebusSendData() again only blocks while this is TRUE.
+********************************************************************/
+uint8_t HomebusSendBusy(void)
+{
+  return (MXC_UART0->int_en & MXC_F_UART_INT_EN_TX_FIFO_ALMOST_EMPTY) ? TRUE:FALSE;
+}
+
+
+/***************************************************************//**
+   \fn GetHomebusOverrunCount()
+   \return Number of UART Rx FIFO overruns
+
+   Each overrun means that received data (usually at least one frame)
+   has been lost because interrupts have been blocked for too long.
+********************************************************************/
+uint32_t GetHomebusOverrunCount(void)
+{
+  return HomebusOverrunCount;
+}
@@ -20,8 +20,14 @@
 #ifndef __HOMEBUS_H
 #define __HOMEBUS_H
 
-void HomebusInit(uint32_t Baudrate);
+//Line codes
+#define HB_LINE_ENCODED 0    //!< every byte is sent as two bytes (at least one 1-bit after each 0-bit)
+#define HB_LINE_RAW     1    //!< plain UART data (no encoding)
+
+void HomebusInit(uint32_t Baudrate, uint8_t LineCode);
 uint8_t HomebusGetData(uint8_t *data);
 void HomebusSendData(uint8_t *data);
+uint8_t HomebusSendBusy(void);
+uint32_t GetHomebusOverrunCount(void);
 
 #endif
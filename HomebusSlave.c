@@ -28,7 +28,13 @@
 #include "TMC5130.h"
 #include "MAX31875.h"
 #include "RefSearch.h"
+#include "Homebus.h"
 #include "TMCL.h"
+#include "LinkTest.h"
+#include "GlobalParameters.h"
+#include "Events.h"
+#include "MotionQueue.h"
+#include "PVT.h"
 
 const char VersionString[]="0026V100";  //<! Version information for the TMCL-IDE
 gpio_cfg_t led_out;               //<! Output for LED
@@ -39,6 +45,78 @@ sys_cfg_spimss_t SPICfg={MAP_A};  //<! SPI MSS interface mappinmg
 uint32_t Delay;                   //<! used for delays
 uint8_t ActualAxis;               //<! Actual axis being processed
 uint8_t StopOnStallState[N_O_MOTORS];
+uint32_t LastRefSearchState[N_O_MOTORS];   //<! used for detecting the end of a reference search
+uint8_t TemperatureLimitExceeded;          //<! TRUE while the temperature is above the limit
+uint8_t LastSPIStatus[N_O_MOTORS];         //<! SPI status byte at the last RAMPSTAT read
+uint32_t LastRampStatTime[N_O_MOTORS];     //<! time of the last RAMPSTAT read
+uint32_t LastTransferCount[N_O_MOTORS];    //<! SPI transfer count after the last RAMPSTAT read
+volatile uint8_t DiagEvents[N_O_MOTORS];   //<! DIAG pin events latched by the GPIO interrupt (DIAG_EVENT_xxx)
+volatile uint32_t DiagInterruptCount;      //<! number of DIAG pin interrupts
+uint32_t PollCount;                        //<! RAMPSTAT reads in the actual second
+uint32_t PollRate;                         //<! RAMPSTAT reads in the last second
+uint32_t LoopCount;                        //<! main loop passes in the actual second
+uint32_t LoopRate;                         //<! main loop passes in the last second
+
+#define DIAG_EVENT_ERROR  0x01   //<! DIAG0: driver error or reset
+#define DIAG_EVENT_STALL  0x02   //<! DIAG1: motor stall
+
+
+/***************************************************************//**
+   \fn DiagInterrupt(void *cbdata)
+   \brief Callback for the DIAG pin interrupts
+   \param cbdata: DIAG_EVENT_xxx bit of the pin
+
+   Only latches the event. It is handled by ProcessStallGuard().
+   With several TMC5130 their open drain DIAG outputs are wired
+   together, so the event is latched for all axes.
+********************************************************************/
+static void DiagInterrupt(void *cbdata)
+{
+  uint32_t i;
+
+  for(i=0; i<N_O_MOTORS; i++) DiagEvents[i]|=(uint32_t) cbdata;
+  DiagInterruptCount++;
+}
+
+
+/***************************************************************//**
+   \fn GPIO0_IRQHandler(void)
+   \brief GPIO port 0 interrupt handler (DIAG0 and DIAG1 pins)
+********************************************************************/
+void GPIO0_IRQHandler(void)
+{
+  GPIO_Handler(PORT_0);
+}
+
+
+/***************************************************************//**
+   \fn GetDiagInterruptCount(void)
+   \return Number of DIAG pin interrupts since reset
+********************************************************************/
+uint32_t GetDiagInterruptCount(void)
+{
+  return DiagInterruptCount;
+}
+
+
+/***************************************************************//**
+   \fn GetPollRate(void)
+   \return Number of RAMPSTAT reads (all axes) in the last second
+********************************************************************/
+uint32_t GetPollRate(void)
+{
+  return PollRate;
+}
+
+
+/***************************************************************//**
+   \fn GetLoopRate(void)
+   \return Number of main loop passes in the last second
+********************************************************************/
+uint32_t GetLoopRate(void)
+{
+  return LoopRate;
+}
 
 
 /***************************************************************//**
@@ -66,6 +144,18 @@ void InitIO(void)
   diag1_in.pad = GPIO_PAD_PULL_UP;
   diag1_in.func = GPIO_FUNC_IN;
   GPIO_Config(&diag1_in);
+
+  //The DIAG outputs of the TMC5130 are open drain and active low
+  //(see TMC5130_GCONF_DIAG_SETTING).
+  GPIO_RegisterCallback(&diag0_in, DiagInterrupt, (void *) DIAG_EVENT_ERROR);
+  GPIO_RegisterCallback(&diag1_in, DiagInterrupt, (void *) DIAG_EVENT_STALL);
+  GPIO_IntConfig(&diag0_in, GPIO_INT_EDGE, GPIO_INT_FALLING);
+  GPIO_IntConfig(&diag1_in, GPIO_INT_EDGE, GPIO_INT_FALLING);
+  GPIO_IntClr(&diag0_in);
+  GPIO_IntClr(&diag1_in);
+  GPIO_IntEnable(&diag0_in);
+  GPIO_IntEnable(&diag1_in);
+  NVIC_EnableIRQ(GPIO0_IRQn);
 }
 
 
@@ -77,7 +167,8 @@ void InitIO(void)
 ********************************************************************/
 void InitSPI(void)
 {
-  SPIMSS_Init(MXC_SPIMSS, 3, 1000000, &SPICfg);
+  SPIMSS_Init(MXC_SPIMSS, 3, TMC5130_SPI_FREQUENCY, &SPICfg);
+  NVIC_EnableIRQ(SPIMSS_IRQn);  //for PostTMC5130Write()
 }
 
 
@@ -94,28 +185,52 @@ void InitI2C(void)
 
 
 /***************************************************************//**
-   \fn ProcessStallGuard()
-   \brief StallGuard functionality
+   \fn ProcessRampStatus()
+   \brief Read and evaluate RAMPSTAT of the actual axis
 
-   Do what is necessary for the StallGuard functionality. Must be
-   called regularly.
+   Handles the StallGuard stop and the event flags and starts the
+   next queued move.
 ********************************************************************/
-void ProcessStallGuard(void)
+static void ProcessRampStatus(void)
 {
+  static const uint8_t StatusRegisters[2]={TMC5130_RAMPSTAT, TMC5130_VACTUAL};
+  int StatusValues[2];
   uint32_t RampStat;
+  int VActual;
 
-  RampStat=ReadTMC5130Int(ActualAxis, TMC5130_RAMPSTAT);
+  //Read RAMPSTAT and (only if needed) VACTUAL with pipelined accesses
+  if(StallVMin[ActualAxis]>0 || StopOnStallState[ActualAxis])
+  {
+    ReadTMC5130Multiple(WHICH_5130(ActualAxis), StatusRegisters, StatusValues, 2);
+    VActual=StatusValues[1];
+  }
+  else
+  {
+    ReadTMC5130Multiple(WHICH_5130(ActualAxis), StatusRegisters, StatusValues, 1);
+    VActual=0;
+  }
+  RampStat=StatusValues[0];
+  RampStatCache[ActualAxis]=RampStat;
+  RampStatValid[ActualAxis]=TRUE;
 
   //Final stop after stall event
   if(RampStat & TMC5130_RS_EV_STOP_SG)
   {
     HardStop(ActualAxis);
+    ClearMotionQueue(ActualAxis);
+    StopPVT(ActualAxis);
     WriteTMC5130Int(WHICH_5130(ActualAxis), TMC5130_SWMODE, ReadTMC5130Int(WHICH_5130(ActualAxis), TMC5130_SWMODE) & ~TMC5130_SW_SG_STOP);
     StallFlag[ActualAxis]=TRUE;
+    SignalEvent(EV_AXIS(EV_STALL, ActualAxis));
   }
 
+  if(RampStat & TMC5130_RS_EV_POSREACHED) SignalEvent(EV_AXIS(EV_POS_REACHED, ActualAxis));
+
+  //Start the next queued move
+  ProcessMotionQueue(ActualAxis, RampStat);
+
   //Switch StallGuard on and off depending on the actual velocity
-  if(StallVMin[ActualAxis]>0 && abs(ReadTMC5130Int(ActualAxis, TMC5130_VACTUAL))>StallVMin[ActualAxis])
+  if(StallVMin[ActualAxis]>0 && abs(VActual)>StallVMin[ActualAxis])
   {
     if(!StopOnStallState[ActualAxis])
     {
@@ -127,7 +242,7 @@ void ProcessStallGuard(void)
   {
     if(StopOnStallState[ActualAxis])
     {
-      if(ReadTMC5130Int(WHICH_5130(ActualAxis), TMC5130_VMAX)==0 || abs(ReadTMC5130Int(WHICH_5130(ActualAxis), TMC5130_VACTUAL))>0)
+      if(ReadTMC5130Int(WHICH_5130(ActualAxis), TMC5130_VMAX)==0 || VActual!=0)
       {
         WriteTMC5130Int(ActualAxis, TMC5130_SWMODE, ReadTMC5130Int(ActualAxis, TMC5130_SWMODE) & ~TMC5130_SW_SG_STOP);
       }
@@ -140,8 +255,103 @@ void ProcessStallGuard(void)
     WriteTMC5130Int(WHICH_5130(ActualAxis), TMC5130_RAMPSTAT, TMC5130_RS_EV_POSREACHED);
   if(RampStat & TMC5130_RS_EV_STOP_SG)
     WriteTMC5130Int(WHICH_5130(ActualAxis), TMC5130_RAMPSTAT, TMC5130_RS_EV_STOP_SG);
+}
+
+
+/***************************************************************//**
+   \fn GetPollInterval()
+   \brief Select the RAMPSTAT read interval of the actual axis
+   \return Interval (ms)
+
+   Reference search, StallGuard switching and the motion queue need
+   the fast rate (GP_POLL_FAST). When the motor has been at standstill
+   at the last RAMPSTAT read and no datagram has been sent since then,
+   nothing can change without a DIAG pin becoming active (stall,
+   driver error, reset), so the slow rate (GP_POLL_IDLE) is enough
+   (e.g. for the stop switches). Otherwise GP_POLL_MOVING is used.
+********************************************************************/
+static uint32_t GetPollInterval(void)
+{
+  uint8_t Standstill;
+
+  Standstill=(LastSPIStatus[ActualAxis] & TMC5130_SPI_STANDSTILL)!=0;
+
+  if(GetRefSearchState(ActualAxis)!=0 || StopOnStallState[ActualAxis] ||
+     GetMotionQueueLevel(ActualAxis)>0 || (StallVMin[ActualAxis]>0 && !Standstill))
+    return GetPollIntervalFast();
+
+  if(Standstill && GetTMC5130TransferCount()==LastTransferCount[ActualAxis] &&
+     GPIO_InGet(&diag0_in) && GPIO_InGet(&diag1_in))
+    return GetPollIntervalIdle();
+
+  return GetPollIntervalMoving();
+}
+
+
+/***************************************************************//**
+   \fn RampStatusUnchanged()
+   \brief Check if RAMPSTAT of the actual axis has to be read
+   \return TRUE if reading RAMPSTAT can be skipped
+
+   This is the case when the interval selected by GetPollInterval()
+   has not elapsed yet, no WAIT command needs a new value, nothing
+   has been written to the driver since its last status byte and the
+   SPI status byte of a recent datagram (not older than
+   TMC5130_STATUS_MAX_AGE) is the same as at the last RAMPSTAT read.
+   The event flags of RAMPSTAT stay set, so they are only seen a bit
+   later.
+********************************************************************/
+static uint8_t RampStatusUnchanged(void)
+{
+  uint8_t Status;
+
+  if(!RampStatValid[ActualAxis]) return FALSE;
+  if(GetSysTimer()-LastRampStatTime[ActualAxis]>=GetPollInterval()) return FALSE;
+
+  //Written since the last status byte (e.g. new target): status unknown
+  if(!GetTMC5130SPIStatus(WHICH_5130(ActualAxis), UINT32_MAX, &Status)) return FALSE;
+
+  if(GetTMC5130SPIStatus(WHICH_5130(ActualAxis), TMC5130_STATUS_MAX_AGE, &Status))
+    return Status==LastSPIStatus[ActualAxis];
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn ProcessStallGuard()
+   \brief StallGuard functionality
+
+   Do what is necessary for the StallGuard functionality. Must be
+   called regularly.
+********************************************************************/
+void ProcessStallGuard(void)
+{
+  uint8_t Events;
+
+  //Take the events latched by the DIAG pin interrupt
+  __disable_irq();
+  Events=DiagEvents[ActualAxis];
+  DiagEvents[ActualAxis]=0;
+  __enable_irq();
+
+  //Driver error or reset: check the registers at once
+  if((Events & DIAG_EVENT_ERROR) && GetShadowVerify())
+    VerifyTMC5130Registers(WHICH_5130(ActualAxis));
+
+  if(Events!=0 || !RampStatusUnchanged())
+  {
+    ProcessRampStatus();
+    GetTMC5130SPIStatus(WHICH_5130(ActualAxis), UINT32_MAX, &LastSPIStatus[ActualAxis]);
+    LastRampStatTime[ActualAxis]=GetSysTimer();
+    LastTransferCount[ActualAxis]=GetTMC5130TransferCount();
+    PollCount++;
+  }
 
   ProcessRefSearch(ActualAxis);
+  if(LastRefSearchState[ActualAxis]!=0 && GetRefSearchState(ActualAxis)==0)
+    SignalEvent(EV_AXIS(EV_RFS_DONE, ActualAxis));
+  LastRefSearchState[ActualAxis]=GetRefSearchState(ActualAxis);
 
   //Next axis
   ActualAxis++;
@@ -152,14 +362,17 @@ void ProcessStallGuard(void)
 //Main program
 void main()
 {
+  uint32_t i;
+
   InitSysTick();
   InitIO();
   InitSPI();
   InitMotorDrivers();
   InitI2C();
   InitMAX31875();
-  HomebusInit(230400);
   InitTMCL();
+  InitPVT();
+  HomebusInit(GetHomebusBaudrate(), GetHomebusLineCode());
 
   GPIO_OutClr(&enable_out);
 
@@ -169,9 +382,36 @@ void main()
     if(abs(GetSysTimer()-Delay)>1000)
     {
       Delay=GetSysTimer();
+
+      //Achieved polling rates
+      PollRate=PollCount;
+      PollCount=0;
+      LoopRate=LoopCount;
+      LoopCount=0;
+
+      //Temperature limit event (only checked when enabled)
+      if(GetEventMask() & EV_TEMPERATURE)
+      {
+        if(GetTemperature()>GetTemperatureLimit())
+        {
+          if(!TemperatureLimitExceeded) SignalEvent(EV_TEMPERATURE);
+          TemperatureLimitExceeded=TRUE;
+        }
+        else TemperatureLimitExceeded=FALSE;
+      }
+
+      //Detect a reset of the motor driver and restore its registers
+      if(GetShadowVerify())
+      {
+        for(i=0; i<N_O_MOTORS; i++) VerifyTMC5130Registers(WHICH_5130(i));
+      }
     }
 
     ProcessCommand();
+    ProcessTMCLProgram();
+    ProcessPVT();
     ProcessStallGuard();
+    ProcessLinkTest();
+    LoopCount++;
   }
 }
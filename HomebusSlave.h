@@ -27,7 +27,19 @@
 
 #define WHICH_5130(a) (a)
 
+//Number of axes. Each axis has its own TMC5130, all TMC5130 are connected
+//in one SPI daisy chain (can be set by e.g. -DN_O_MOTORS=2).
+#ifndef N_O_MOTORS
 #define N_O_MOTORS 1
-#define N_O_DRIVERS 1
+#endif
+#define N_O_DRIVERS N_O_MOTORS
+
+#if N_O_MOTORS<1 || N_O_MOTORS>7
+#error "N_O_MOTORS must be 1..7"   //MVP COORD selects the axes with bits 0..6
+#endif
+
+uint32_t GetDiagInterruptCount(void);
+uint32_t GetPollRate(void);
+uint32_t GetLoopRate(void);
 
 #endif
@@ -0,0 +1,302 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file LinkTest.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: LinkTest.c
+ *         Description: Homebus link characterisation (loopback test)
+ *
+ *                      In loopback mode the master sends pattern frames
+ *                      (TMCL_LinkTest, type LT_PATTERN) with an 8 bit
+ *                      sequence number in the motor byte and a 32 bit
+ *                      pattern in the value field. The node echoes each
+ *                      pattern back in its reply and compares it with the
+ *                      expected pattern. The expected patterns are generated
+ *                      by a 32 bit xorshift generator (x^=x<<13; x^=x>>17;
+ *                      x^=x<<5) started with the seed sent with LT_START,
+ *                      so the master has to use the same generator.
+ *                      A sequence number up to 127 ahead of the expected
+ *                      one counts the frames in between as lost; a
+ *                      sequence number behind the expected one (repeated
+ *                      or late frame) is counted as out of order and not
+ *                      checked, the expected sequence is kept.
+ *                      The round trip time is measured from handing over
+ *                      a reply to the UART until the next pattern frame
+ *                      has been received.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include "max32660.h"
+#include "SysTick.h"
+#include "LinkTest.h"
+
+#define LINKTEST_DEFAULT_SEED 0x2545f491    //!< used when the master sends zero as seed
+
+static uint8_t LinkTestIsActive;        //!< TRUE while loopback mode is active
+static uint32_t ExpectedPattern;        //!< next expected pattern
+static uint8_t ExpectedSequence;        //!< next expected sequence number
+static uint32_t FrameCount;             //!< number of pattern frames received
+static uint32_t BadFrameCount;          //!< number of pattern frames with wrong pattern
+static uint32_t BitErrorCount;          //!< number of wrong bits
+static uint32_t LostFrameCount;         //!< number of lost frames
+static uint32_t OutOfOrderCount;        //!< number of repeated or late frames
+static uint32_t ChecksumErrorCount;     //!< number of frames with checksum error
+static uint32_t RTTMin;                 //!< minimum round trip time (cycles)
+static uint32_t RTTMax;                 //!< maximum round trip time (cycles)
+static uint64_t RTTSum;                 //!< sum of all round trip times (cycles)
+static uint32_t RTTCount;               //!< number of round trip time measurements
+static uint32_t ReplySentCycles;        //!< cycle counter value when the last reply has been sent
+static uint8_t ReplySentValid;          //!< TRUE when ReplySentCycles is valid
+static uint32_t LastFrameTime;          //!< time (ms) of the last pattern frame
+
+
+/***************************************************************//**
+   \fn NextPattern(uint32_t Pattern)
+   \brief Pattern generator
+   \param Pattern: actual pattern
+   \return Next pattern
+
+   32 bit xorshift pseudo random generator used for generating
+   the test patterns.
+********************************************************************/
+static uint32_t NextPattern(uint32_t Pattern)
+{
+  Pattern^=Pattern << 13;
+  Pattern^=Pattern >> 17;
+  Pattern^=Pattern << 5;
+
+  return Pattern;
+}
+
+
+/***************************************************************//**
+   \fn StartLinkTest(uint32_t Seed)
+   \brief Start loopback mode
+   \param Seed: start value of the pattern generator (0 => default)
+
+   Reset all results and switch on the loopback mode.
+********************************************************************/
+void StartLinkTest(uint32_t Seed)
+{
+  ExpectedPattern=(Seed!=0) ? Seed : LINKTEST_DEFAULT_SEED;
+  ExpectedSequence=0;
+  FrameCount=0;
+  BadFrameCount=0;
+  BitErrorCount=0;
+  LostFrameCount=0;
+  OutOfOrderCount=0;
+  ChecksumErrorCount=0;
+  RTTMin=0xffffffff;
+  RTTMax=0;
+  RTTSum=0;
+  RTTCount=0;
+  ReplySentValid=FALSE;
+  LastFrameTime=GetSysTimer();
+  LinkTestIsActive=TRUE;
+}
+
+
+/***************************************************************//**
+   \fn StopLinkTest(void)
+   \brief Stop loopback mode
+
+   Switch off the loopback mode. The results are kept.
+********************************************************************/
+void StopLinkTest(void)
+{
+  LinkTestIsActive=FALSE;
+  ReplySentValid=FALSE;
+}
+
+
+/***************************************************************//**
+   \fn LinkTestActive(void)
+   \return TRUE if loopback mode is active.
+
+   Check if the loopback mode is active.
+********************************************************************/
+uint8_t LinkTestActive(void)
+{
+  return LinkTestIsActive;
+}
+
+
+/***************************************************************//**
+   \fn LinkTestPattern(uint8_t Sequence, uint32_t Pattern)
+   \brief Process a pattern frame
+   \param Sequence: sequence number sent by the master
+   \param Pattern: pattern sent by the master
+   \return TRUE if the pattern was correct (or has not been checked
+           because the frame was out of order).
+
+   Check a received pattern frame and update the statistics.
+   Must only be called when loopback mode is active.
+********************************************************************/
+uint8_t LinkTestPattern(uint8_t Sequence, uint32_t Pattern)
+{
+  uint32_t Cycles;
+  uint32_t Diff;
+  uint8_t Gap;
+
+  Cycles=GetCycleCounter();
+  LastFrameTime=GetSysTimer();
+
+  //Round trip time: last reply sent => this frame received
+  if(ReplySentValid)
+  {
+    Cycles-=ReplySentCycles;
+    if(Cycles<RTTMin) RTTMin=Cycles;
+    if(Cycles>RTTMax) RTTMax=Cycles;
+    RTTSum+=Cycles;
+    RTTCount++;
+    ReplySentValid=FALSE;
+  }
+
+  //Sequence number behind the expected one (modulo 256): repeated or
+  //late frame. Its pattern is not known any more, so it is only counted.
+  Gap=Sequence-ExpectedSequence;
+  if(Gap>=0x80)
+  {
+    OutOfOrderCount++;
+    return TRUE;
+  }
+
+  //Lost frames: skip the generator forward to the received sequence number
+  while(Gap>0)
+  {
+    ExpectedPattern=NextPattern(ExpectedPattern);
+    ExpectedSequence++;
+    LostFrameCount++;
+    Gap--;
+  }
+
+  FrameCount++;
+  Diff=Pattern^ExpectedPattern;
+  if(Diff!=0)
+  {
+    BadFrameCount++;
+    BitErrorCount+=__builtin_popcount(Diff);
+  }
+
+  ExpectedPattern=NextPattern(ExpectedPattern);
+  ExpectedSequence++;
+
+  if(FrameCount>=LINKTEST_MAX_FRAMES) LinkTestIsActive=FALSE;
+
+  return Diff==0;
+}
+
+
+/***************************************************************//**
+   \fn LinkTestReplySent(void)
+   \brief Start round trip time measurement
+
+   Has to be called right after the reply to a pattern frame has
+   been handed over to the Homebus interface.
+********************************************************************/
+void LinkTestReplySent(void)
+{
+  if(LinkTestIsActive)
+  {
+    ReplySentCycles=GetCycleCounter();
+    ReplySentValid=TRUE;
+  }
+}
+
+
+/***************************************************************//**
+   \fn LinkTestChecksumError(void)
+   \brief Count a checksum error
+
+   Has to be called when a frame with wrong checksum has been
+   received.
+********************************************************************/
+void LinkTestChecksumError(void)
+{
+  if(LinkTestIsActive)
+  {
+    ChecksumErrorCount++;
+    ReplySentValid=FALSE;
+  }
+}
+
+
+/***************************************************************//**
+   \fn GetLinkTestResult(uint8_t Index, uint32_t *Result)
+   \brief Read a link test result
+   \param Index: result index (LTR_xxx)
+   \param Result: pointer to variable for the result
+   \return TRUE if the index is valid.
+
+   Read a result of the last (or actual) link test.
+********************************************************************/
+uint8_t GetLinkTestResult(uint8_t Index, uint32_t *Result)
+{
+  switch(Index)
+  {
+    case LTR_FRAMES:
+      *Result=FrameCount;
+      break;
+
+    case LTR_BAD_FRAMES:
+      *Result=BadFrameCount;
+      break;
+
+    case LTR_BIT_ERRORS:
+      *Result=BitErrorCount;
+      break;
+
+    case LTR_LOST_FRAMES:
+      *Result=LostFrameCount;
+      break;
+
+    case LTR_CHKERR:
+      *Result=ChecksumErrorCount;
+      break;
+
+    case LTR_RTT_MIN:
+      *Result=(RTTCount>0) ? RTTMin : 0;
+      break;
+
+    case LTR_RTT_MAX:
+      *Result=RTTMax;
+      break;
+
+    case LTR_RTT_AVG:
+      *Result=(RTTCount>0) ? (uint32_t) (RTTSum/RTTCount) : 0;
+      break;
+
+    case LTR_ACTIVE:
+      *Result=LinkTestIsActive;
+      break;
+
+    case LTR_OUT_OF_ORDER:
+      *Result=OutOfOrderCount;
+      break;
+
+    default:
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn ProcessLinkTest(void)
+   \brief Loopback mode timeout
+
+   Switch off the loopback mode when no pattern frame has been
+   received for LINKTEST_TIMEOUT ms. Must be called regularly.
+********************************************************************/
+void ProcessLinkTest(void)
+{
+  if(LinkTestIsActive && GetSysTimer()-LastFrameTime>LINKTEST_TIMEOUT)
+    StopLinkTest();
+}
@@ -0,0 +1,50 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file LinkTest.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: LinkTest.h
+ *         Description: Homebus link characterisation (loopback test)
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __LINK_TEST_H
+#define __LINK_TEST_H
+
+//Type codes of the link test command
+#define LT_START    0     //!< start loopback mode (value: pattern seed)
+#define LT_PATTERN  1     //!< pattern frame (motor: sequence number, value: pattern)
+#define LT_STOP     2     //!< stop loopback mode
+#define LT_RESULT   3     //!< read result (motor: result index, see LTR_xxx)
+
+//Result indices (motor parameter of LT_RESULT)
+#define LTR_FRAMES       0   //!< number of pattern frames received
+#define LTR_BAD_FRAMES   1   //!< number of pattern frames with wrong pattern
+#define LTR_BIT_ERRORS   2   //!< number of wrong bits in all pattern frames
+#define LTR_LOST_FRAMES  3   //!< number of lost frames (gaps in the sequence numbers)
+#define LTR_CHKERR       4   //!< number of frames with checksum error
+#define LTR_RTT_MIN      5   //!< minimum round trip time (CPU cycles)
+#define LTR_RTT_MAX      6   //!< maximum round trip time (CPU cycles)
+#define LTR_RTT_AVG      7   //!< average round trip time (CPU cycles)
+#define LTR_ACTIVE       8   //!< 1 if loopback mode is active
+#define LTR_OUT_OF_ORDER 9   //!< number of repeated or late pattern frames (sequence number behind)
+
+#define LINKTEST_MAX_FRAMES   100000   //!< loopback mode ends after this number of pattern frames
+#define LINKTEST_TIMEOUT      2000     //!< loopback mode ends after this time (ms) without pattern frame
+
+void StartLinkTest(uint32_t Seed);
+void StopLinkTest(void);
+uint8_t LinkTestActive(void);
+uint8_t LinkTestPattern(uint8_t Sequence, uint32_t Pattern);
+void LinkTestReplySent(void);
+void LinkTestChecksumError(void);
+uint8_t GetLinkTestResult(uint8_t Index, uint32_t *Result);
+void ProcessLinkTest(void);
+
+#endif
@@ -0,0 +1,227 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file MotionQueue.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: MotionQueue.c
+ *         Description: Queue of positioning moves (executed back-to-back)
+ *
+ *                      Moves are queued with MVP type 3 (target position,
+ *                      together with the actual VMAX and AMAX settings).
+ *                      The last move of a sequence is queued with MVP
+ *                      type 4, which closes the sequence.
+ *                      The next move is started as soon as the actual one
+ *                      has reached its target, so there is no gap caused
+ *                      by polling over the bus. With a blend distance set
+ *                      the next target is already written when the motor
+ *                      is closer than the blend distance to the actual
+ *                      target, so the motor does not stop in between.
+ *                      If the queue runs empty before the sequence has
+ *                      been closed (the master has not sent the next
+ *                      move in time), this is counted as an underrun.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include "max32660.h"
+#include "HomebusSlave.h"
+#include "Globals.h"
+#include "TMC5130.h"
+#include "MotionQueue.h"
+
+//! Queued positioning move
+typedef struct
+{
+  int Target;       //!< target position
+  uint32_t VMax;    //!< maximum velocity (TMC5130 unit)
+  int AMax;         //!< maximum acceleration (TMC5130 unit)
+  uint8_t Last;     //!< TRUE: last move of a sequence
+} TQueuedMove;
+
+static TQueuedMove Queue[N_O_MOTORS][MQ_DEPTH];  //!< queued moves (ring buffer)
+static uint8_t QueueHead[N_O_MOTORS];            //!< index of the next move
+static uint8_t QueueLevel[N_O_MOTORS];           //!< number of queued moves
+static uint8_t QueueActive[N_O_MOTORS];          //!< TRUE while a move from the queue is executed
+static int ActiveTarget[N_O_MOTORS];             //!< target of the move being executed
+static uint8_t ActiveLast[N_O_MOTORS];           //!< TRUE: the move being executed closes the sequence
+static uint32_t Underruns[N_O_MOTORS];           //!< number of times the queue has run empty within a sequence
+static uint32_t BlendDistance[N_O_MOTORS];       //!< blend distance (0: stop between the moves)
+
+
+/***************************************************************//**
+   \fn StartNextMove(uint8_t Motor)
+   \brief Start the next move from the queue
+   \param Motor: axis number
+
+   The queue must not be empty.
+********************************************************************/
+static void StartNextMove(uint8_t Motor)
+{
+  TQueuedMove *Move;
+
+  Move=&Queue[Motor][QueueHead[Motor]];
+  QueueHead[Motor]=(QueueHead[Motor]+1) % MQ_DEPTH;
+  QueueLevel[Motor]--;
+
+  //The deferred writes are sent before RAMPMODE (in this order).
+  WriteTMC5130Deferred(WHICH_5130(Motor), TMC5130_VMAX, Move->VMax);
+  WriteTMC5130Deferred(WHICH_5130(Motor), TMC5130_AMAX, Move->AMax);
+  WriteTMC5130Deferred(WHICH_5130(Motor), TMC5130_XTARGET, Move->Target);
+  PostTMC5130Write(WHICH_5130(Motor), TMC5130_RAMPMODE, TMC5130_MODE_POSITION);
+
+  //The next MVP command has to write VMax and AMax again.
+  VMaxModified[Motor]=TRUE;
+  AMaxModified[Motor]=TRUE;
+  StallFlag[Motor]=FALSE;
+
+  ActiveTarget[Motor]=Move->Target;
+  ActiveLast[Motor]=Move->Last;
+  QueueActive[Motor]=TRUE;
+}
+
+
+/***************************************************************//**
+   \fn EnqueueMove(uint8_t Motor, int Target, uint8_t Last)
+   \brief Add a move to the queue
+   \param Motor: axis number
+   \param Target: target position
+   \param Last: TRUE for the last move of a sequence
+   \return FALSE if the queue is full
+
+   The actual settings of VMax and AMax (axis parameters 4 and 5)
+   are used for the move. If no queued move is being executed the
+   move is started immediately.
+********************************************************************/
+uint8_t EnqueueMove(uint8_t Motor, int Target, uint8_t Last)
+{
+  TQueuedMove *Move;
+
+  if(QueueLevel[Motor]>=MQ_DEPTH) return FALSE;
+
+  Move=&Queue[Motor][(QueueHead[Motor]+QueueLevel[Motor]) % MQ_DEPTH];
+  Move->Target=Target;
+  Move->VMax=VMax[Motor];
+  Move->AMax=AMax[Motor];
+  Move->Last=Last;
+  QueueLevel[Motor]++;
+
+  if(!QueueActive[Motor]) StartNextMove(Motor);
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn ClearMotionQueue(uint8_t Motor)
+   \brief Delete all queued moves
+   \param Motor: axis number
+
+   Has to be called by all commands that start a different kind of
+   motion or stop the motor. The move being executed is not stopped.
+********************************************************************/
+void ClearMotionQueue(uint8_t Motor)
+{
+  QueueLevel[Motor]=0;
+  QueueActive[Motor]=FALSE;
+}
+
+
+/***************************************************************//**
+   \fn ProcessMotionQueue(uint8_t Motor, uint32_t RampStat)
+   \brief Advance the motion queue
+   \param Motor: axis number
+   \param RampStat: actual value of the RAMPSTAT register
+
+   Start the next move when the actual one has reached its target
+   or has come closer than the blend distance. Called by
+   ProcessStallGuard() with the RAMPSTAT value read there.
+   The position_reached status bit is used instead of the event bit
+   because the event bit might still be set from a move that has
+   ended before the queued move has been started.
+********************************************************************/
+void ProcessMotionQueue(uint8_t Motor, uint32_t RampStat)
+{
+  if(!QueueActive[Motor]) return;
+
+  if(RampStat & TMC5130_RS_POSREACHED)
+  {
+    if(QueueLevel[Motor]>0)
+    {
+      StartNextMove(Motor);
+    }
+    else
+    {
+      QueueActive[Motor]=FALSE;
+      if(!ActiveLast[Motor]) Underruns[Motor]++;
+    }
+  }
+  else if(QueueLevel[Motor]>0 && BlendDistance[Motor]>0)
+  {
+    if((uint32_t) abs(ActiveTarget[Motor]-ReadTMC5130Int(WHICH_5130(Motor), TMC5130_XACTUAL))<=BlendDistance[Motor])
+      StartNextMove(Motor);
+  }
+}
+
+
+/***************************************************************//**
+   \fn GetMotionQueueLevel(uint8_t Motor)
+   \param Motor: axis number
+   \return Number of queued moves (not including the move being executed)
+********************************************************************/
+uint32_t GetMotionQueueLevel(uint8_t Motor)
+{
+  return QueueLevel[Motor];
+}
+
+
+/***************************************************************//**
+   \fn GetMotionQueueUnderruns(uint8_t Motor)
+   \param Motor: axis number
+   \return Number of times the queue has run empty within a sequence,
+           that is the motor has stopped at the end of a queued move
+           because there was no next move and the move had not been
+           queued as the last one (MVP type 4).
+********************************************************************/
+uint32_t GetMotionQueueUnderruns(uint8_t Motor)
+{
+  return Underruns[Motor];
+}
+
+
+/***************************************************************//**
+   \fn ResetMotionQueueUnderruns(uint8_t Motor)
+   \param Motor: axis number
+   \brief Reset the underrun counter
+********************************************************************/
+void ResetMotionQueueUnderruns(uint8_t Motor)
+{
+  Underruns[Motor]=0;
+}
+
+
+/***************************************************************//**
+   \fn SetMotionQueueBlendDistance(uint8_t Motor, uint32_t Distance)
+   \param Motor: axis number
+   \param Distance: blend distance in microsteps (0: no blending)
+   \brief Set the blend distance
+********************************************************************/
+void SetMotionQueueBlendDistance(uint8_t Motor, uint32_t Distance)
+{
+  BlendDistance[Motor]=Distance;
+}
+
+
+/***************************************************************//**
+   \fn GetMotionQueueBlendDistance(uint8_t Motor)
+   \param Motor: axis number
+   \return Blend distance in microsteps
+********************************************************************/
+uint32_t GetMotionQueueBlendDistance(uint8_t Motor)
+{
+  return BlendDistance[Motor];
+}
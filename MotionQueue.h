@@ -0,0 +1,31 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file MotionQueue.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: MotionQueue.h
+ *         Description: Queue of positioning moves (executed back-to-back)
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __MOTION_QUEUE_H
+#define __MOTION_QUEUE_H
+
+#define MQ_DEPTH 16    //!< number of moves that can be queued per axis
+
+uint8_t EnqueueMove(uint8_t Motor, int Target, uint8_t Last);
+void ClearMotionQueue(uint8_t Motor);
+void ProcessMotionQueue(uint8_t Motor, uint32_t RampStat);
+uint32_t GetMotionQueueLevel(uint8_t Motor);
+uint32_t GetMotionQueueUnderruns(uint8_t Motor);
+void ResetMotionQueueUnderruns(uint8_t Motor);
+void SetMotionQueueBlendDistance(uint8_t Motor, uint32_t Distance);
+uint32_t GetMotionQueueBlendDistance(uint8_t Motor);
+
+#endif
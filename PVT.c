@@ -0,0 +1,450 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file PVT.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: PVT.c
+ *         Description: Position-velocity-time (PVT) streaming mode
+ *
+ *                      The master streams trajectory points (position,
+ *                      velocity at that position, duration of the
+ *                      segment leading to it) into a ring buffer. The
+ *                      trajectory between two points is a cubic Hermite
+ *                      spline. The TMC5130 runs in velocity mode: every
+ *                      PVT_PERIOD_MS (timed by TMR0) VMAX and the
+ *                      direction are set to the velocity of the
+ *                      trajectory one period ahead plus a correction
+ *                      of the position error (XACTUAL against the
+ *                      trajectory), which is removed within
+ *                      PVT_CORRECTION_MS. In velocity mode the ramp
+ *                      generator only uses AMAX (axis parameter 5), so
+ *                      the acceleration of the trajectory must not be
+ *                      higher. At the end of the trajectory the motor
+ *                      is switched to positioning mode for the last
+ *                      steps.
+ *
+ *                      (Positioning mode with XTARGET set a period ahead
+ *                      does not work: the ramp generator always brakes
+ *                      towards the near target with DMAX and falls
+ *                      behind by about v^2/(2*DMAX).)
+ *
+ *                      sim/PVTSim.c runs this file against a model of
+ *                      the ramp generator and reports the tracking error.
+ *
+ *                      The timer interrupt only counts; the SPI accesses
+ *                      are done by ProcessPVT() from the main loop, so
+ *                      they cannot collide with other TMC5130 accesses.
+ *
+ *                      If the buffer runs empty while the motor is still
+ *                      moving (underrun) the motor is stopped with AMAX.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include "max32660.h"
+#include "tmr.h"
+#include "HomebusSlave.h"
+#include "Globals.h"
+#include "TMC5130.h"
+#include "PVT.h"
+
+#define PVT_DEFAULT_DURATION  10    //!< default segment duration (ms)
+#define PVT_CORRECTION_MS     20    //!< time in which a position error is corrected (ms)
+#define PVT_MAX_ERROR     100000    //!< limit of the position error used for the correction (microsteps)
+
+//! Trajectory point
+typedef struct
+{
+  int Position;       //!< position (microsteps)
+  int Velocity;       //!< velocity at this position (pps)
+  uint16_t Duration;  //!< time from the previous point to this point (ms)
+} TPVTPoint;
+
+static volatile uint32_t PVTTickCounter;                  //!< incremented every PVT_PERIOD_MS by TMR0
+static uint32_t LastTick;                                 //!< value of PVTTickCounter at the last update
+
+static TPVTPoint Buffer[N_O_MOTORS][PVT_BUFFER_SIZE];     //!< buffered points (ring buffer)
+static uint8_t BufferHead[N_O_MOTORS];                    //!< index of the next point
+static uint8_t BufferLevel[N_O_MOTORS];                   //!< number of buffered points
+static uint8_t State[N_O_MOTORS];                         //!< PVT_IDLE, PVT_RUNNING or PVT_UNDERRUN
+static TPVTPoint Segment[N_O_MOTORS];                     //!< end point of the actual segment
+static int StartPosition[N_O_MOTORS];                     //!< start position of the actual segment
+static int StartVelocity[N_O_MOTORS];                     //!< start velocity of the actual segment
+static uint32_t SegmentTime[N_O_MOTORS];                  //!< time since the start of the actual segment (ms)
+static int NextVelocity[N_O_MOTORS];                      //!< velocity for the next pushed point
+static uint16_t NextDuration[N_O_MOTORS];                 //!< duration for the next pushed point
+static uint32_t LastVMax[N_O_MOTORS];                     //!< last VMAX value written
+static uint8_t LastRampMode[N_O_MOTORS];                  //!< last RAMPMODE value written
+static uint32_t MaxError[N_O_MOTORS];                     //!< highest position error of the trajectory (microsteps)
+static uint32_t Underruns[N_O_MOTORS];                    //!< underrun counter
+
+
+/***************************************************************//**
+   \fn TMR0_IRQHandler(void)
+   \brief Timer 0 interrupt handler
+
+   Counts the interpolator periods.
+********************************************************************/
+void TMR0_IRQHandler(void)
+{
+  TMR_IntClear(MXC_TMR0);
+  PVTTickCounter++;
+}
+
+
+/***************************************************************//**
+   \fn InitPVT(void)
+   \brief Initialise the PVT mode
+
+   Sets up TMR0 to interrupt every PVT_PERIOD_MS.
+********************************************************************/
+void InitPVT(void)
+{
+  tmr_cfg_t TimerCfg;
+  uint32_t i;
+
+  for(i=0; i<N_O_MOTORS; i++) NextDuration[i]=PVT_DEFAULT_DURATION;
+
+  TMR_Init(MXC_TMR0, TMR_PRES_1, NULL);
+  TimerCfg.mode=TMR_MODE_CONTINUOUS;
+  TimerCfg.cmp_cnt=PeripheralClock/1000*PVT_PERIOD_MS;
+  TimerCfg.pol=0;
+  TMR_Config(MXC_TMR0, &TimerCfg);
+  TMR_IntClear(MXC_TMR0);
+  TMR_Enable(MXC_TMR0);
+  NVIC_EnableIRQ(TMR0_IRQn);
+
+  LastTick=PVTTickCounter;
+}
+
+
+/***************************************************************//**
+   \fn Interpolate(uint8_t Motor, uint32_t Time, int64_t *Velocity)
+   \brief Calculate a point of the actual segment
+   \param Motor: axis number
+   \param Time: time since the start of the segment (ms, 0..duration)
+   \param Velocity: pointer to variable for the velocity (pps)
+   \return Position
+
+   Cubic Hermite interpolation between the start point and the end
+   point of the segment, calculated in Q16 fixed point (s = t/T).
+********************************************************************/
+static int Interpolate(uint8_t Motor, uint32_t Time, int64_t *Velocity)
+{
+  int64_t S, S2, S3;
+  int64_t Distance;
+  int64_t H01, H10, H11;
+  int64_t Position;
+  uint32_t Duration;
+
+  Duration=Segment[Motor].Duration;
+  if(Time>Duration) Time=Duration;
+
+  S=((int64_t) Time<<16)/Duration;
+  S2=(S*S)>>16;
+  S3=(S2*S)>>16;
+  Distance=(int64_t) Segment[Motor].Position-StartPosition[Motor];
+
+  //Hermite basis functions
+  H01=3*S2-2*S3;
+  H10=S-2*S2+S3;
+  H11=S3-S2;
+
+  Position=StartPosition[Motor]+
+           ((Distance*H01)>>16)+
+           ((((int64_t) StartVelocity[Motor]*Duration/1000)*H10)>>16)+
+           ((((int64_t) Segment[Motor].Velocity*Duration/1000)*H11)>>16);
+
+  //Derivatives of the basis functions (dp/dt=dp/ds/T)
+  *Velocity=(((Distance*1000/Duration)*(6*S-6*S2))>>16)+
+            (((int64_t) StartVelocity[Motor]*(65536-4*S+3*S2))>>16)+
+            (((int64_t) Segment[Motor].Velocity*(3*S2-2*S))>>16);
+
+  return (int) Position;
+}
+
+
+/***************************************************************//**
+   \fn NextSegment(uint8_t Motor)
+   \brief Switch to the next segment
+   \param Motor: axis number
+   \return FALSE if there is no more point in the buffer
+
+   The end point of the actual segment becomes the start point
+   of the next one.
+********************************************************************/
+static uint8_t NextSegment(uint8_t Motor)
+{
+  StartPosition[Motor]=Segment[Motor].Position;
+  StartVelocity[Motor]=Segment[Motor].Velocity;
+
+  if(BufferLevel[Motor]==0) return FALSE;
+
+  Segment[Motor]=Buffer[Motor][BufferHead[Motor]];
+  BufferHead[Motor]=(BufferHead[Motor]+1) % PVT_BUFFER_SIZE;
+  BufferLevel[Motor]--;
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn EndPVT(uint8_t Motor)
+   \brief Regular end of the trajectory
+   \param Motor: axis number
+
+   Moves to the end point in positioning mode (removing the remaining
+   position error) with the VMAX of the axis.
+********************************************************************/
+static void EndPVT(uint8_t Motor)
+{
+  WriteTMC5130Int(WHICH_5130(Motor), TMC5130_XTARGET, StartPosition[Motor]);
+  WriteTMC5130Int(WHICH_5130(Motor), TMC5130_VMAX, VMax[Motor]);
+  WriteTMC5130Datagram(WHICH_5130(Motor), TMC5130_RAMPMODE, 0, 0, 0, TMC5130_MODE_POSITION);
+  VMaxModified[Motor]=FALSE;
+  State[Motor]=PVT_IDLE;
+}
+
+
+/***************************************************************//**
+   \fn ProcessPVT(void)
+   \brief PVT interpolator
+
+   Updates VMAX and RAMPMODE of all axes in PVT mode once per elapsed
+   interpolator period. Has to be called from the main loop. If the
+   main loop has been delayed, the missed periods are caught up
+   in one step.
+   The commanded velocity (trajectory plus correction) is calculated
+   in 64 bit and limited to the VMAX of the axis.
+********************************************************************/
+void ProcessPVT(void)
+{
+  uint32_t Ticks;
+  uint32_t Elapsed;
+  uint32_t VMaxValue;
+  uint8_t RampMode;
+  uint8_t Motor;
+  int Position;
+  int64_t Velocity;
+  int64_t Limit;
+  int Error;
+  uint32_t AbsError;
+
+  Ticks=PVTTickCounter;
+  if(Ticks==LastTick) return;
+  Elapsed=(Ticks-LastTick)*PVT_PERIOD_MS;
+  LastTick=Ticks;
+
+  for(Motor=0; Motor<N_O_MOTORS; Motor++)
+  {
+    if(State[Motor]!=PVT_RUNNING) continue;
+
+    SegmentTime[Motor]+=Elapsed;
+    while(SegmentTime[Motor]>=Segment[Motor].Duration)
+    {
+      SegmentTime[Motor]-=Segment[Motor].Duration;
+      if(!NextSegment(Motor))
+      {
+        if(StartVelocity[Motor]==0)
+        {
+          EndPVT(Motor);
+        }
+        else
+        {
+          //Underrun: stop with AMAX (velocity mode)
+          WriteTMC5130Int(WHICH_5130(Motor), TMC5130_VMAX, 0);
+          State[Motor]=PVT_UNDERRUN;
+          Underruns[Motor]++;
+        }
+        break;
+      }
+    }
+    if(State[Motor]!=PVT_RUNNING) continue;
+
+    //Position error against the trajectory now
+    Position=Interpolate(Motor, SegmentTime[Motor], &Velocity);
+    Error=(int) ((uint32_t) Position-(uint32_t) ReadTMC5130Int(WHICH_5130(Motor), TMC5130_XACTUAL));
+    AbsError=(Error<0) ? -(uint32_t) Error:(uint32_t) Error;
+    if(AbsError>MaxError[Motor]) MaxError[Motor]=AbsError;
+    if(Error>PVT_MAX_ERROR) Error=PVT_MAX_ERROR;
+    else if(Error< -PVT_MAX_ERROR) Error= -PVT_MAX_ERROR;
+
+    //Velocity one period ahead plus the correction
+    Interpolate(Motor, SegmentTime[Motor]+PVT_PERIOD_MS, &Velocity);
+    Velocity+=(int64_t) Error*(1000/PVT_CORRECTION_MS);
+    Limit=ConvertVelocityInternalToUser(VMax[Motor]);
+    if(Velocity>Limit) Velocity=Limit;
+    else if(Velocity< -Limit) Velocity= -Limit;
+
+    RampMode=(Velocity>=0) ? TMC5130_MODE_VELPOS:TMC5130_MODE_VELNEG;
+    VMaxValue=ConvertVelocityUserToInternal((int) (Velocity>=0 ? Velocity:-Velocity));
+
+    if(VMaxValue!=LastVMax[Motor])
+    {
+      PostTMC5130Write(WHICH_5130(Motor), TMC5130_VMAX, VMaxValue);
+      LastVMax[Motor]=VMaxValue;
+    }
+    if(RampMode!=LastRampMode[Motor])
+    {
+      PostTMC5130Write(WHICH_5130(Motor), TMC5130_RAMPMODE, RampMode);
+      LastRampMode[Motor]=RampMode;
+    }
+  }
+}
+
+
+/***************************************************************//**
+   \fn PushPVTPoint(uint8_t Motor, int Position)
+   \brief Add a point to the buffer
+   \param Motor: axis number
+   \param Position: position of the point
+   \return FALSE if the buffer is full
+
+   The velocity and the duration set last with SetPVTVelocity()
+   and SetPVTDuration() are used for the point.
+********************************************************************/
+uint8_t PushPVTPoint(uint8_t Motor, int Position)
+{
+  TPVTPoint *Point;
+
+  if(BufferLevel[Motor]>=PVT_BUFFER_SIZE) return FALSE;
+
+  Point=&Buffer[Motor][(BufferHead[Motor]+BufferLevel[Motor]) % PVT_BUFFER_SIZE];
+  Point->Position=Position;
+  Point->Velocity=NextVelocity[Motor];
+  Point->Duration=NextDuration[Motor];
+  BufferLevel[Motor]++;
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn SetPVTVelocity(uint8_t Motor, int Velocity)
+   \brief Set the velocity for the next points
+   \param Motor: axis number
+   \param Velocity: velocity (pps, -VMAX..VMAX of the axis)
+   \return FALSE if the velocity is out of range
+********************************************************************/
+uint8_t SetPVTVelocity(uint8_t Motor, int Velocity)
+{
+  int Limit;
+
+  Limit=ConvertVelocityInternalToUser(VMax[Motor]);
+  if(Velocity>Limit || Velocity< -Limit) return FALSE;
+  NextVelocity[Motor]=Velocity;
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn SetPVTDuration(uint8_t Motor, int Duration)
+   \brief Set the duration for the next points
+   \param Motor: axis number
+   \param Duration: duration (1..65535ms)
+   \return FALSE if the duration is out of range
+********************************************************************/
+uint8_t SetPVTDuration(uint8_t Motor, int Duration)
+{
+  if(Duration<1 || Duration>65535) return FALSE;
+  NextDuration[Motor]=Duration;
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn StartPVT(uint8_t Motor)
+   \brief Start the trajectory
+   \param Motor: axis number
+
+   The trajectory starts at the actual position with velocity 0.
+   Points should have been pushed before, otherwise the trajectory
+   ends immediately. The motor is switched to velocity mode (VMAX 0)
+   with the AMAX of the axis.
+********************************************************************/
+void StartPVT(uint8_t Motor)
+{
+  Segment[Motor].Position=ReadTMC5130Int(WHICH_5130(Motor), TMC5130_XACTUAL);
+  Segment[Motor].Velocity=0;
+  SegmentTime[Motor]=0;
+  if(!NextSegment(Motor)) return;
+
+  WriteTMC5130Int(WHICH_5130(Motor), TMC5130_AMAX, AMax[Motor]);
+  WriteTMC5130Int(WHICH_5130(Motor), TMC5130_VMAX, 0);
+  WriteTMC5130Datagram(WHICH_5130(Motor), TMC5130_RAMPMODE, 0, 0, 0, TMC5130_MODE_VELPOS);
+  VMaxModified[Motor]=TRUE;
+  AMaxModified[Motor]=FALSE;
+  StallFlag[Motor]=FALSE;
+  LastVMax[Motor]=0;
+  LastRampMode[Motor]=TMC5130_MODE_VELPOS;
+  MaxError[Motor]=0;
+  State[Motor]=PVT_RUNNING;
+}
+
+
+/***************************************************************//**
+   \fn StopPVT(uint8_t Motor)
+   \brief Leave the PVT mode
+   \param Motor: axis number
+
+   Deletes all buffered points. The motor is not stopped here, this
+   has to be done by the caller if necessary (e.g. MST command).
+********************************************************************/
+void StopPVT(uint8_t Motor)
+{
+  State[Motor]=PVT_IDLE;
+  BufferLevel[Motor]=0;
+}
+
+
+/***************************************************************//**
+   \fn GetPVTLevel(uint8_t Motor)
+   \param Motor: axis number
+   \return Number of buffered points (for flow control)
+********************************************************************/
+uint32_t GetPVTLevel(uint8_t Motor)
+{
+  return BufferLevel[Motor];
+}
+
+
+/***************************************************************//**
+   \fn GetPVTState(uint8_t Motor)
+   \param Motor: axis number
+   \return PVT_IDLE, PVT_RUNNING or PVT_UNDERRUN
+********************************************************************/
+uint8_t GetPVTState(uint8_t Motor)
+{
+  return State[Motor];
+}
+
+
+/***************************************************************//**
+   \fn GetPVTMaxError(uint8_t Motor)
+   \param Motor: axis number
+   \return Highest position error (microsteps) since the start of
+           the trajectory
+********************************************************************/
+uint32_t GetPVTMaxError(uint8_t Motor)
+{
+  return MaxError[Motor];
+}
+
+
+/***************************************************************//**
+   \fn GetPVTUnderruns(uint8_t Motor)
+   \param Motor: axis number
+   \return Number of times the motor has been stopped because the
+           buffer has run empty
+********************************************************************/
+uint32_t GetPVTUnderruns(uint8_t Motor)
+{
+  return Underruns[Motor];
+}
@@ -0,0 +1,51 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file PVT.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: PVT.h
+ *         Description: Position-velocity-time (PVT) streaming mode
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __PVT_H
+#define __PVT_H
+
+#define PVT_BUFFER_SIZE  32    //!< number of points that can be buffered per axis
+#define PVT_PERIOD_MS     2    //!< update period of the interpolator (ms)
+
+//States of the PVT mode
+#define PVT_IDLE         0     //!< not active
+#define PVT_RUNNING      1     //!< trajectory is being executed
+#define PVT_UNDERRUN     2     //!< motor stopped because the buffer ran empty
+
+//Types of the PVT command (TMCL_PVT)
+#define PVT_SET_VELOCITY 0     //!< velocity of the next point(s) (pps)
+#define PVT_SET_DURATION 1     //!< duration of the next point(s) (ms)
+#define PVT_PUSH         2     //!< add a point (value: position)
+#define PVT_START        3     //!< start the trajectory
+#define PVT_STOP         4     //!< stop and delete all points
+#define PVT_GET_LEVEL    5     //!< read the number of buffered points
+#define PVT_GET_STATE    6     //!< read the state (PVT_IDLE, PVT_RUNNING, PVT_UNDERRUN)
+#define PVT_GET_UNDERRUNS 7    //!< read the underrun counter
+#define PVT_GET_MAX_ERROR 8    //!< read the highest position error of the trajectory (microsteps)
+
+void InitPVT(void);
+void ProcessPVT(void);
+uint8_t PushPVTPoint(uint8_t Motor, int Position);
+uint8_t SetPVTVelocity(uint8_t Motor, int Velocity);
+uint8_t SetPVTDuration(uint8_t Motor, int Duration);
+void StartPVT(uint8_t Motor);
+void StopPVT(uint8_t Motor);
+uint32_t GetPVTLevel(uint8_t Motor);
+uint8_t GetPVTState(uint8_t Motor);
+uint32_t GetPVTUnderruns(uint8_t Motor);
+uint32_t GetPVTMaxError(uint8_t Motor);
+
+#endif
@@ -0,0 +1,363 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file ParamStore.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: ParamStore.c
+ *         Description: Non-volatile parameter store in the MAX32660 flash
+ *
+ *                      The store is a log of 16 byte records (one flash
+ *                      write unit each) in one of PS_PAGES flash pages.
+ *                      Every write appends a new record, so the latest
+ *                      record of a parameter is valid. When the page is
+ *                      full the latest values are copied to the next page
+ *                      (round robin), which is then marked active by
+ *                      writing its header record with an incremented
+ *                      generation number. The header is written last, so
+ *                      an interrupted page change leaves the old page
+ *                      valid. The latest values are also held in a RAM
+ *                      mirror which is filled in one pass at start-up.
+ *
+ *                      Interrupts are disabled during every flash
+ *                      operation, as the interrupt handlers and the
+ *                      vector table are in the flash, which cannot be
+ *                      read while it is being programmed. Writing a
+ *                      record takes some ten microseconds, which the
+ *                      UART FIFO bridges. A page erase (page change,
+ *                      ParamStoreClear()) blocks for some ten
+ *                      milliseconds, so Homebus frames arriving then
+ *                      are lost. The UART reports this as an RX FIFO
+ *                      overrun (see GetHomebusOverrunCount()). A
+ *                      master that waits for the reply of STAP, STGP,
+ *                      SCO and command 137 before sending anything to
+ *                      this node is not affected.
+ *
+ *                      Record layout (32 bit words):
+ *                        0: key (kind | bank<<8 | index<<16 | PS_MARKER<<24)
+ *                        1: value (header: generation)
+ *                        2: generation of the page
+ *                        3: check word (word0 ^ word1 ^ word2 ^ PS_CHECK)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdlib.h>
+#include "max32660.h"
+#include "mxc_errors.h"
+#include "flc.h"
+#include "ParamStore.h"
+
+#define PS_RECORD_SIZE 16                                     //!< size of a record (flash write unit)
+#define PS_SLOTS       (MXC_FLASH_PAGE_SIZE/PS_RECORD_SIZE)   //!< records per page (including the header)
+#define PS_MARKER      0xa5                                   //!< marks a written record
+#define PS_CHECK       0x5aa5c33c                             //!< start value of the check word
+
+static TParamEntry Entries[PS_MAX_ENTRIES];   //!< RAM mirror (latest value of every stored parameter)
+static uint32_t EntryCount;                   //!< number of used entries in the RAM mirror
+static uint32_t ActivePage;                   //!< address of the active page
+static uint32_t NextSlot;                     //!< next free record in the active page
+static uint32_t Generation;                   //!< generation of the active page (0: store is empty)
+
+
+static uint32_t MakeKey(uint8_t Kind, uint8_t Bank, uint8_t Index)
+{
+  return Kind | (Bank<<8) | (Index<<16) | (PS_MARKER<<24);
+}
+
+static uint8_t CheckRecord(const uint32_t *Record)
+{
+  return (Record[0]>>24)==PS_MARKER && Record[3]==(Record[0]^Record[1]^Record[2]^PS_CHECK);
+}
+
+static uint8_t IsErased(const uint32_t *Record)
+{
+  return Record[0]==0xffffffff && Record[1]==0xffffffff &&
+         Record[2]==0xffffffff && Record[3]==0xffffffff;
+}
+
+
+/***************************************************************//**
+   \fn WriteRecord(uint32_t Address, uint32_t Key, int Value, uint32_t RecordGeneration)
+   \brief Write a record to the flash
+   \param Address: flash address (must be 16 byte aligned)
+   \param Key: parameter key
+   \param Value: parameter value
+   \param RecordGeneration: generation of the page
+   \return TRUE if successful
+********************************************************************/
+static uint8_t WriteRecord(uint32_t Address, uint32_t Key, int Value, uint32_t RecordGeneration)
+{
+  uint32_t Record[4];
+  int Result;
+
+  Record[0]=Key;
+  Record[1]=Value;
+  Record[2]=RecordGeneration;
+  Record[3]=Record[0]^Record[1]^Record[2]^PS_CHECK;
+
+  __disable_irq();
+  Result=FLC_Write128(Address, Record);
+  __enable_irq();
+
+  return Result==E_NO_ERROR && CheckRecord((const uint32_t *) Address);
+}
+
+
+/***************************************************************//**
+   \fn ErasePage(uint32_t Address)
+   \brief Erase a page of the parameter store
+   \param Address: address of the page
+   \return TRUE if successful
+********************************************************************/
+static uint8_t ErasePage(uint32_t Address)
+{
+  int Result;
+
+  __disable_irq();
+  Result=FLC_PageErase(Address);
+  __enable_irq();
+
+  return Result==E_NO_ERROR;
+}
+
+
+/***************************************************************//**
+   \fn FindEntry(uint8_t Kind, uint8_t Bank, uint8_t Index)
+   \brief Look up a parameter in the RAM mirror
+   \return Pointer to the entry or NULL if not found
+********************************************************************/
+static TParamEntry *FindEntry(uint8_t Kind, uint8_t Bank, uint8_t Index)
+{
+  uint32_t i;
+
+  for(i=0; i<EntryCount; i++)
+    if(Entries[i].Kind==Kind && Entries[i].Bank==Bank && Entries[i].Index==Index)
+      return &Entries[i];
+
+  return NULL;
+}
+
+
+/***************************************************************//**
+   \fn UpdateEntry(uint8_t Kind, uint8_t Bank, uint8_t Index, int Value)
+   \brief Set a parameter in the RAM mirror
+   \return FALSE if there is no more space for a new parameter
+********************************************************************/
+static uint8_t UpdateEntry(uint8_t Kind, uint8_t Bank, uint8_t Index, int Value)
+{
+  TParamEntry *Entry;
+
+  Entry=FindEntry(Kind, Bank, Index);
+  if(Entry==NULL)
+  {
+    if(EntryCount>=PS_MAX_ENTRIES) return FALSE;
+    Entry=&Entries[EntryCount++];
+    Entry->Kind=Kind;
+    Entry->Bank=Bank;
+    Entry->Index=Index;
+  }
+  Entry->Value=Value;
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn ChangePage(void)
+   \brief Copy all parameters to the next page
+
+   Erase the next page, write the contents of the RAM mirror to it
+   and then activate it by writing its header.
+   \return TRUE if successful
+********************************************************************/
+static uint8_t ChangePage(void)
+{
+  uint32_t NewPage;
+  uint32_t NewGeneration;
+  uint32_t i;
+
+  NewPage=ActivePage+MXC_FLASH_PAGE_SIZE;
+  if(NewPage>=PS_START+PS_PAGES*MXC_FLASH_PAGE_SIZE) NewPage=PS_START;
+  NewGeneration=Generation+1;
+
+  if(!ErasePage(NewPage)) return FALSE;
+
+  for(i=0; i<EntryCount; i++)
+  {
+    if(!WriteRecord(NewPage+(i+1)*PS_RECORD_SIZE, MakeKey(Entries[i].Kind, Entries[i].Bank, Entries[i].Index),
+                    Entries[i].Value, NewGeneration))
+      return FALSE;
+  }
+
+  if(!WriteRecord(NewPage, MakeKey(PS_KIND_HEADER, 0, 0), NewGeneration, NewGeneration)) return FALSE;
+
+  ActivePage=NewPage;
+  Generation=NewGeneration;
+  NextSlot=EntryCount+1;
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn InitParamStore(void)
+   \brief Initialise the parameter store
+
+   Find the active page and read all records into the RAM mirror
+   (one pass through the log). Has to be called once at start-up,
+   before any other function of this module.
+********************************************************************/
+void InitParamStore(void)
+{
+  const uint32_t *Record;
+  uint32_t Page;
+  uint32_t i;
+
+  FLC_Init(NULL);
+
+  EntryCount=0;
+  Generation=0;
+  ActivePage=PS_START;
+  NextSlot=PS_SLOTS;  //the first write then activates a new page
+
+  //The valid page with the highest generation is the active page.
+  for(i=0; i<PS_PAGES; i++)
+  {
+    Page=PS_START+i*MXC_FLASH_PAGE_SIZE;
+    Record=(const uint32_t *) Page;
+    if(CheckRecord(Record) && (Record[0] & 0xff)==PS_KIND_HEADER && Record[1]==Record[2] &&
+       (Generation==0 || (int32_t) (Record[1]-Generation)>0))
+    {
+      Generation=Record[1];
+      ActivePage=Page;
+    }
+  }
+  if(Generation==0) return;
+
+  for(NextSlot=1; NextSlot<PS_SLOTS; NextSlot++)
+  {
+    Record=(const uint32_t *) (ActivePage+NextSlot*PS_RECORD_SIZE);
+    if(IsErased(Record)) break;
+
+    //Records damaged by a reset during writing are skipped.
+    if(CheckRecord(Record) && Record[2]==Generation)
+      UpdateEntry(Record[0] & 0xff, (Record[0]>>8) & 0xff, (Record[0]>>16) & 0xff, Record[1]);
+  }
+}
+
+
+/***************************************************************//**
+   \fn ParamStoreWrite(uint8_t Kind, uint8_t Bank, uint8_t Index, int Value)
+   \brief Store a parameter
+   \param Kind: kind of parameter (PS_KIND_AXIS, PS_KIND_GLOBAL, PS_KIND_COORD)
+   \param Bank: motor or bank number
+   \param Index: parameter number
+   \param Value: value to be stored
+   \return PS_OK, PS_FULL or PS_FLASH_ERROR
+
+   Nothing is written to the flash if the value is already stored.
+   Changing the page (erasing) blocks all interrupts for some ten
+   milliseconds (see above).
+********************************************************************/
+uint8_t ParamStoreWrite(uint8_t Kind, uint8_t Bank, uint8_t Index, int Value)
+{
+  TParamEntry *Entry;
+
+  Entry=FindEntry(Kind, Bank, Index);
+  if(Entry!=NULL && Entry->Value==Value) return PS_OK;
+  if(Entry==NULL && EntryCount>=PS_MAX_ENTRIES) return PS_FULL;
+
+  if(NextSlot>=PS_SLOTS)
+  {
+    if(!ChangePage()) return PS_FLASH_ERROR;
+  }
+
+  if(!WriteRecord(ActivePage+NextSlot*PS_RECORD_SIZE, MakeKey(Kind, Bank, Index), Value, Generation))
+  {
+    NextSlot++;
+    return PS_FLASH_ERROR;
+  }
+  NextSlot++;
+  UpdateEntry(Kind, Bank, Index, Value);
+
+  return PS_OK;
+}
+
+
+/***************************************************************//**
+   \fn ParamStoreRead(uint8_t Kind, uint8_t Bank, uint8_t Index, int *Value)
+   \brief Read a stored parameter
+   \param Kind: kind of parameter (PS_KIND_AXIS, PS_KIND_GLOBAL, PS_KIND_COORD)
+   \param Bank: motor or bank number
+   \param Index: parameter number
+   \param Value: pointer to variable for the stored value
+   \return TRUE if the parameter has been stored
+********************************************************************/
+uint8_t ParamStoreRead(uint8_t Kind, uint8_t Bank, uint8_t Index, int *Value)
+{
+  TParamEntry *Entry;
+
+  Entry=FindEntry(Kind, Bank, Index);
+  if(Entry==NULL) return FALSE;
+
+  *Value=Entry->Value;
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn GetParamStoreEntry(uint32_t Number)
+   \brief Iterate through all stored parameters
+   \param Number: entry number (0..)
+   \return Pointer to the entry or NULL if Number is too high
+********************************************************************/
+const TParamEntry *GetParamStoreEntry(uint32_t Number)
+{
+  return (Number<EntryCount) ? &Entries[Number] : NULL;
+}
+
+
+/***************************************************************//**
+   \fn ParamStoreClear(void)
+   \brief Delete all stored parameters
+   \return PS_OK or PS_FLASH_ERROR
+********************************************************************/
+uint8_t ParamStoreClear(void)
+{
+  uint32_t Page;
+  uint32_t i;
+
+  Page=ActivePage;
+  EntryCount=0;
+  Generation=0;
+  ActivePage=PS_START;
+  NextSlot=PS_SLOTS;
+
+  //The active page is erased last. A reset during the clear then
+  //cannot activate an older page with outdated values.
+  for(i=0; i<PS_PAGES; i++)
+  {
+    Page+=MXC_FLASH_PAGE_SIZE;
+    if(Page>=PS_START+PS_PAGES*MXC_FLASH_PAGE_SIZE) Page=PS_START;
+    if(!ErasePage(Page)) return PS_FLASH_ERROR;
+  }
+
+  return PS_OK;
+}
+
+
+/***************************************************************//**
+   \fn GetParamStoreEraseCount(void)
+   \return Number of page erase cycles since the store was cleared.
+
+   Each page has been erased about GetParamStoreEraseCount()/PS_PAGES
+   times.
+********************************************************************/
+uint32_t GetParamStoreEraseCount(void)
+{
+  return Generation;
+}
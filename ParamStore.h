@@ -0,0 +1,54 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file ParamStore.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: ParamStore.h
+ *         Description: Non-volatile parameter store in the MAX32660 flash
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __PARAM_STORE_H
+#define __PARAM_STORE_H
+
+//The last two flash pages are used for the parameter store
+//(the linker script must not use them).
+#define PS_PAGES       2
+#define PS_START       (MXC_FLASH_MEM_BASE+MXC_FLASH_MEM_SIZE-PS_PAGES*MXC_FLASH_PAGE_SIZE)
+
+#define PS_MAX_ENTRIES 192    //!< maximum number of different parameters that can be stored
+
+//Kinds of stored parameters
+#define PS_KIND_HEADER  0     //!< page header (used internally)
+#define PS_KIND_AXIS    1     //!< axis parameter (bank: motor, index: parameter number)
+#define PS_KIND_GLOBAL  2     //!< global parameter (bank: bank, index: parameter number)
+#define PS_KIND_COORD   3     //!< coordinate (bank: motor, index: coordinate number)
+
+//Result codes
+#define PS_OK           0     //!< successful
+#define PS_FULL         1     //!< no more space for new parameters
+#define PS_FLASH_ERROR  2     //!< flash write or erase failed
+
+//! Parameter in the RAM mirror of the store
+typedef struct
+{
+  uint8_t Kind;     //!< kind of parameter (PS_KIND_xxx)
+  uint8_t Bank;     //!< motor or bank number
+  uint8_t Index;    //!< parameter number
+  int Value;        //!< stored value
+} TParamEntry;
+
+void InitParamStore(void);
+uint8_t ParamStoreWrite(uint8_t Kind, uint8_t Bank, uint8_t Index, int Value);
+uint8_t ParamStoreRead(uint8_t Kind, uint8_t Bank, uint8_t Index, int *Value);
+const TParamEntry *GetParamStoreEntry(uint32_t Number);
+uint8_t ParamStoreClear(void);
+uint32_t GetParamStoreEraseCount(void);
+
+#endif
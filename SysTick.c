@@ -46,6 +46,11 @@ void InitSysTick(void)
 {
   SysTickTimer=0;
   SysTick_Config(96000);  //96MHz => 1ms-Timer
+
+  //Also start the DWT cycle counter (used for time measurements)
+  CoreDebug->DEMCR|=CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT=0;
+  DWT->CTRL|=DWT_CTRL_CYCCNTENA_Msk;
 }
 
 /***************************************************************//**
@@ -59,3 +64,16 @@ uint32_t GetSysTimer(void)
 {
   return SysTickTimer;
 }
+
+/***************************************************************//**
+   \fn GetCycleCounter()
+   \brief Read CPU cycle counter
+   \return CPU clock cycles since startup (wraps around).
+
+   Returns the value of the DWT cycle counter. This can be used
+   for measuring short time intervals (1 cycle = 1/96MHz).
+********************************************************************/
+uint32_t GetCycleCounter(void)
+{
+  return DWT->CYCCNT;
+}
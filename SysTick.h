@@ -22,5 +22,6 @@
 
 void InitSysTick(void);
 uint32_t GetSysTimer(void);
+uint32_t GetCycleCounter(void);
 
 #endif
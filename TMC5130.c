@@ -18,42 +18,785 @@
  *  -------------------------------------------------------------------- */
 
 #include <stdlib.h>
-#include <math.h>
 #include "max32660.h"
 #include "spi.h"
 #include "spimss.h"
 #include "bits.h"
-#include "math.h"
 
 #include "HomebusSlave.h"
 #include "TMC5130.h"
 #include "SysTick.h"
 #include "Globals.h"
-
+#include "FixedPoint.h"
+
+//Host simulation (see sim/SimTMC5130.c): the daisy chain is simulated
+//instead of accessing the SPIMSS registers.
+#if defined(TMC5130_SIMULATION)
+#include "SimTMC5130.h"
+#else
+#define WAIT_FOR_SPI_INTERRUPT()
+#endif
+
+//The TMC5130 clock frequency can be set by defining TMC5130_FCLK (in Hz,
+//e.g. -DTMC5130_FCLK=16000000 when an external clock is used).
+#if defined(DEVTYPE_TMC5160) && !defined(TMC5130_FCLK)
+#define TMC5130_FCLK 12000000             //Internal clock of the TMC5160 (typical)
+#endif
+#ifdef TMC5130_FCLK
+#define VEL_FACTOR ((double) TMC5130_FCLK/16777216.0)                                        //fClk/2 / 2^23
+#define ACC_FACTOR ((double) TMC5130_FCLK*(double) TMC5130_FCLK/(512.0*256.0)/16777216.0)    //fClk^2 / (512*256) / 2^24
+#else
 #define VEL_FACTOR 0.7451                 //fClk/2 / 2^23   (Internal clock, typical fClk=12.5MHz)
 #define ACC_FACTOR 71.054274              //fClk^2 / (512*256) / 2^24   (Internal clock, typical fClk=12.5MHz)
+#endif
+
+//Conversion factors for the integer unit conversion (see FixedPoint.c)
+static const TFixedFactor VelocityFactor=FIXED_FACTOR(VEL_FACTOR, 53);
+static const TFixedFactor AccelerationFactor=FIXED_FACTOR(ACC_FACTOR, 54);
+
+//All registers of the TMC5130: X(address, readable, volatile)
+//  readable: the register can be read back
+//  volatile: the register is changed by the TMC5130 itself or has side
+//            effects when written, so writes are never skipped by the
+//            software copy
+//The slot table, the bitmaps and the register list below are generated
+//from this table.
+#if defined(DEVTYPE_TMC5160)
+#define TMC5160_CONF_REGISTERS(X) \
+  X(TMC5160_OTP_PROG,      0, 1) \
+  X(TMC5160_OTP_READ,      1, 1) \
+  X(TMC5160_FACTORY_CONF,  1, 0) \
+  X(TMC5160_SHORT_CONF,    0, 0) \
+  X(TMC5160_DRV_CONF,      0, 0) \
+  X(TMC5160_GLOBAL_SCALER, 0, 0) \
+  X(TMC5160_OFFSET_READ,   1, 1)
+#define TMC5160_ENC_REGISTERS(X) \
+  X(TMC5160_ENC_DEVIATION, 0, 0)
+#define TMC5130_REGISTER_72(X) \
+  X(TMC5160_PWM_AUTO,      1, 1)
+#else
+#define TMC5160_CONF_REGISTERS(X)
+#define TMC5160_ENC_REGISTERS(X)
+#define TMC5130_REGISTER_72(X) \
+  X(TMC5130_ENCM_CTRL,     0, 0)
+#endif
+
+#define TMC5130_REGISTERS(X) \
+  X(TMC5130_GCONF,         1, 0) \
+  X(TMC5130_GSTAT,         1, 1) \
+  X(TMC5130_IFCNT,         1, 1) \
+  X(TMC5130_SLAVECONF,     0, 0) \
+  X(TMC5130_IOIN,          1, 1) \
+  X(TMC5130_X_COMPARE,     0, 0) \
+  TMC5160_CONF_REGISTERS(X) \
+  X(TMC5130_IHOLD_IRUN,    0, 0) \
+  X(TMC5130_TPOWERDOWN,    0, 0) \
+  X(TMC5130_TSTEP,         1, 1) \
+  X(TMC5130_TPWMTHRS,      0, 0) \
+  X(TMC5130_TCOOLTHRS,     0, 0) \
+  X(TMC5130_THIGH,         0, 0) \
+  X(TMC5130_RAMPMODE,      1, 0) \
+  X(TMC5130_XACTUAL,       1, 1) \
+  X(TMC5130_VACTUAL,       1, 1) \
+  X(TMC5130_VSTART,        0, 0) \
+  X(TMC5130_A1,            0, 0) \
+  X(TMC5130_V1,            0, 0) \
+  X(TMC5130_AMAX,          0, 0) \
+  X(TMC5130_VMAX,          0, 0) \
+  X(TMC5130_DMAX,          0, 0) \
+  X(TMC5130_D1,            0, 0) \
+  X(TMC5130_VSTOP,         0, 0) \
+  X(TMC5130_TZEROWAIT,     0, 0) \
+  X(TMC5130_XTARGET,       1, 0) \
+  X(TMC5130_VDCMIN,        0, 0) \
+  X(TMC5130_SWMODE,        1, 0) \
+  X(TMC5130_RAMPSTAT,      1, 1) \
+  X(TMC5130_XLATCH,        1, 1) \
+  X(TMC5130_ENCMODE,       1, 0) \
+  X(TMC5130_XENC,          1, 1) \
+  X(TMC5130_ENC_CONST,     0, 0) \
+  X(TMC5130_ENC_STATUS,    1, 1) \
+  X(TMC5130_ENC_LATCH,     1, 1) \
+  TMC5160_ENC_REGISTERS(X) \
+  X(TMC5130_MSLUT0,        0, 0) \
+  X(TMC5130_MSLUT1,        0, 0) \
+  X(TMC5130_MSLUT2,        0, 0) \
+  X(TMC5130_MSLUT3,        0, 0) \
+  X(TMC5130_MSLUT4,        0, 0) \
+  X(TMC5130_MSLUT5,        0, 0) \
+  X(TMC5130_MSLUT6,        0, 0) \
+  X(TMC5130_MSLUT7,        0, 0) \
+  X(TMC5130_MSLUTSEL,      0, 0) \
+  X(TMC5130_MSLUTSTART,    0, 0) \
+  X(TMC5130_MSCNT,         1, 1) \
+  X(TMC5130_MSCURACT,      1, 1) \
+  X(TMC5130_CHOPCONF,      1, 0) \
+  X(TMC5130_COOLCONF,      0, 0) \
+  X(TMC5130_DCCTRL,        0, 0) \
+  X(TMC5130_DRVSTATUS,     1, 1) \
+  X(TMC5130_PWMCONF,       0, 0) \
+  X(TMC5130_PWMSCALE,      1, 1) \
+  TMC5130_REGISTER_72(X) \
+  X(TMC5130_LOST_STEPS,    1, 1)
+
+//Slots of the software copy (slot 0 is used for all unknown addresses)
+#define REGISTER_SLOT(Address, Readable, Volatile) SLOT_##Address,
+enum
+{
+  SLOT_NONE,
+  TMC5130_REGISTERS(REGISTER_SLOT)
+  TMC5130_SLOTS
+};
+
+//Register address => slot of the software copy
+#define REGISTER_INDEX(Address, Readable, Volatile) [Address]=SLOT_##Address,
+static const uint8_t TMC5130RegisterSlot[128]={
+  TMC5130_REGISTERS(REGISTER_INDEX)
+};
+
+//All registers of the TMC5130 (used for the register snapshot and for restoring the registers).
+#define REGISTER_ADDRESS(Address, Readable, Volatile) Address,
+static const uint8_t TMC5130Registers[]={
+  TMC5130_REGISTERS(REGISTER_ADDRESS)
+};
+
+_Static_assert(sizeof(TMC5130Registers)==TMC5130_SNAPSHOT_SIZE, "TMC5130_SNAPSHOT_SIZE does not match the register table");
+
+//Bitmaps (bit n of word n/32 for address n) of the readable registers and of
+//the registers that can be cached in the software copy (not volatile). Unknown
+//addresses are never cached, as they all share slot 0.
+#define REGISTER_FLAG(Address, Flag, Word) |(((Flag) && ((Address)>>5)==(Word)) ? 1UL<<((Address) & 0x1f) : 0UL)
+#define READABLE_0(Address, Readable, Volatile) REGISTER_FLAG(Address, Readable, 0)
+#define READABLE_1(Address, Readable, Volatile) REGISTER_FLAG(Address, Readable, 1)
+#define READABLE_2(Address, Readable, Volatile) REGISTER_FLAG(Address, Readable, 2)
+#define READABLE_3(Address, Readable, Volatile) REGISTER_FLAG(Address, Readable, 3)
+#define CACHED_0(Address, Readable, Volatile) REGISTER_FLAG(Address, !(Volatile), 0)
+#define CACHED_1(Address, Readable, Volatile) REGISTER_FLAG(Address, !(Volatile), 1)
+#define CACHED_2(Address, Readable, Volatile) REGISTER_FLAG(Address, !(Volatile), 2)
+#define CACHED_3(Address, Readable, Volatile) REGISTER_FLAG(Address, !(Volatile), 3)
+
+static const uint32_t TMC5130RegisterReadable[4]={
+  0 TMC5130_REGISTERS(READABLE_0), 0 TMC5130_REGISTERS(READABLE_1),
+  0 TMC5130_REGISTERS(READABLE_2), 0 TMC5130_REGISTERS(READABLE_3)
+};
 
-//This table shows which TMC5130 register can be read back (0=no, 1=yes).
-static const uint8_t TMC5130RegisterReadable[128]={
-1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    //00..0f
-0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    //10..1f
-1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0,    //20..2f
-0, 0, 0, 0, 1, 1, 1, 0, 1, 1, 0, 1, 1, 0, 0, 0,    //30..3f
-0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    //40..4f
-0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    //50..5f
-0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 1,    //60..6f
-0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    //70..7f
+static const uint32_t TMC5130RegisterCached[4]={
+  0 TMC5130_REGISTERS(CACHED_0), 0 TMC5130_REGISTERS(CACHED_1),
+  0 TMC5130_REGISTERS(CACHED_2), 0 TMC5130_REGISTERS(CACHED_3)
 };
 
-static int TMC5130SoftwareCopy[128][N_O_MOTORS];    //!< Software copy of all registers
+static int TMC5130SoftwareCopy[N_O_MOTORS][TMC5130_SLOTS];  //!< Software copy of all registers (see SHADOW())
+static uint32_t ShadowValid[N_O_MOTORS][4];         //!< Bit set: software copy is equal to the register
+static uint32_t ShadowDirty[N_O_MOTORS][4];         //!< Bit set: deferred write pending
+static uint8_t DeferredWrites[N_O_MOTORS][TMC5130_MAX_DEFERRED];  //!< Registers with deferred writes (in order)
+static uint8_t DeferredCount[N_O_MOTORS];           //!< Number of deferred writes
+static uint32_t SPITransferCount;                   //!< Number of SPI datagrams sent to the TMC5130
+static uint32_t SPISavedWriteCount;                 //!< Number of register writes skipped by the software copy
+static uint32_t ShadowRestoreCount;                 //!< Number of register restores by VerifyTMC5130Registers()
+static volatile uint8_t SPIStatus[N_O_MOTORS];      //!< SPI status byte of the last datagram (also set by the SPI interrupt)
+static volatile uint32_t SPIStatusTime[N_O_MOTORS]; //!< Time (ms) when the SPI status byte has been received
+static volatile uint8_t SPIStatusValid[N_O_MOTORS]; //!< TRUE: SPIStatus has been received after the last write
 static uint8_t DriverDisableFlag[N_O_MOTORS];       //!< Flags used for switching off a motor driver via TOff
 static uint8_t LastTOffSetting[N_O_MOTORS];         //!< Last TOff setting before switching off the driver
 
+#define ADDRESS_BIT(Address) (1UL<<((Address) & 0x1f))
+#define IS_READABLE(Address) (TMC5130RegisterReadable[(Address)>>5] & ADDRESS_BIT(Address))
+#define IS_VOLATILE(Address) (!(TMC5130RegisterCached[(Address)>>5] & ADDRESS_BIT(Address)))
+#define SHADOW(Which5130, Address) TMC5130SoftwareCopy[Which5130][TMC5130RegisterSlot[Address]]
+
+//Event flags of RAMPSTAT (cleared by writing 1). The TMC5130 clears them
+//already when RAMPSTAT is read, so this is emulated using the software copy.
+#define RAMPSTAT_W1C_BITS (BIT12|BIT7|BIT6|BIT3|BIT2)
+
+//All TMC5130 are connected in one SPI daisy chain (MOSI to SDI of driver 0,
+//SDO of driver n to SDI of driver n+1, SDO of the last driver to MISO).
+//Every transfer shifts one datagram through each driver. The datagram sent
+//first ends up in the last driver, so driver n uses the slot at this offset
+//(in the frame sent and in the reply).
+#define TMC5130_CHAIN_BYTES    (5*N_O_DRIVERS)
+#define TMC5130_CHAIN_SLOT(Which5130) (5*(N_O_DRIVERS-1-(Which5130)))
+
+#if N_O_DRIVERS>32
+#error "Too many TMC5130 in the daisy chain"
+#endif
+
+//! Posted write datagram
+typedef struct
+{
+  uint8_t Which5130;   //!< index of the TMC5130
+  uint8_t Address;     //!< register address
+  int Value;           //!< value to be written
+} TAsyncWrite;
+
+static TAsyncWrite AsyncQueue[TMC5130_ASYNC_QUEUE];  //!< Posted writes (ring buffer)
+static volatile uint32_t AsyncHead;                  //!< Next posted write to be sent
+static volatile uint32_t AsyncTail;                  //!< Next free entry of AsyncQueue
+static volatile uint8_t AsyncBusy;                   //!< TRUE while posted writes are being sent
+static uint8_t AsyncHold;                            //!< TRUE: posted writes are only queued (see HoldTMC5130Writes())
+static volatile uint32_t AsyncCount;                 //!< Number of posted writes in the frame being sent
+static spimss_req_t AsyncRequest;                    //!< SPI request of the posted writes being sent
+static uint8_t AsyncTxData[TMC5130_CHAIN_BYTES];     //!< Frame of the posted writes being sent
+static uint8_t AsyncRxData[TMC5130_CHAIN_BYTES];     //!< Reply to the posted writes being sent
+static uint32_t SPIWaitCycles;                       //!< CPU cycles spent waiting for the SPI
+static uint32_t SPIAsyncFallbackCount;               //!< Posted write frames sent blocking (SPIMSS driver error)
+
+static void AsyncTransferDone(spimss_req_t *Request, int Error);
+static void PrepareAsyncFrame(void);
+static void HoldTMC5130Writes(void);
+static void ReleaseTMC5130Writes(void);
+static void FinishAsyncFrame(void);
+
+static int TransferTMC5130ReadDatagram(uint8_t Which5130, uint8_t Address);
+static void TransferTMC5130ReadChain(uint8_t Which5130, const uint8_t *Addresses, int *Values, uint32_t Count);
+
+
+/***************************************************************//**
+   \fn IsMCUOwnedRegister(uint8_t Address)
+   \brief Check if a register is only written by the MCU
+   \param Address    Register adress (0x00..0x7f)
+   \return           TRUE for the configuration registers that are
+                     never changed by the TMC5130 itself
+********************************************************************/
+static uint8_t IsMCUOwnedRegister(uint8_t Address)
+{
+  switch(Address)
+  {
+    case TMC5130_GCONF:
+    case TMC5130_IHOLD_IRUN:
+    case TMC5130_SWMODE:
+    case TMC5130_CHOPCONF:
+    case TMC5130_COOLCONF:
+    case TMC5130_PWMCONF:
+      return TRUE;
+
+    default:
+      return FALSE;
+  }
+}
+
+
+/***************************************************************//**
+   \fn UpdateTMC5130SPIStatus(uint8_t Which5130, uint8_t Status)
+   \brief Store the status byte of a datagram
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Status     First byte returned by the TMC5130
+
+  The TMC5130 returns its SPI status (TMC5130_SPI_xxx bits) with
+  every datagram, so it is available without extra accesses.
+********************************************************************/
+static void UpdateTMC5130SPIStatus(uint8_t Which5130, uint8_t Status)
+{
+  SPIStatus[Which5130]=Status;
+  SPIStatusTime[Which5130]=GetSysTimer();
+  SPIStatusValid[Which5130]=TRUE;
+}
+
+
+/***************************************************************//**
+   \fn InvalidateTMC5130SPIStatus(uint8_t Which5130)
+   \brief Mark the SPI status byte as outdated
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+
+  Has to be called for every write to the TMC5130 (sent, posted or
+  deferred): the status returned with a write datagram still shows
+  the state before the write (e.g. "position reached" before the new
+  XTARGET), so only the status of a later datagram is valid again.
+********************************************************************/
+static void InvalidateTMC5130SPIStatus(uint8_t Which5130)
+{
+  SPIStatusValid[Which5130]=FALSE;
+}
+
+
+/***************************************************************//**
+   \fn UpdateTMC5130ChainStatus(const uint8_t *TxData, const uint8_t *RxData)
+   \brief Store the status bytes of all drivers in the daisy chain
+   \param TxData     Frame that has been sent (TMC5130_CHAIN_BYTES bytes)
+   \param RxData     Reply to the frame (TMC5130_CHAIN_BYTES bytes)
+
+  Each driver returns its status in its slot of every frame, also
+  when the frame contains no datagram for it. The status is not
+  taken from a slot containing a write datagram or for a driver
+  that still has deferred writes pending.
+********************************************************************/
+static void UpdateTMC5130ChainStatus(const uint8_t *TxData, const uint8_t *RxData)
+{
+  uint32_t i;
+
+  for(i=0; i<N_O_DRIVERS; i++)
+  {
+    if((TxData[TMC5130_CHAIN_SLOT(i)] & 0x80) || DeferredCount[i]>0)
+      InvalidateTMC5130SPIStatus(i);
+    else
+      UpdateTMC5130SPIStatus(i, RxData[TMC5130_CHAIN_SLOT(i)]);
+  }
+}
+
+
+/***************************************************************//**
+   \fn GetTMC5130SPIStatus(uint8_t Which5130, uint32_t MaxAge, uint8_t *Status)
+   \brief Get the SPI status byte of the last datagram
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param MaxAge     Maximum age of the status (ms)
+   \param Status     Pointer to variable for the status (TMC5130_SPI_xxx bits)
+   \return           TRUE if the status is not older than MaxAge and has
+                     been received after the last write to this driver
+                     (FALSE: the register has to be read)
+
+  The SPI interrupt (posted writes) also updates the status, so the
+  three values are copied with interrupts disabled.
+********************************************************************/
+uint8_t GetTMC5130SPIStatus(uint8_t Which5130, uint32_t MaxAge, uint8_t *Status)
+{
+  uint8_t Valid;
+  uint8_t StatusCopy;
+  uint32_t Time;
+
+  if(Which5130>=N_O_DRIVERS) return FALSE;
+
+  __disable_irq();
+  Valid=SPIStatusValid[Which5130];
+  StatusCopy=SPIStatus[Which5130];
+  Time=SPIStatusTime[Which5130];
+  __enable_irq();
+
+  if(!Valid || GetSysTimer()-Time>MaxAge) return FALSE;
+
+  *Status=StatusCopy;
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn WaitTMC5130Async(void)
+   \brief Wait until all posted writes have been sent
+********************************************************************/
+static void WaitTMC5130Async(void)
+{
+  uint32_t Start;
+
+  if(!AsyncBusy) return;
+
+  Start=GetCycleCounter();
+  while(AsyncBusy) WAIT_FOR_SPI_INTERRUPT();
+  SPIWaitCycles+=GetCycleCounter()-Start;
+}
+
+
+/***************************************************************//**
+   \fn ShiftTMC5130Frame(const uint8_t *TxData, uint8_t *RxData)
+   \brief Shift a frame through the daisy chain (blocking)
+   \param TxData     Frame to be sent (TMC5130_CHAIN_BYTES bytes)
+   \param RxData     Array for the reply (TMC5130_CHAIN_BYTES bytes)
+
+  This is the lowest level transfer function. The time spent here
+  is counted (see GetTMC5130SPIWaitTime()).
+
+  The SPIMSS registers are accessed directly: only the FIFOs are
+  used, so neither the request structure and lock nor the generic
+  FIFO handling of SPIMSS_MasterTrans() is needed. The SPIMSS
+  driver is still used for the posted writes.
+********************************************************************/
+static void ShiftTMC5130Frame(const uint8_t *TxData, uint8_t *RxData)
+{
+  static uint8_t Prepared;
+  uint32_t Start;
+  uint32_t Sent;
+  uint32_t i;
+
+  Start=GetCycleCounter();
+
+#if defined(TMC5130_SIMULATION)
+  SimulateTMC5130Frame(TxData, RxData, TMC5130_CHAIN_BYTES);
+  SPIWaitCycles+=GetCycleCounter()-Start;
+  return;
+#endif
+
+  //Master mode, 8 bit characters (the same setting is used by the SPIMSS driver)
+  if(!Prepared)
+  {
+    MXC_SPIMSS->ctrl&= ~MXC_F_SPIMSS_CTRL_SPIEN;
+    MXC_SPIMSS->ctrl|=MXC_F_SPIMSS_CTRL_MMEN;
+    MXC_SPIMSS->mod|=MXC_F_SPIMSS_MOD_TX_LJ|MXC_F_SPIMSS_CTRL_MMEN|MXC_F_SPIMSS_MOD_SSV;
+    MXC_SETFIELD(MXC_SPIMSS->mod, MXC_F_SPIMSS_MOD_NUMBITS, 8 << MXC_F_SPIMSS_MOD_NUMBITS_POS);
+    Prepared=TRUE;
+  }
+
+  //Fill the TX FIFO, then send the next byte for every byte received
+  MXC_SPIMSS->dma|=MXC_F_SPIMSS_DMA_TX_FIFO_CLEAR|MXC_F_SPIMSS_DMA_RX_FIFO_CLEAR;
+  for(Sent=0; Sent<TMC5130_CHAIN_BYTES && Sent<MXC_SPIMSS_FIFO_DEPTH; Sent++) MXC_SPIMSS->data8[0]=TxData[Sent];
+
+  MXC_SPIMSS->mod&= ~MXC_F_SPIMSS_MOD_SSV;
+  MXC_SPIMSS->ctrl|=MXC_F_SPIMSS_CTRL_SPIEN;
+  for(i=0; i<TMC5130_CHAIN_BYTES; i++)
+  {
+    while(!(MXC_SPIMSS->dma & MXC_F_SPIMSS_DMA_RX_FIFO_CNT));
+    RxData[i]=MXC_SPIMSS->data8[0];
+    if(Sent<TMC5130_CHAIN_BYTES) MXC_SPIMSS->data8[0]=TxData[Sent++];
+  }
+  MXC_SPIMSS->mod|=MXC_F_SPIMSS_MOD_SSV;
+  MXC_SPIMSS->ctrl&= ~MXC_F_SPIMSS_CTRL_SPIEN;
+
+  SPIWaitCycles+=GetCycleCounter()-Start;
+}
+
+
+/***************************************************************//**
+   \fn TransferTMC5130Frame(const uint8_t *TxData, uint8_t *RxData)
+   \brief Send a frame through the daisy chain and wait for the end
+   \param TxData     Frame to be sent (TMC5130_CHAIN_BYTES bytes)
+   \param RxData     Array for the reply (TMC5130_CHAIN_BYTES bytes)
+
+  Posted writes are always sent before.
+********************************************************************/
+static void TransferTMC5130Frame(const uint8_t *TxData, uint8_t *RxData)
+{
+  WaitTMC5130Async();
+  ShiftTMC5130Frame(TxData, RxData);
+
+  SPITransferCount++;
+  UpdateTMC5130ChainStatus(TxData, RxData);
+}
+
+
+/***************************************************************//**
+   \fn TransferTMC5130Datagram(uint8_t Which5130, uint8_t *TxData, uint8_t *RxData)
+   \brief Send a datagram to one TMC5130 and wait for the end
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param TxData     Datagram to be sent (5 bytes)
+   \param RxData     Array for the reply (5 bytes)
+
+  All other drivers in the daisy chain get a read request for GCONF
+  (no side effects) in the same frame.
+********************************************************************/
+static void TransferTMC5130Datagram(uint8_t Which5130, uint8_t *TxData, uint8_t *RxData)
+{
+  uint8_t FrameTx[TMC5130_CHAIN_BYTES];
+  uint8_t FrameRx[TMC5130_CHAIN_BYTES];
+  uint32_t i;
+
+  for(i=0; i<TMC5130_CHAIN_BYTES; i++) FrameTx[i]=0;
+  for(i=0; i<5; i++) FrameTx[TMC5130_CHAIN_SLOT(Which5130)+i]=TxData[i];
+
+  TransferTMC5130Frame(FrameTx, FrameRx);
+
+  for(i=0; i<5; i++) RxData[i]=FrameRx[TMC5130_CHAIN_SLOT(Which5130)+i];
+}
+
+
+/***************************************************************//**
+   \fn TransferTMC5130WriteDatagram(uint8_t Which5130, uint8_t Address, int Value)
+   \brief Send a write datagram to the TMC5130
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Address    Register adress (0x00..0x7f)
+   \param Value      Value to be written
+********************************************************************/
+static void TransferTMC5130WriteDatagram(uint8_t Which5130, uint8_t Address, int Value)
+{
+  uint8_t SPITxData[5];
+  uint8_t SPIRxData[5];
+
+  SPITxData[0]=Address|0x80;
+  SPITxData[1]=Value >> 24;
+  SPITxData[2]=Value >> 16;
+  SPITxData[3]=Value >> 8;
+  SPITxData[4]=Value & 0xff;
+  TransferTMC5130Datagram(Which5130, SPITxData, SPIRxData);
+}
+
+
+/***************************************************************//**
+   \fn StartAsyncTransfer(void)
+   \brief Start sending the next posted writes
+
+   Consecutive posted writes to different drivers of the daisy chain
+   are combined into one frame. Has to be called with interrupts
+   disabled or from the SPI interrupt.
+
+   If the SPIMSS driver cannot start the transfer, the frame is sent
+   here (blocking), so that AsyncBusy never stays set without a
+   completion callback.
+********************************************************************/
+static void StartAsyncTransfer(void)
+{
+  while(AsyncHead!=AsyncTail)
+  {
+    AsyncBusy=TRUE;
+    PrepareAsyncFrame();
+
+    AsyncRequest.ssel=0;
+    AsyncRequest.deass=1;
+    AsyncRequest.tx_data=AsyncTxData;
+    AsyncRequest.rx_data=AsyncRxData;
+    AsyncRequest.len=TMC5130_CHAIN_BYTES;
+    AsyncRequest.bits=8;
+    AsyncRequest.callback=AsyncTransferDone;
+    if(SPIMSS_MasterTransAsync(MXC_SPIMSS, &AsyncRequest)==E_NO_ERROR) return;
+
+    SPIAsyncFallbackCount++;
+    ShiftTMC5130Frame(AsyncTxData, AsyncRxData);
+    FinishAsyncFrame();
+  }
+
+  AsyncBusy=FALSE;
+}
+
+
+/***************************************************************//**
+   \fn PrepareAsyncFrame(void)
+   \brief Build the frame of the next posted writes
+
+   Puts the next posted writes into AsyncTxData and their number
+   into AsyncCount.
+********************************************************************/
+static void PrepareAsyncFrame(void)
+{
+  TAsyncWrite *Write;
+  uint32_t Used;
+  uint32_t Index;
+  uint8_t *Slot;
+  uint32_t i;
+
+  for(i=0; i<TMC5130_CHAIN_BYTES; i++) AsyncTxData[i]=0;
+
+  Used=0;
+  AsyncCount=0;
+  for(Index=AsyncHead; Index!=AsyncTail; Index=(Index+1) % TMC5130_ASYNC_QUEUE)
+  {
+    Write=&AsyncQueue[Index];
+    if(Used & (1UL<<Write->Which5130)) break;  //keep the order of the writes to one driver
+    Used|=1UL<<Write->Which5130;
+    AsyncCount++;
+
+    Slot=&AsyncTxData[TMC5130_CHAIN_SLOT(Write->Which5130)];
+    Slot[0]=Write->Address|0x80;
+    Slot[1]=Write->Value >> 24;
+    Slot[2]=Write->Value >> 16;
+    Slot[3]=Write->Value >> 8;
+    Slot[4]=Write->Value & 0xff;
+  }
+}
+
+
+/***************************************************************//**
+   \fn FinishAsyncFrame(void)
+   \brief Remove the posted writes that have been sent from the queue
+
+  Also stores the SPI status bytes. While more posted writes are
+  queued the status bytes are not stored, as they do not yet show
+  the effect of these writes.
+********************************************************************/
+static void FinishAsyncFrame(void)
+{
+  AsyncHead=(AsyncHead+AsyncCount) % TMC5130_ASYNC_QUEUE;
+
+  SPITransferCount++;
+  if(AsyncHead==AsyncTail) UpdateTMC5130ChainStatus(AsyncTxData, AsyncRxData);
+}
+
+
+/***************************************************************//**
+   \fn AsyncTransferDone(spimss_req_t *Request, int Error)
+   \brief Completion callback of posted writes (SPI interrupt)
+   \param Request    SPI request (AsyncRequest)
+   \param Error      E_NO_ERROR if successful
+
+  Ends the frame (slave select high), stores the SPI status bytes
+  and starts the next posted writes. A frame that has failed is sent
+  again (blocking), as the software copy already contains its values.
+********************************************************************/
+static void AsyncTransferDone(spimss_req_t *Request, int Error)
+{
+  (void) Request;
+
+  MXC_SPIMSS->mod|=MXC_F_SPIMSS_MOD_SSV;
+  MXC_SPIMSS->ctrl&= ~MXC_F_SPIMSS_CTRL_SPIEN;
+
+  if(Error!=E_NO_ERROR)
+  {
+    SPIAsyncFallbackCount++;
+    ShiftTMC5130Frame(AsyncTxData, AsyncRxData);
+  }
+
+  FinishAsyncFrame();
+  StartAsyncTransfer();
+}
+
+
+/***************************************************************//**
+   \fn SPI1_IRQHandler(void)
+   \brief SPIMSS interrupt handler
+********************************************************************/
+void SPI1_IRQHandler(void)
+{
+  SPIMSS_Handler(MXC_SPIMSS);
+}
+
+
+/***************************************************************//**
+   \fn QueueTMC5130Write(uint8_t Which5130, uint8_t Address, int Value)
+   \brief Append a write datagram to the asynchronous queue
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Address    Register adress (0x00..0x7f)
+   \param Value      Value to be written
+
+  Only waits if the queue is full.
+********************************************************************/
+static void QueueTMC5130Write(uint8_t Which5130, uint8_t Address, int Value)
+{
+  uint32_t Next;
+  uint32_t Start;
+
+  Next=(AsyncTail+1) % TMC5130_ASYNC_QUEUE;
+  if(Next==AsyncHead)
+  {
+    Start=GetCycleCounter();
+    __disable_irq();
+    if(!AsyncBusy) StartAsyncTransfer();  //queue full of held writes
+    __enable_irq();
+    while(Next==AsyncHead) WAIT_FOR_SPI_INTERRUPT();
+    SPIWaitCycles+=GetCycleCounter()-Start;
+  }
+
+  AsyncQueue[AsyncTail].Which5130=Which5130;
+  AsyncQueue[AsyncTail].Address=Address;
+  AsyncQueue[AsyncTail].Value=Value;
+
+  __disable_irq();
+  InvalidateTMC5130SPIStatus(Which5130);
+  AsyncTail=Next;
+  if(!AsyncBusy && !AsyncHold) StartAsyncTransfer();
+  __enable_irq();
+}
+
+
+/***************************************************************//**
+   \fn HoldTMC5130Writes(void)
+   \brief Only queue the following posted writes
+
+  Otherwise the first posted write of a burst would go out alone,
+  as the transfer is started immediately. This would shift the
+  writes of a burst for several drivers by one frame, so that e.g.
+  XTARGET of the first driver is sent together with VMAX of the
+  others. ReleaseTMC5130Writes() starts sending. A full queue is
+  still sent (see QueueTMC5130Write()). No other access is allowed
+  before ReleaseTMC5130Writes().
+********************************************************************/
+static void HoldTMC5130Writes(void)
+{
+  AsyncHold=TRUE;
+}
+
+
+/***************************************************************//**
+   \fn ReleaseTMC5130Writes(void)
+   \brief Start sending the writes queued since HoldTMC5130Writes()
+********************************************************************/
+static void ReleaseTMC5130Writes(void)
+{
+  AsyncHold=FALSE;
+
+  __disable_irq();
+  if(!AsyncBusy) StartAsyncTransfer();
+  __enable_irq();
+}
+
+
+/***************************************************************//**
+   \fn FlushTMC5130Writes(uint8_t Which5130)
+   \brief Send all deferred writes to the TMC5130
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+
+  The deferred writes are posted (see PostTMC5130Write()) in the order
+  in which the registers have been written first by
+  WriteTMC5130Deferred(). This is also done automatically before every
+  other access to the TMC5130, so deferred writes never overtake an
+  immediate write or a read.
+********************************************************************/
+void FlushTMC5130Writes(uint8_t Which5130)
+{
+  uint32_t i;
+  uint8_t Address;
+
+  for(i=0; i<DeferredCount[Which5130]; i++)
+  {
+    Address=DeferredWrites[Which5130][i];
+    if(ShadowDirty[Which5130][Address>>5] & ADDRESS_BIT(Address))
+    {
+      QueueTMC5130Write(Which5130, Address, SHADOW(Which5130, Address));
+      ShadowDirty[Which5130][Address>>5]&= ~ADDRESS_BIT(Address);
+      ShadowValid[Which5130][Address>>5]|=ADDRESS_BIT(Address);
+    }
+  }
+  DeferredCount[Which5130]=0;
+}
+
+
+/***************************************************************//**
+   \fn FlushAllTMC5130Writes(void)
+   \brief Send the deferred writes of all drivers together
+
+  Like FlushTMC5130Writes() for every driver, but the writes are
+  posted alternately for all drivers, so that the n-th deferred
+  write of every driver goes out in the same daisy chain frame
+  (e.g. for starting several axes at the same time).
+********************************************************************/
+void FlushAllTMC5130Writes(void)
+{
+  uint32_t i;
+  uint32_t Which5130;
+  uint8_t Address;
+  uint8_t Pending;
+
+  HoldTMC5130Writes();
+  for(i=0; i<TMC5130_MAX_DEFERRED; i++)
+  {
+    Pending=FALSE;
+    for(Which5130=0; Which5130<N_O_DRIVERS; Which5130++)
+    {
+      if(i>=DeferredCount[Which5130]) continue;
+
+      Pending=TRUE;
+      Address=DeferredWrites[Which5130][i];
+      if(ShadowDirty[Which5130][Address>>5] & ADDRESS_BIT(Address))
+      {
+        QueueTMC5130Write(Which5130, Address, SHADOW(Which5130, Address));
+        ShadowDirty[Which5130][Address>>5]&= ~ADDRESS_BIT(Address);
+        ShadowValid[Which5130][Address>>5]|=ADDRESS_BIT(Address);
+      }
+    }
+    if(!Pending) break;
+  }
+
+  for(Which5130=0; Which5130<N_O_DRIVERS; Which5130++) DeferredCount[Which5130]=0;
+  ReleaseTMC5130Writes();
+}
+
+
+/***************************************************************//**
+   \fn InvalidateTMC5130Shadow(uint8_t Which5130)
+   \brief Mark the software copy as unknown
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+
+  After this the next write to each register is always sent to the
+  TMC5130. Has to be called when the TMC5130 might have lost its
+  register contents (e.g. reset by undervoltage).
+********************************************************************/
+void InvalidateTMC5130Shadow(uint8_t Which5130)
+{
+  uint32_t i;
+
+  if(Which5130>=N_O_DRIVERS) return;
+
+  FlushTMC5130Writes(Which5130);
+  for(i=0; i<4; i++) ShadowValid[Which5130][i]=0;
+}
+
 
 /***************************************************************//**
    \fn WriteTMC5130Datagram(uint8_t Which5130, uint8_t Address, uint8_t x1, uint8_t x2, uint8_t x3, uint8_t x4)
    \brief Write bytes to a TMC5130 register
-   \param Which5130  Index of TMC5130 to be used (with stepRocker always 0)
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
    \param Address    Register adress (0x00..0x7f)
    \param x1        First byte to write (MSB)
    \param x2        Second byte to write
@@ -65,165 +808,466 @@ static uint8_t LastTOffSetting[N_O_MOTORS];         //!< Last TOff setting befor
 ********************************************************************/
 void WriteTMC5130Datagram(uint8_t Which5130, uint8_t Address, uint8_t x1, uint8_t x2, uint8_t x3, uint8_t x4)
 {
-  int Value;
-  spimss_req_t SPIRequest;
-  uint8_t SPITxData[5];
-  uint8_t SPIRxData[5];
+  WriteTMC5130Int(Which5130, Address, (x1<<24)|(x2<<16)|(x3<<8)|x4);
+}
 
-  //Emulate W1C-Bits of the TMC5160
-  if((Address & 0x7f) == TMC5130_RAMPSTAT)
+
+/***************************************************************//**
+   \fn WriteTMC5130Int(uint8_t Which5130, uint8_t Address, int Value)
+   \brief Write a 32 bit value to a TMC5130 register
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Address    Registeradresse (0x00..0x7f)
+   \param Value      Value to be written
+
+  This is a low level function for writing data to a TMC5130 register
+  (32 bit value). The write is skipped if the register already
+  contains this value (software copy valid and register not volatile).
+********************************************************************/
+void WriteTMC5130Int(uint8_t Which5130, uint8_t Address, int Value)
+{
+  if(Which5130>=N_O_DRIVERS) return;
+
+  Address&=0x7f;
+
+  //Emulate W1C-Bits emulieren of the TMC5130
+  #if !defined(DEVTYPE_TMC5160)
+  if(Address == TMC5130_RAMPSTAT)
   {
-    Value=x1;
-    Value<<=8;
-    Value|=x2;
-    Value<<=8;
-    Value|=x3;
-    Value<<=8;
-    Value|=x4;
-    Value&=(BIT12|BIT7|BIT6|BIT3|BIT2);
-    TMC5130SoftwareCopy[Address & 0x7f][Which5130]&= ~Value;
+    Value&=RAMPSTAT_W1C_BITS;
+    SHADOW(Which5130, Address)&= ~Value;
     return;
   }
+  #endif
 
-  //Write to TMC5130 register
-  SPITxData[0]=Address|0x80;
-  SPITxData[1]=x1;
-  SPITxData[2]=x2;
-  SPITxData[3]=x3;
-  SPITxData[4]=x4;
-  SPIRequest.ssel=0;
-  SPIRequest.deass=1;
-  SPIRequest.tx_data=SPITxData;
-  SPIRequest.rx_data=SPIRxData;
-  SPIRequest.len=5;
-  SPIRequest.bits=8;
-  SPIRequest.callback=NULL;
-  SPIMSS_MasterTrans(MXC_SPIMSS, &SPIRequest);
-
-  //Update software copy
-  Value=x1;
-  Value<<=8;
-  Value|=x2;
-  Value<<=8;
-  Value|=x3;
-  Value<<=8;
-  Value|=x4;
-  TMC5130SoftwareCopy[Address & 0x7f][Which5130]=Value;
+  FlushTMC5130Writes(Which5130);
+
+  if(!IS_VOLATILE(Address))
+  {
+    if((ShadowValid[Which5130][Address>>5] & ADDRESS_BIT(Address)) && SHADOW(Which5130, Address)==Value)
+    {
+      SPISavedWriteCount++;
+      return;
+    }
+    ShadowValid[Which5130][Address>>5]|=ADDRESS_BIT(Address);
+  }
+
+  //Write to TMC5130 register and update software copy
+  TransferTMC5130WriteDatagram(Which5130, Address, Value);
+  SHADOW(Which5130, Address)=Value;
 }
 
 
 /***************************************************************//**
-   \fn WriteTMC5130Int(uint8_t Which5130, uint8_t Address, int Value)
-   \brief Write a 32 bit value to a TMC5130 register
-   \param Which5130  Index of TMC5130 to be used (with stepRocker always 0)
+   \fn PostTMC5130Write(uint8_t Which5130, uint8_t Address, int Value)
+   \brief Write a 32 bit value to a TMC5130 register without waiting
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
    \param Address    Registeradresse (0x00..0x7f)
    \param Value      Value to be written
 
-  This is a low level function for writing data to a TMC5130 register
-  (32 bit value).
+  Like WriteTMC5130Int(), but the datagram is sent in the background
+  (SPI interrupt). The software copy is updated immediately. All
+  other accesses wait until the posted writes have been sent, so the
+  order of the accesses is kept.
 ********************************************************************/
-void WriteTMC5130Int(uint8_t Which5130, uint8_t Address, int Value)
+void PostTMC5130Write(uint8_t Which5130, uint8_t Address, int Value)
+{
+  if(Which5130>=N_O_DRIVERS) return;
+
+  Address&=0x7f;
+  #if !defined(DEVTYPE_TMC5160)
+  if(Address==TMC5130_RAMPSTAT)
+  {
+    WriteTMC5130Int(Which5130, Address, Value);
+    return;
+  }
+  #endif
+
+  FlushTMC5130Writes(Which5130);
+
+  if(!IS_VOLATILE(Address))
+  {
+    if((ShadowValid[Which5130][Address>>5] & ADDRESS_BIT(Address)) && SHADOW(Which5130, Address)==Value)
+    {
+      SPISavedWriteCount++;
+      return;
+    }
+    ShadowValid[Which5130][Address>>5]|=ADDRESS_BIT(Address);
+  }
+
+  SHADOW(Which5130, Address)=Value;
+  QueueTMC5130Write(Which5130, Address, Value);
+}
+
+
+/***************************************************************//**
+   \fn WriteTMC5130Deferred(uint8_t Which5130, uint8_t Address, int Value)
+   \brief Write a TMC5130 register later
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Address    Registeradresse (0x00..0x7f)
+   \param Value      Value to be written
+
+  Like WriteTMC5130Int(), but the value is only stored in the software
+  copy and sent by FlushTMC5130Writes() or before the next immediate
+  access. Several deferred writes to the same register result in one
+  SPI transfer. Volatile registers are written immediately.
+********************************************************************/
+void WriteTMC5130Deferred(uint8_t Which5130, uint8_t Address, int Value)
+{
+  if(Which5130>=N_O_DRIVERS) return;
+
+  Address&=0x7f;
+  if(IS_VOLATILE(Address))
+  {
+    WriteTMC5130Int(Which5130, Address, Value);
+    return;
+  }
+
+  if(ShadowDirty[Which5130][Address>>5] & ADDRESS_BIT(Address))
+  {
+    //Already pending => just replace the value
+    SHADOW(Which5130, Address)=Value;
+    SPISavedWriteCount++;
+    return;
+  }
+
+  if((ShadowValid[Which5130][Address>>5] & ADDRESS_BIT(Address)) && SHADOW(Which5130, Address)==Value)
+  {
+    SPISavedWriteCount++;
+    return;
+  }
+
+  if(DeferredCount[Which5130]>=TMC5130_MAX_DEFERRED) FlushTMC5130Writes(Which5130);
+  DeferredWrites[Which5130][DeferredCount[Which5130]++]=Address;
+  ShadowDirty[Which5130][Address>>5]|=ADDRESS_BIT(Address);
+  SHADOW(Which5130, Address)=Value;
+  InvalidateTMC5130SPIStatus(Which5130);
+}
+
+
+/***************************************************************//**
+   \fn GetTMC5130TransferCount(void)
+   \return Number of SPI datagrams sent to the TMC5130 since reset
+********************************************************************/
+uint32_t GetTMC5130TransferCount(void)
+{
+  return SPITransferCount;
+}
+
+
+/***************************************************************//**
+   \fn GetTMC5130SavedWriteCount(void)
+   \return Number of register writes skipped because the register
+           already contained the value
+********************************************************************/
+uint32_t GetTMC5130SavedWriteCount(void)
+{
+  return SPISavedWriteCount;
+}
+
+
+/***************************************************************//**
+   \fn GetTMC5130SPIWaitTime(void)
+   \return CPU time (µs) spent waiting for SPI transfers since reset
+********************************************************************/
+uint32_t GetTMC5130SPIWaitTime(void)
+{
+  return SPIWaitCycles/(SystemCoreClock/1000000);
+}
+
+
+/***************************************************************//**
+   \fn RestoreTMC5130Registers(uint8_t Which5130)
+   \brief Write all known register values to the TMC5130 again
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+
+  XTARGET and RAMPMODE are not restored, as this could start a
+  motion. They are written again with the next move command.
+********************************************************************/
+static void RestoreTMC5130Registers(uint8_t Which5130)
+{
+  uint32_t i;
+  uint8_t Address;
+
+  ShadowValid[Which5130][TMC5130_RAMPMODE>>5]&= ~(ADDRESS_BIT(TMC5130_RAMPMODE)|ADDRESS_BIT(TMC5130_XTARGET));
+
+  for(i=0; i<sizeof(TMC5130Registers); i++)
+  {
+    Address=TMC5130Registers[i];
+    if(!IS_VOLATILE(Address) && (ShadowValid[Which5130][Address>>5] & ADDRESS_BIT(Address)))
+      TransferTMC5130WriteDatagram(Which5130, Address, SHADOW(Which5130, Address));
+  }
+  ShadowRestoreCount++;
+}
+
+
+/***************************************************************//**
+   \fn VerifyTMC5130Registers(uint8_t Which5130)
+   \brief Check the TMC5130 registers against the software copy
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \return           TRUE if the registers had to be restored
+
+  Reads GSTAT and the readable MCU owned registers (pipelined). If the
+  TMC5130 has been reset or one of these registers differs from the
+  software copy all known register values are written again. Should be
+  called periodically.
+********************************************************************/
+uint8_t VerifyTMC5130Registers(uint8_t Which5130)
+{
+  static const uint8_t VerifyRegisters[]={TMC5130_GSTAT, TMC5130_GCONF, TMC5130_SWMODE, TMC5130_CHOPCONF};
+  uint32_t i;
+  uint8_t Address;
+  uint8_t Mismatch;
+  int Values[sizeof(VerifyRegisters)];
+
+  if(Which5130>=N_O_DRIVERS) return FALSE;
+
+  FlushTMC5130Writes(Which5130);
+
+  //The raw values are compared, so FinishTMC5130Read() is not used here.
+  Mismatch=FALSE;
+  TransferTMC5130ReadChain(Which5130, VerifyRegisters, Values, sizeof(VerifyRegisters));
+  for(i=0; i<sizeof(VerifyRegisters); i++)
+  {
+    Address=VerifyRegisters[i];
+    if(Address==TMC5130_GSTAT)
+    {
+      if(Values[i] & BIT0) Mismatch=TRUE;
+    }
+    else if((ShadowValid[Which5130][Address>>5] & ADDRESS_BIT(Address)) && SHADOW(Which5130, Address)!=Values[i])
+    {
+      Mismatch=TRUE;
+    }
+  }
+  if(!Mismatch) return FALSE;
+
+  RestoreTMC5130Registers(Which5130);
+  TransferTMC5130WriteDatagram(Which5130, TMC5130_GSTAT, BIT0);  //clear the reset flag
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn GetTMC5130RestoreCount(void)
+   \return Number of register restores done by VerifyTMC5130Registers()
+********************************************************************/
+uint32_t GetTMC5130RestoreCount(void)
+{
+  return ShadowRestoreCount;
+}
+
+
+/***************************************************************//**
+   \fn GetTMC5130AsyncFallbackCount(void)
+   \return Number of posted write frames that had to be sent blocking
+           because the SPIMSS driver could not start or complete
+           the transfer
+********************************************************************/
+uint32_t GetTMC5130AsyncFallbackCount(void)
+{
+  return SPIAsyncFallbackCount;
+}
+
+
+/***************************************************************//**
+   \fn TransferTMC5130ReadDatagram(uint8_t Which5130, uint8_t Address)
+   \brief Send a read datagram to the TMC5130
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Address    Register to be read with the next datagram
+   \return           Data returned by the TMC5130 (result of the read
+                     request sent with the previous datagram)
+
+  This is the lowest level read function. The TMC5130 returns
+  the data of a read request with the next datagram, so a read
+  access always needs two datagrams. When reading several registers
+  the second datagram can already be the next read request.
+********************************************************************/
+static int TransferTMC5130ReadDatagram(uint8_t Which5130, uint8_t Address)
 {
-  spimss_req_t SPIRequest;
   uint8_t SPITxData[5];
   uint8_t SPIRxData[5];
 
-  if(Which5130!=0) return;
+  SPITxData[0]=Address;
+  SPITxData[1]=0;
+  SPITxData[2]=0;
+  SPITxData[3]=0;
+  SPITxData[4]=0;
+  TransferTMC5130Datagram(Which5130, SPITxData, SPIRxData);
 
-  //Emulate W1C-Bits emulieren of the TMC5130
-  if((Address & 0x7f) == TMC5130_RAMPSTAT)
+  return (SPIRxData[1]<<24)|(SPIRxData[2]<<16)|(SPIRxData[3]<<8)|SPIRxData[4];
+}
+
+
+/***************************************************************//**
+   \fn TransferTMC5130ReadChain(uint8_t Which5130, const uint8_t *Addresses, int *Values, uint32_t Count)
+   \brief Read several registers with chained read datagrams
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Addresses  Registers to be read (must all be readable)
+   \param Values     Array for the raw values (Count elements)
+   \param Count      Number of registers to be read
+
+  Every datagram requests the next register and returns the data
+  of the previous request, so Count registers take Count+1 datagrams.
+********************************************************************/
+static void TransferTMC5130ReadChain(uint8_t Which5130, const uint8_t *Addresses, int *Values, uint32_t Count)
+{
+  uint32_t i;
+
+  if(Count==0) return;
+
+  TransferTMC5130ReadDatagram(Which5130, Addresses[0]);
+  for(i=1; i<Count; i++) Values[i-1]=TransferTMC5130ReadDatagram(Which5130, Addresses[i]);
+  Values[Count-1]=TransferTMC5130ReadDatagram(Which5130, 0);
+}
+
+
+/***************************************************************//**
+   \fn FinishTMC5130Read(uint8_t Which5130, uint8_t Address, int Value)
+   \brief Post-process a value read from a TMC5130 register
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Address    Register adress (0x00..0x7f)
+   \param Value      Raw value read from the register
+   \return           Value to be used by the application
+
+  Emulates the W1C bits of RAMPSTAT and sign extends the
+  24 bit velocity registers. The value of a non-volatile register
+  is also taken over into the software copy.
+********************************************************************/
+static int FinishTMC5130Read(uint8_t Which5130, uint8_t Address, int Value)
+{
+  if(!IS_VOLATILE(Address))
   {
-    Value&=(BIT12|BIT7|BIT6|BIT3|BIT2);
-    TMC5130SoftwareCopy[Address & 0x7f][Which5130]&= ~Value;
-    return;
+    SHADOW(Which5130, Address)=Value;
+    ShadowValid[Which5130][Address>>5]|=ADDRESS_BIT(Address);
   }
 
-  //Write to TMC5130 register
-  SPITxData[0]=Address|0x80;
-  SPITxData[1]=Value >> 24;
-  SPITxData[2]=Value >> 16;
-  SPITxData[3]=Value >> 8;
-  SPITxData[4]=Value & 0xff;
-  SPIRequest.ssel=0;
-  SPIRequest.deass=1;
-  SPIRequest.tx_data=SPITxData;
-  SPIRequest.rx_data=SPIRxData;
-  SPIRequest.len=5;
-  SPIRequest.bits=8;
-  SPIRequest.callback=NULL;
-  SPIMSS_MasterTrans(MXC_SPIMSS, &SPIRequest);
+  //Emulate W1C-Bits of the TMC5160
+  #if !defined(DEVTYPE_TMC5160)
+  if(Address==TMC5130_RAMPSTAT)
+  {
+    SHADOW(Which5130, Address)&=RAMPSTAT_W1C_BITS;
+    SHADOW(Which5130, Address)|=Value;
+    Value=SHADOW(Which5130, Address);
+  }
+  #endif
+
+  //Sign extend VACTUAL register (24 bits => 32 bits)
+  if(Address==0x22 || Address==0x42)
+  {
+    if(Value & BIT23) Value|=0xff000000;
+  }
 
-  //Update software copy
-  TMC5130SoftwareCopy[Address & 0x7f][Which5130]=Value;
+  return Value;
 }
 
 
 /***************************************************************//**
    \fn ReadTMC5130Int(uint8_t Which5130, uint8_t Address)
-   \brief Write a 32 bit value to a TMC5130 register
-   \param Which5130  Index of TMC5130 to be used (with stepRocker always 0)
+   \brief Read a 32 bit value from a TMC5130 register
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
    \param Address    Registeradresse (0x00..0x7f)
    \return           Value read from the register
 
-  This is a low level function for writing data to a TMC5130 register
-  (32 bit value).
+  This is a low level function for reading data from a TMC5130 register
+  (32 bit value). Registers which are only written by the MCU (see
+  IsMCUOwnedRegister()) are taken from the software copy when it is
+  valid, so that read-modify-write accesses need no SPI read.
 ********************************************************************/
 int ReadTMC5130Int(uint8_t Which5130, uint8_t Address)
 {
-  int Value;
-  spimss_req_t SPIRequest;
-  uint8_t SPITxData[5];
-  uint8_t SPIRxData[5];
-
-  if(Which5130!=0) return 0;
+  if(Which5130>=N_O_DRIVERS) return 0;
 
   Address&=0x7f;
-  if(TMC5130RegisterReadable[Address])
+  if(IS_READABLE(Address) &&
+     !(IsMCUOwnedRegister(Address) && (ShadowValid[Which5130][Address>>5] & ADDRESS_BIT(Address))))
   {
     //Register readavle => read from TMC5130.
     //Two read accesses are needed for this.
-    SPITxData[0]=Address;
-    SPITxData[1]=0;
-    SPITxData[2]=0;
-    SPITxData[3]=0;
-    SPITxData[4]=0;
-    SPIRequest.ssel=0;
-    SPIRequest.deass=1;
-    SPIRequest.tx_data=SPITxData;
-    SPIRequest.rx_data=SPIRxData;
-    SPIRequest.len=5;
-    SPIRequest.bits=8;
-    SPIRequest.callback=NULL;
-    SPIMSS_MasterTrans(MXC_SPIMSS, &SPIRequest);
-
     //Always use register 0 (GCONF) for the second access.
-    SPITxData[0]=0;
-    SPIMSS_MasterTrans(MXC_SPIMSS, &SPIRequest);
-    Value=(SPIRxData[1]<<24)|(SPIRxData[2]<<16)|(SPIRxData[3]<<8)|SPIRxData[4];
+    FlushTMC5130Writes(Which5130);
+    TransferTMC5130ReadDatagram(Which5130, Address);
+    return FinishTMC5130Read(Which5130, Address, TransferTMC5130ReadDatagram(Which5130, 0));
+  }
+  else
+  {
+    //Register not readable or only written by the MCU => return software copy
+    return SHADOW(Which5130, Address);
+  }
+}
 
-    //Emulate W1C-Bits of the TMC5160
-    #if !defined(DEVTYPE_TMC5160)
-    if(Address==TMC5130_RAMPSTAT)
-    {
-      TMC5130SoftwareCopy[Address][Which5130]&=(BIT12|BIT7|BIT6|BIT3|BIT2);
-      TMC5130SoftwareCopy[Address][Which5130]|=Value;
-      Value=TMC5130SoftwareCopy[Address][Which5130];
-    }
-    #endif
 
-    //Sign extend VACTUAL register (24 bits => 32 bits)
-    if(Address==0x22 || Address==0x42)
+/***************************************************************//**
+   \fn ReadTMC5130Multiple(uint8_t Which5130, const uint8_t *Addresses, int *Values, uint32_t Count)
+   \brief Read several TMC5130 registers
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Addresses  Registers to be read
+   \param Values     Array for the values read (Count elements)
+   \param Count      Number of registers to be read
+
+  Like ReadTMC5130Int(), but the read requests are pipelined: every
+  datagram already requests the next register, so reading n readable
+  registers takes n+1 datagrams instead of 2n.
+********************************************************************/
+void ReadTMC5130Multiple(uint8_t Which5130, const uint8_t *Addresses, int *Values, uint32_t Count)
+{
+  uint32_t i;
+  int Pending;
+  int Value;
+  uint8_t Address;
+
+  if(Which5130>=N_O_DRIVERS)
+  {
+    for(i=0; i<Count; i++) Values[i]=0;
+    return;
+  }
+
+  FlushTMC5130Writes(Which5130);
+  Pending=-1;  //index of the value that comes back with the next datagram
+  for(i=0; i<Count; i++)
+  {
+    Address=Addresses[i] & 0x7f;
+    if(IS_READABLE(Address))
     {
-      if(Value & BIT23) Value|=0xff000000;
+      Value=TransferTMC5130ReadDatagram(Which5130, Address);
+      if(Pending>=0) Values[Pending]=FinishTMC5130Read(Which5130, Addresses[Pending] & 0x7f, Value);
+      Pending=i;
     }
+    else Values[i]=SHADOW(Which5130, Address);
+  }
 
-    return Value;
+  if(Pending>=0)
+  {
+    Value=TransferTMC5130ReadDatagram(Which5130, 0);
+    Values[Pending]=FinishTMC5130Read(Which5130, Addresses[Pending] & 0x7f, Value);
   }
-  else
+}
+
+
+/***************************************************************//**
+   \fn ReadTMC5130Snapshot(uint8_t Which5130, uint8_t *Addresses, int *Values, uint8_t *Readable)
+   \brief Read all TMC5130 registers
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
+   \param Addresses  Array for the register addresses (TMC5130_SNAPSHOT_SIZE elements)
+   \param Values     Array for the register values (TMC5130_SNAPSHOT_SIZE elements)
+   \param Readable   Array for the source of the values (TMC5130_SNAPSHOT_SIZE elements):
+                     TRUE: read from the TMC5130, FALSE: software copy
+   \return           Number of registers
+
+  Readable registers are read from the TMC5130 using pipelined
+  read accesses, for all other registers the software copy is used.
+********************************************************************/
+uint32_t ReadTMC5130Snapshot(uint8_t Which5130, uint8_t *Addresses, int *Values, uint8_t *Readable)
+{
+  uint32_t i;
+
+  for(i=0; i<TMC5130_SNAPSHOT_SIZE; i++)
   {
-    //Register not readable => return software copy
-    return TMC5130SoftwareCopy[Address][Which5130];
+    Addresses[i]=TMC5130Registers[i];
+    Readable[i]=IS_READABLE(TMC5130Registers[i])!=0;
   }
+  ReadTMC5130Multiple(Which5130, TMC5130Registers, Values, TMC5130_SNAPSHOT_SIZE);
+
+  return TMC5130_SNAPSHOT_SIZE;
 }
 
 
@@ -1169,7 +2213,7 @@ uint8_t GetTMC5130PWMAmpl(uint8_t Motor)
 /***************************************************************//**
    \fn Read5130State(uint8_t Which5130, uint32_t *StallGuard, uint8_t *SmartEnergy, uint8_t *Flags)
    \brief Get TMC5130 status from TMC4361 polling mechanism
-   \param Which5130  Index of TMC5130 to be used (with stepRocker always 0)
+   \param Which5130  Index of TMC5130 to be used (position in the daisy chain)
    \param StallGuard   Pointer at uint32_t for stallGuard value
    \param SmartEnergy  Pointer at uint8_t for smartEnergy value
    \param Flags   Pointer at uint8_t for driver error flags
@@ -1190,6 +2234,38 @@ void Read5130State(uint8_t Which5130, uint32_t *StallGuard, uint8_t *SmartEnergy
 }
 
 
+//! Register value written by InitMotorDrivers()
+typedef struct
+{
+  uint8_t Address;     //!< register address
+  int Value;           //!< initial value
+} TInitValue;
+
+//! Register values written by InitMotorDrivers() (in this order)
+static const TInitValue TMC5130InitValues[]=
+{
+  {TMC5130_GCONF,      TMC5130_GCONF_DIAG_SETTING},
+  {TMC5130_CHOPCONF,   0x00010255},
+  {TMC5130_IHOLD_IRUN, 0x00070f01},
+  {TMC5130_PWMCONF,    TMC5130_PWMCONF_DEFAULT},
+
+  {TMC5130_RAMPMODE,   TMC5130_MODE_POSITION},
+  {TMC5130_XTARGET,    0},
+  {TMC5130_XACTUAL,    0},
+
+  {TMC5130_VSTART,     1},
+  {TMC5130_A1,         25600/ACC_FACTOR},
+  {TMC5130_V1,         25600/VEL_FACTOR},
+  {TMC5130_AMAX,       51200/ACC_FACTOR},
+  {TMC5130_VMAX,       51200/VEL_FACTOR},
+  {TMC5130_DMAX,       51200/ACC_FACTOR},
+  {TMC5130_D1,         25600/ACC_FACTOR},
+  {TMC5130_VSTOP,      10/VEL_FACTOR},
+
+  {TMC5130_TCOOLTHRS,  1048575}
+};
+
+
 /***************************************************************//**
    \fn InitMotorDrivers(void)
    \brief Initialise all motor drivers
@@ -1201,36 +2277,27 @@ void Read5130State(uint8_t Which5130, uint32_t *StallGuard, uint8_t *SmartEnergy
 void InitMotorDrivers(void)
 {
   int Delay;
+  uint32_t Register;
   int i;
 
   //Short delay (TMC5130 power-on reset)
   Delay=GetSysTimer();
   while(abs(GetSysTimer()-Delay)<10);
 
+  //The initialisation is sent as a burst of posted writes, register by
+  //register for all drivers, so that each frame initialises all drivers.
+  HoldTMC5130Writes();
+  for(Register=0; Register<sizeof(TMC5130InitValues)/sizeof(TMC5130InitValues[0]); Register++)
+  {
+    for(i=0; i<N_O_MOTORS; i++)
+      PostTMC5130Write(i, TMC5130InitValues[Register].Address, TMC5130InitValues[Register].Value);
+  }
+  ReleaseTMC5130Writes();
+
   for(i=0; i<N_O_MOTORS; i++)
   {
-    WriteTMC5130Int(i, TMC5130_GCONF, 0);
-    WriteTMC5130Datagram(i, TMC5130_CHOPCONF, 0x00, 0x01, 0x02, 0x55);
-    WriteTMC5130Datagram(i, TMC5130_IHOLD_IRUN, 0x00, 0x07, 0x0f, 0x01);
-    WriteTMC5130Int(i, TMC5130_PWMCONF, 0x00050480); //Reset default of PWMCONF
     LastTOffSetting[i]=GetTMC5130ChopperTOff(i);
     DriverDisableFlag[i]=FALSE;
-
-    WriteTMC5130Int(i, TMC5130_RAMPMODE, TMC5130_MODE_POSITION);
-    WriteTMC5130Int(i, TMC5130_XTARGET, 0);
-    WriteTMC5130Int(i, TMC5130_XACTUAL, 0);
-
-    WriteTMC5130Int(i, TMC5130_VSTART, 1);
-    WriteTMC5130Int(i, TMC5130_A1, 25600/ACC_FACTOR);
-    WriteTMC5130Int(i, TMC5130_V1, 25600/VEL_FACTOR);
-    WriteTMC5130Int(i, TMC5130_AMAX, 51200/ACC_FACTOR);
-    WriteTMC5130Int(i, TMC5130_VMAX, 51200/VEL_FACTOR);
-    WriteTMC5130Int(i, TMC5130_DMAX, 51200/ACC_FACTOR);
-    WriteTMC5130Int(i, TMC5130_D1, 25600/ACC_FACTOR);
-    WriteTMC5130Int(i, TMC5130_VSTOP, 10/VEL_FACTOR);
-
-    WriteTMC5130Int(i, TMC5130_TCOOLTHRS, 1048575);
-
   }
 }
 
@@ -1299,10 +2366,7 @@ void HardStop(uint32_t Motor)
 ********************************************************************/
 int ConvertVelocityUserToInternal(int UserVelocity)
 {
-  if(UserVelocity>=0)
-    return (int) floor((double) UserVelocity/VEL_FACTOR);
-  else
-    return (int) ceil((double) UserVelocity/VEL_FACTOR);
+  return FixedDivide(UserVelocity, &VelocityFactor, FX_TRUNC);
 }
 
 
@@ -1318,7 +2382,7 @@ int ConvertVelocityUserToInternal(int UserVelocity)
 ********************************************************************/
 int ConvertAccelerationUserToInternal(int UserAcceleration)
 {
-  return (int) floor((double) UserAcceleration/ACC_FACTOR);
+  return FixedDivide(UserAcceleration, &AccelerationFactor, FX_FLOOR);
 }
 
 
@@ -1333,10 +2397,7 @@ int ConvertAccelerationUserToInternal(int UserAcceleration)
 ********************************************************************/
 int ConvertVelocityInternalToUser(int InternalVelocity)
 {
-  if(InternalVelocity>=0)
-    return (int) ceil((double) InternalVelocity*VEL_FACTOR);
-  else
-    return (int) floor((double) InternalVelocity*VEL_FACTOR);
+  return FixedMultiply(InternalVelocity, &VelocityFactor, FX_AWAY);
 }
 
 /***************************************************************//**
@@ -1350,7 +2411,8 @@ int ConvertVelocityInternalToUser(int InternalVelocity)
 ********************************************************************/
 int ConvertAccelerationInternalToUser(int InternalAcceleration)
 {
-  return (int) ceil((float) InternalAcceleration*ACC_FACTOR);
+  //Same result as the former calculation ceil((float) InternalAcceleration*ACC_FACTOR)
+  return FixedMultiply(InternalAcceleration, &AccelerationFactor, FX_CEIL|FX_FLOAT_INPUT);
 }
 
 /***************************************************************//**
@@ -20,6 +20,14 @@
 #ifndef __TMC5130_H
 #define __TMC5130_H
 
+//The driver family is selected at build time:
+//  default           TMC5130
+//  -DDEVTYPE_TMC5160 TMC5160 (external MOSFETs, same ramp generator)
+//Register names common to both families use the TMC5130_ prefix.
+#if defined(DEVTYPE_TMC2160)
+#error "The TMC2160 has no ramp generator and cannot be used with this firmware"
+#endif
+
 //Registers
 #define TMC5130_GCONF        0x00
 #define TMC5130_GSTAT        0x01
@@ -27,7 +35,15 @@
 #define TMC5130_SLAVECONF    0x03
 #define TMC5130_IOIN         0x04
 #define TMC5130_X_COMPARE    0x05
-
+#if defined(DEVTYPE_TMC5160)
+#define TMC5160_OTP_PROG     0x06
+#define TMC5160_OTP_READ     0x07
+#define TMC5160_FACTORY_CONF 0x08
+#define TMC5160_SHORT_CONF   0x09
+#define TMC5160_DRV_CONF     0x0A
+#define TMC5160_GLOBAL_SCALER 0x0B
+#define TMC5160_OFFSET_READ  0x0C
+#endif
 
 #define TMC5130_IHOLD_IRUN   0x10
 #define TMC5130_TPOWERDOWN   0x11
@@ -57,6 +73,9 @@
 #define TMC5130_ENC_CONST    0x3A
 #define TMC5130_ENC_STATUS   0x3B
 #define TMC5130_ENC_LATCH    0x3C
+#if defined(DEVTYPE_TMC5160)
+#define TMC5160_ENC_DEVIATION 0x3D
+#endif
 #define TMC5130_MSLUT0       0x60
 #define TMC5130_MSLUT1       0x61
 #define TMC5130_MSLUT2       0x62
@@ -75,7 +94,11 @@
 #define TMC5130_DRVSTATUS    0x6F
 #define TMC5130_PWMCONF      0x70
 #define TMC5130_PWMSCALE     0x71
+#if defined(DEVTYPE_TMC5160)
+#define TMC5160_PWM_AUTO     0x72
+#else
 #define TMC5130_ENCM_CTRL    0x72
+#endif
 #define TMC5130_LOST_STEPS   0x73
 
 //Write bit
@@ -107,6 +130,23 @@
 #define TMC5130_GCONF_DIRECT_MODE       0x10000
 #define TMC5130_GCONF_TEST_MODE         0x20000
 
+#if defined(DEVTYPE_TMC5160)
+//With the ramp generator of the TMC5160 bits 7 and 8 switch DIAG0/DIAG1 to
+//STEP/DIR output and diag0_error is not available, so no DIAG function is
+//selected (the 1s register check detects a reset).
+#define TMC5130_GCONF_DIAG_SETTING  0
+#else
+//DIAG0: driver errors and reset, DIAG1: stall (both open drain, active low)
+#define TMC5130_GCONF_DIAG_SETTING  (TMC5130_GCONF_DIAG0_ERROR|TMC5130_GCONF_DIAG0_OTPW|TMC5130_GCONF_DIAG1_STALL_DIR)
+#endif
+
+//Reset default of PWMCONF
+#if defined(DEVTYPE_TMC5160)
+#define TMC5130_PWMCONF_DEFAULT  0xC40C001E
+#else
+#define TMC5130_PWMCONF_DEFAULT  0x00050480
+#endif
+
 //End switch mode bits (Register TMC5130_SWMODE)
 #define TMC5130_SW_STOPL_ENABLE   0x0001
 #define TMC5130_SW_STOPR_ENABLE   0x0002
@@ -152,9 +192,44 @@
 
 #define TPOWERDOWN_FACTOR (4.17792*100.0/255.0)
 
+//SPI status byte (returned with every datagram)
+#define TMC5130_SPI_RESET         0x01
+#define TMC5130_SPI_DRIVER_ERROR  0x02
+#define TMC5130_SPI_SG2           0x04
+#define TMC5130_SPI_STANDSTILL    0x08
+#define TMC5130_SPI_VELREACHED    0x10
+#define TMC5130_SPI_POSREACHED    0x20
+#define TMC5130_SPI_STOPL         0x40
+#define TMC5130_SPI_STOPR         0x80
+
+#define TMC5130_STATUS_MAX_AGE 5   //!< maximum age (ms) of the SPI status byte to be used instead of reading RAMPSTAT
+
+#define TMC5130_SPI_FREQUENCY 4000000   //!< SPI clock (Hz), max. 4MHz when the TMC5130 uses its internal clock
+#define TMC5130_ASYNC_QUEUE   16   //!< size of the queue for posted writes (see PostTMC5130Write())
+#define TMC5130_MAX_DEFERRED  8    //!< maximum number of pending deferred register writes (see WriteTMC5130Deferred())
+#if defined(DEVTYPE_TMC5160)
+#define TMC5130_SNAPSHOT_SIZE 62   //!< number of registers of the TMC5160 (see ReadTMC5130Snapshot())
+#else
+#define TMC5130_SNAPSHOT_SIZE 54   //!< number of registers of the TMC5130 (see ReadTMC5130Snapshot())
+#endif
+
 void WriteTMC5130Datagram(uint8_t Which562, uint8_t Address, uint8_t x1, uint8_t x2, uint8_t x3, uint8_t x4);
 void WriteTMC5130Int(uint8_t Which562, uint8_t Address, int Value);
+void PostTMC5130Write(uint8_t Which5130, uint8_t Address, int Value);
+void WriteTMC5130Deferred(uint8_t Which5130, uint8_t Address, int Value);
+void FlushTMC5130Writes(uint8_t Which5130);
+void FlushAllTMC5130Writes(void);
+void InvalidateTMC5130Shadow(uint8_t Which5130);
+uint32_t GetTMC5130TransferCount(void);
+uint32_t GetTMC5130SavedWriteCount(void);
+uint32_t GetTMC5130SPIWaitTime(void);
+uint8_t VerifyTMC5130Registers(uint8_t Which5130);
+uint32_t GetTMC5130RestoreCount(void);
+uint32_t GetTMC5130AsyncFallbackCount(void);
+uint8_t GetTMC5130SPIStatus(uint8_t Which5130, uint32_t MaxAge, uint8_t *Status);
 int ReadTMC5130Int(uint8_t Which562, uint8_t Address);
+void ReadTMC5130Multiple(uint8_t Which562, const uint8_t *Addresses, int *Values, uint32_t Count);
+uint32_t ReadTMC5130Snapshot(uint8_t Which562, uint8_t *Addresses, int *Values, uint8_t *Readable);
 void SetTMC5130ChopperTOff(uint8_t Motor, uint8_t TOff);
 void SetTMC5130ChopperHysteresisStart(uint8_t Motor, uint8_t HysteresisStart);
 void SetTMC5130ChopperHysteresisEnd(uint8_t Motor, uint8_t HysteresisEnd);
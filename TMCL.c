@@ -18,7 +18,6 @@
  *  -------------------------------------------------------------------- */
 
 #include <stdlib.h>
-#include <math.h>
 #include "max32660.h"
 #include "gpio.h"
 #include "bits.h"
@@ -30,18 +29,80 @@
 #include "MAX31875.h"
 #include "Homebus.h"
 #include "RefSearch.h"
-
-#define RS485_MODULE_ADDRESS 1
-#define RS485_HOST_ADDRESS   2
+#include "LinkTest.h"
+#include "AxisParameters.h"
+#include "ParamStore.h"
+#include "GlobalParameters.h"
+#include "Events.h"
+#include "MotionQueue.h"
+#include "PVT.h"
 
 extern const char VersionString[];
-extern gpio_cfg_t enable_out;            //<! Output for TMC5130 ENABLE pin
 
 static uint8_t TMCLCommandState;              //!< State of the interpreter
 static TTMCLCommand ActualCommand;            //!< TMCL command to be executed (with all parameters)
 static TTMCLReply ActualReply;                //!< Reply of last executed TMCL command
 static uint8_t TMCLReplyFormat;               //!< format of next reply (RF_NORMAL or RF_SPECIAL)
-static uint8_t SpecialReply[9];               //!< buffer for special replies
+static uint8_t SpecialReply[9*TMCL_MAX_REPLY_FRAMES];  //!< buffer for special replies (one or more frames)
+static uint8_t SpecialReplyFrames;            //!< number of frames in the special reply buffer
+static uint8_t SpecialReplySent;              //!< number of frames of the special reply handed over to Homebus
+static uint8_t SpecialReplyRemaining;         //!< number of frames of the special reply still to be sent
+
+static TTMCLCommand TMCLProgram[TMCL_MEM_SIZE];  //!< stand-alone program memory
+static uint8_t TMCLExecutionMode;             //!< TM_IDLE, TM_RUN, TM_STEP or TM_DOWNLOAD
+static uint16_t TMCLProgramCounter;           //!< address of the next program command
+static uint16_t TMCLDownloadPointer;          //!< address for the next downloaded command
+static uint8_t TMCLStepPending;               //!< TRUE when one command is to be executed in step mode
+static int TMCLAccumulator;                   //!< accumulator register
+static int TMCLXRegister;                     //!< X register
+static uint32_t TMCLFlags;                    //!< comparison and error flags (FLAG_xxx)
+static uint16_t TMCLStack[TMCL_STACK_DEPTH];  //!< return addresses of CSUB commands
+static uint8_t TMCLStackPointer;              //!< number of entries on the stack
+
+//! State of a WAIT command
+typedef struct
+{
+  uint8_t Type;     //!< condition (WAIT_xxx, WAIT_NONE: no active WAIT command)
+  uint8_t Motor;    //!< motor
+  uint32_t Start;   //!< start time
+  uint32_t Time;    //!< wait time or timeout (ms, 0: no timeout)
+} TWaitState;
+
+static int TMCLCoordinates[N_O_MOTORS][TMCL_COORDINATES];  //!< coordinates (SCO/GCO/CCO, MVP COORD)
+static TWaitState ProgramWait;                //!< WAIT command of the stand-alone program
+static TWaitState DirectWait;                 //!< WAIT command sent in direct mode
+static uint8_t DirectWaitResult;              //!< result of the last WAIT command in direct mode (WS_xxx)
+
+//! Item of the batched read command
+typedef struct
+{
+  uint8_t Source;   //!< BR_AXIS: axis parameter, BR_INPUT: input of bank 1 (GIO), BR_EVENTS: pending events
+  uint8_t Number;   //!< axis parameter number or input number
+} TBatchReadItem;
+
+#define BR_AXIS   0
+#define BR_INPUT  1
+#define BR_EVENTS 2
+
+//! Items of the batched read command (bit n of the value selects item n)
+static const TBatchReadItem BatchReadItems[]=
+{
+  {BR_AXIS,    0},   //target position
+  {BR_AXIS,    1},   //actual position
+  {BR_AXIS,    3},   //actual velocity
+  {BR_AXIS,    8},   //position reached
+  {BR_AXIS,   10},   //right stop switch
+  {BR_AXIS,   11},   //left stop switch
+  {BR_AXIS,  206},   //stallGuard value
+  {BR_AXIS,  208},   //driver error flags
+  {BR_AXIS,  180},   //actual motor current
+  {BR_AXIS,  207},   //stall flag
+  {BR_AXIS,  189},   //PWM scale
+  {BR_INPUT,   9},   //temperature
+  {BR_EVENTS,  0},   //pending events (not cleared)
+};
+
+#define N_BATCH_READ_ITEMS (sizeof(BatchReadItems)/sizeof(BatchReadItems[0]))
 
 static void RotateLeft(void);
 static void RotateRight(void);
@@ -49,14 +110,52 @@ static void MotorStop(void);
 static void MoveToPosition(void);
 static void SetAxisParameter(void);
 static void GetAxisParameter(void);
+static void StoreAxisParameter(void);
+static void RestoreAxisParameter(void);
+static void FactoryDefault(void);
+static void SetCoordinate(void);
+static void GetCoordinate(void);
+static void CaptureCoordinate(void);
+static void SetGlobalParameter(void);
+static void GetGlobalParameter(void);
+static void StoreGlobalParameter(void);
+static void RestoreGlobalParameter(void);
+static void AccumulatorToGlobalParameter(void);
 static void GetInput(void);
 static void GetVersion(void);
 static void ReferenceSearch(void);
+static void LinkTest(void);
+static void BatchRead(void);
+static void RegisterDump(void);
+static void SetEvent(void);
+static void PVTCommand(void);
+static void Calculate(void);
+static void CalculateX(void);
+static void Compare(void);
+static void JumpAlways(void);
+static void JumpConditional(void);
+static void CallSubroutine(void);
+static void ReturnFromSubroutine(void);
+static void Wait(void);
+static uint8_t WaitFinished(TWaitState *Wait);
+static void UpdateDirectWait(void);
+static void StopProgram(void);
+static void AccumulatorToAxisParameter(void);
+static void ClearErrorFlags(void);
+static void ApplicationStop(void);
+static void ApplicationRun(void);
+static void ApplicationStep(void);
+static void ApplicationReset(void);
+static void DownloadStart(void);
+static void DownloadEnd(void);
+static void ReadMemory(void);
+static void GetStatus(void);
 
 
 void InitTMCL(void)
 {
   uint32_t i;
+  const TParamEntry *Entry;
 
   for(i=0; i<N_O_MOTORS; i++)
   {
@@ -69,6 +168,22 @@ void InitTMCL(void)
     RefSearchStallVMin[i]=98000;
     RefSearchStallThreshold[i]=5;  //smaller drive: 3
   }
+
+  TMCLExecutionMode=TM_IDLE;
+  ProgramWait.Type=WAIT_NONE;
+  DirectWait.Type=WAIT_NONE;
+  DirectWaitResult=WS_NONE;
+
+  //Restore all parameters stored with STAP and STGP and all stored coordinates
+  InitParamStore();
+  for(i=0; (Entry=GetParamStoreEntry(i))!=NULL; i++)
+  {
+    if(Entry->Kind==PS_KIND_AXIS)
+      WriteAxisParameter(Entry->Bank, Entry->Index, Entry->Value);
+    else if(Entry->Kind==PS_KIND_COORD && Entry->Bank<N_O_MOTORS && Entry->Index<TMCL_COORDINATES)
+      TMCLCoordinates[Entry->Bank][Entry->Index]=Entry->Value;
+  }
+  InitGlobalParameters();
 }
 
 
@@ -113,6 +228,34 @@ static void ExecuteActualCommand(void)
       GetAxisParameter();
       break;
 
+    case TMCL_STAP:
+      StoreAxisParameter();
+      break;
+
+    case TMCL_RSAP:
+      RestoreAxisParameter();
+      break;
+
+    case TMCL_SGP:
+      SetGlobalParameter();
+      break;
+
+    case TMCL_GGP:
+      GetGlobalParameter();
+      break;
+
+    case TMCL_STGP:
+      StoreGlobalParameter();
+      break;
+
+    case TMCL_RSGP:
+      RestoreGlobalParameter();
+      break;
+
+    case TMCL_AGP:
+      AccumulatorToGlobalParameter();
+      break;
+
     case TMCL_GIO:
       GetInput();
       break;
@@ -125,10 +268,201 @@ static void ExecuteActualCommand(void)
       GetVersion();
       break;
 
+    case TMCL_LinkTest:
+      LinkTest();
+      break;
+
+    case TMCL_BatchRead:
+      BatchRead();
+      break;
+
+    case TMCL_RegisterDump:
+      RegisterDump();
+      break;
+
+    case TMCL_SetEvent:
+      SetEvent();
+      break;
+
+    case TMCL_PVT:
+      PVTCommand();
+      break;
+
+    case TMCL_CALC:
+      Calculate();
+      break;
+
+    case TMCL_COMP:
+      Compare();
+      break;
+
+    case TMCL_JC:
+      JumpConditional();
+      break;
+
+    case TMCL_JA:
+      JumpAlways();
+      break;
+
+    case TMCL_CSUB:
+      CallSubroutine();
+      break;
+
+    case TMCL_RSUB:
+      ReturnFromSubroutine();
+      break;
+
+    case TMCL_WAIT:
+      Wait();
+      break;
+
+    case TMCL_STOP:
+      StopProgram();
+      break;
+
+    case TMCL_SCO:
+      SetCoordinate();
+      break;
+
+    case TMCL_GCO:
+      GetCoordinate();
+      break;
+
+    case TMCL_CCO:
+      CaptureCoordinate();
+      break;
+
+    case TMCL_CALCX:
+      CalculateX();
+      break;
+
+    case TMCL_AAP:
+      AccumulatorToAxisParameter();
+      break;
+
+    case TMCL_CLE:
+      ClearErrorFlags();
+      break;
+
+    case TMCL_ApplStop:
+      ApplicationStop();
+      break;
+
+    case TMCL_ApplRun:
+      ApplicationRun();
+      break;
+
+    case TMCL_ApplStep:
+      ApplicationStep();
+      break;
+
+    case TMCL_ApplReset:
+      ApplicationReset();
+      break;
+
+    case TMCL_DownloadStart:
+      DownloadStart();
+      break;
+
+    case TMCL_DownloadEnd:
+      DownloadEnd();
+      break;
+
+    case TMCL_ReadMem:
+      ReadMemory();
+      break;
+
+    case TMCL_GetStatus:
+      GetStatus();
+      break;
+
+    case TMCL_FactoryDefault:
+      FactoryDefault();
+      break;
+
     default:
       ActualReply.Status=REPLY_INVALID_CMD;
       break;
   }
+
+  //GAP, GGP, GIO and GCO in a stand-alone program load the result into the accumulator
+  if(TMCLCommandState==TCS_MEM && ActualReply.Status==REPLY_OK &&
+     (ActualCommand.Opcode==TMCL_GAP || ActualCommand.Opcode==TMCL_GGP || ActualCommand.Opcode==TMCL_GIO ||
+      (ActualCommand.Opcode==TMCL_GCO && ActualCommand.Motor!=COORD_ALL_AXES)))
+    TMCLAccumulator=ActualReply.Value.Int32;
+}
+
+
+/***************************************************************//**
+   \fn StoreActualCommand()
+   \brief Store a command in download mode
+
+   Store the actual command in the program memory instead of
+   executing it (download mode).
+********************************************************************/
+static void StoreActualCommand(void)
+{
+  ActualReply.Opcode=ActualCommand.Opcode;
+  ActualReply.Value.Int32=ActualCommand.Value.Int32;
+
+  if(TMCLDownloadPointer<TMCL_MEM_SIZE)
+  {
+    TMCLProgram[TMCLDownloadPointer++]=ActualCommand;
+    ActualReply.Status=REPLY_CMD_LOADED;
+  }
+  else ActualReply.Status=REPLY_MAX_EXCEEDED;
+}
+
+
+/***************************************************************//**
+   \fn ReplyStatus(uint8_t Status)
+   \brief Status code to be sent in a reply
+   \param Status: status code
+   \return REPLY_OK_EVENT instead of REPLY_OK when there are pending
+           events (tells the master that there are pending events),
+           otherwise the status code
+
+   Has to be used for the status byte of every reply frame (standard
+   and special replies).
+********************************************************************/
+static uint8_t ReplyStatus(uint8_t Status)
+{
+  if(Status==REPLY_OK && GetPendingEvents()!=0) return REPLY_OK_EVENT;
+
+  return Status;
+}
+
+
+/***************************************************************//**
+   \fn SendReply(TTMCLReply *Reply)
+   \brief Send a reply in the standard format
+   \param Reply: reply to be sent
+
+   The status REPLY_OK is replaced by REPLY_OK_EVENT when there are
+   pending events.
+********************************************************************/
+static void SendReply(TTMCLReply *Reply)
+{
+  uint8_t RS485Reply[9];
+
+  Reply->Status=ReplyStatus(Reply->Status);
+
+  RS485Reply[8]=HostAddress+ModuleAddress+
+                Reply->Status+Reply->Opcode+
+                Reply->Value.Byte[3]+
+                Reply->Value.Byte[2]+
+                Reply->Value.Byte[1]+
+                Reply->Value.Byte[0];
+
+  RS485Reply[0]=HostAddress;
+  RS485Reply[1]=ModuleAddress;
+  RS485Reply[2]=Reply->Status;
+  RS485Reply[3]=Reply->Opcode;
+  RS485Reply[4]=Reply->Value.Byte[3];
+  RS485Reply[5]=Reply->Value.Byte[2];
+  RS485Reply[6]=Reply->Value.Byte[1];
+  RS485Reply[7]=Reply->Value.Byte[0];
+  HomebusSendData(RS485Reply);
 }
 
 
@@ -138,73 +472,69 @@ static void ExecuteActualCommand(void)
 
    This is the main function for fetching and executing TMCL commands
    and has to be called periodically from the main loop.
+   Of a special reply with more than one frame only the first frame
+   is sent at once. The others are sent one per call when the previous
+   frame has been sent out, so that a long reply (e.g. RegisterDump())
+   does not block the main loop. No new command is fetched before the
+   last frame has been sent.
 ********************************************************************/
 void ProcessCommand(void)
 {
   uint8_t RS485Cmd[9];
-  uint8_t RS485Reply[9];
   uint8_t Checksum;
   uint32_t i;
 
+  //**Send the next frame of a special reply**
+  if(SpecialReplyRemaining>0)
+  {
+    if(!HomebusSendBusy())
+    {
+      HomebusSendData(&SpecialReply[9*SpecialReplySent]);
+      SpecialReplySent++;
+      SpecialReplyRemaining--;
+    }
+    if(SpecialReplyRemaining>0) return;
+  }
+
   //**Send answer for the last command**
   if(TMCLCommandState==TCS_UART)  //via UART
   {
     if(TMCLReplyFormat==RF_STANDARD)
     {
-      RS485Reply[8]=RS485_HOST_ADDRESS+RS485_MODULE_ADDRESS+
-                    ActualReply.Status+ActualReply.Opcode+
-                    ActualReply.Value.Byte[3]+
-                    ActualReply.Value.Byte[2]+
-                    ActualReply.Value.Byte[1]+
-                    ActualReply.Value.Byte[0];
-
-      RS485Reply[0]=RS485_HOST_ADDRESS;
-      RS485Reply[1]=RS485_MODULE_ADDRESS;
-      RS485Reply[2]=ActualReply.Status;
-      RS485Reply[3]=ActualReply.Opcode;
-      RS485Reply[4]=ActualReply.Value.Byte[3];
-      RS485Reply[5]=ActualReply.Value.Byte[2];
-      RS485Reply[6]=ActualReply.Value.Byte[1];
-      RS485Reply[7]=ActualReply.Value.Byte[0];
-      HomebusSendData(RS485Reply);
+      SendReply(&ActualReply);
+      if(ActualReply.Opcode==TMCL_LinkTest) LinkTestReplySent();
     }
     else if(TMCLReplyFormat==RF_SPECIAL)
     {
       HomebusSendData(SpecialReply);
+      SpecialReplySent=1;
+      SpecialReplyRemaining=SpecialReplyFrames-1;
     }
   }
   else if(TMCLCommandState==TCS_UART_ERROR)  //check sum of the last command has been wrong
   {
+    ChecksumErrorCount++;
+    LinkTestChecksumError();
+
     ActualReply.Opcode=0;
     ActualReply.Status=REPLY_CHKERR;
     ActualReply.Value.Int32=0;
+    SendReply(&ActualReply);
+  }
+
+  //Check the condition of a WAIT command sent in direct mode
+  UpdateDirectWait();
 
-    RS485Reply[8]=RS485_HOST_ADDRESS+RS485_MODULE_ADDRESS+
-                  ActualReply.Status+ActualReply.Opcode+
-                  ActualReply.Value.Byte[3]+
-                  ActualReply.Value.Byte[2]+
-                  ActualReply.Value.Byte[1]+
-                  ActualReply.Value.Byte[0];
-
-    RS485Reply[0]=RS485_HOST_ADDRESS;
-    RS485Reply[1]=RS485_MODULE_ADDRESS;
-    RS485Reply[2]=ActualReply.Status;
-    RS485Reply[3]=ActualReply.Opcode;
-    RS485Reply[4]=ActualReply.Value.Byte[3];
-    RS485Reply[5]=ActualReply.Value.Byte[2];
-    RS485Reply[6]=ActualReply.Value.Byte[1];
-    RS485Reply[7]=ActualReply.Value.Byte[0];
-    HomebusSendData(RS485Reply);
-  }
-
-  //Reset state (answer has been sent now)
+  //Reset state (answer has been sent now, except further frames of a special reply)
   TMCLCommandState=TCS_IDLE;
   TMCLReplyFormat=RF_STANDARD;
+  SpecialReplyFrames=1;
+  if(SpecialReplyRemaining>0) return;
 
   //**Try to get a new command**
   if(HomebusGetData(RS485Cmd))  //Get data from UART
   {
-    if(RS485Cmd[0]==RS485_MODULE_ADDRESS)  //Is this our addresss?
+    if(RS485Cmd[0]==ModuleAddress)  //Is this our addresss?
     {
       Checksum=0;
       for(i=0; i<8; i++) Checksum+=RS485Cmd[i];
@@ -220,6 +550,7 @@ void ProcessCommand(void)
         ActualCommand.Value.Byte[0]=RS485Cmd[7];
 
         TMCLCommandState=TCS_UART;
+        CommandCount++;
       }
       else TMCLCommandState=TCS_UART_ERROR;  //Checksum wrong
     }
@@ -227,7 +558,139 @@ void ProcessCommand(void)
 
   //**Execute the command**
   //Check if a command could be fetched and execute it.
-  if(TMCLCommandState!=TCS_IDLE && TMCLCommandState!=TCS_UART_ERROR) ExecuteActualCommand();
+  //In download mode all commands that can be part of a program are stored.
+  if(TMCLCommandState!=TCS_IDLE && TMCLCommandState!=TCS_UART_ERROR)
+  {
+    if(TMCLExecutionMode==TM_DOWNLOAD && ActualCommand.Opcode<TMCL_ApplStop)
+      StoreActualCommand();
+    else
+      ExecuteActualCommand();
+  }
+}
+
+
+/***************************************************************//**
+   \fn WaitFinished(TWaitState *Wait)
+   \brief Check the condition of a WAIT command
+   \param Wait: state of the WAIT command
+   \return WS_RUNNING, WS_DONE or WS_TIMEOUT
+
+   Check if the condition of the WAIT command has become true
+   or if the timeout has expired. The ramp status is taken from
+   the copy read by ProcessStallGuard(), so no SPI access is
+   needed here.
+********************************************************************/
+static uint8_t WaitFinished(TWaitState *Wait)
+{
+  uint8_t Finished;
+  uint32_t Elapsed;
+
+  Elapsed=GetSysTimer()-Wait->Start;
+  switch(Wait->Type)
+  {
+    case WAIT_TICKS:
+      return (Elapsed>=Wait->Time) ? WS_DONE:WS_RUNNING;
+
+    case WAIT_POS:
+      Finished=RampStatValid[Wait->Motor] && (RampStatCache[Wait->Motor] & TMC5130_RS_POSREACHED);
+      break;
+
+    case WAIT_REFSW:
+      Finished=RampStatValid[Wait->Motor] && (RampStatCache[Wait->Motor] & TMC5130_RS_STOPL);
+      break;
+
+    case WAIT_LIMSW:
+      Finished=RampStatValid[Wait->Motor] && (RampStatCache[Wait->Motor] & (TMC5130_RS_STOPL|TMC5130_RS_STOPR));
+      break;
+
+    case WAIT_RFS:
+      Finished=(GetRefSearchState(Wait->Motor)==0);
+      break;
+
+    default:
+      return WS_DONE;
+  }
+
+  if(Finished) return WS_DONE;
+  if(Wait->Time>0 && Elapsed>=Wait->Time) return WS_TIMEOUT;
+
+  return WS_RUNNING;
+}
+
+
+/***************************************************************//**
+   \fn UpdateDirectWait(void)
+   \brief Check the WAIT command sent in direct mode
+
+   As a Homebus slave this module cannot send a frame on its own,
+   so the result is only stored in DirectWaitResult and has to be
+   polled by the master (command 135, type 6). The end of the WAIT
+   command is also signalled as event EV_WAIT_DONE.
+********************************************************************/
+static void UpdateDirectWait(void)
+{
+  if(DirectWait.Type==WAIT_NONE) return;
+
+  DirectWaitResult=WaitFinished(&DirectWait);
+  if(DirectWaitResult!=WS_RUNNING)
+  {
+    DirectWait.Type=WAIT_NONE;
+    SignalEvent(EV_WAIT_DONE);
+  }
+}
+
+
+/***************************************************************//**
+   \fn ProcessTMCLProgram(void)
+   \brief Execute the stand-alone program
+
+   Executes up to TMCL_PROGRAM_BUDGET commands of the stand-alone
+   program (in run mode) or one command (in step mode). A WAIT
+   command does not block but ends the processing until its
+   condition has become true. Has to be called periodically from
+   the main loop after ProcessCommand().
+********************************************************************/
+void ProcessTMCLProgram(void)
+{
+  uint32_t i;
+
+  //Do not overwrite the pending reply of a direct mode command.
+  if(TMCLCommandState!=TCS_IDLE) return;
+
+  for(i=0; i<TMCL_PROGRAM_BUDGET; i++)
+  {
+    if(TMCLExecutionMode!=TM_RUN && !(TMCLExecutionMode==TM_STEP && TMCLStepPending)) return;
+
+    if(ProgramWait.Type!=WAIT_NONE)
+    {
+      switch(WaitFinished(&ProgramWait))
+      {
+        case WS_RUNNING:
+          return;
+
+        case WS_TIMEOUT:
+          TMCLFlags|=FLAG_ERROR_TIMEOUT;
+          break;
+      }
+      ProgramWait.Type=WAIT_NONE;
+      TMCLStepPending=FALSE;
+      continue;
+    }
+
+    if(TMCLProgramCounter>=TMCL_MEM_SIZE)
+    {
+      TMCLExecutionMode=TM_IDLE;
+      return;
+    }
+
+    ActualCommand=TMCLProgram[TMCLProgramCounter++];
+    TMCLCommandState=TCS_MEM;
+    ExecuteActualCommand();
+    TMCLCommandState=TCS_IDLE;
+
+    if(ActualReply.Status==REPLY_INVALID_CMD) TMCLExecutionMode=TM_IDLE;
+    if(ProgramWait.Type==WAIT_NONE) TMCLStepPending=FALSE;
+  }
 }
 
 
@@ -241,6 +704,8 @@ static void RotateLeft(void)
 {
   if(ActualCommand.Motor<N_O_MOTORS)
   {
+    ClearMotionQueue(ActualCommand.Motor);
+    StopPVT(ActualCommand.Motor);
     if(AMaxModified[ActualCommand.Motor])
     {
       WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_AMAX, AMax[ActualCommand.Motor]);
@@ -268,6 +733,8 @@ static void RotateRight(void)
 {
   if(ActualCommand.Motor<N_O_MOTORS)
   {
+    ClearMotionQueue(ActualCommand.Motor);
+    StopPVT(ActualCommand.Motor);
     if(AMaxModified[ActualCommand.Motor])
     {
       WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_AMAX, AMax[ActualCommand.Motor]);
@@ -295,6 +762,8 @@ static void MotorStop(void)
 {
   if(ActualCommand.Motor<N_O_MOTORS)
   {
+    ClearMotionQueue(ActualCommand.Motor);
+    StopPVT(ActualCommand.Motor);
     VMaxModified[ActualCommand.Motor]=TRUE;
     StallFlag[ActualCommand.Motor]=FALSE;
     WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VMAX, 0);
@@ -304,58 +773,103 @@ static void MotorStop(void)
 }
 
 
+/***************************************************************//**
+   \fn StartPositioning(uint8_t Motor, int Position)
+   \brief Start a positioning move
+   \param Motor: axis number
+   \param Position: target position
+
+   Used by MVP ABS, MVP REL and MVP COORD. All register writes are
+   deferred, so FlushAllTMC5130Writes() has to be called afterwards.
+********************************************************************/
+static void StartPositioning(uint8_t Motor, int Position)
+{
+  ClearMotionQueue(Motor);
+  StopPVT(Motor);
+  if(VMaxModified[Motor])
+  {
+    WriteTMC5130Deferred(WHICH_5130(Motor), TMC5130_VMAX, VMax[Motor]);
+    VMaxModified[Motor]=FALSE;
+  }
+  if(AMaxModified[Motor])
+  {
+    WriteTMC5130Deferred(WHICH_5130(Motor), TMC5130_AMAX, AMax[Motor]);
+    AMaxModified[Motor]=FALSE;
+  }
+  StallFlag[Motor]=FALSE;
+
+  //The deferred writes are sent in this order, RAMPMODE last.
+  WriteTMC5130Deferred(WHICH_5130(Motor), TMC5130_XTARGET, Position);
+  WriteTMC5130Deferred(WHICH_5130(Motor), TMC5130_RAMPMODE, TMC5130_MODE_POSITION);
+}
+
+
 /***************************************************************//**
    \fn MoveToPosition()
    \brief TMCL MVP command
 
-   Execute TMCL MVP command.
+   Execute TMCL MVP command. With MVP COORD the value is the number
+   of the coordinate. If bit 7 of the motor parameter is set
+   (MVP_MULTI_AXIS), bits 0..6 select the axes that are all moved
+   to their coordinate with this number.
 ********************************************************************/
 static void MoveToPosition(void)
 {
   int NewPosition;
+  uint32_t i;
+
+  if(ActualCommand.Type==MVP_COORD && (ActualCommand.Motor & MVP_MULTI_AXIS))
+  {
+    if(ActualCommand.Value.Int32<0 || ActualCommand.Value.Int32>=TMCL_COORDINATES ||
+       (ActualCommand.Motor & ~MVP_MULTI_AXIS)>=(1<<N_O_MOTORS))
+    {
+      ActualReply.Status=REPLY_INVALID_VALUE;
+      return;
+    }
+
+    //All axes get their datagrams in the same daisy chain frames
+    for(i=0; i<N_O_MOTORS; i++)
+      if(ActualCommand.Motor & (1<<i))
+        StartPositioning(i, TMCLCoordinates[i][ActualCommand.Value.Int32]);
+    FlushAllTMC5130Writes();
+    return;
+  }
 
   if(ActualCommand.Motor<N_O_MOTORS)
   {
     switch(ActualCommand.Type)
     {
       case MVP_ABS:
-        if(VMaxModified[ActualCommand.Motor])
-        {
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VMAX, VMax[ActualCommand.Motor]);
-          VMaxModified[ActualCommand.Motor]=FALSE;
-        }
-        if(AMaxModified[ActualCommand.Motor])
-        {
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_AMAX, AMax[ActualCommand.Motor]);
-          AMaxModified[ActualCommand.Motor]=FALSE;
-        }
-        StallFlag[ActualCommand.Motor]=FALSE;
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_XTARGET, ActualCommand.Value.Int32);
-        WriteTMC5130Datagram(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPMODE, 0, 0, 0, TMC5130_MODE_POSITION);
+        StartPositioning(ActualCommand.Motor, ActualCommand.Value.Int32);
         break;
 
       case MVP_REL:
-        if(VMaxModified[ActualCommand.Motor])
-        {
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VMAX, VMax[ActualCommand.Motor]);
-          VMaxModified[ActualCommand.Motor]=FALSE;
-        }
-        if(AMaxModified[ActualCommand.Motor])
-        {
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_AMAX, AMax[ActualCommand.Motor]);
-          AMaxModified[ActualCommand.Motor]=FALSE;
-        }
-        StallFlag[ActualCommand.Motor]=FALSE;
         NewPosition=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_XTARGET)+ActualCommand.Value.Int32;
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_XTARGET, NewPosition);
-        WriteTMC5130Datagram(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPMODE, 0, 0, 0, TMC5130_MODE_POSITION);
+        StartPositioning(ActualCommand.Motor, NewPosition);
         ActualReply.Value.Int32=NewPosition;
         break;
 
+      case MVP_COORD:
+        if(ActualCommand.Value.Int32>=0 && ActualCommand.Value.Int32<TMCL_COORDINATES)
+          StartPositioning(ActualCommand.Motor, TMCLCoordinates[ActualCommand.Motor][ActualCommand.Value.Int32]);
+        else
+          ActualReply.Status=REPLY_INVALID_VALUE;
+        break;
+
+      case MVP_QUEUE:
+      case MVP_QUEUE_LAST:
+        StopPVT(ActualCommand.Motor);
+        if(EnqueueMove(ActualCommand.Motor, ActualCommand.Value.Int32, ActualCommand.Type==MVP_QUEUE_LAST))
+          ActualReply.Value.Int32=GetMotionQueueLevel(ActualCommand.Motor);
+        else
+          ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;  //queue full
+        break;
+
       default:
         ActualReply.Status=REPLY_WRONG_TYPE;
         break;
     }
+    FlushAllTMC5130Writes();
   } else ActualReply.Status=REPLY_INVALID_VALUE;
 }
 
@@ -364,586 +878,319 @@ static void MoveToPosition(void)
    \fn SetAxisParameter()
    \brief TMCL SAP command
 
-   Execute TMCL SAP command.
+   Execute TMCL SAP command (see AxisParameters.c).
 ********************************************************************/
 void SetAxisParameter(void)
 {
-  uint32_t Value;
+  ActualReply.Status=WriteAxisParameter(ActualCommand.Motor, ActualCommand.Type, ActualCommand.Value.Int32);
+}
 
-  if(ActualCommand.Motor<N_O_MOTORS)
-  {
-    switch(ActualCommand.Type)
-    {
-      case 0:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_XTARGET, ActualCommand.Value.Int32);
-        break;
 
-      case 1:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_XACTUAL, ActualCommand.Value.Int32);
-        break;
+/***************************************************************//**
+   \fn GetAxisParameter()
+   \brief TMCL GAP command
 
-      case 2:
-        if(ActualCommand.Value.Int32>0)
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPMODE, TMC5130_MODE_VELPOS);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPMODE, TMC5130_MODE_VELNEG);
+   Execute TMCL GAP command (see AxisParameters.c).
+********************************************************************/
+void GetAxisParameter(void)
+{
+  int Value;
 
-        VMaxModified[ActualCommand.Motor]=TRUE;
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VMAX, ConvertVelocityUserToInternal(abs(ActualCommand.Value.Int32)));
-        break;
+  ActualReply.Status=ReadAxisParameter(ActualCommand.Motor, ActualCommand.Type, &Value);
+  if(ActualReply.Status==REPLY_OK) ActualReply.Value.Int32=Value;
+}
 
-      case 4:
-        VMax[ActualCommand.Motor]=ConvertVelocityUserToInternal(abs(ActualCommand.Value.Int32));
-        if(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPMODE)==TMC5130_MODE_POSITION)
-        {
-            WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VMAX, VMax[ActualCommand.Motor]);
-        }
-        break;
 
-      case 5:
-        AMaxModified[ActualCommand.Motor]=FALSE;
-        AMax[ActualCommand.Motor]=ConvertAccelerationUserToInternal(ActualCommand.Value.Int32);
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_AMAX, AMax[ActualCommand.Motor]);
-        break;
+/***************************************************************//**
+   \fn StoreAxisParameter()
+   \brief TMCL STAP command
+
+   Store the actual value of an axis parameter in the flash. It
+   will then be restored at every start-up.
+   Note: when the flash page is full, the page change blocks all
+   interrupts for some ten milliseconds. Homebus frames arriving
+   meanwhile are lost (see ParamStore.c).
+********************************************************************/
+static void StoreAxisParameter(void)
+{
+  const TAxisParameter *Parameter;
+  int Value;
 
-      case 6:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN);
-        WriteTMC5130Datagram(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN, 0, Value >> 16,
-                            ActualCommand.Value.Byte[0]/8, Value & 0xff);
-        break;
+  if(ActualCommand.Motor>=N_O_MOTORS)
+  {
+    ActualReply.Status=REPLY_INVALID_VALUE;
+    return;
+  }
 
-      case 7:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN);
-        WriteTMC5130Datagram(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN, 0, Value >> 16,
-                            Value >> 8, ActualCommand.Value.Byte[0]/8);
-        break;
+  Parameter=FindAxisParameter(ActualCommand.Type);
+  if(Parameter==NULL || !(Parameter->Access & PB_STORE))
+  {
+    ActualReply.Status=REPLY_WRONG_TYPE;
+    return;
+  }
 
-      case 12:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE);
-        if(ActualCommand.Value.Int32==0)
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value|TMC5130_SW_STOPR_ENABLE);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value & ~TMC5130_SW_STOPR_ENABLE);
-        break;
+  ActualReply.Status=ReadAxisParameter(ActualCommand.Motor, ActualCommand.Type, &Value);
+  if(ActualReply.Status!=REPLY_OK) return;
+  ActualReply.Value.Int32=Value;
 
-      case 13:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE);
-        if(ActualCommand.Value.Int32==0)
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value|TMC5130_SW_STOPL_ENABLE);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value & ~TMC5130_SW_STOPL_ENABLE);
-        break;
+  switch(ParamStoreWrite(PS_KIND_AXIS, ActualCommand.Motor, ActualCommand.Type, Value))
+  {
+    case PS_OK:
+      break;
 
-      case 14:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE);
-        if(ActualCommand.Value.Int32!=0)
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value|TMC5130_SW_SWAP_LR);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value & ~TMC5130_SW_SWAP_LR);
-        break;
+    case PS_FULL:
+      ActualReply.Status=REPLY_MAX_EXCEEDED;
+      break;
 
-      case 15:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_A1, ConvertAccelerationUserToInternal(ActualCommand.Value.Int32));
-        break;
+    default:
+      ActualReply.Status=REPLY_CMD_LOAD_ERROR;
+      break;
+  }
+}
 
-      case 16:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_V1, ConvertVelocityUserToInternal(ActualCommand.Value.Int32));
-        break;
 
-      case 17:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_DMAX, ConvertAccelerationUserToInternal(ActualCommand.Value.Int32));
-        break;
+/***************************************************************//**
+   \fn RestoreAxisParameter()
+   \brief TMCL RSAP command
 
-      case 18:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_D1, ConvertAccelerationUserToInternal(ActualCommand.Value.Int32));
-        break;
+   Set an axis parameter to the value stored in the flash. If the
+   parameter has never been stored it is left unchanged.
+********************************************************************/
+static void RestoreAxisParameter(void)
+{
+  const TAxisParameter *Parameter;
+  int Value;
 
-      case 19:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VSTART, ConvertVelocityUserToInternal(ActualCommand.Value.Int32));
-        break;
+  if(ActualCommand.Motor>=N_O_MOTORS)
+  {
+    ActualReply.Status=REPLY_INVALID_VALUE;
+    return;
+  }
 
-      case 20:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VSTOP, ConvertVelocityUserToInternal(ActualCommand.Value.Int32));
-        break;
+  Parameter=FindAxisParameter(ActualCommand.Type);
+  if(Parameter==NULL || !(Parameter->Access & PB_STORE))
+  {
+    ActualReply.Status=REPLY_WRONG_TYPE;
+    return;
+  }
 
-      case 21:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TZEROWAIT, ActualCommand.Value.Int32);
-        break;
+  if(ParamStoreRead(PS_KIND_AXIS, ActualCommand.Motor, ActualCommand.Type, &Value))
+    ActualReply.Status=WriteAxisParameter(ActualCommand.Motor, ActualCommand.Type, Value);
+  else
+    ActualReply.Status=ReadAxisParameter(ActualCommand.Motor, ActualCommand.Type, &Value);
 
-      case 22:
-        if(ActualCommand.Value.Int32>=0)
-        {
-          if(ActualCommand.Value.Int32>0)
-            WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_THIGH, 13000000 / ActualCommand.Value.Int32);
-          else
-            WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_THIGH, 1048757);
-        }
-        else ActualReply.Status=REPLY_INVALID_VALUE;
-        break;
-
-      case 23:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VDCMIN, ConvertVelocityUserToInternal(ActualCommand.Value.Int32));
-        break;
-
-      case 24:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE);
-        if(ActualCommand.Value.Int32!=0)
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value|TMC5130_SW_STOPR_POLARITY);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value & ~TMC5130_SW_STOPR_POLARITY);
-        break;
-
-      case 25:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE);
-        if(ActualCommand.Value.Int32!=0)
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value|TMC5130_SW_STOPL_POLARITY);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value & ~TMC5130_SW_STOPL_POLARITY);
-        break;
-
-      case 26:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE);
-        if(ActualCommand.Value.Int32!=0)
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value|TMC5130_SW_SOFTSTOP);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE, Value & ~TMC5130_SW_SOFTSTOP);
-        break;
-
-      case 27:
-        SetTMC5130ChopperVHighChm(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 28:
-        SetTMC5130ChopperVHighFs(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 31:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN);
-        WriteTMC5130Datagram(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN, 0, ActualCommand.Value.Byte[0] & 0x0f,
-                             Value >> 8, Value & 0xff);
-        break;
-
-      case 32:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_DCCTRL);  //DC_TIME
-        WriteTMC5130Datagram(WHICH_5130(ActualCommand.Motor), TMC5130_DCCTRL, 0, Value >> 16,
-                             ActualCommand.Value.Byte[1] & 0x03, ActualCommand.Value.Byte[0]);
-        break;
-
-      case 33:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_DCCTRL);  //DC_SG
-        WriteTMC5130Datagram(WHICH_5130(ActualCommand.Motor), TMC5130_DCCTRL, 0, ActualCommand.Value.Byte[0],
-                             Value >> 8, Value & 0xff);
-        break;
-
-      case 140:
-        SetTMC5130ChopperMStepRes(ActualCommand.Motor, 8-ActualCommand.Value.Int32);
-        break;
-
-      case 167:
-        SetTMC5130ChopperTOff(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 168:
-        SetTMC5130SmartEnergyIMin(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 169:
-        SetTMC5130SmartEnergyDownStep(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 170:
-        SetTMC5130SmartEnergyStallLevelMax(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 171:
-        SetTMC5130SmartEnergyUpStep(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 172:
-        SetTMC5130SmartEnergyStallLevelMin(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 173:
-        SetTMC5130SmartEnergyFilter(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 174:
-        SetTMC5130SmartEnergyStallThreshold(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 179:
-        SetTMC5130ChopperVSenseMode(ActualCommand.Motor, ActualCommand.Value.Byte[0]);
-        break;
-
-      case 181:
-        StallVMin[ActualCommand.Motor]=ConvertVelocityUserToInternal(ActualCommand.Value.Int32);
-        break;
-
-      case 182:
-        if(ActualCommand.Value.Int32>=0)
-        {
-          if(ActualCommand.Value.Int32>0)
-            WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TCOOLTHRS, 12500000 / ActualCommand.Value.Int32);
-          else
-            WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TCOOLTHRS, 1048757);
-        }
-        else ActualReply.Status=REPLY_INVALID_VALUE;
-        break;
-
-      case 186:
-        if(ActualCommand.Value.Int32>=0)
-        {
-          if(ActualCommand.Value.Int32>0)
-            WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TPWMTHRS, 12500000 / ActualCommand.Value.Int32);
-          else
-            WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TPWMTHRS, 1048757);
-        }
-        else ActualReply.Status=REPLY_INVALID_VALUE;
-        break;
-
-      case 187:
-        SetTMC5130PWMGrad(ActualCommand.Motor, ActualCommand.Value.Int32);
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_GCONF);
-        if(ActualCommand.Value.Int32!=0)  //PWMGrad=0 => completely switch off StealthChop
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_GCONF, Value|TMC5130_GCONF_EN_PWM_MODE);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_GCONF, Value& ~TMC5130_GCONF_EN_PWM_MODE);
-        break;
-
-      case 188:
-        SetTMC5130PWMAmpl(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 191:
-        SetTMC5130PWMFrequency(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
-
-      case 192:
-        SetTMC5130PWMAutoscale(ActualCommand.Motor, ActualCommand.Value.Int32);
-        break;
+  ActualReply.Value.Int32=Value;
+}
 
-      case 193:
-        RefSearchStallThreshold[ActualCommand.Motor]=ActualCommand.Value.Int32;
-        break;
 
-      case 194:
-        RefSearchVelocity[ActualCommand.Motor]=ActualCommand.Value.Int32;
-        break;
+/***************************************************************//**
+   \fn SetCoordinate()
+   \brief TMCL SCO command
+
+   Set coordinate <type> of an axis (RAM only). With motor 255
+   (COORD_ALL_AXES) coordinate <type> of all axes is stored in the
+   flash instead, so that it is restored at every start-up
+   (coordinates 1..TMCL_COORDINATES-1, coordinate 0 is RAM only).
+   Like STAP this can block the Homebus receiver during a page
+   change.
+********************************************************************/
+static void SetCoordinate(void)
+{
+  uint32_t i;
 
-      case 195:
-        RefSearchStallVMin[ActualCommand.Motor]=ActualCommand.Value.Int32;
-        break;
+  if(ActualCommand.Type>=TMCL_COORDINATES)
+  {
+    ActualReply.Status=REPLY_WRONG_TYPE;
+    return;
+  }
 
-      case 214:
-        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TPOWERDOWN, (int) floor((double) ActualCommand.Value.Int32/TPOWERDOWN_FACTOR));
-        break;
+  if(ActualCommand.Motor==COORD_ALL_AXES)
+  {
+    if(ActualCommand.Type==0)
+    {
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      return;
+    }
 
-      case 251:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_GCONF);
-        if(ActualCommand.Value.Int32!=0)
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_GCONF, Value|TMC5130_GCONF_SHAFT);
-        else
-          WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_GCONF, Value & ~TMC5130_GCONF_SHAFT);
-        break;
+    for(i=0; i<N_O_MOTORS; i++)
+    {
+      switch(ParamStoreWrite(PS_KIND_COORD, i, ActualCommand.Type, TMCLCoordinates[i][ActualCommand.Type]))
+      {
+        case PS_OK:
+          break;
 
-      case 255:
-        if(ActualCommand.Value.Int32!=0)
-          GPIO_OutClr(&enable_out);
-        else
-          GPIO_OutSet(&enable_out);
-        break;
+        case PS_FULL:
+          ActualReply.Status=REPLY_MAX_EXCEEDED;
+          return;
 
-      default:
-        ActualReply.Status=REPLY_WRONG_TYPE;
+        default:
+          ActualReply.Status=REPLY_CMD_LOAD_ERROR;
+          return;
+      }
     }
-  } else ActualReply.Status=REPLY_INVALID_VALUE;
+  }
+  else if(ActualCommand.Motor<N_O_MOTORS)
+    TMCLCoordinates[ActualCommand.Motor][ActualCommand.Type]=ActualCommand.Value.Int32;
+  else
+    ActualReply.Status=REPLY_INVALID_VALUE;
 }
 
 
 /***************************************************************//**
-   \fn GetAxisParameter()
-   \brief TMCL GAP command
+   \fn GetCoordinate()
+   \brief TMCL GCO command
 
-   Execute TMCL GAP command.
+   Read coordinate <type> of an axis. With motor 255 (COORD_ALL_AXES)
+   coordinate <type> of all axes is restored from the flash instead
+   (coordinates that have never been stored are left unchanged).
 ********************************************************************/
-void GetAxisParameter(void)
+static void GetCoordinate(void)
 {
-  uint32_t Value;
+  uint32_t i;
+  int Value;
 
-  if(ActualCommand.Motor<N_O_MOTORS)
+  if(ActualCommand.Type>=TMCL_COORDINATES)
   {
-    switch(ActualCommand.Type)
-    {
-      case 0:
-        ActualReply.Value.Int32=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_XTARGET);
-        break;
-
-      case 1:
-        ActualReply.Value.Int32=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_XACTUAL);
-        break;
-
-      case 2:
-        if(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPMODE)==TMC5130_MODE_VELPOS)
-          ActualReply.Value.Int32=ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VMAX));
-        else
-          ActualReply.Value.Int32=-ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VMAX));
-        break;
-
-      case 3:
-        ActualReply.Value.Int32=ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VACTUAL));
-        break;
-
-      case 4:
-        ActualReply.Value.Int32=ConvertVelocityInternalToUser(VMax[ActualCommand.Motor]);
-        break;
-
-      case 5:
-        ActualReply.Value.Int32=ConvertAccelerationInternalToUser(AMax[ActualCommand.Motor]);
-        break;
-
-      case 6:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN);
-        ActualReply.Value.Int32=((Value>>8) & 0xff)*8;
-        break;
-
-      case 7:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN);
-        ActualReply.Value.Int32=(Value & 0xff)*8;
-        break;
-
-      case 8:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPSTAT) & TMC5130_RS_POSREACHED) ? 1:0;
-        break;
-
-      case 10:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPSTAT) & TMC5130_RS_STOPR) ? 1:0;
-        break;
-
-      case 11:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_RAMPSTAT) & TMC5130_RS_STOPL) ? 1:0;
-        break;
-
-      case 12:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE) & TMC5130_SW_STOPR_ENABLE) ? 0:1;
-        break;
-
-      case 13:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE) & TMC5130_SW_STOPL_ENABLE) ? 0:1;
-        break;
-
-      case 14:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE) & TMC5130_SW_SWAP_LR) ? 1:0;
-        break;
-
-      case 15:
-        ActualReply.Value.Int32=ConvertAccelerationInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_A1));
-        break;
-
-      case 16:
-        ActualReply.Value.Int32=ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_V1));
-        break;
-
-      case 17:
-        ActualReply.Value.Int32=ConvertAccelerationInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_DMAX));
-        break;
-
-      case 18:
-        ActualReply.Value.Int32=ConvertAccelerationInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_D1));
-        break;
-
-      case 19:
-        ActualReply.Value.Int32=ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VSTART));
-        break;
-
-      case 20:
-        ActualReply.Value.Int32=ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VSTOP));
-        break;
-
-      case 21:
-        ActualReply.Value.Int32=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TZEROWAIT);
-        break;
-
-      case 22:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_THIGH);
-        if(Value>0)
-          ActualReply.Value.Int32=16000000/Value;
-         else
-          ActualReply.Value.Int32=16777215;
-        break;
-
-      case 23:
-        ActualReply.Value.Int32=ConvertVelocityInternalToUser(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VDCMIN));
-        break;
-
-      case 24:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE) & TMC5130_SW_STOPR_POLARITY) ? 1:0;
-        break;
-
-      case 25:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE) & TMC5130_SW_STOPL_POLARITY) ? 1:0;
-        break;
-
-      case 26:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_SWMODE) & TMC5130_SW_SOFTSTOP) ? 1:0;
-        break;
-
-      case 27:
-        ActualReply.Value.Int32=GetTMC5130ChopperVHighChm(ActualCommand.Motor);
-        break;
-
-      case 28:
-        ActualReply.Value.Int32=GetTMC5130ChopperVHighFs(ActualCommand.Motor);
-        break;
-
-      case 30:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN);
-        ActualReply.Value.Int32=((Value>>16) & 0x0f);
-        break;
-
-      case 31:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_IHOLD_IRUN);
-        ActualReply.Value.Int32=((Value>>16) & 0x0f);
-        break;
-
-      case 32:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_DCCTRL);
-        ActualReply.Value.Int32=Value & 0x3ff;
-        break;
-
-      case 33:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_DCCTRL);
-        ActualReply.Value.Int32=Value >> 16;
-        break;
-
-      case 140:
-        ActualReply.Value.Int32=8-GetTMC5130ChopperMStepRes(ActualCommand.Motor);
-        break;
+    ActualReply.Status=REPLY_WRONG_TYPE;
+    return;
+  }
 
-      case 167:
-        ActualReply.Value.Int32=GetTMC5130ChopperTOff(ActualCommand.Motor);
-        break;
+  if(ActualCommand.Motor==COORD_ALL_AXES)
+  {
+    for(i=0; i<N_O_MOTORS; i++)
+      if(ParamStoreRead(PS_KIND_COORD, i, ActualCommand.Type, &Value))
+        TMCLCoordinates[i][ActualCommand.Type]=Value;
+  }
+  else if(ActualCommand.Motor<N_O_MOTORS)
+    ActualReply.Value.Int32=TMCLCoordinates[ActualCommand.Motor][ActualCommand.Type];
+  else
+    ActualReply.Status=REPLY_INVALID_VALUE;
+}
 
-      case 168:
-        ActualReply.Value.Int32=GetTMC5130SmartEnergyIMin(ActualCommand.Motor);
-        break;
 
-      case 169:
-        ActualReply.Value.Int32=GetTMC5130SmartEnergyDownStep(ActualCommand.Motor);
-        break;
+/***************************************************************//**
+   \fn CaptureCoordinate()
+   \brief TMCL CCO command
 
-      case 170:
-        ActualReply.Value.Int32=GetTMC5130SmartEnergyStallLevelMax(ActualCommand.Motor);
-        break;
+   Set coordinate <type> of an axis to the actual position.
+********************************************************************/
+static void CaptureCoordinate(void)
+{
+  if(ActualCommand.Type>=TMCL_COORDINATES)
+  {
+    ActualReply.Status=REPLY_WRONG_TYPE;
+    return;
+  }
 
-      case 171:
-        ActualReply.Value.Int32=GetTMC5130SmartEnergyUpStep(ActualCommand.Motor);
-        break;
+  if(ActualCommand.Motor<N_O_MOTORS)
+  {
+    TMCLCoordinates[ActualCommand.Motor][ActualCommand.Type]=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_XACTUAL);
+    ActualReply.Value.Int32=TMCLCoordinates[ActualCommand.Motor][ActualCommand.Type];
+  }
+  else ActualReply.Status=REPLY_INVALID_VALUE;
+}
 
-      case 172:
-        ActualReply.Value.Int32=GetTMC5130SmartEnergyStallLevelMin(ActualCommand.Motor);
-        break;
 
-      case 173:
-        ActualReply.Value.Int32=GetTMC5130SmartEnergyFilter(ActualCommand.Motor);
-        break;
+/***************************************************************//**
+   \fn SetGlobalParameter()
+   \brief TMCL SGP command
 
-      case 174:
-        ActualReply.Value.Int32=GetTMC5130SmartEnergyStallThreshold(ActualCommand.Motor);
-        break;
+   Execute TMCL SGP command (see GlobalParameters.c).
+********************************************************************/
+static void SetGlobalParameter(void)
+{
+  ActualReply.Status=WriteGlobalParameter(ActualCommand.Motor, ActualCommand.Type, ActualCommand.Value.Int32);
+}
 
-      case 179:
-        ActualReply.Value.Int32=GetTMC5130ChopperVSenseMode(ActualCommand.Motor);
-        break;
 
-      case 180:
-        ActualReply.Value.Int32=(ReadTMC5130Int(ActualCommand.Motor, TMC5130_DRVSTATUS) >> 16) & 0x1f;
-        break;
+/***************************************************************//**
+   \fn GetGlobalParameter()
+   \brief TMCL GGP command
 
-      case 181:
-        ActualReply.Value.Int32=ConvertVelocityInternalToUser(StallVMin[ActualCommand.Motor]);
-        break;
+   Execute TMCL GGP command (see GlobalParameters.c).
+********************************************************************/
+static void GetGlobalParameter(void)
+{
+  int Value;
 
-      case 182:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TCOOLTHRS);
-        if(Value>0)
-          ActualReply.Value.Int32=12500000/Value;
-         else
-          ActualReply.Value.Int32=16777215;
-        break;
+  ActualReply.Status=ReadGlobalParameter(ActualCommand.Motor, ActualCommand.Type, &Value);
+  if(ActualReply.Status==REPLY_OK) ActualReply.Value.Int32=Value;
+}
 
-      case 186:
-        Value=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TPWMTHRS);
-        if(Value>0)
-          ActualReply.Value.Int32=12500000/Value;
-         else
-          ActualReply.Value.Int32=16777215;
-        break;
 
-      case 187:
-        ActualReply.Value.Int32=GetTMC5130PWMGrad(ActualCommand.Motor);
-        break;
+/***************************************************************//**
+   \fn StoreGlobalParameter()
+   \brief TMCL STGP command
 
-      case 188:
-        ActualReply.Value.Int32=GetTMC5130PWMAmpl(ActualCommand.Motor);
-        break;
+   Store the actual value of a global parameter in the flash. It
+   will then be restored at every start-up. Like STAP this can
+   block the Homebus receiver during a page change.
+********************************************************************/
+static void StoreGlobalParameter(void)
+{
+  int Value;
 
-      case 189:
-        ActualReply.Value.Int32=ReadTMC5130Int(ActualCommand.Motor, TMC5130_PWMSCALE);
-        break;
+  if(!(GlobalParameterAccess(ActualCommand.Motor, ActualCommand.Type) & PB_STORE))
+  {
+    ActualReply.Status=REPLY_WRONG_TYPE;
+    return;
+  }
 
-      case 191:
-        ActualReply.Value.Int32=GetTMC5130PWMFrequency(ActualCommand.Motor);
-        break;
+  ReadGlobalParameter(ActualCommand.Motor, ActualCommand.Type, &Value);
+  ActualReply.Value.Int32=Value;
 
-      case 192:
-        ActualReply.Value.Int32=GetTMC5130PWMAutoscale(ActualCommand.Motor);
-        break;
+  switch(ParamStoreWrite(PS_KIND_GLOBAL, ActualCommand.Motor, ActualCommand.Type, Value))
+  {
+    case PS_OK:
+      break;
 
-      case 193:
-        ActualReply.Value.Int32=RefSearchStallThreshold[ActualCommand.Motor];
-        break;
+    case PS_FULL:
+      ActualReply.Status=REPLY_MAX_EXCEEDED;
+      break;
 
-      case 194:
-        ActualReply.Value.Int32=RefSearchVelocity[ActualCommand.Motor];
-        break;
+    default:
+      ActualReply.Status=REPLY_CMD_LOAD_ERROR;
+      break;
+  }
+}
 
-      case 195:
-        ActualReply.Value.Int32=RefSearchStallVMin[ActualCommand.Motor];
-        break;
 
-      case 196:
-        ActualReply.Value.Int32=RefSearchDistance[ActualCommand.Motor];
-        break;
+/***************************************************************//**
+   \fn RestoreGlobalParameter()
+   \brief TMCL RSGP command
 
-      case 206:
-        ActualReply.Value.Int32=ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_DRVSTATUS) & 0x3ff;
-        break;
+   Set a global parameter to the value stored in the flash. If the
+   parameter has never been stored it is left unchanged.
+********************************************************************/
+static void RestoreGlobalParameter(void)
+{
+  int Value;
 
-      case 207:
-        ActualReply.Value.Int32=StallFlag[ActualCommand.Motor];
-        break;
+  if(!(GlobalParameterAccess(ActualCommand.Motor, ActualCommand.Type) & PB_STORE))
+  {
+    ActualReply.Status=REPLY_WRONG_TYPE;
+    return;
+  }
 
-      case 208:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_DRVSTATUS) >> 24) & 0xff;
-        break;
+  if(ParamStoreRead(PS_KIND_GLOBAL, ActualCommand.Motor, ActualCommand.Type, &Value))
+    ActualReply.Status=WriteGlobalParameter(ActualCommand.Motor, ActualCommand.Type, Value);
+  else
+    ReadGlobalParameter(ActualCommand.Motor, ActualCommand.Type, &Value);
 
-      case 214:
-        ActualReply.Value.Int32=(int) ceil((double) ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_TPOWERDOWN)*TPOWERDOWN_FACTOR);
-        break;
+  ActualReply.Value.Int32=Value;
+}
 
-      case 251:
-        ActualReply.Value.Int32=(ReadTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_GCONF) & TMC5130_GCONF_SHAFT) ? 1:0;
-        break;
 
-      case 255:
-        ActualReply.Value.Int32=GPIO_OutGet(&enable_out) ? 0:1;
-        break;
+/***************************************************************//**
+   \fn AccumulatorToGlobalParameter()
+   \brief TMCL AGP command
 
-      default:
-        ActualReply.Status=REPLY_WRONG_TYPE;
-        break;
-    }
-  } else ActualReply.Status=REPLY_INVALID_VALUE;
+   Copy the accumulator to a global parameter.
+********************************************************************/
+static void AccumulatorToGlobalParameter(void)
+{
+  ActualReply.Status=WriteGlobalParameter(ActualCommand.Motor, ActualCommand.Type, TMCLAccumulator);
+  ActualReply.Value.Int32=TMCLAccumulator;
 }
 
 
@@ -990,6 +1237,8 @@ static void ReferenceSearch(void)
     switch(ActualCommand.Type)
     {
       case RFS_START:
+        ClearMotionQueue(ActualCommand.Motor);
+        StopPVT(ActualCommand.Motor);
         StartRefSearch(ActualCommand.Motor);
         break;
 
@@ -1011,30 +1260,41 @@ static void ReferenceSearch(void)
 
 
 /***************************************************************//**
-  \fn GetVersion(void)
-  \brief Command 136 (get version)
+   \fn LinkTest()
+   \brief TMCL link test command
 
-  Get the version number (when type==0) or
-  the version string (when type==1).
+   Loopback mode for measuring throughput and error rate of the
+   Homebus link (see LinkTest.c).
 ********************************************************************/
-static void GetVersion(void)
+static void LinkTest(void)
 {
-  uint32_t i;
+  uint32_t Result;
 
   switch(ActualCommand.Type)
   {
-    case 0:
-      TMCLReplyFormat=RF_SPECIAL;
-      SpecialReply[0]=RS485_HOST_ADDRESS;
-      for(i=0; i<8; i++)
-        SpecialReply[i+1]=VersionString[i];
+    case LT_START:
+      StartLinkTest(ActualCommand.Value.Int32);
       break;
 
-    case 1:
-      ActualReply.Value.Byte[3]=SW_TYPE_HIGH;
-      ActualReply.Value.Byte[2]=SW_TYPE_LOW;
-      ActualReply.Value.Byte[1]=SW_VERSION_HIGH;
-      ActualReply.Value.Byte[0]=SW_VERSION_LOW;
+    case LT_PATTERN:
+      //The pattern is echoed back unchanged in the reply.
+      if(LinkTestActive())
+      {
+        if(!LinkTestPattern(ActualCommand.Motor, ActualCommand.Value.Int32))
+          ActualReply.Status=REPLY_INVALID_VALUE;
+      }
+      else ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+      break;
+
+    case LT_STOP:
+      StopLinkTest();
+      break;
+
+    case LT_RESULT:
+      if(GetLinkTestResult(ActualCommand.Motor, &Result))
+        ActualReply.Value.Int32=Result;
+      else
+        ActualReply.Status=REPLY_INVALID_VALUE;
       break;
 
     default:
@@ -1042,3 +1302,980 @@ static void GetVersion(void)
       break;
   }
 }
+
+
+/***************************************************************//**
+   \fn BuildReplyFrame(uint8_t *Frame, uint8_t Status, uint8_t Opcode, int Value)
+   \brief Build a standard reply frame
+   \param Frame: buffer for the frame (9 bytes)
+   \param Status: status code
+   \param Opcode: opcode
+   \param Value: reply value
+
+   Build a frame in standard reply format (used for multi-frame
+   special replies). The status is used unchanged, so status codes
+   have to be passed through ReplyStatus().
+********************************************************************/
+static void BuildReplyFrame(uint8_t *Frame, uint8_t Status, uint8_t Opcode, int Value)
+{
+  uint32_t i;
+
+  Frame[0]=HostAddress;
+  Frame[1]=ModuleAddress;
+  Frame[2]=Status;
+  Frame[3]=Opcode;
+  Frame[4]=Value >> 24;
+  Frame[5]=Value >> 16;
+  Frame[6]=Value >> 8;
+  Frame[7]=Value & 0xff;
+  Frame[8]=0;
+  for(i=0; i<8; i++) Frame[8]+=Frame[i];
+}
+
+
+/***************************************************************//**
+   \fn BatchRead()
+   \brief Read several values with one command
+
+   Bit n of the value selects item n of BatchReadItems[] (motor: axis).
+   The reply consists of one standard reply frame per selected item,
+   in ascending bit order. The TMC5130 registers are read with
+   pipelined SPI accesses (see ReadAxisParameterList()).
+********************************************************************/
+static void BatchRead(void)
+{
+  uint8_t Numbers[N_BATCH_READ_ITEMS];
+  int Values[N_BATCH_READ_ITEMS];
+  uint8_t Status[N_BATCH_READ_ITEMS];
+  uint32_t Items;
+  uint32_t Count;
+  uint32_t Frames;
+  uint32_t i;
+
+  Items=ActualCommand.Value.Int32;
+  if(Items==0 || (Items>>N_BATCH_READ_ITEMS)!=0)
+  {
+    ActualReply.Status=REPLY_INVALID_VALUE;
+    return;
+  }
+
+  //Read all selected axis parameters at once
+  Count=0;
+  for(i=0; i<N_BATCH_READ_ITEMS; i++)
+  {
+    if((Items & (1<<i)) && BatchReadItems[i].Source==BR_AXIS)
+      Numbers[Count++]=BatchReadItems[i].Number;
+  }
+  ReadAxisParameterList(ActualCommand.Motor, Numbers, Values, Status, Count);
+
+  //One reply frame per item
+  Count=0;
+  Frames=0;
+  for(i=0; i<N_BATCH_READ_ITEMS; i++)
+  {
+    if(!(Items & (1<<i))) continue;
+
+    if(BatchReadItems[i].Source==BR_AXIS)
+    {
+      BuildReplyFrame(&SpecialReply[9*Frames], ReplyStatus(Status[Count]), TMCL_BatchRead, (Status[Count]==REPLY_OK) ? Values[Count] : 0);
+      Count++;
+    }
+    else if(BatchReadItems[i].Source==BR_INPUT)
+      BuildReplyFrame(&SpecialReply[9*Frames], ReplyStatus(REPLY_OK), TMCL_BatchRead, GetTemperature());
+    else
+      BuildReplyFrame(&SpecialReply[9*Frames], ReplyStatus(REPLY_OK), TMCL_BatchRead, GetPendingEvents());
+    Frames++;
+  }
+
+  TMCLReplyFormat=RF_SPECIAL;
+  SpecialReplyFrames=Frames;
+}
+
+/***************************************************************//**
+   \fn RegisterDump()
+   \brief Read all TMC5130 registers
+
+   The reply consists of a standard reply frame (value: number of
+   following frames) and then one frame per TMC5130 register:
+     byte 0: host address
+     byte 1: module address
+     byte 2: register address
+     byte 3: 1: read from the TMC5130, 0: software copy (write only register)
+     byte 4..7: register value (MSB first)
+     byte 8: checksum
+   The complete dump (55 frames) takes about 43ms at 230400bps. It is
+   sent one frame per main loop iteration by ProcessCommand(), so the
+   main loop is not blocked.
+********************************************************************/
+static void RegisterDump(void)
+{
+  uint8_t Addresses[TMC5130_SNAPSHOT_SIZE];
+  int Values[TMC5130_SNAPSHOT_SIZE];
+  uint8_t Readable[TMC5130_SNAPSHOT_SIZE];
+  uint32_t Count;
+  uint32_t i;
+
+  if(ActualCommand.Motor>=N_O_MOTORS)
+  {
+    ActualReply.Status=REPLY_INVALID_VALUE;
+    return;
+  }
+
+  Count=ReadTMC5130Snapshot(WHICH_5130(ActualCommand.Motor), Addresses, Values, Readable);
+
+  BuildReplyFrame(SpecialReply, ReplyStatus(REPLY_OK), TMCL_RegisterDump, Count);
+  for(i=0; i<Count; i++)
+  {
+    BuildReplyFrame(&SpecialReply[9*(i+1)], Addresses[i], Readable[i], Values[i]);
+  }
+
+  TMCLReplyFormat=RF_SPECIAL;
+  SpecialReplyFrames=Count+1;
+}
+
+/***************************************************************//**
+   \fn SetEvent()
+   \brief Command 138 (event control)
+
+   Type 0: set event mask (value, 0: no events), 1: read event mask,
+   2: read pending events, 3: read and clear pending events.
+   See Events.h for the event flags.
+********************************************************************/
+static void SetEvent(void)
+{
+  switch(ActualCommand.Type)
+  {
+    case SE_SET_MASK:
+      SetEventMask(ActualCommand.Value.Int32);
+      break;
+
+    case SE_GET_MASK:
+      ActualReply.Value.Int32=GetEventMask();
+      break;
+
+    case SE_GET_EVENTS:
+      ActualReply.Value.Int32=GetPendingEvents();
+      break;
+
+    case SE_CLEAR_EVENTS:
+      ActualReply.Value.Int32=ClearPendingEvents();
+      break;
+
+    default:
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      break;
+  }
+}
+
+/***************************************************************//**
+   \fn PVTCommand()
+   \brief Command 158 (PVT streaming mode)
+
+   Type 0/1: set velocity (pps) / duration (ms) used for the next
+   points, 2: add a point (value: position, reply: number of buffered
+   points), 3: start, 4: stop the motor and delete all points, 5: read
+   the number of buffered points, 6: read the state, 7: read the
+   underrun counter, 8: read the highest position error. See PVT.c.
+********************************************************************/
+static void PVTCommand(void)
+{
+  if(ActualCommand.Motor>=N_O_MOTORS)
+  {
+    ActualReply.Status=REPLY_INVALID_VALUE;
+    return;
+  }
+
+  switch(ActualCommand.Type)
+  {
+    case PVT_SET_VELOCITY:
+      if(!SetPVTVelocity(ActualCommand.Motor, ActualCommand.Value.Int32))
+        ActualReply.Status=REPLY_INVALID_VALUE;
+      break;
+
+    case PVT_SET_DURATION:
+      if(!SetPVTDuration(ActualCommand.Motor, ActualCommand.Value.Int32))
+        ActualReply.Status=REPLY_INVALID_VALUE;
+      break;
+
+    case PVT_PUSH:
+      if(PushPVTPoint(ActualCommand.Motor, ActualCommand.Value.Int32))
+        ActualReply.Value.Int32=GetPVTLevel(ActualCommand.Motor);
+      else
+        ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;  //buffer full
+      break;
+
+    case PVT_START:
+      ClearMotionQueue(ActualCommand.Motor);
+      StartPVT(ActualCommand.Motor);
+      break;
+
+    case PVT_STOP:
+      //Velocity mode: stop with AMAX
+      if(GetPVTState(ActualCommand.Motor)==PVT_RUNNING)
+        WriteTMC5130Int(WHICH_5130(ActualCommand.Motor), TMC5130_VMAX, 0);
+      StopPVT(ActualCommand.Motor);
+      break;
+
+    case PVT_GET_LEVEL:
+      ActualReply.Value.Int32=GetPVTLevel(ActualCommand.Motor);
+      break;
+
+    case PVT_GET_STATE:
+      ActualReply.Value.Int32=GetPVTState(ActualCommand.Motor);
+      break;
+
+    case PVT_GET_UNDERRUNS:
+      ActualReply.Value.Int32=GetPVTUnderruns(ActualCommand.Motor);
+      break;
+
+    case PVT_GET_MAX_ERROR:
+      ActualReply.Value.Int32=GetPVTMaxError(ActualCommand.Motor);
+      break;
+
+    default:
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      break;
+  }
+}
+
+/***************************************************************//**
+  \fn GetVersion(void)
+  \brief Command 136 (get version)
+
+  Get the version number (when type==0) or
+  the version string (when type==1).
+********************************************************************/
+static void GetVersion(void)
+{
+  uint32_t i;
+
+  switch(ActualCommand.Type)
+  {
+    case 0:
+      TMCLReplyFormat=RF_SPECIAL;
+      SpecialReply[0]=HostAddress;
+      for(i=0; i<8; i++)
+        SpecialReply[i+1]=VersionString[i];
+      break;
+
+    case 1:
+      ActualReply.Value.Byte[3]=SW_TYPE_HIGH;
+      ActualReply.Value.Byte[2]=SW_TYPE_LOW;
+      ActualReply.Value.Byte[1]=SW_VERSION_HIGH;
+      ActualReply.Value.Byte[0]=SW_VERSION_LOW;
+      break;
+
+    default:
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      break;
+  }
+}
+
+
+/***************************************************************//**
+  \fn JumpTo(int Address)
+  \brief Set the program counter
+  \param Address: new program address
+  \return TRUE if the address is valid
+
+  Set the program counter of the stand-alone program. An invalid
+  address stops the program.
+********************************************************************/
+static uint8_t JumpTo(int Address)
+{
+  if(Address>=0 && Address<TMCL_MEM_SIZE)
+  {
+    TMCLProgramCounter=Address;
+    return TRUE;
+  }
+
+  TMCLExecutionMode=TM_IDLE;
+  ActualReply.Status=REPLY_INVALID_VALUE;
+  return FALSE;
+}
+
+
+/***************************************************************//**
+  \fn CalculateAccumulator(uint8_t Type, int Operand)
+  \brief Arithmetic and logic operations of CALC and CALCX
+  \param Type: CALC_ADD ... CALC_NOT
+  \param Operand: value or X register
+  \return REPLY_OK, REPLY_INVALID_VALUE (division by zero) or
+          REPLY_WRONG_TYPE (other type)
+
+  Calculate accumulator <op> operand. Addition, subtraction and
+  multiplication are done in 32 bit unsigned arithmetic, so an
+  overflow wraps around (two's complement) instead of being
+  undefined. Dividing -2147483648 by -1 gives -2147483648, the
+  remainder is 0.
+********************************************************************/
+static uint8_t CalculateAccumulator(uint8_t Type, int Operand)
+{
+  switch(Type)
+  {
+    case CALC_ADD:
+      TMCLAccumulator=(int) ((uint32_t) TMCLAccumulator+(uint32_t) Operand);
+      break;
+
+    case CALC_SUB:
+      TMCLAccumulator=(int) ((uint32_t) TMCLAccumulator-(uint32_t) Operand);
+      break;
+
+    case CALC_MUL:
+      TMCLAccumulator=(int) ((uint32_t) TMCLAccumulator*(uint32_t) Operand);
+      break;
+
+    case CALC_DIV:
+    case CALC_MOD:
+      if(Operand==0) return REPLY_INVALID_VALUE;
+      if(Operand==-1)
+      {
+        //-2147483648/-1 would overflow
+        if(Type==CALC_DIV)
+          TMCLAccumulator=(int) (0-(uint32_t) TMCLAccumulator);
+        else
+          TMCLAccumulator=0;
+      }
+      else if(Type==CALC_DIV)
+        TMCLAccumulator/=Operand;
+      else
+        TMCLAccumulator%=Operand;
+      break;
+
+    case CALC_AND:
+      TMCLAccumulator&=Operand;
+      break;
+
+    case CALC_OR:
+      TMCLAccumulator|=Operand;
+      break;
+
+    case CALC_XOR:
+      TMCLAccumulator^=Operand;
+      break;
+
+    case CALC_NOT:
+      TMCLAccumulator=~TMCLAccumulator;
+      break;
+
+    default:
+      return REPLY_WRONG_TYPE;
+  }
+
+  return REPLY_OK;
+}
+
+
+/***************************************************************//**
+  \fn Calculate(void)
+  \brief TMCL CALC command
+
+  Calculate accumulator <op> value. The result is stored in
+  the accumulator and returned as reply value.
+********************************************************************/
+static void Calculate(void)
+{
+  if(ActualCommand.Type==CALC_LOAD)
+  {
+    TMCLAccumulator=ActualCommand.Value.Int32;
+  }
+  else
+  {
+    ActualReply.Status=CalculateAccumulator(ActualCommand.Type, ActualCommand.Value.Int32);
+    if(ActualReply.Status!=REPLY_OK) return;
+  }
+
+  if(TMCLAccumulator==0)
+    TMCLFlags|=FLAG_ZERO;
+  else
+    TMCLFlags&= ~FLAG_ZERO;
+
+  ActualReply.Value.Int32=TMCLAccumulator;
+}
+
+
+/***************************************************************//**
+  \fn CalculateX(void)
+  \brief TMCL CALCX command
+
+  Calculate accumulator <op> X register. The result is stored in
+  the accumulator (LOAD: X register := accumulator, SWAP: exchange
+  accumulator and X register).
+********************************************************************/
+static void CalculateX(void)
+{
+  int Temp;
+
+  switch(ActualCommand.Type)
+  {
+    case CALC_LOAD:
+      TMCLXRegister=TMCLAccumulator;
+      break;
+
+    case CALC_SWAP:
+      Temp=TMCLAccumulator;
+      TMCLAccumulator=TMCLXRegister;
+      TMCLXRegister=Temp;
+      break;
+
+    default:
+      ActualReply.Status=CalculateAccumulator(ActualCommand.Type, TMCLXRegister);
+      if(ActualReply.Status!=REPLY_OK) return;
+      break;
+  }
+
+  if(TMCLAccumulator==0)
+    TMCLFlags|=FLAG_ZERO;
+  else
+    TMCLFlags&= ~FLAG_ZERO;
+
+  ActualReply.Value.Int32=TMCLAccumulator;
+}
+
+
+/***************************************************************//**
+  \fn Compare(void)
+  \brief TMCL COMP command
+
+  Compare the accumulator with the value and set the
+  comparison flags accordingly.
+********************************************************************/
+static void Compare(void)
+{
+  TMCLFlags&= ~(FLAG_EQUAL|FLAG_LOWER|FLAG_GREATER);
+
+  if(TMCLAccumulator==ActualCommand.Value.Int32)
+    TMCLFlags|=FLAG_EQUAL;
+  else if(TMCLAccumulator<ActualCommand.Value.Int32)
+    TMCLFlags|=FLAG_LOWER;
+  else
+    TMCLFlags|=FLAG_GREATER;
+}
+
+
+/***************************************************************//**
+  \fn JumpAlways(void)
+  \brief TMCL JA command
+
+  Jump to the address given by the value (only in a
+  stand-alone program).
+********************************************************************/
+static void JumpAlways(void)
+{
+  if(TMCLCommandState==TCS_MEM)
+    JumpTo(ActualCommand.Value.Int32);
+  else
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+}
+
+
+/***************************************************************//**
+  \fn JumpConditional(void)
+  \brief TMCL JC command
+
+  Jump to the address given by the value if the condition
+  selected by the type is true (only in a stand-alone program).
+********************************************************************/
+static void JumpConditional(void)
+{
+  uint32_t Condition;
+
+  if(TMCLCommandState!=TCS_MEM)
+  {
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+    return;
+  }
+
+  switch(ActualCommand.Type)
+  {
+    case JC_ZE:
+      Condition=TMCLFlags & FLAG_ZERO;
+      break;
+
+    case JC_NZ:
+      Condition=!(TMCLFlags & FLAG_ZERO);
+      break;
+
+    case JC_EQ:
+      Condition=TMCLFlags & FLAG_EQUAL;
+      break;
+
+    case JC_NE:
+      Condition=!(TMCLFlags & FLAG_EQUAL);
+      break;
+
+    case JC_GT:
+      Condition=TMCLFlags & FLAG_GREATER;
+      break;
+
+    case JC_GE:
+      Condition=TMCLFlags & FLAG_GREATER_EQUAL;
+      break;
+
+    case JC_LT:
+      Condition=TMCLFlags & FLAG_LOWER;
+      break;
+
+    case JC_LE:
+      Condition=TMCLFlags & FLAG_LOWER_EQUAL;
+      break;
+
+    case JC_ETO:
+      Condition=TMCLFlags & FLAG_ERROR_TIMEOUT;
+      break;
+
+    case JC_EAL:
+      Condition=TMCLFlags & FLAG_ERROR_EXT_ALARM;
+      break;
+
+    case JC_EDV:
+      Condition=TMCLFlags & FLAG_ERROR_DEVIATION;
+      break;
+
+    case JC_EPO:
+      Condition=TMCLFlags & FLAG_ERROR_POSITION;
+      break;
+
+    case JC_ESD:
+      Condition=TMCLFlags & FLAG_ERROR_SHUTDOWN;
+      break;
+
+    default:
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      return;
+  }
+
+  if(Condition) JumpTo(ActualCommand.Value.Int32);
+}
+
+
+/***************************************************************//**
+  \fn CallSubroutine(void)
+  \brief TMCL CSUB command
+
+  Push the return address on the stack and jump to the
+  subroutine (only in a stand-alone program). A stack
+  overflow stops the program.
+********************************************************************/
+static void CallSubroutine(void)
+{
+  if(TMCLCommandState!=TCS_MEM)
+  {
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+    return;
+  }
+
+  if(TMCLStackPointer>=TMCL_STACK_DEPTH)
+  {
+    TMCLExecutionMode=TM_IDLE;
+    ActualReply.Status=REPLY_MAX_EXCEEDED;
+    return;
+  }
+
+  TMCLStack[TMCLStackPointer++]=TMCLProgramCounter;
+  if(!JumpTo(ActualCommand.Value.Int32)) TMCLStackPointer--;
+}
+
+
+/***************************************************************//**
+  \fn ReturnFromSubroutine(void)
+  \brief TMCL RSUB command
+
+  Return from a subroutine (only in a stand-alone program).
+  A stack underflow stops the program.
+********************************************************************/
+static void ReturnFromSubroutine(void)
+{
+  if(TMCLCommandState!=TCS_MEM)
+  {
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+    return;
+  }
+
+  if(TMCLStackPointer==0)
+  {
+    TMCLExecutionMode=TM_IDLE;
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+    return;
+  }
+
+  TMCLProgramCounter=TMCLStack[--TMCLStackPointer];
+}
+
+
+/***************************************************************//**
+  \fn Wait(void)
+  \brief TMCL WAIT command
+
+  Start waiting for the condition selected by the type. The value
+  is the wait time (WAIT_TICKS) or the timeout (other types, 0: no
+  timeout) in ticks of TMCL_TICK_MS (0..TMCL_MAX_WAIT_TICKS).
+  In a stand-alone program the condition is checked by
+  ProcessTMCLProgram(). In direct mode the command is answered at
+  once and the master polls the result with command 135, type 6
+  (WS_RUNNING, WS_DONE or WS_TIMEOUT). A new WAIT command cancels
+  a running one; its reply value is then WS_CANCELLED, otherwise
+  the result of the previous WAIT command.
+********************************************************************/
+static void Wait(void)
+{
+  TWaitState *Target;
+
+  switch(ActualCommand.Type)
+  {
+    case WAIT_TICKS:
+      break;
+
+    case WAIT_POS:
+    case WAIT_REFSW:
+    case WAIT_LIMSW:
+    case WAIT_RFS:
+      if(ActualCommand.Motor>=N_O_MOTORS)
+      {
+        ActualReply.Status=REPLY_INVALID_VALUE;
+        return;
+      }
+      //Only use ramp status data read after the start of the WAIT command
+      RampStatValid[ActualCommand.Motor]=FALSE;
+      break;
+
+    default:
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      return;
+  }
+
+  if(ActualCommand.Value.Int32<0 || ActualCommand.Value.Int32>TMCL_MAX_WAIT_TICKS)
+  {
+    ActualReply.Status=REPLY_INVALID_VALUE;
+    return;
+  }
+
+  if(TMCLCommandState==TCS_MEM)
+  {
+    Target=&ProgramWait;
+  }
+  else
+  {
+    Target=&DirectWait;
+    UpdateDirectWait();
+    if(DirectWait.Type!=WAIT_NONE) DirectWaitResult=WS_CANCELLED;
+    ActualReply.Value.Int32=DirectWaitResult;
+    DirectWaitResult=WS_RUNNING;
+  }
+
+  Target->Type=ActualCommand.Type;
+  Target->Motor=ActualCommand.Motor;
+  Target->Start=GetSysTimer();
+  Target->Time=ActualCommand.Value.Int32*TMCL_TICK_MS;
+}
+
+
+/***************************************************************//**
+  \fn StopProgram(void)
+  \brief TMCL STOP command
+
+  End the stand-alone program.
+********************************************************************/
+static void StopProgram(void)
+{
+  if(TMCLCommandState==TCS_MEM)
+    TMCLExecutionMode=TM_IDLE;
+  else
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+}
+
+
+/***************************************************************//**
+  \fn AccumulatorToAxisParameter(void)
+  \brief TMCL AAP command
+
+  Copy the accumulator to an axis parameter.
+********************************************************************/
+static void AccumulatorToAxisParameter(void)
+{
+  ActualReply.Status=WriteAxisParameter(ActualCommand.Motor, ActualCommand.Type, TMCLAccumulator);
+  ActualReply.Value.Int32=TMCLAccumulator;
+}
+
+
+/***************************************************************//**
+  \fn ClearErrorFlags(void)
+  \brief TMCL CLE command
+
+  Clear the error flag(s) selected by the type.
+********************************************************************/
+static void ClearErrorFlags(void)
+{
+  switch(ActualCommand.Type)
+  {
+    case CLE_ALL:
+      TMCLFlags&= ~(FLAG_ERROR_TIMEOUT|FLAG_ERROR_EXT_ALARM|FLAG_ERROR_DEVIATION|
+                    FLAG_ERROR_POSITION|FLAG_ERROR_SHUTDOWN);
+      break;
+
+    case CLE_ETO:
+      TMCLFlags&= ~FLAG_ERROR_TIMEOUT;
+      break;
+
+    case CLE_EAL:
+      TMCLFlags&= ~FLAG_ERROR_EXT_ALARM;
+      break;
+
+    case CLE_EDV:
+      TMCLFlags&= ~FLAG_ERROR_DEVIATION;
+      break;
+
+    case CLE_EPO:
+      TMCLFlags&= ~FLAG_ERROR_POSITION;
+      break;
+
+    case CLE_ESD:
+      TMCLFlags&= ~FLAG_ERROR_SHUTDOWN;
+      break;
+
+    default:
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      break;
+  }
+}
+
+
+/***************************************************************//**
+  \fn ApplicationStop(void)
+  \brief Command 128 (stop application)
+
+  Stop the stand-alone program. It can be continued with
+  command 129 (type 0).
+********************************************************************/
+static void ApplicationStop(void)
+{
+  if(TMCLExecutionMode==TM_RUN || TMCLExecutionMode==TM_STEP)
+  {
+    TMCLExecutionMode=TM_IDLE;
+    ProgramWait.Type=WAIT_NONE;
+  }
+}
+
+
+/***************************************************************//**
+  \fn ApplicationRun(void)
+  \brief Command 129 (run application)
+
+  Start the stand-alone program from the actual address (type 0)
+  or from the address given by the value (type 1).
+********************************************************************/
+static void ApplicationRun(void)
+{
+  if(TMCLExecutionMode==TM_DOWNLOAD)
+  {
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+    return;
+  }
+
+  switch(ActualCommand.Type)
+  {
+    case 0:
+      break;
+
+    case 1:
+      if(ActualCommand.Value.Int32<0 || ActualCommand.Value.Int32>=TMCL_MEM_SIZE)
+      {
+        ActualReply.Status=REPLY_INVALID_VALUE;
+        return;
+      }
+      TMCLProgramCounter=ActualCommand.Value.Int32;
+      ProgramWait.Type=WAIT_NONE;
+      break;
+
+    default:
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      return;
+  }
+
+  TMCLExecutionMode=TM_RUN;
+}
+
+
+/***************************************************************//**
+  \fn ApplicationStep(void)
+  \brief Command 130 (step application)
+
+  Execute the next command of the stand-alone program.
+********************************************************************/
+static void ApplicationStep(void)
+{
+  if(TMCLExecutionMode==TM_DOWNLOAD)
+  {
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+    return;
+  }
+
+  TMCLExecutionMode=TM_STEP;
+  TMCLStepPending=TRUE;
+}
+
+
+/***************************************************************//**
+  \fn ApplicationReset(void)
+  \brief Command 131 (reset application)
+
+  Stop the stand-alone program and reset program counter,
+  stack, registers and flags.
+********************************************************************/
+static void ApplicationReset(void)
+{
+  if(TMCLExecutionMode==TM_DOWNLOAD)
+  {
+    ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+    return;
+  }
+
+  TMCLExecutionMode=TM_IDLE;
+  ProgramWait.Type=WAIT_NONE;
+  TMCLStepPending=FALSE;
+  TMCLProgramCounter=0;
+  TMCLStackPointer=0;
+  TMCLAccumulator=0;
+  TMCLXRegister=0;
+  TMCLFlags=0;
+}
+
+
+/***************************************************************//**
+  \fn DownloadStart(void)
+  \brief Command 132 (start download)
+
+  Stop the stand-alone program and enter download mode. All
+  following program commands are stored in the program memory,
+  starting at the address given by the value.
+********************************************************************/
+static void DownloadStart(void)
+{
+  if(ActualCommand.Value.Int32<0 || ActualCommand.Value.Int32>=TMCL_MEM_SIZE)
+  {
+    ActualReply.Status=REPLY_INVALID_VALUE;
+    return;
+  }
+
+  TMCLExecutionMode=TM_DOWNLOAD;
+  ProgramWait.Type=WAIT_NONE;
+  TMCLDownloadPointer=ActualCommand.Value.Int32;
+}
+
+
+/***************************************************************//**
+  \fn DownloadEnd(void)
+  \brief Command 133 (end download)
+
+  Leave download mode. The reply value is the address after
+  the last stored command.
+********************************************************************/
+static void DownloadEnd(void)
+{
+  if(TMCLExecutionMode==TM_DOWNLOAD)
+  {
+    TMCLExecutionMode=TM_IDLE;
+    TMCLProgramCounter=0;
+    TMCLStackPointer=0;
+    ActualReply.Value.Int32=TMCLDownloadPointer;
+  }
+  else ActualReply.Status=REPLY_CMD_NOT_AVAILABLE;
+}
+
+
+/***************************************************************//**
+  \fn ReadMemory(void)
+  \brief Command 134 (read program memory)
+
+  Read back the program command at the address given by the
+  value. The reply consists of two frames: a standard reply frame
+  (status, value: address) and then the command in the same
+  layout as a command frame (byte 0: host address, bytes 1..7:
+  opcode, type, motor, value MSB first, byte 8: checksum).
+********************************************************************/
+static void ReadMemory(void)
+{
+  uint32_t i;
+
+  if(ActualCommand.Value.Int32<0 || ActualCommand.Value.Int32>=TMCL_MEM_SIZE)
+  {
+    ActualReply.Status=REPLY_INVALID_VALUE;
+    return;
+  }
+
+  TMCLReplyFormat=RF_SPECIAL;
+  SpecialReplyFrames=2;
+  BuildReplyFrame(SpecialReply, ReplyStatus(REPLY_OK), TMCL_ReadMem, ActualCommand.Value.Int32);
+  SpecialReply[9]=HostAddress;
+  SpecialReply[10]=TMCLProgram[ActualCommand.Value.Int32].Opcode;
+  SpecialReply[11]=TMCLProgram[ActualCommand.Value.Int32].Type;
+  SpecialReply[12]=TMCLProgram[ActualCommand.Value.Int32].Motor;
+  SpecialReply[13]=TMCLProgram[ActualCommand.Value.Int32].Value.Byte[3];
+  SpecialReply[14]=TMCLProgram[ActualCommand.Value.Int32].Value.Byte[2];
+  SpecialReply[15]=TMCLProgram[ActualCommand.Value.Int32].Value.Byte[1];
+  SpecialReply[16]=TMCLProgram[ActualCommand.Value.Int32].Value.Byte[0];
+  SpecialReply[17]=0;
+  for(i=9; i<17; i++) SpecialReply[17]+=SpecialReply[i];
+}
+
+
+/***************************************************************//**
+  \fn GetStatus(void)
+  \brief Command 135 (get application status)
+
+  Type 0: execution mode (TM_xxx), 1: program counter,
+  2: accumulator, 3: X register, 4: flags, 5: stack depth,
+  6: result of the last WAIT command in direct mode (WS_xxx).
+********************************************************************/
+static void GetStatus(void)
+{
+  switch(ActualCommand.Type)
+  {
+    case 0:
+      ActualReply.Value.Int32=TMCLExecutionMode;
+      break;
+
+    case 1:
+      ActualReply.Value.Int32=TMCLProgramCounter;
+      break;
+
+    case 2:
+      ActualReply.Value.Int32=TMCLAccumulator;
+      break;
+
+    case 3:
+      ActualReply.Value.Int32=TMCLXRegister;
+      break;
+
+    case 4:
+      ActualReply.Value.Int32=TMCLFlags;
+      break;
+
+    case 5:
+      ActualReply.Value.Int32=TMCLStackPointer;
+      break;
+
+    case 6:
+      UpdateDirectWait();
+      ActualReply.Value.Int32=DirectWaitResult;
+      break;
+
+    default:
+      ActualReply.Status=REPLY_WRONG_TYPE;
+      break;
+  }
+}
+
+
+/***************************************************************//**
+  \fn FactoryDefault(void)
+  \brief Command 137 (restore factory defaults)
+
+  Delete all parameters stored in the flash. The default values
+  will be used after the next reset. All interrupts (also the
+  Homebus receiver) are blocked while the pages are erased.
+********************************************************************/
+static void FactoryDefault(void)
+{
+  if(ParamStoreClear()!=PS_OK) ActualReply.Status=REPLY_CMD_LOAD_ERROR;
+}
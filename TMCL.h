@@ -126,6 +126,10 @@
 #define TMCL_Breakpoint 141
 
 #define TMCL_DriverCalibration 154
+#define TMCL_LinkTest 155
+#define TMCL_BatchRead 156
+#define TMCL_RegisterDump 157
+#define TMCL_PVT 158
 
 #define TMCL_Boot 0xf2
 #define TMCL_SoftwareReset 0xff
@@ -135,6 +139,10 @@
 #define MVP_ABS   0            //!< absolute movement (with MVP command)
 #define MVP_REL   1            //!< relative movement (with MVP command)
 #define MVP_COORD 2            //!< coordinate movement (with MVO command)
+#define MVP_QUEUE 3            //!< absolute movement added to the motion queue (see MotionQueue.c)
+#define MVP_QUEUE_LAST 4       //!< like MVP_QUEUE, last movement of a sequence (closes the sequence)
+#define MVP_MULTI_AXIS 0x80    //!< MVP COORD: motor parameter is a bit mask of axes
+#define COORD_ALL_AXES 0xff    //!< SCO/GCO: store/restore a coordinate of all axes in the flash
 
 //Optionen für relative Positionierung
 #define RMO_TARGET 0    //letzte Zielposition
@@ -144,6 +152,7 @@
 //TMCL status codes
 #define REPLY_OK 100                //!< command successfully executed
 #define REPLY_CMD_LOADED 101        //!< command succsssfully stored in EEPROM
+#define REPLY_OK_EVENT 102          //!< command successfully executed, events pending (see Events.c)
 #define REPLY_DELAYED 128           //!< delayed reply
 #define REPLY_CHKERR 1              //!< checksum error
 #define REPLY_INVALID_CMD 2         //!< command not supported
@@ -159,6 +168,8 @@
 #define RF_STANDARD 0               //!< use standard TMCL reply
 #define RF_SPECIAL 1                //!< use special reply
 
+#define TMCL_MAX_REPLY_FRAMES 64    //!< maximum number of frames of a special reply
+
 //Optionscodes
 #define RFS_START 0
 #define RFS_STOP 1
@@ -169,6 +180,14 @@
 #define WAIT_REFSW 2
 #define WAIT_LIMSW 3
 #define WAIT_RFS 4
+#define WAIT_NONE 0xff            //!< no WAIT command active
+
+//Results of a WAIT command (direct mode: command 135, type 6)
+#define WS_RUNNING   0            //!< condition not met yet
+#define WS_DONE      1            //!< condition met
+#define WS_TIMEOUT   2            //!< timeout expired
+#define WS_CANCELLED 3            //!< replaced by a new WAIT command
+#define WS_NONE      4            //!< no WAIT command since reset
 
 #define JC_ZE 0
 #define JC_NZ 1
@@ -220,6 +239,7 @@
 //Schreib-/Leseschutzbits
 #define PB_READ  0x01
 #define PB_WRITE 0x02
+#define PB_STORE 0x04     //!< parameter can be stored in the flash (STAP)
 
 //Motor-Fehler-Flags
 #define ME_STALLGUARD 0x01
@@ -268,6 +288,11 @@ typedef struct
 } TTMCLReply;
 
 
+#define TMCL_PROGRAM_BUDGET 16      //!< maximum number of program commands executed per main loop iteration
+#define TMCL_TICK_MS 10             //!< length of a TMCL timer tick (WAIT command) in ms
+#define TMCL_MAX_WAIT_TICKS (0x7fffffff/TMCL_TICK_MS)  //!< highest value of the WAIT command (about 24 days)
+
 //Prototypes of exported functions
 void InitTMCL(void);
-void ProcessTMCL(void);
+void ProcessCommand(void);
+void ProcessTMCLProgram(void);
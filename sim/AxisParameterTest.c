@@ -0,0 +1,448 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file AxisParameterTest.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: AxisParameterTest.c
+ *         Description: Test of the axis parameter table (../AxisParameters.c)
+ *
+ *                      Runs the whole firmware (see SimFirmware.c) and
+ *                      checks every axis parameter number 0..255 with
+ *                      SAP/GAP/STAP/RSAP commands. The expectations are
+ *                      taken from the table itself (FindAxisParameter()):
+ *                      - numbers not in the table: REPLY_WRONG_TYPE
+ *                      - access bits: SAP, GAP and STAP/RSAP only if
+ *                        PB_WRITE, PB_READ and PB_STORE are set
+ *                      - range: Min-1 and Max+1 are rejected, all values
+ *                        of small ranges and 0 and 100 are accepted
+ *                      - shift/width: a SAP changes only the bits of its
+ *                        field in the register of the simulated driver
+ *                      - no truncation: every value written to a driver
+ *                        register is kept by it (the model keeps only the
+ *                        bits of the data sheet, see SimRegisterWriteMask())
+ *                        and rejected values do not write anything
+ *                      - conversion round trip: GAP after SAP returns
+ *                        the written value within the resolution of the
+ *                        conversion, and writing it back changes nothing
+ *                      - read only register fields: GAP returns the bits
+ *                        of the driver register
+ *                      - STAP/RSAP restore the stored value
+ *
+ *                      It also reports the host time of the table lookup
+ *                      (FindAxisParameter()).
+ *
+ *                      Build and run (from this directory):
+ *                      make test (AxisParameterTest3)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "max32660.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "TMC5130.h"
+#include "TMCL.h"
+#include "AxisParameters.h"
+#include "SimTMC5130.h"
+#include "SimFirmware.h"
+
+#define LOG_SIZE     4096
+#define TEST_MOTOR   (N_O_MOTORS-1)   //!< axis used for the write tests
+#define THIGH_CLOCK  13000000         //!< CONV_THIGH: pps * THIGH
+#define TSTEP_CLOCK  12500000         //!< CONV_TSTEP: pps * TCOOLTHRS/TPWMTHRS
+#define LOOKUPS      1000000          //!< table lookups for the time measurement
+
+static TSimDatagram Log[LOG_SIZE];
+static uint32_t Failures;
+static uint32_t Checks;
+static uint32_t ValuesTested;
+static uint32_t ValuesRejected;
+
+#define CHECK(Condition, ...) do { Checks++; if(!(Condition)) { Failures++; printf("  FAILED: " __VA_ARGS__); printf("\n"); } } while(0)
+
+//! Values tried for parameters with a large range
+static const int TypicalValues[]=
+{
+  0, 1, 2, 3, 7, 8, 15, 100, 255, 256, 1000, 4095, 51200, 65535, 100000, 262143,
+  1000000, 8388607, 10000000, INT32_MAX, -1, -100, -51200, -1000000, INT32_MIN
+};
+
+
+/***************************************************************//**
+   \fn IsOK(uint8_t Status)
+   \return TRUE if the TMCL status means success
+********************************************************************/
+static int IsOK(uint8_t Status)
+{
+  return Status==REPLY_OK || Status==REPLY_OK_EVENT;
+}
+
+
+/***************************************************************//**
+   \fn FieldMask(const TAxisParameter *Parameter)
+   \return Bits of the register that belong to the parameter
+********************************************************************/
+static uint32_t FieldMask(const TAxisParameter *Parameter)
+{
+  if(Parameter->Width>=32) return 0xffffffff;
+
+  return ((1u<<Parameter->Width)-1) << Parameter->Shift;
+}
+
+
+/***************************************************************//**
+   \fn SetParameter(const TAxisParameter *Parameter, int Value)
+   \brief SAP on the test axis
+   \return TMCL status
+
+   Logs the datagrams of the command and checks that every register
+   written keeps the value sent (no truncation by the driver) and
+   that a rejected value does not write anything.
+********************************************************************/
+static uint8_t SetParameter(const TAxisParameter *Parameter, int Value)
+{
+  uint8_t Written[128];
+  int LastValue[128];
+  uint8_t Status;
+  uint32_t Count;
+  uint32_t Address;
+  uint32_t i;
+
+  SimSetDatagramLog(Log, LOG_SIZE);
+  Status=SimCommand(TMCL_SAP, Parameter->Number, TEST_MOTOR, Value, NULL);
+  SimRunLoop(10);   //posted writes
+  Count=SimGetDatagramCount();
+  SimSetDatagramLog(NULL, 0);
+
+  for(Address=0; Address<128; Address++) Written[Address]=FALSE;
+  for(i=0; i<Count && i<LOG_SIZE; i++)
+  {
+    if(!Log[i].Write || Log[i].Which5130!=WHICH_5130(TEST_MOTOR)) continue;
+
+    Written[Log[i].Address]=TRUE;
+    LastValue[Log[i].Address]=Log[i].Value;
+  }
+
+  for(Address=0; Address<128; Address++)
+  {
+    if(!Written[Address]) continue;
+
+    CHECK(IsOK(Status), "AP %u = %d rejected, but register 0x%02x written", Parameter->Number, Value, Address);
+
+    //Registers changed by the driver itself or with event flags are not compared
+    if(Address==TMC5130_XACTUAL || (SimRegisterAccess(Address) & SIM_ACC_WC)) continue;
+
+    CHECK(SimGetRegister(WHICH_5130(TEST_MOTOR), Address)==LastValue[Address],
+          "AP %u = %d: register 0x%02x written with 0x%08x, driver keeps 0x%08x",
+          Parameter->Number, Value, Address, LastValue[Address], SimGetRegister(WHICH_5130(TEST_MOTOR), Address));
+  }
+
+  return Status;
+}
+
+
+/***************************************************************//**
+   \fn ExpectedThreshold(int Clock, int Value, int Read)
+   \brief Round trip of a velocity threshold (Clock / velocity)
+   \return TRUE if Read gives the same register value as Value
+********************************************************************/
+static int ExpectedThreshold(int Clock, int Value, int Read)
+{
+  if(Value==0) return Read==0;                //off
+  if(Value>Clock) return Read==16777215;      //register value 0
+
+  return Read>=Value && Clock/Read==Clock/Value;
+}
+
+
+/***************************************************************//**
+   \fn ExpectedUserValue(const TAxisParameter *Parameter, int Value, int Read)
+   \brief Check the result of a conversion round trip
+   \param Value: value written
+   \param Read: value read back
+   \return TRUE if Read is within the resolution of the conversion
+********************************************************************/
+static int ExpectedUserValue(const TAxisParameter *Parameter, int Value, int Read)
+{
+  int64_t Difference;
+
+  Difference=(int64_t) Read-(int64_t) Value;
+  switch(Parameter->Conversion)
+  {
+    case CONV_NONE:
+    case CONV_SIGNED8:
+    case CONV_MRES:
+      return Read==Value;
+
+    case CONV_BOOL:
+    case CONV_BOOL_INV:
+      return Read==(Value!=0);
+
+    case CONV_CURRENT:
+      return Read==(Value & 0xf8);
+
+    case CONV_VELOCITY:
+      return llabs(Difference)<=1;
+
+    case CONV_ACCELERATION:
+      return Difference>=-72 && Difference<=1;
+
+    case CONV_THIGH:
+      return ExpectedThreshold(THIGH_CLOCK, Value, Read);
+
+    case CONV_TSTEP:
+      return ExpectedThreshold(TSTEP_CLOCK, Value, Read);
+
+    case CONV_TPOWERDOWN:
+      return Difference<=0 && Difference>= -(int64_t) TPOWERDOWN_FACTOR-1;
+
+    default:
+      return FALSE;
+  }
+}
+
+
+/***************************************************************//**
+   \fn TestValue(const TAxisParameter *Parameter, int Value, int MustAccept)
+   \brief SAP of one value, then check register and read back
+********************************************************************/
+static void TestValue(const TAxisParameter *Parameter, int Value, int MustAccept)
+{
+  uint32_t Before, After;
+  uint8_t Status;
+  int Read;
+  int Again;
+
+  Before=(Parameter->Register!=AP_NO_REGISTER) ? SimGetRegister(WHICH_5130(TEST_MOTOR), Parameter->Register) : 0;
+  Status=SetParameter(Parameter, Value);
+  ValuesTested++;
+  if(!IsOK(Status))
+  {
+    ValuesRejected++;
+    CHECK(!MustAccept, "AP %u = %d rejected (%u)", Parameter->Number, Value, Status);
+    CHECK(Status==REPLY_INVALID_VALUE, "AP %u = %d: status %u", Parameter->Number, Value, Status);
+    return;
+  }
+
+  //Only the bits of the field may change
+  if(Parameter->Register!=AP_NO_REGISTER && Parameter->SetHook==NULL)
+  {
+    After=SimGetRegister(WHICH_5130(TEST_MOTOR), Parameter->Register);
+    CHECK(((Before ^ After) & ~FieldMask(Parameter))==0, "AP %u = %d: register 0x%02x 0x%08x => 0x%08x outside the field",
+          Parameter->Number, Value, Parameter->Register, Before, After);
+  }
+
+  if(!(Parameter->Access & PB_READ)) return;
+
+  //Round trip
+  CHECK(IsOK(SimCommand(TMCL_GAP, Parameter->Number, TEST_MOTOR, 0, &Read)), "GAP %u", Parameter->Number);
+  if(Parameter->GetHook==NULL)
+    CHECK(ExpectedUserValue(Parameter, Value, Read), "AP %u = %d read back as %d", Parameter->Number, Value, Read);
+
+  //Writing the value read back must not change it
+  CHECK(IsOK(SetParameter(Parameter, Read)), "AP %u = %d (value read back) rejected", Parameter->Number, Read);
+  CHECK(IsOK(SimCommand(TMCL_GAP, Parameter->Number, TEST_MOTOR, 0, &Again)), "GAP %u", Parameter->Number);
+  CHECK(Again==Read, "AP %u: %d written back, %d read", Parameter->Number, Read, Again);
+}
+
+
+/***************************************************************//**
+   \fn TestAccess(uint8_t Number)
+   \brief Access bits and unknown parameter numbers
+********************************************************************/
+static void TestAccess(uint8_t Number)
+{
+  const TAxisParameter *Parameter;
+  uint8_t Status;
+
+  Parameter=FindAxisParameter(Number);
+  if(Parameter==NULL)
+  {
+    CHECK(SimCommand(TMCL_SAP, Number, 0, 0, NULL)==REPLY_WRONG_TYPE, "SAP %u: unknown parameter accepted", Number);
+    CHECK(SimCommand(TMCL_GAP, Number, 0, 0, NULL)==REPLY_WRONG_TYPE, "GAP %u: unknown parameter accepted", Number);
+    CHECK(SimCommand(TMCL_STAP, Number, 0, 0, NULL)==REPLY_WRONG_TYPE, "STAP %u: unknown parameter accepted", Number);
+    CHECK(SimCommand(TMCL_RSAP, Number, 0, 0, NULL)==REPLY_WRONG_TYPE, "RSAP %u: unknown parameter accepted", Number);
+    return;
+  }
+
+  CHECK(Parameter->Number==Number, "FindAxisParameter(%u) returns parameter %u", Number, Parameter->Number);
+  CHECK(Parameter->Access & PB_READ, "AP %u cannot be read", Number);
+  CHECK(Parameter->Width>0 || Parameter->Register==AP_NO_REGISTER, "AP %u: width 0", Number);
+  CHECK(Parameter->Shift+Parameter->Width<=32, "AP %u: field beyond bit 31", Number);
+  CHECK(Parameter->Min<=Parameter->Max, "AP %u: empty range", Number);
+  CHECK(!(Parameter->Access & PB_STORE) || (Parameter->Access & PB_WRITE), "AP %u can be stored but not written", Number);
+
+  if(Parameter->Register==AP_NO_REGISTER)
+  {
+    CHECK(Parameter->GetHook!=NULL, "AP %u: no register and no get hook", Number);
+    CHECK(!(Parameter->Access & PB_WRITE) || Parameter->SetHook!=NULL, "AP %u: no register and no set hook", Number);
+  }
+  else
+  {
+    CHECK(SimRegisterAccess(Parameter->Register)!=0, "AP %u: register 0x%02x does not exist", Number, Parameter->Register);
+    CHECK(!(Parameter->Access & PB_WRITE) || Parameter->SetHook!=NULL || (SimRegisterAccess(Parameter->Register) & SIM_ACC_W),
+          "AP %u: register 0x%02x cannot be written", Number, Parameter->Register);
+    CHECK(FieldMask(Parameter) & SimRegisterWriteMask(Parameter->Register) || !(SimRegisterAccess(Parameter->Register) & SIM_ACC_W),
+          "AP %u: field not in register 0x%02x", Number, Parameter->Register);
+  }
+
+  CHECK(IsOK(SimCommand(TMCL_GAP, Number, 0, 0, NULL)), "GAP %u", Number);
+  CHECK(SimCommand(TMCL_GAP, Number, N_O_MOTORS, 0, NULL)==REPLY_INVALID_VALUE, "GAP %u: motor %u accepted", Number, N_O_MOTORS);
+  if(!(Parameter->Access & PB_WRITE))
+    CHECK(SimCommand(TMCL_SAP, Number, 0, 0, NULL)==REPLY_WRONG_TYPE, "SAP %u: read only parameter written", Number);
+  else
+    CHECK(SimCommand(TMCL_SAP, Number, N_O_MOTORS, 0, NULL)==REPLY_INVALID_VALUE, "SAP %u: motor %u accepted", Number, N_O_MOTORS);
+  if(!(Parameter->Access & PB_STORE))
+  {
+    Status=SimCommand(TMCL_STAP, Number, 0, 0, NULL);
+    CHECK(Status==REPLY_WRONG_TYPE, "STAP %u: status %u", Number, Status);
+    Status=SimCommand(TMCL_RSAP, Number, 0, 0, NULL);
+    CHECK(Status==REPLY_WRONG_TYPE, "RSAP %u: status %u", Number, Status);
+  }
+}
+
+
+/***************************************************************//**
+   \fn TestWrite(const TAxisParameter *Parameter)
+   \brief Range, field and conversion of a writable parameter
+********************************************************************/
+static void TestWrite(const TAxisParameter *Parameter)
+{
+  int64_t Value;
+  uint32_t i;
+
+  //Range limits
+  if(Parameter->Min>INT32_MIN)
+    CHECK(SetParameter(Parameter, Parameter->Min-1)==REPLY_INVALID_VALUE, "AP %u = %d (below the range) accepted",
+          Parameter->Number, Parameter->Min-1);
+  if(Parameter->Max<INT32_MAX)
+    CHECK(SetParameter(Parameter, Parameter->Max+1)==REPLY_INVALID_VALUE, "AP %u = %d (above the range) accepted",
+          Parameter->Number, Parameter->Max+1);
+
+  if((int64_t) Parameter->Max-Parameter->Min<=1024)
+  {
+    //Small range: all values, all of them have to fit into the register
+    for(Value=Parameter->Min; Value<=Parameter->Max; Value++)
+      TestValue(Parameter, Value, TRUE);
+  }
+  else
+  {
+    TestValue(Parameter, Parameter->Min, FALSE);
+    TestValue(Parameter, Parameter->Max, FALSE);
+    for(i=0; i<sizeof(TypicalValues)/sizeof(TypicalValues[0]); i++)
+    {
+      if(TypicalValues[i]>=Parameter->Min && TypicalValues[i]<=Parameter->Max)
+        TestValue(Parameter, TypicalValues[i], TypicalValues[i]==0 || TypicalValues[i]==100);
+    }
+  }
+}
+
+
+/***************************************************************//**
+   \fn TestReadOnly(const TAxisParameter *Parameter)
+   \brief Read only register field: GAP returns the driver bits
+********************************************************************/
+static void TestReadOnly(const TAxisParameter *Parameter)
+{
+  uint32_t Register;
+  int Value;
+
+  if(Parameter->Register==AP_NO_REGISTER || Parameter->GetHook!=NULL || Parameter->Conversion!=CONV_NONE) return;
+
+  CHECK(IsOK(SimCommand(TMCL_GAP, Parameter->Number, TEST_MOTOR, 0, &Value)), "GAP %u", Parameter->Number);
+  Register=SimGetRegister(WHICH_5130(TEST_MOTOR), Parameter->Register);
+  CHECK((uint32_t) Value==(Register & FieldMask(Parameter)) >> Parameter->Shift, "AP %u = %d, register 0x%02x = 0x%08x",
+        Parameter->Number, Value, Parameter->Register, Register);
+}
+
+
+/***************************************************************//**
+   \fn TestStore(const TAxisParameter *Parameter)
+   \brief STAP, change, RSAP
+********************************************************************/
+static void TestStore(const TAxisParameter *Parameter)
+{
+  int Stored;
+  int Value;
+
+  CHECK(IsOK(SimCommand(TMCL_GAP, Parameter->Number, TEST_MOTOR, 0, &Value)), "GAP %u", Parameter->Number);
+  CHECK(IsOK(SimCommand(TMCL_STAP, Parameter->Number, TEST_MOTOR, 0, &Stored)), "STAP %u", Parameter->Number);
+  CHECK(Stored==Value, "STAP %u stored %d instead of %d", Parameter->Number, Stored, Value);
+
+  CHECK(IsOK(SetParameter(Parameter, 0)), "AP %u = 0", Parameter->Number);
+  CHECK(IsOK(SimCommand(TMCL_RSAP, Parameter->Number, TEST_MOTOR, 0, NULL)), "RSAP %u", Parameter->Number);
+  CHECK(IsOK(SimCommand(TMCL_GAP, Parameter->Number, TEST_MOTOR, 0, &Value)), "GAP %u", Parameter->Number);
+  CHECK(Value==Stored, "AP %u restored as %d instead of %d", Parameter->Number, Value, Stored);
+}
+
+
+/***************************************************************//**
+   \fn MeasureLookup(uint32_t *Count)
+   \brief Host time of FindAxisParameter()
+   \param Count: number of parameters in the table
+   \return Nanoseconds per lookup (average over all numbers 0..255)
+********************************************************************/
+static double MeasureLookup(uint32_t *Count)
+{
+  struct timespec Start, End;
+  volatile uintptr_t Sum;
+  uint32_t i;
+
+  *Count=0;
+  for(i=0; i<256; i++)
+    if(FindAxisParameter(i)!=NULL) (*Count)++;
+
+  Sum=0;
+  clock_gettime(CLOCK_MONOTONIC, &Start);
+  for(i=0; i<LOOKUPS; i++) Sum+=(uintptr_t) FindAxisParameter(i & 0xff);
+  clock_gettime(CLOCK_MONOTONIC, &End);
+  (void) Sum;
+
+  return ((End.tv_sec-Start.tv_sec)*1e9+(End.tv_nsec-Start.tv_nsec))/LOOKUPS;
+}
+
+
+int main(void)
+{
+  const TAxisParameter *Parameter;
+  uint32_t Number;
+  uint32_t Count;
+  double LookupTime;
+
+  printf("Axis parameter test: %u axes, write tests on axis %u\n", N_O_MOTORS, TEST_MOTOR);
+  SimFirmwareStart();
+  SimRunLoop(100);
+
+  for(Number=0; Number<256; Number++) TestAccess(Number);
+
+  for(Number=0; Number<256; Number++)
+  {
+    Parameter=FindAxisParameter(Number);
+    if(Parameter==NULL) continue;
+
+    if(Parameter->Access & PB_WRITE)
+      TestWrite(Parameter);
+    else
+      TestReadOnly(Parameter);
+    if(Parameter->Access & PB_STORE) TestStore(Parameter);
+
+    //Stop the motion some parameters have started and switch the driver on again
+    SimCommand(TMCL_MST, 0, TEST_MOTOR, 0, NULL);
+    SimCommand(TMCL_SAP, 255, TEST_MOTOR, 1, NULL);
+    SimRunTime(10);
+  }
+
+  LookupTime=MeasureLookup(&Count);
+  printf("%u parameters, %u values written (%u rejected), lookup %.1f ns (host)\n",
+         Count, ValuesTested, ValuesRejected, LookupTime);
+  printf("%u checks, %u failed\n", Checks, Failures);
+
+  return Failures>0 ? 2 : 0;
+}
@@ -0,0 +1,234 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file ChainBenchmark.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: ChainBenchmark.c
+ *         Description: Benchmark of the firmware against the number of
+ *                      TMC5130 in the daisy chain
+ *
+ *                      Runs the whole firmware (see SimFirmware.c) for one
+ *                      value of N_O_MOTORS and measures:
+ *                      - the initialisation burst (InitMotorDrivers() and
+ *                        InitTMCL()): frames and posted write datagrams
+ *                      - MVP COORD with all axes (MVP_MULTI_AXIS): the
+ *                        deferred writes of all drivers have to go out
+ *                        in shared frames (FlushAllTMC5130Writes() and
+ *                        PrepareAsyncFrame()), XTARGET always in an
+ *                        earlier frame than RAMPMODE of the same driver,
+ *                        and all axes have to reach their targets
+ *                      - one second with all axes rotating: main loop
+ *                        passes, per axis service rate (ProcessStallGuard()
+ *                        handles one axis per pass), SPI frames and the
+ *                        busy time of the SPI bus
+ *
+ *                      The results depend on the timing assumptions of
+ *                      SimTMC5130.c (SPI clock, interrupt and polling
+ *                      cost) and SIM_LOOP_CYCLES, so they show trends
+ *                      rather than exact target numbers.
+ *
+ *                      Build and run (from this directory):
+ *                      make benchmark (ChainBenchmark1 .. ChainBenchmark7)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "max32660.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "TMC5130.h"
+#include "TMCL.h"
+#include "SimTMC5130.h"
+#include "SimFirmware.h"
+
+#define LOG_SIZE 100000
+
+static TSimDatagram Log[LOG_SIZE];
+static uint32_t Failures;
+static uint32_t Checks;
+
+#define CHECK(Condition, ...) do { Checks++; if(!(Condition)) { Failures++; printf("  FAILED: " __VA_ARGS__); printf("\n"); } } while(0)
+
+
+/***************************************************************//**
+   \fn CountWriteFrames(uint32_t First, uint32_t Last, uint32_t *Writes)
+   \brief Count the frames containing write datagrams in the log
+   \param First, Last: range of log entries
+   \param Writes: number of write datagrams
+   \return Number of different frames with write datagrams
+********************************************************************/
+static uint32_t CountWriteFrames(uint32_t First, uint32_t Last, uint32_t *Writes)
+{
+  uint32_t Frames;
+  uint32_t LastFrame;
+  uint32_t i;
+
+  Frames=0;
+  LastFrame=UINT32_MAX;
+  *Writes=0;
+  for(i=First; i<Last; i++)
+  {
+    if(!Log[i].Write) continue;
+
+    (*Writes)++;
+    if(Log[i].Frame!=LastFrame) Frames++;
+    LastFrame=Log[i].Frame;
+  }
+
+  return Frames;
+}
+
+
+/***************************************************************//**
+   \fn BenchmarkInit(void)
+   \brief Start of the firmware: initialisation burst
+********************************************************************/
+static void BenchmarkInit(uint32_t *InitFrames)
+{
+  uint32_t Writes;
+
+  SimSetDatagramLog(Log, LOG_SIZE);
+  SimFirmwareStart();
+  SimRunLoop(100);   //posted writes still queued
+
+  *InitFrames=CountWriteFrames(0, SimGetDatagramCount(), &Writes);
+  printf("initialisation: %u write datagrams in %u frames (%u frames in total, %.2f ms)\n",
+         Writes, *InitFrames, SimSPIStatistics.Frames, (double) SimCycles/SIM_CYCLES_PER_MS);
+}
+
+
+/***************************************************************//**
+   \fn BenchmarkMultiAxisMove(void)
+   \brief MVP COORD with all axes: frames and order of the writes
+********************************************************************/
+static void BenchmarkMultiAxisMove(uint32_t *MoveFrames)
+{
+  uint32_t Axis;
+  uint32_t Count;
+  uint32_t Writes;
+  uint32_t i;
+  uint32_t XTargetFrame[N_O_MOTORS];
+  uint32_t RampModeFrame[N_O_MOTORS];
+  uint32_t Time;
+  int Reached;
+  int Target;
+
+  //Coordinate 1 of every axis, all axes rotating
+  for(Axis=0; Axis<N_O_MOTORS; Axis++)
+  {
+    CHECK(SimCommand(TMCL_SCO, 1, Axis, 20000+5000*Axis, NULL)==REPLY_OK, "SCO axis %u", Axis);
+    CHECK(SimCommand(TMCL_ROR, 0, Axis, 20000, NULL)==REPLY_OK, "ROR axis %u", Axis);
+  }
+  SimRunTime(10);
+
+  //Move all axes to coordinate 1
+  SimSetDatagramLog(Log, LOG_SIZE);
+  CHECK(SimCommand(TMCL_MVP, MVP_COORD, MVP_MULTI_AXIS|((1<<N_O_MOTORS)-1), 1, NULL)==REPLY_OK, "MVP COORD");
+  SimRunLoop(10);
+  Count=SimGetDatagramCount();
+  CHECK(Count<LOG_SIZE, "datagram log full");
+
+  for(Axis=0; Axis<N_O_MOTORS; Axis++)
+  {
+    XTargetFrame[Axis]=UINT32_MAX;
+    RampModeFrame[Axis]=UINT32_MAX;
+  }
+  for(i=0; i<Count; i++)
+  {
+    if(!Log[i].Write || Log[i].Which5130>=N_O_MOTORS) continue;
+
+    if(Log[i].Address==TMC5130_XTARGET && XTargetFrame[Log[i].Which5130]==UINT32_MAX)
+      XTargetFrame[Log[i].Which5130]=Log[i].Frame;
+    if(Log[i].Address==TMC5130_RAMPMODE && RampModeFrame[Log[i].Which5130]==UINT32_MAX)
+      RampModeFrame[Log[i].Which5130]=Log[i].Frame;
+  }
+  for(Axis=0; Axis<N_O_MOTORS; Axis++)
+  {
+    CHECK(XTargetFrame[Axis]!=UINT32_MAX && RampModeFrame[Axis]!=UINT32_MAX, "axis %u: XTARGET or RAMPMODE not written", Axis);
+    CHECK(XTargetFrame[Axis]<RampModeFrame[Axis], "axis %u: XTARGET in frame %u, RAMPMODE in frame %u",
+          Axis, XTargetFrame[Axis], RampModeFrame[Axis]);
+    CHECK(XTargetFrame[Axis]==XTargetFrame[0], "axis %u: XTARGET not in the frame of axis 0", Axis);
+    CHECK(RampModeFrame[Axis]==RampModeFrame[0], "axis %u: RAMPMODE not in the frame of axis 0", Axis);
+  }
+  *MoveFrames=CountWriteFrames(0, Count, &Writes);
+  printf("MVP COORD all axes: %u write datagrams in %u frames\n", Writes, *MoveFrames);
+
+  //All axes have to reach their targets
+  for(Time=0; Time<10000; Time+=10)
+  {
+    SimRunTime(10);
+    for(Axis=0; Axis<N_O_MOTORS; Axis++)
+    {
+      SimCommand(TMCL_GAP, 8, Axis, 0, &Reached);
+      if(!Reached) break;
+    }
+    if(Axis==N_O_MOTORS) break;
+  }
+  for(Axis=0; Axis<N_O_MOTORS; Axis++)
+  {
+    Target=20000+5000*Axis;
+    CHECK(SimGetRegister(WHICH_5130(Axis), TMC5130_XACTUAL)==Target, "axis %u at %d instead of %d",
+          Axis, SimGetRegister(WHICH_5130(Axis), TMC5130_XACTUAL), Target);
+  }
+}
+
+
+/***************************************************************//**
+   \fn BenchmarkServiceRate(void)
+   \brief One second with all axes rotating
+********************************************************************/
+static void BenchmarkServiceRate(double *PassRate, double *BusLoad)
+{
+  uint32_t Axis;
+  uint32_t Passes;
+  uint64_t Cycles;
+  TSimSPIStatistics Start;
+
+  for(Axis=0; Axis<N_O_MOTORS; Axis++)
+    CHECK(SimCommand(TMCL_ROR, 0, Axis, 10000+1000*Axis, NULL)==REPLY_OK, "ROR axis %u", Axis);
+
+  SimSetDatagramLog(NULL, 0);
+  SimRunTime(100);
+  Passes=SimGetLoopCount();
+  Cycles=SimCycles;
+  Start=SimSPIStatistics;
+  SimRunTime(1000);
+  Passes=SimGetLoopCount()-Passes;
+  Cycles=SimCycles-Cycles;
+
+  *PassRate=(double) Passes*SIM_CPU_CLOCK/Cycles;
+  *BusLoad=100.0*(SimSPIStatistics.BusyCycles-Start.BusyCycles)/Cycles;
+  printf("all axes rotating: %.0f main loop passes/s, %.0f per axis, %.0f frames/s (%.0f reads, %.0f writes), SPI busy %.1f%%\n",
+         *PassRate, *PassRate/N_O_MOTORS,
+         (double) (SimSPIStatistics.Frames-Start.Frames)*SIM_CPU_CLOCK/Cycles,
+         (double) (SimSPIStatistics.Reads-Start.Reads)*SIM_CPU_CLOCK/Cycles,
+         (double) (SimSPIStatistics.Writes-Start.Writes)*SIM_CPU_CLOCK/Cycles,
+         *BusLoad);
+}
+
+
+int main(void)
+{
+  uint32_t InitFrames;
+  uint32_t MoveFrames;
+  double PassRate;
+  double BusLoad;
+
+  printf("Daisy chain benchmark: %u axes, SPI %u Hz\n", N_O_MOTORS, SimGetSPIClock());
+
+  BenchmarkInit(&InitFrames);
+  BenchmarkMultiAxisMove(&MoveFrames);
+  BenchmarkServiceRate(&PassRate, &BusLoad);
+
+  printf("summary: axes %u, init frames %u, MVP frames %u, passes/s %.0f, per axis %.0f, SPI busy %.1f%%\n",
+         N_O_MOTORS, InitFrames, MoveFrames, PassRate, PassRate/N_O_MOTORS, BusLoad);
+  printf("%u checks, %u failed\n", Checks, Failures);
+
+  return Failures>0 ? 2 : 0;
+}
@@ -0,0 +1,281 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file FixedPointTest.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: FixedPointTest.c
+ *         Description: Host test of the integer unit conversions
+ *
+ *                      Compares FixedDivide()/FixedMultiply() (../FixedPoint.c,
+ *                      unchanged) with the former double precision
+ *                      calculations (floor()/ceil() of the double result,
+ *                      conversion to int saturated like the Cortex-M4 does)
+ *                      for every int32 input, for all conversions used by
+ *                      the firmware: velocity and acceleration (internal
+ *                      clock and TMC5130_FCLK=16MHz) and TPOWERDOWN.
+ *
+ *                      Then the time per call of both implementations is
+ *                      measured (time stamp counter of the host, so only
+ *                      the ratio is meaningful: the host has a double
+ *                      precision FPU, the Cortex-M4 uses soft-float).
+ *
+ *                      Build and run (from this directory): make test
+ *                      (every 1009th value), ./FixedPointTest (all values)
+ *                      Options: -s <step>  test every step-th value only
+ *                               -b         benchmark only
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <x86intrin.h>
+#include "max32660.h"
+#include "TMC5130.h"
+#include "FixedPoint.h"
+
+#define VEL_FACTOR 0.7451                 //same constants as in ../TMC5130.c
+#define ACC_FACTOR 71.054274
+#define FCLK_16MHZ 16000000.0
+#define VEL_FACTOR_16MHZ (FCLK_16MHZ/16777216.0)
+#define ACC_FACTOR_16MHZ (FCLK_16MHZ*FCLK_16MHZ/(512.0*256.0)/16777216.0)
+
+#define MAX_REPORTED_ERRORS 5
+#define BENCHMARK_VALUES (1<<20)
+#define BENCHMARK_ROUNDS 8
+
+//Former calculation of a conversion
+#define CONV_DIV_TRUNC        0   //!< floor(v/f) for v>=0, ceil(v/f) for v<0 (velocity to internal)
+#define CONV_DIV_FLOOR        1   //!< floor(v/f) (acceleration and TPOWERDOWN to internal)
+#define CONV_MUL_AWAY         2   //!< ceil(v*f) for v>=0, floor(v*f) for v<0 (velocity to user)
+#define CONV_MUL_CEIL_FLOAT   3   //!< ceil((float) v*f) (acceleration to user)
+#define CONV_MUL_CEIL         4   //!< ceil(v*f) (TPOWERDOWN to user)
+
+//! One conversion of the firmware
+typedef struct
+{
+  const char *Name;
+  uint8_t Type;          //!< CONV_xxx
+  double Factor;
+  TFixedFactor Fixed;    //!< as defined in the firmware
+} TConversionTest;
+
+static const TConversionTest Conversions[]=
+{
+  {"velocity to internal",          CONV_DIV_TRUNC,      VEL_FACTOR,        FIXED_FACTOR(VEL_FACTOR, 53)},
+  {"acceleration to internal",      CONV_DIV_FLOOR,      ACC_FACTOR,        FIXED_FACTOR(ACC_FACTOR, 54)},
+  {"velocity to user",              CONV_MUL_AWAY,       VEL_FACTOR,        FIXED_FACTOR(VEL_FACTOR, 53)},
+  {"acceleration to user",          CONV_MUL_CEIL_FLOAT, ACC_FACTOR,        FIXED_FACTOR(ACC_FACTOR, 54)},
+  {"velocity to internal 16MHz",    CONV_DIV_TRUNC,      VEL_FACTOR_16MHZ,  FIXED_FACTOR(VEL_FACTOR_16MHZ, 53)},
+  {"acceleration to internal 16MHz",CONV_DIV_FLOOR,      ACC_FACTOR_16MHZ,  FIXED_FACTOR(ACC_FACTOR_16MHZ, 54)},
+  {"velocity to user 16MHz",        CONV_MUL_AWAY,       VEL_FACTOR_16MHZ,  FIXED_FACTOR(VEL_FACTOR_16MHZ, 53)},
+  {"acceleration to user 16MHz",    CONV_MUL_CEIL_FLOAT, ACC_FACTOR_16MHZ,  FIXED_FACTOR(ACC_FACTOR_16MHZ, 54)},
+  {"TPOWERDOWN to internal",        CONV_DIV_FLOOR,      TPOWERDOWN_FACTOR, FIXED_FACTOR(TPOWERDOWN_FACTOR, 53)},
+  {"TPOWERDOWN to user",            CONV_MUL_CEIL,       TPOWERDOWN_FACTOR, FIXED_FACTOR(TPOWERDOWN_FACTOR, 53)}
+};
+
+#define N_O_CONVERSIONS (sizeof(Conversions)/sizeof(Conversions[0]))
+
+
+/***************************************************************//**
+   \fn SaturateToInt(double Value)
+   \brief Conversion double => int like on the Cortex-M4
+   \return Value truncated and saturated to the int range
+
+   The firmware relied on the saturation of __aeabi_d2iz(), which
+   the x86 conversion does not do (it returns INT32_MIN).
+********************************************************************/
+static int SaturateToInt(double Value)
+{
+  if(Value>=2147483647.0) return INT32_MAX;
+  if(Value<=-2147483648.0) return INT32_MIN;
+
+  return (int) Value;
+}
+
+
+/***************************************************************//**
+   \fn ReferenceConversion(const TConversionTest *Conversion, int Value)
+   \brief Former double precision calculation
+********************************************************************/
+static int ReferenceConversion(const TConversionTest *Conversion, int Value)
+{
+  switch(Conversion->Type)
+  {
+    case CONV_DIV_TRUNC:
+      if(Value>=0)
+        return SaturateToInt(floor((double) Value/Conversion->Factor));
+      else
+        return SaturateToInt(ceil((double) Value/Conversion->Factor));
+
+    case CONV_DIV_FLOOR:
+      return SaturateToInt(floor((double) Value/Conversion->Factor));
+
+    case CONV_MUL_AWAY:
+      if(Value>=0)
+        return SaturateToInt(ceil((double) Value*Conversion->Factor));
+      else
+        return SaturateToInt(floor((double) Value*Conversion->Factor));
+
+    case CONV_MUL_CEIL_FLOAT:
+      return SaturateToInt(ceil((float) Value*Conversion->Factor));
+
+    default:
+      return SaturateToInt(ceil((double) Value*Conversion->Factor));
+  }
+}
+
+
+/***************************************************************//**
+   \fn FixedConversion(const TConversionTest *Conversion, int Value)
+   \brief Integer calculation as done by the firmware
+********************************************************************/
+static int FixedConversion(const TConversionTest *Conversion, int Value)
+{
+  switch(Conversion->Type)
+  {
+    case CONV_DIV_TRUNC:
+      return FixedDivide(Value, &Conversion->Fixed, FX_TRUNC);
+
+    case CONV_DIV_FLOOR:
+      return FixedDivide(Value, &Conversion->Fixed, FX_FLOOR);
+
+    case CONV_MUL_AWAY:
+      return FixedMultiply(Value, &Conversion->Fixed, FX_AWAY);
+
+    case CONV_MUL_CEIL_FLOAT:
+      return FixedMultiply(Value, &Conversion->Fixed, FX_CEIL|FX_FLOAT_INPUT);
+
+    default:
+      return FixedMultiply(Value, &Conversion->Fixed, FX_CEIL);
+  }
+}
+
+
+/***************************************************************//**
+   \fn TestConversion(const TConversionTest *Conversion, uint32_t Step)
+   \brief Compare both calculations over the int32 range
+   \return Number of differences
+********************************************************************/
+static uint64_t TestConversion(const TConversionTest *Conversion, uint32_t Step)
+{
+  int64_t Value;
+  uint64_t Errors;
+  uint64_t Tested;
+  int Expected;
+  int Result;
+
+  Errors=0;
+  Tested=0;
+  for(Value=INT32_MIN; Value<=INT32_MAX; Value+=Step)
+  {
+    Expected=ReferenceConversion(Conversion, Value);
+    Result=FixedConversion(Conversion, Value);
+    Tested++;
+    if(Result!=Expected)
+    {
+      if(Errors<MAX_REPORTED_ERRORS)
+        printf("  %s(%d): %d, expected %d\n", Conversion->Name, (int) Value, Result, Expected);
+      Errors++;
+    }
+  }
+
+  printf("%-32s %10llu values, %llu differences\n", Conversion->Name,
+         (unsigned long long) Tested, (unsigned long long) Errors);
+
+  return Errors;
+}
+
+
+/***************************************************************//**
+   \fn BenchmarkConversion(const TConversionTest *Conversion, const int *Values)
+   \brief Measure the time per call of both calculations
+********************************************************************/
+static void BenchmarkConversion(const TConversionTest *Conversion, const int *Values)
+{
+  uint64_t Start;
+  uint64_t FixedCycles, ReferenceCycles;
+  volatile int Sink;
+  int Sum;
+  int Round;
+  int i;
+
+  FixedCycles=UINT64_MAX;
+  ReferenceCycles=UINT64_MAX;
+  for(Round=0; Round<BENCHMARK_ROUNDS; Round++)
+  {
+    Sum=0;
+    Start=__rdtsc();
+    for(i=0; i<BENCHMARK_VALUES; i++) Sum+=FixedConversion(Conversion, Values[i]);
+    Start=__rdtsc()-Start;
+    if(Start<FixedCycles) FixedCycles=Start;
+    Sink=Sum;
+
+    Sum=0;
+    Start=__rdtsc();
+    for(i=0; i<BENCHMARK_VALUES; i++) Sum+=ReferenceConversion(Conversion, Values[i]);
+    Start=__rdtsc()-Start;
+    if(Start<ReferenceCycles) ReferenceCycles=Start;
+    Sink=Sum;
+  }
+  (void) Sink;
+
+  printf("%-32s %6.1f %6.1f\n", Conversion->Name,
+         (double) FixedCycles/BENCHMARK_VALUES, (double) ReferenceCycles/BENCHMARK_VALUES);
+}
+
+
+int main(int argc, char *argv[])
+{
+  static int Values[BENCHMARK_VALUES];
+  uint32_t Step;
+  uint32_t Random;
+  uint64_t Errors;
+  int BenchmarkOnly;
+  size_t i;
+  int c;
+
+  Step=1;
+  BenchmarkOnly=0;
+  while((c=getopt(argc, argv, "s:b"))!= -1)
+  {
+    switch(c)
+    {
+      case 's': Step=strtoul(optarg, NULL, 0); break;
+      case 'b': BenchmarkOnly=1; break;
+      default:
+        fprintf(stderr, "usage: FixedPointTest [-s <step>] [-b]\n");
+        return 1;
+    }
+  }
+  if(Step==0) Step=1;
+  setvbuf(stdout, NULL, _IOLBF, 0);   //the exhaustive test takes a while
+
+  Errors=0;
+  if(!BenchmarkOnly)
+  {
+    printf("Comparison with the double precision calculation (step %u)\n", (unsigned) Step);
+    for(i=0; i<N_O_CONVERSIONS; i++) Errors+=TestConversion(&Conversions[i], Step);
+    printf("\n");
+  }
+
+  //Inputs spread over the whole range (magnitudes of all sizes)
+  Random=12345;
+  for(i=0; i<BENCHMARK_VALUES; i++)
+  {
+    Random=Random*1664525+1013904223;
+    Values[i]=(int) Random>>(Random & 0x1f);
+  }
+
+  printf("Time per call (host TSC cycles)  fixed double\n");
+  for(i=0; i<N_O_CONVERSIONS; i++) BenchmarkConversion(&Conversions[i], Values);
+
+  return Errors>0 ? 2 : 0;
+}
@@ -0,0 +1,512 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file PVTSim.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: PVTSim.c
+ *         Description: Host simulation of the PVT streaming mode
+ *
+ *                      Runs the PVT interpolator (../PVT.c, unchanged)
+ *                      against a model of the TMC5130 ramp generator
+ *                      (velocity mode: VMAX/AMAX, positioning mode:
+ *                      VMAX/AMAX/DMAX without A1/V1/D1) and reports the
+ *                      tracking error (XACTUAL against the trajectory
+ *                      defined by the points) for some test trajectories.
+ *
+ *                      The model uses pps and pps/s as internal units.
+ *                      TMR0 ticks every PVT_PERIOD_MS, ProcessPVT() is
+ *                      called every SIM_LOOP_US. TMC5130 writes take
+ *                      effect immediately (SPI latency is not modelled).
+ *
+ *                      A second part sweeps the segment duration and the
+ *                      buffer level kept by the master and reports the
+ *                      shortest duration (highest point rate) that runs
+ *                      without underrun. There the master wakes up every
+ *                      SIM_MASTER_PERIOD_MS and sends points until the
+ *                      buffer level is reached; each point costs two
+ *                      command/reply transactions (velocity and point)
+ *                      at SIM_BAUDRATE.
+ *
+ *                      Build and run (from this directory): make run
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "max32660.h"
+#include "tmr.h"
+#include "HomebusSlave.h"
+#include "Globals.h"
+#include "TMC5130.h"
+#include "PVT.h"
+
+#define SIM_STEP_US      10       //!< time step of the ramp generator model (µs)
+#define SIM_LOOP_US     500       //!< main loop period (µs)
+#define SIM_AMAX     200000       //!< AMAX of the axis (pps/s)
+#define SIM_DMAX     200000       //!< DMAX of the axis (pps/s)
+#define SIM_VMAX      50000       //!< VMAX of the axis (pps)
+#define SIM_SETTLE_MS   200       //!< time simulated after the end of the trajectory (ms)
+#define SIM_MAX_POINTS 2000       //!< maximum number of points of a test trajectory
+#define SIM_MASTER_PERIOD_MS 10   //!< wake-up period of the master in the sweep (ms)
+#define SIM_BAUDRATE     230400   //!< Homebus baud rate in the sweep (default of GP_BAUDRATE)
+
+//! Time needed by the master to send one point (SetPVTVelocity and PushPVTPoint, command and reply frame each, 10 bits per byte)
+#define SIM_POINT_US ((2*2*9*10*1000000L+SIM_BAUDRATE-1)/SIM_BAUDRATE)
+
+//! Test trajectory point (as sent by the master)
+typedef struct
+{
+  double Time;        //!< time of the point (s)
+  int Position;       //!< position (microsteps)
+  int Velocity;       //!< velocity (pps)
+} TSimPoint;
+
+uint32_t SystemCoreClock=96000000;
+
+void TMR0_IRQHandler(void);
+
+static double XActual;            //!< position of the model (microsteps)
+static double VActual;            //!< velocity of the model (pps)
+static int XTarget;
+static int RampMode;
+static uint32_t VMaxRegister;
+static uint32_t AMaxRegister;
+static uint32_t DMaxRegister;
+
+static TSimPoint Points[SIM_MAX_POINTS];
+static int PointCount;
+static int ReferenceIndex;        //!< segment used last by ReferencePosition()
+
+
+/* Stubs of the MAX32660 timer driver (TMR0 is simulated by the main loop) */
+int TMR_Init(mxc_tmr_regs_t *tmr, tmr_pres_t pres, const sys_cfg_tmr_t* sys_cfg)
+{
+  (void) tmr; (void) pres; (void) sys_cfg;
+  return 0;
+}
+
+int TMR_Config(mxc_tmr_regs_t *tmr, const tmr_cfg_t *cfg)
+{
+  (void) tmr; (void) cfg;
+  return 0;
+}
+
+void TMR_Enable(mxc_tmr_regs_t* tmr)
+{
+  (void) tmr;
+}
+
+void TMR_IntClear(mxc_tmr_regs_t* tmr)
+{
+  (void) tmr;
+}
+
+
+/* Model of the TMC5130 registers used by PVT.c */
+static void WriteRegister(uint8_t Address, int Value)
+{
+  switch(Address & 0x7f)
+  {
+    case TMC5130_RAMPMODE: RampMode=Value; break;
+    case TMC5130_XTARGET:  XTarget=Value; break;
+    case TMC5130_VMAX:     VMaxRegister=Value; break;
+    case TMC5130_AMAX:     AMaxRegister=Value; break;
+    case TMC5130_DMAX:     DMaxRegister=Value; break;
+  }
+}
+
+int ReadTMC5130Int(uint8_t Which5130, uint8_t Address)
+{
+  (void) Which5130;
+  return (Address==TMC5130_XACTUAL) ? (int) floor(XActual) : 0;
+}
+
+void WriteTMC5130Int(uint8_t Which5130, uint8_t Address, int Value)
+{
+  (void) Which5130;
+  WriteRegister(Address, Value);
+}
+
+void WriteTMC5130Datagram(uint8_t Which5130, uint8_t Address, uint8_t x1, uint8_t x2, uint8_t x3, uint8_t x4)
+{
+  (void) Which5130;
+  WriteRegister(Address, (x1<<24)|(x2<<16)|(x3<<8)|x4);
+}
+
+void PostTMC5130Write(uint8_t Which5130, uint8_t Address, int Value)
+{
+  (void) Which5130;
+  WriteRegister(Address, Value);
+}
+
+int ConvertVelocityUserToInternal(int UserVelocity)
+{
+  return UserVelocity;
+}
+
+int ConvertVelocityInternalToUser(int InternalVelocity)
+{
+  return InternalVelocity;
+}
+
+
+/***************************************************************//**
+   \fn StepRampGenerator(double dt)
+   \brief Advance the model of the ramp generator by one time step
+   \param dt: time step (s)
+********************************************************************/
+static void StepRampGenerator(double dt)
+{
+  double VTarget;
+  double Distance;
+  double Change;
+
+  if(RampMode==TMC5130_MODE_POSITION)
+  {
+    //Brake with DMAX when the stop distance reaches the target
+    Distance=XTarget-XActual;
+    if(fabs(Distance)<0.5 && fabs(VActual)<DMaxRegister*dt)
+    {
+      VActual=0;
+      XActual=XTarget;
+      return;
+    }
+    if(VActual*Distance>0 && VActual*VActual/(2.0*DMaxRegister)>=fabs(Distance))
+      VTarget=0;
+    else
+      VTarget=(Distance>0) ? (double) VMaxRegister : -(double) VMaxRegister;
+  }
+  else if(RampMode==TMC5130_MODE_VELPOS)
+  {
+    VTarget=VMaxRegister;
+  }
+  else if(RampMode==TMC5130_MODE_VELNEG)
+  {
+    VTarget= -(double) VMaxRegister;
+  }
+  else VTarget=0;
+
+  //AMAX when the speed rises, DMAX when it falls (positioning mode),
+  //AMAX for both in velocity mode
+  if(RampMode==TMC5130_MODE_POSITION && fabs(VTarget)<fabs(VActual) && VTarget*VActual>=0)
+    Change=DMaxRegister*dt;
+  else
+    Change=AMaxRegister*dt;
+
+  if(VTarget>VActual+Change) VActual+=Change;
+  else if(VTarget<VActual-Change) VActual-=Change;
+  else VActual=VTarget;
+
+  XActual+=VActual*dt;
+}
+
+
+/***************************************************************//**
+   \fn ReferencePosition(double Time)
+   \brief Position of the test trajectory
+   \param Time: time since the start (s)
+   \return Position (cubic Hermite spline through the points)
+
+   The time must not decrease between calls (except after resetting
+   ReferenceIndex to 1).
+********************************************************************/
+static double ReferencePosition(double Time)
+{
+  int i;
+  double T, S, P0, P1, V0, V1;
+
+  if(Time<=0) return Points[0].Position;
+
+  for(i=ReferenceIndex; i<PointCount; i++)
+  {
+    if(Time<=Points[i].Time)
+    {
+      T=Points[i].Time-Points[i-1].Time;
+      S=(Time-Points[i-1].Time)/T;
+      P0=Points[i-1].Position;
+      P1=Points[i].Position;
+      V0=Points[i-1].Velocity*T;
+      V1=Points[i].Velocity*T;
+      ReferenceIndex=i;
+      return (2*S*S*S-3*S*S+1)*P0+(S*S*S-2*S*S+S)*V0+(-2*S*S*S+3*S*S)*P1+(S*S*S-S*S)*V1;
+    }
+  }
+
+  return Points[PointCount-1].Position;
+}
+
+
+/***************************************************************//**
+   \fn SendPoint(int *NextPoint)
+   \brief Master: send the next point of the test trajectory
+   \param NextPoint: index of the point, incremented
+********************************************************************/
+static void SendPoint(int *NextPoint)
+{
+  SetPVTVelocity(0, Points[*NextPoint].Velocity);
+  PushPVTPoint(0, Points[*NextPoint].Position);
+  (*NextPoint)++;
+}
+
+
+/***************************************************************//**
+   \fn SimulateTrajectory(int DurationMs, int MasterLevel, double *MaxErrorTime)
+   \brief Run the points in Points[]
+   \param DurationMs: duration of each segment (ms)
+   \param MasterLevel: 0: the master keeps the buffer full without
+                       delay, otherwise: buffer level the master fills
+                       up to every SIM_MASTER_PERIOD_MS, sending one
+                       point per SIM_POINT_US
+   \param MaxErrorTime: time of the maximum tracking error (s)
+   \return Maximum tracking error (microsteps)
+********************************************************************/
+static double SimulateTrajectory(int DurationMs, int MasterLevel, double *MaxErrorTime)
+{
+  int NextPoint;
+  long Time;
+  long EndTime;
+  long PointTime;
+  int MasterAwake;
+  double Error;
+  double MaxError;
+
+  XActual=Points[0].Position;
+  VActual=0;
+  XTarget=Points[0].Position;
+  RampMode=TMC5130_MODE_POSITION;
+  VMaxRegister=0;
+  AMaxRegister=SIM_AMAX;
+  DMaxRegister=SIM_DMAX;
+  AMax[0]=SIM_AMAX;
+  VMax[0]=SIM_VMAX;
+  ReferenceIndex=1;
+
+  StopPVT(0);
+  SetPVTDuration(0, DurationMs);
+  NextPoint=1;
+  while(NextPoint<PointCount && GetPVTLevel(0)<(MasterLevel>0 ? (uint32_t) MasterLevel:PVT_BUFFER_SIZE))
+    SendPoint(&NextPoint);
+
+  //Start right after a timer tick
+  TMR0_IRQHandler();
+  ProcessPVT();
+  StartPVT(0);
+
+  MaxError=0;
+  *MaxErrorTime=0;
+  PointTime= -1;
+  MasterAwake=0;
+  EndTime=(long) (Points[PointCount-1].Time*1e6)+SIM_SETTLE_MS*1000L;
+  for(Time=SIM_STEP_US; Time<=EndTime; Time+=SIM_STEP_US)
+  {
+    StepRampGenerator(SIM_STEP_US*1e-6);
+
+    if(Time % (PVT_PERIOD_MS*1000)==0) TMR0_IRQHandler();
+    if(Time % SIM_LOOP_US==0)
+    {
+      ProcessPVT();
+
+      //Master: keep the buffer filled
+      if(MasterLevel==0)
+      {
+        while(NextPoint<PointCount && GetPVTLevel(0)<PVT_BUFFER_SIZE)
+          SendPoint(&NextPoint);
+      }
+    }
+
+    //Master in the sweep: a point is pushed when its frames have been sent
+    if(MasterLevel>0)
+    {
+      if(PointTime>=0 && Time>=PointTime)
+      {
+        SendPoint(&NextPoint);
+        PointTime= -1;
+      }
+      if(Time % (SIM_MASTER_PERIOD_MS*1000)==0) MasterAwake=1;
+      if(MasterAwake && PointTime<0)
+      {
+        if(NextPoint<PointCount && GetPVTLevel(0)<(uint32_t) MasterLevel)
+          PointTime=Time+SIM_POINT_US;
+        else
+          MasterAwake=0;
+      }
+    }
+
+    Error=fabs(XActual-ReferencePosition(Time*1e-6));
+    if(Error>MaxError)
+    {
+      MaxError=Error;
+      *MaxErrorTime=Time*1e-6;
+    }
+  }
+
+  return MaxError;
+}
+
+
+/***************************************************************//**
+   \fn RunTrajectory(const char *Name, int DurationMs)
+   \brief Run the points in Points[] and print the tracking error
+   \param Name: name of the test trajectory
+   \param DurationMs: duration of each segment (ms)
+   \return Maximum tracking error (microsteps)
+********************************************************************/
+static double RunTrajectory(const char *Name, int DurationMs)
+{
+  double MaxError;
+  double MaxErrorTime;
+
+  MaxError=SimulateTrajectory(DurationMs, 0, &MaxErrorTime);
+
+  printf("%-28s max. tracking error %7.1f usteps at %.3fs, final error %5.1f usteps, state %d, underruns %u, firmware max. error %u\n",
+         Name, MaxError, MaxErrorTime, XActual-Points[PointCount-1].Position,
+         GetPVTState(0), (unsigned) GetPVTUnderruns(0), (unsigned) GetPVTMaxError(0));
+
+  return MaxError;
+}
+
+
+/***************************************************************//**
+   \fn MakeTrapezoid(double VPeak, double Accel, double Cruise, int DurationMs)
+   \brief Points of a trapezoidal velocity profile
+********************************************************************/
+static void MakeTrapezoid(double VPeak, double Accel, double Cruise, int DurationMs)
+{
+  double TAcc, Total, t, p, v;
+  int i;
+
+  TAcc=VPeak/Accel;
+  Total=2*TAcc+Cruise;
+  for(i=0; i<SIM_MAX_POINTS; i++)
+  {
+    t=i*DurationMs/1000.0;
+    if(t>Total) t=Total;
+    if(t<TAcc)
+    {
+      v=Accel*t;
+      p=Accel*t*t/2;
+    }
+    else if(t<TAcc+Cruise)
+    {
+      v=VPeak;
+      p=VPeak*TAcc/2+VPeak*(t-TAcc);
+    }
+    else
+    {
+      v=VPeak-Accel*(t-TAcc-Cruise);
+      p=VPeak*TAcc/2+VPeak*Cruise+VPeak*(t-TAcc-Cruise)-Accel*(t-TAcc-Cruise)*(t-TAcc-Cruise)/2;
+    }
+    Points[i].Time=t;
+    Points[i].Position=(int) lround(p);
+    Points[i].Velocity=(int) lround(v);
+    PointCount=i+1;
+    if(t>=Total) break;
+  }
+}
+
+
+/***************************************************************//**
+   \fn MakeSine(double Amplitude, double Frequency, int Periods, int DurationMs)
+   \brief Points of the profile Amplitude*(1-cos(2*pi*f*t))
+********************************************************************/
+static void MakeSine(double Amplitude, double Frequency, int Periods, int DurationMs)
+{
+  double w, t, Total;
+  int i;
+
+  w=2*M_PI*Frequency;
+  Total=Periods/Frequency;
+  for(i=0; i<SIM_MAX_POINTS; i++)
+  {
+    t=i*DurationMs/1000.0;
+    if(t>Total) t=Total;
+    Points[i].Time=t;
+    Points[i].Position=(int) lround(Amplitude*(1-cos(w*t)));
+    Points[i].Velocity=(int) lround(Amplitude*w*sin(w*t));
+    PointCount=i+1;
+    if(t>=Total) break;
+  }
+}
+
+
+/***************************************************************//**
+   \fn SweepPointRate(void)
+   \brief Shortest segment duration without underrun per buffer level
+
+   Trapezoid 20kpps with 1s cruise for every combination of segment
+   duration and buffer level kept by the master. Prints the shortest
+   duration that does not underrun and the resulting point rate.
+********************************************************************/
+static void SweepPointRate(void)
+{
+  static const int Durations[]={1, 2, 3, 4, 5, 6, 8, 10, 12, 15, 20, 25, 30};
+  static const int Levels[]={1, 2, 4, 8, 16, 32};
+  double MaxErrorTime;
+  uint32_t Underruns;
+  int Lowest;
+  int i, j;
+
+  printf("\nsweep: master wakes up every %dms, %ldus per point (%d baud)\n",
+         SIM_MASTER_PERIOD_MS, (long) SIM_POINT_US, SIM_BAUDRATE);
+  printf("buffer level  shortest duration  point rate\n");
+  for(i=0; i<(int) (sizeof(Levels)/sizeof(Levels[0])); i++)
+  {
+    Lowest=0;
+    for(j=0; j<(int) (sizeof(Durations)/sizeof(Durations[0])); j++)
+    {
+      MakeTrapezoid(20000, 100000, 1.0, Durations[j]);
+      Underruns=GetPVTUnderruns(0);
+      SimulateTrajectory(Durations[j], Levels[i], &MaxErrorTime);
+      if(GetPVTUnderruns(0)==Underruns)
+      {
+        Lowest=Durations[j];
+        break;
+      }
+    }
+    if(Lowest>0)
+      printf("%12d  %15dms  %6.0f/s\n", Levels[i], Lowest, 1000.0/Lowest);
+    else
+      printf("%12d  %17s  %8s\n", Levels[i], "> 30ms", "-");
+  }
+}
+
+
+int main(void)
+{
+  double MaxError;
+  double Error;
+
+  MaxError=0;
+
+  MakeTrapezoid(10000, 50000, 0.5, 10);
+  Error=RunTrajectory("trapezoid 10kpps, 10ms", 10);
+  if(Error>MaxError) MaxError=Error;
+
+  MakeTrapezoid(40000, 150000, 0.3, 10);
+  Error=RunTrajectory("trapezoid 40kpps, 10ms", 10);
+  if(Error>MaxError) MaxError=Error;
+
+  MakeTrapezoid(10000, 50000, 0.5, 25);
+  Error=RunTrajectory("trapezoid 10kpps, 25ms", 25);
+  if(Error>MaxError) MaxError=Error;
+
+  MakeSine(2000, 1, 2, 10);
+  Error=RunTrajectory("sine 2000usteps 1Hz, 10ms", 10);
+  if(Error>MaxError) MaxError=Error;
+
+  MakeSine(300, 4, 3, 5);
+  Error=RunTrajectory("sine 300usteps 4Hz, 5ms", 5);
+  if(Error>MaxError) MaxError=Error;
+
+  printf("max. tracking error of all trajectories: %.1f usteps\n", MaxError);
+
+  SweepPointRate();
+
+  return 0;
+}
@@ -0,0 +1,544 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file ParamStoreTest.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: ParamStoreTest.c
+ *         Description: Test of the parameter store (../ParamStore.c)
+ *
+ *                      Runs the parameter store against the emulated
+ *                      flash (SimFlash.c) and compares the RAM mirror
+ *                      after every restart (InitParamStore()) with a
+ *                      reference model:
+ *                      - empty store, unchanged values, full store
+ *                      - write-heavy load: page changes, erase counting,
+ *                        wear levelling of the pages
+ *                      - power failure during every flash operation of
+ *                        a record write and of a page change (torn
+ *                        record, torn copy, torn header, torn erase)
+ *                      - power failure during ParamStoreClear()
+ *
+ *                      It reports the erase cycles per stored value and
+ *                      the time of the restore at start-up (one pass
+ *                      through a full page).
+ *
+ *                      Build and run (from this directory):
+ *                      make test (ParamStoreTest)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "max32660.h"
+#include "ParamStore.h"
+#include "SimFlash.h"
+
+#define N_KEYS         256        //!< parameters used by the tests (see KeyKind() etc.)
+#define HEAVY_KEYS     48         //!< parameters of the write-heavy load
+#define HEAVY_WRITES   200000     //!< stores of the write-heavy load
+#define FAIL_KEYS      24         //!< parameters of the power failure tests
+#define FAIL_PRELOAD   500        //!< stores before the power failure (page change follows soon)
+#define FAIL_RANGE     120        //!< power failure after 0..FAIL_RANGE-1 flash operations
+#define FAIL_SEEDS     4          //!< different torn operations per failure point
+#define ENDURANCE      10000      //!< erase cycles of a flash page (MAX32660 data sheet)
+#define PAGE_SLOTS     (uint32_t) (MXC_FLASH_PAGE_SIZE/16)   //!< records per page (including the header)
+#define RESTORE_REPEAT 1000       //!< restores per time measurement
+
+static uint32_t Failures;
+static uint32_t Checks;
+
+#define CHECK(Condition, ...) do { Checks++; if(!(Condition)) { Failures++; printf("  FAILED: " __VA_ARGS__); printf("\n"); } } while(0)
+
+//! Reference model of the store
+static struct
+{
+  uint8_t Stored;
+  int Value;
+} Reference[N_KEYS];
+
+static uint32_t RandomState;
+
+//! Torn operations of TestPowerFail()
+enum
+{
+  TORN_RECORD,
+  TORN_ERASE,
+  TORN_COPY,
+  TORN_HEADER,
+  N_TORN
+};
+
+
+static uint32_t Random(void)
+{
+  RandomState^=RandomState<<13;
+  RandomState^=RandomState>>17;
+  RandomState^=RandomState<<5;
+
+  return RandomState;
+}
+
+static uint8_t KeyKind(uint32_t Key)  { return PS_KIND_AXIS+Key%3; }
+static uint8_t KeyBank(uint32_t Key)  { return (Key/3)%3; }
+static uint8_t KeyIndex(uint32_t Key) { return Key/9; }
+
+
+/***************************************************************//**
+   \fn Store(uint32_t Key, int Value)
+   \brief Store a parameter and update the reference model
+   \return Result of ParamStoreWrite()
+********************************************************************/
+static uint8_t Store(uint32_t Key, int Value)
+{
+  uint8_t Result;
+
+  Result=ParamStoreWrite(KeyKind(Key), KeyBank(Key), KeyIndex(Key), Value);
+  if(Result==PS_OK)
+  {
+    Reference[Key].Stored=TRUE;
+    Reference[Key].Value=Value;
+  }
+
+  return Result;
+}
+
+
+/***************************************************************//**
+   \fn Restart(void)
+   \brief Power on and restore the store (like a reset of the MCU)
+********************************************************************/
+static void Restart(void)
+{
+  SimFlashPowerOn();
+  InitParamStore();
+}
+
+
+/***************************************************************//**
+   \fn Clear(void)
+   \brief Clear the store and the reference model
+********************************************************************/
+static void Clear(void)
+{
+  uint32_t i;
+
+  SimFlashPowerOn();
+  CHECK(ParamStoreClear()==PS_OK, "ParamStoreClear()");
+  for(i=0; i<N_KEYS; i++) Reference[i].Stored=FALSE;
+}
+
+
+/***************************************************************//**
+   \fn FindKey(const TParamEntry *Entry)
+   \return Key of an entry of the RAM mirror (N_KEYS if unknown)
+********************************************************************/
+static uint32_t FindKey(const TParamEntry *Entry)
+{
+  uint32_t Key;
+
+  for(Key=0; Key<N_KEYS; Key++)
+    if(Entry->Kind==KeyKind(Key) && Entry->Bank==KeyBank(Key) && Entry->Index==KeyIndex(Key)) return Key;
+
+  return N_KEYS;
+}
+
+
+/***************************************************************//**
+   \fn MatchesReference(uint8_t AllowMissing)
+   \brief Compare the RAM mirror with the reference model
+   \param AllowMissing: stored parameters may be missing (interrupted clear)
+   \return TRUE if equal
+********************************************************************/
+static uint8_t MatchesReference(uint8_t AllowMissing)
+{
+  const TParamEntry *Entry;
+  uint8_t Found[N_KEYS]={0};
+  uint32_t Key;
+  uint32_t i;
+  int Value;
+
+  for(i=0; (Entry=GetParamStoreEntry(i))!=NULL; i++)
+  {
+    Key=FindKey(Entry);
+    if(Key>=N_KEYS || Found[Key] || !Reference[Key].Stored || Reference[Key].Value!=Entry->Value) return FALSE;
+    Found[Key]=TRUE;
+  }
+
+  for(Key=0; Key<N_KEYS; Key++)
+  {
+    if(Reference[Key].Stored && !Found[Key] && !AllowMissing) return FALSE;
+    if(ParamStoreRead(KeyKind(Key), KeyBank(Key), KeyIndex(Key), &Value)!=Found[Key]) return FALSE;
+    if(Found[Key] && Value!=Reference[Key].Value) return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn StoredCount(void)
+   \return Number of stored parameters of the reference model
+********************************************************************/
+static uint32_t StoredCount(void)
+{
+  uint32_t Count;
+  uint32_t Key;
+
+  for(Count=0, Key=0; Key<N_KEYS; Key++) Count+=Reference[Key].Stored;
+
+  return Count;
+}
+
+
+/***************************************************************//**
+   \fn UsedSlots(uint32_t Page)
+   \return Number of written records of a page (up to the first erased one)
+********************************************************************/
+static uint32_t UsedSlots(uint32_t Page)
+{
+  const uint32_t *Record;
+  uint32_t Slot;
+
+  for(Slot=0; Slot<PAGE_SLOTS; Slot++)
+  {
+    Record=(const uint32_t *) (PS_START+Page*MXC_FLASH_PAGE_SIZE+Slot*16);
+    if(Record[0]==0xffffffff && Record[1]==0xffffffff && Record[2]==0xffffffff && Record[3]==0xffffffff) break;
+  }
+
+  return Slot;
+}
+
+
+/***************************************************************//**
+   \fn TestBasics(void)
+   \brief Empty store, unchanged values, full store
+********************************************************************/
+static void TestBasics(void)
+{
+  uint32_t Writes;
+  uint32_t Key;
+  int Value;
+
+  Clear();
+  Restart();
+  CHECK(GetParamStoreEntry(0)==NULL, "empty store has entries");
+  CHECK(!ParamStoreRead(PS_KIND_AXIS, 0, 0, &Value), "empty store: parameter found");
+  CHECK(GetParamStoreEraseCount()==0, "empty store: erase count %u", GetParamStoreEraseCount());
+
+  //The first write activates a page
+  CHECK(Store(0, 1234)==PS_OK, "first write");
+  CHECK(GetParamStoreEraseCount()==1, "first write: erase count %u", GetParamStoreEraseCount());
+  Restart();
+  CHECK(MatchesReference(FALSE), "first write: restored store differs");
+
+  //Unchanged values are not written again
+  Writes=SimFlashStatistics.Writes;
+  CHECK(Store(0, 1234)==PS_OK, "unchanged value");
+  CHECK(SimFlashStatistics.Writes==Writes, "unchanged value written to the flash");
+  CHECK(Store(0, -1)==PS_OK, "changed value");
+  CHECK(SimFlashStatistics.Writes==Writes+1, "changed value: %u flash writes", SimFlashStatistics.Writes-Writes);
+
+  //PS_MAX_ENTRIES different parameters
+  for(Key=1; Key<PS_MAX_ENTRIES; Key++) CHECK(Store(Key, Key*1000)==PS_OK, "key %u", Key);
+  CHECK(Store(PS_MAX_ENTRIES, 0)==PS_FULL, "store not full after %u parameters", PS_MAX_ENTRIES);
+  CHECK(Store(5, 55)==PS_OK, "full store: update of a stored parameter");
+  Restart();
+  CHECK(MatchesReference(FALSE), "full store: restored store differs");
+  CHECK(Store(PS_MAX_ENTRIES, 0)==PS_FULL, "restored store not full");
+
+  //Clear
+  Clear();
+  Restart();
+  CHECK(GetParamStoreEntry(0)==NULL && GetParamStoreEraseCount()==0, "store not empty after ParamStoreClear()");
+}
+
+
+/***************************************************************//**
+   \fn TestWriteHeavy(void)
+   \brief Many stores of changing values, restart after every 997 stores
+********************************************************************/
+static void TestWriteHeavy(void)
+{
+  TSimFlashStatistics Start;
+  uint32_t PageStart[PS_PAGES];
+  uint32_t PageErases;
+  uint32_t EraseCount;
+  uint32_t Unchanged;
+  uint32_t Records;
+  uint32_t Erases;
+  uint32_t Key;
+  uint32_t n;
+  uint32_t i;
+  int Value;
+
+  Clear();
+  RandomState=4711;
+  Start=SimFlashStatistics;
+  for(i=0; i<PS_PAGES; i++) PageStart[i]=SimFlashPageErases(i);
+  Unchanged=0;
+  for(n=0; n<HEAVY_WRITES; n++)
+  {
+    Key=Random() % HEAVY_KEYS;
+    Value=Random() % 8;
+    if(Reference[Key].Stored && Reference[Key].Value==Value) Unchanged++;
+
+    Records=StoredCount();
+    EraseCount=GetParamStoreEraseCount();
+    Erases=SimFlashStatistics.Erases;
+    CHECK(Store(Key, Value)==PS_OK, "store %u failed", n);
+
+    //Page change: one erase, the new page holds the header, the copies of all other parameters and the new record
+    if(GetParamStoreEraseCount()!=EraseCount)
+    {
+      CHECK(GetParamStoreEraseCount()==EraseCount+1 && SimFlashStatistics.Erases==Erases+1,
+            "store %u: %u erases, erase count %u->%u", n, SimFlashStatistics.Erases-Erases, EraseCount, GetParamStoreEraseCount());
+      i=GetParamStoreEraseCount() % PS_PAGES;   //the first page change activates the second page
+      CHECK(UsedSlots(i)==Records+2, "store %u: %u records in the new page, %u parameters", n, UsedSlots(i), Records);
+    }
+    else
+    {
+      CHECK(SimFlashStatistics.Erases==Erases, "store %u: erase without page change", n);
+    }
+
+    if(n % 997==0)
+    {
+      Restart();
+      CHECK(MatchesReference(FALSE), "store %u: restored store differs", n);
+      CHECK(GetParamStoreEraseCount()==SimFlashStatistics.Erases-Start.Erases,
+            "store %u: erase count %u, %u erases", n, GetParamStoreEraseCount(), SimFlashStatistics.Erases-Start.Erases);
+    }
+  }
+  Restart();
+  CHECK(MatchesReference(FALSE), "restored store differs after the write-heavy load");
+
+  //Wear levelling
+  Erases=SimFlashStatistics.Erases-Start.Erases;
+  for(i=0; i<PS_PAGES; i++)
+  {
+    PageErases=SimFlashPageErases(i)-PageStart[i];
+    CHECK(PageErases>=Erases/PS_PAGES && PageErases<=Erases/PS_PAGES+1, "page %u erased %u times of %u", i, PageErases, Erases);
+  }
+
+  Records=SimFlashStatistics.Writes-Start.Writes;
+  printf("Write-heavy load: %u stores of %u parameters (%u unchanged), %u records written, %u erases (%u per page)\n",
+         HEAVY_WRITES, HEAVY_KEYS, Unchanged, Records, Erases, Erases/PS_PAGES);
+  printf("  %.1f stores per erase, %.2f records per changed value, %.0f changed values until %u erase cycles per page\n",
+         (double) HEAVY_WRITES/Erases, (double) Records/(HEAVY_WRITES-Unchanged),
+         (double) (HEAVY_WRITES-Unchanged)/Erases*ENDURANCE*PS_PAGES, ENDURANCE);
+}
+
+
+/***************************************************************//**
+   \fn PreloadStore(void)
+   \brief Clear the store and store FAIL_PRELOAD values (same every time)
+********************************************************************/
+static void PreloadStore(void)
+{
+  uint32_t n;
+
+  Clear();
+  RandomState=815;
+  for(n=0; n<FAIL_PRELOAD; n++) Store(Random() % FAIL_KEYS, Random() % 1000);
+}
+
+
+/***************************************************************//**
+   \fn TestPowerFail(void)
+   \brief Power failure during every flash operation around a page change
+
+   After the restart every parameter must have its last successfully
+   stored value, only the parameter stored during the power failure
+   may have the old or the new value. The store must then work
+   normally again.
+********************************************************************/
+static void TestPowerFail(void)
+{
+  TSimFlashStatistics Before;
+  uint32_t Torn[N_TORN]={0};
+  uint32_t NewValueKept;
+  uint32_t FailedKey;
+  uint32_t Fail;
+  uint32_t Seed;
+  uint32_t Runs;
+  uint32_t Key;
+  uint32_t n;
+  int FailedValue;
+  int OldValue;
+  uint8_t OldStored;
+  uint8_t Ok;
+
+  NewValueKept=0;
+  Runs=0;
+  for(Seed=1; Seed<=FAIL_SEEDS; Seed++)
+  {
+    for(Fail=0; Fail<FAIL_RANGE; Fail++)
+    {
+      PreloadStore();
+      SimFlashPowerFail(Fail, Seed*7919+Fail);
+
+      FailedKey=N_KEYS;
+      FailedValue=0;
+      OldValue=0;
+      OldStored=FALSE;
+      Before=SimFlashStatistics;
+      for(n=0; n<2*FAIL_RANGE && FailedKey==N_KEYS; n++)
+      {
+        Key=Random() % FAIL_KEYS;
+        OldStored=Reference[Key].Stored;
+        OldValue=Reference[Key].Value;
+        FailedValue=Random() % 1000;
+        Before=SimFlashStatistics;
+        if(Store(Key, FailedValue)!=PS_OK) FailedKey=Key;
+      }
+      CHECK(FailedKey<N_KEYS && SimFlashPowerIsDown(), "seed %u, failure after %u operations: no store failed", Seed, Fail);
+      if(FailedKey>=N_KEYS) continue;
+      Runs++;
+
+      //Torn operation of the failed store
+      if(SimFlashStatistics.Erases==Before.Erases) Torn[TORN_RECORD]++;
+      else if(SimFlashStatistics.Writes==Before.Writes) Torn[TORN_ERASE]++;
+      else if(SimFlashStatistics.Writes-Before.Writes<=StoredCount()) Torn[TORN_COPY]++;
+      else Torn[TORN_HEADER]++;
+
+      //The interrupted store may have reached the flash or not
+      Restart();
+      Ok=MatchesReference(FALSE);
+      if(!Ok)
+      {
+        Reference[FailedKey].Stored=TRUE;
+        Reference[FailedKey].Value=FailedValue;
+        Ok=MatchesReference(FALSE);
+        NewValueKept+=Ok;
+        if(!Ok)
+        {
+          Reference[FailedKey].Stored=OldStored;
+          Reference[FailedKey].Value=OldValue;
+        }
+      }
+      CHECK(Ok, "seed %u, failure after %u operations: restored store differs", Seed, Fail);
+
+      //Go on through the next page change
+      for(n=0; n<FAIL_PRELOAD; n++)
+        CHECK(Store(Random() % FAIL_KEYS, Random() % 1000)==PS_OK, "seed %u, failure after %u operations: store %u after the restart", Seed, Fail, n);
+      Restart();
+      CHECK(MatchesReference(FALSE), "seed %u, failure after %u operations: restored store differs after further stores", Seed, Fail);
+    }
+  }
+
+  printf("Power failures: %u (torn record %u, erase %u, copy %u, header %u), interrupted store kept in %u, lost in %u\n",
+         Runs, Torn[TORN_RECORD], Torn[TORN_ERASE], Torn[TORN_COPY], Torn[TORN_HEADER], NewValueKept, Runs-NewValueKept);
+}
+
+
+/***************************************************************//**
+   \fn PrepareClear(uint32_t PageChanges)
+   \brief Fill the store so that the other page holds older values
+   \param PageChanges: page changes after the clear (selects the active page)
+********************************************************************/
+static void PrepareClear(uint32_t PageChanges)
+{
+  uint32_t Key;
+  int Value;
+
+  Clear();
+  RandomState=2024;
+  for(Key=0; Key<FAIL_KEYS; Key++) Store(Key, -1-Key);
+  for(Value=0; GetParamStoreEraseCount()<PageChanges; Value++)
+    Store(Random() % FAIL_KEYS, Value);
+}
+
+
+/***************************************************************//**
+   \fn TestClearPowerFail(void)
+   \brief Power failure during ParamStoreClear()
+
+   The interrupted clear may leave some of the parameters, but these
+   must have their latest values: old values from the other page must
+   not come back.
+********************************************************************/
+static void TestClearPowerFail(void)
+{
+  uint32_t PageChanges;
+  uint32_t Remaining;
+  uint32_t Fail;
+  uint32_t Seed;
+  uint32_t i;
+
+  Remaining=0;
+  for(PageChanges=3; PageChanges<3+PS_PAGES; PageChanges++)
+  {
+    for(Fail=0; Fail<PS_PAGES; Fail++)
+    {
+      for(Seed=1; Seed<=50; Seed++)
+      {
+        PrepareClear(PageChanges);
+        SimFlashPowerFail(Fail, Seed);
+        CHECK(ParamStoreClear()==PS_FLASH_ERROR, "clear not interrupted");
+        Restart();
+        CHECK(MatchesReference(TRUE), "active page %u, erase %u interrupted (seed %u): old values restored",
+              PageChanges % PS_PAGES, Fail, Seed);
+        for(i=0; GetParamStoreEntry(i)!=NULL; i++) Remaining++;
+      }
+    }
+  }
+  printf("Interrupted clears: %u, %.1f of %u parameters left on average\n",
+         PS_PAGES*PS_PAGES*50, (double) Remaining/(PS_PAGES*PS_PAGES*50), FAIL_KEYS);
+}
+
+
+/***************************************************************//**
+   \fn MeasureRestore(uint32_t Parameters)
+   \brief Time of InitParamStore() with a full page
+   \param Parameters: number of different parameters in the store
+********************************************************************/
+static void MeasureRestore(uint32_t Parameters)
+{
+  struct timespec Start, End;
+  uint32_t EraseCount;
+  uint32_t Key;
+  uint32_t n;
+  double Time;
+
+  Clear();
+  for(Key=0; Key<Parameters; Key++) Store(Key, Key);
+
+  //Fill the page after the next page change
+  EraseCount=GetParamStoreEraseCount();
+  for(n=0; GetParamStoreEraseCount()==EraseCount; n++) Store(n % Parameters, n+Parameters);
+  for(; UsedSlots(GetParamStoreEraseCount() % PS_PAGES)<PAGE_SLOTS; n++) Store(n % Parameters, n+Parameters);
+
+  clock_gettime(CLOCK_MONOTONIC, &Start);
+  for(n=0; n<RESTORE_REPEAT; n++) InitParamStore();
+  clock_gettime(CLOCK_MONOTONIC, &End);
+  Time=((End.tv_sec-Start.tv_sec)*1e9+(End.tv_nsec-Start.tv_nsec))/RESTORE_REPEAT;
+
+  CHECK(MatchesReference(FALSE), "%u parameters: restored store differs", Parameters);
+  CHECK(GetParamStoreEraseCount()==EraseCount+1, "%u parameters: page change while filling the page", Parameters);
+  printf("Restore of a full page (%u records), %3u parameters: %6.1f µs on the host, at most %u entry compares\n",
+         PAGE_SLOTS-1, Parameters, Time/1000, (PAGE_SLOTS-1)*Parameters);
+}
+
+
+int main(void)
+{
+  printf("Parameter store test: %u pages of %u records\n", PS_PAGES, PAGE_SLOTS);
+  SimFlashInit();
+  InitParamStore();
+
+  TestBasics();
+  TestWriteHeavy();
+  TestPowerFail();
+  TestClearPowerFail();
+  MeasureRestore(FAIL_KEYS);
+  MeasureRestore(PS_MAX_ENTRIES);
+
+  printf("%u checks, %u failed\n", Checks, Failures);
+
+  return Failures>0 ? 2 : 0;
+}
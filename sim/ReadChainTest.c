@@ -0,0 +1,458 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file ReadChainTest.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: ReadChainTest.c
+ *         Description: Host test of the pipelined TMC5130 reads
+ *
+ *                      Runs ../TMC5130.c (compiled with -DTMC5130_SIMULATION)
+ *                      against the daisy chain model of SimTMC5130.c, which
+ *                      returns the data of a read request one datagram
+ *                      late like the real drivers. Checks:
+ *                      - ReadTMC5130Multiple() / ReadTMC5130Snapshot():
+ *                        values of readable registers, software copy for
+ *                        the others, n+1 frames for n readable registers
+ *                        (also for 0 and 1 register and mixed lists)
+ *                      - reads of one driver do not disturb the others
+ *                        (N_O_MOTORS>1)
+ *                      - posted and deferred writes are sent before reads
+ *                      - sign extension of VACTUAL
+ *                      - RAMPSTAT event flags (read-clear on the TMC5130,
+ *                        write-1-clear on the TMC5160)
+ *                      - VerifyTMC5130Registers() after a driver reset
+ *
+ *                      Build and run (from this directory): make test
+ *                      (ReadChainTest1: one driver, ReadChainTest3: three
+ *                      drivers in the daisy chain, ReadChainTest5160:
+ *                      three TMC5160)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include "max32660.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "TMC5130.h"
+#include "SimTMC5130.h"
+
+#define LOG_SIZE 1024
+
+#define CHECK(Condition, ...) Check((Condition), __LINE__, __VA_ARGS__)
+
+static TSimDatagram Log[LOG_SIZE];
+static uint32_t Failures;
+static uint32_t Checks;
+
+
+/***************************************************************//**
+   \fn Check(int Condition, int Line, const char *Format, ...)
+   \brief Count a check and report it if it has failed
+********************************************************************/
+static void Check(int Condition, int Line, const char *Format, ...)
+{
+  va_list Arguments;
+
+  Checks++;
+  if(Condition) return;
+
+  Failures++;
+  printf("  FAILED (line %d): ", Line);
+  va_start(Arguments, Format);
+  vprintf(Format, Arguments);
+  va_end(Arguments);
+  printf("\n");
+}
+
+
+/***************************************************************//**
+   \fn StartLog(void)
+   \brief Start recording the datagrams and frames of a test step
+   \return Frame counter at the start
+********************************************************************/
+static uint32_t StartLog(void)
+{
+  SimSetDatagramLog(Log, LOG_SIZE);
+  return SimSPIStatistics.Frames;
+}
+
+
+/***************************************************************//**
+   \fn CountDatagrams(uint8_t Which5130, int Write)
+   \return Number of logged datagrams received by a driver
+           (Write: 1 writes, 0 reads)
+********************************************************************/
+static uint32_t CountDatagrams(uint8_t Which5130, int Write)
+{
+  uint32_t Count;
+  uint32_t i;
+
+  Count=0;
+  for(i=0; i<SimGetDatagramCount() && i<LOG_SIZE; i++)
+    if(Log[i].Which5130==Which5130 && Log[i].Write==Write) Count++;
+
+  return Count;
+}
+
+
+/***************************************************************//**
+   \fn SignExtend24(int Value)
+   \return 24 bit register value extended to 32 bits
+********************************************************************/
+static int SignExtend24(int Value)
+{
+  return (Value & BIT23) ? (Value | (int) 0xff000000) : (Value & 0xffffff);
+}
+
+
+/***************************************************************//**
+   \fn TestValue(uint8_t Which5130, uint8_t Address)
+   \return Distinct value for a register of a driver (only the bits
+           the register has, see SimRegisterWriteMask())
+********************************************************************/
+static int TestValue(uint8_t Which5130, uint8_t Address)
+{
+  return (((Which5130+1)<<20)|(Address<<8)|0x5a) & SimRegisterWriteMask(Address);
+}
+
+
+/***************************************************************//**
+   \fn IsTestRegister(uint8_t Address)
+   \return TRUE for the writable registers that get a test value
+           (no motion, no event flags, no OTP programming)
+********************************************************************/
+static int IsTestRegister(uint8_t Address)
+{
+  if(!(SimRegisterAccess(Address) & SIM_ACC_W)) return FALSE;
+  if(Address>=TMC5130_RAMPMODE && Address<=TMC5130_XTARGET) return FALSE;
+#if defined(DEVTYPE_TMC5160)
+  if(Address==TMC5160_OTP_PROG) return FALSE;
+#endif
+
+  return TRUE;
+}
+
+
+/***************************************************************//**
+   \fn Configure(uint8_t Which5130)
+   \brief Write test values to all configuration registers of a driver
+********************************************************************/
+static void Configure(uint8_t Which5130)
+{
+  uint32_t Address;
+
+  WriteTMC5130Int(Which5130, TMC5130_VMAX, 0);
+  WriteTMC5130Int(Which5130, TMC5130_RAMPMODE, TMC5130_MODE_HOLD);
+  for(Address=0; Address<128; Address++)
+    if(IsTestRegister(Address)) WriteTMC5130Int(Which5130, Address, TestValue(Which5130, Address));
+}
+
+
+/***************************************************************//**
+   \fn TestSnapshot(uint8_t Which5130)
+   \brief Read all registers of a driver with ReadTMC5130Snapshot()
+********************************************************************/
+static void TestSnapshot(uint8_t Which5130)
+{
+  uint8_t Addresses[TMC5130_SNAPSHOT_SIZE];
+  uint8_t Readable[TMC5130_SNAPSHOT_SIZE];
+  int Values[TMC5130_SNAPSHOT_SIZE];
+  int Expected[128];
+  uint32_t ReadableCount;
+  uint32_t Frames;
+  uint32_t Count;
+  uint32_t i;
+
+  printf("snapshot of driver %u\n", Which5130);
+
+  for(i=0; i<128; i++) Expected[i]=SimGetRegister(Which5130, i);
+  Expected[TMC5130_VACTUAL]=SignExtend24(Expected[TMC5130_VACTUAL]);
+
+  Frames=StartLog();
+  Count=ReadTMC5130Snapshot(Which5130, Addresses, Values, Readable);
+  Frames=SimSPIStatistics.Frames-Frames;
+
+  CHECK(Count==TMC5130_SNAPSHOT_SIZE, "snapshot size %u", Count);
+  ReadableCount=0;
+  for(i=0; i<Count; i++)
+  {
+    if(Readable[i])
+    {
+      ReadableCount++;
+      if(Addresses[i]!=TMC5130_IFCNT)
+        CHECK(Values[i]==Expected[Addresses[i]], "register 0x%02x read 0x%08x, expected 0x%08x",
+              Addresses[i], Values[i], Expected[Addresses[i]]);
+    }
+    else if(IsTestRegister(Addresses[i]))
+    {
+      CHECK(Values[i]==TestValue(Which5130, Addresses[i]), "register 0x%02x copy 0x%08x, expected 0x%08x",
+            Addresses[i], Values[i], TestValue(Which5130, Addresses[i]));
+    }
+  }
+  CHECK(Frames==ReadableCount+1, "%u frames for %u readable registers", Frames, ReadableCount);
+  CHECK(CountDatagrams(Which5130, 0)==ReadableCount+1, "%u read datagrams", CountDatagrams(Which5130, 0));
+  CHECK(CountDatagrams(Which5130, 1)==0, "%u write datagrams", CountDatagrams(Which5130, 1));
+}
+
+
+/***************************************************************//**
+   \fn TestShortLists(uint8_t Which5130)
+   \brief ReadTMC5130Multiple() with 0 and 1 registers and with
+          write-only registers between readable ones
+********************************************************************/
+static void TestShortLists(uint8_t Which5130)
+{
+  static const uint8_t Single[]={TMC5130_XACTUAL};
+  static const uint8_t WriteOnly[]={TMC5130_IHOLD_IRUN, TMC5130_TPOWERDOWN};
+  static const uint8_t Mixed[]={TMC5130_IHOLD_IRUN, TMC5130_XACTUAL, TMC5130_TPWMTHRS, TMC5130_TPWMTHRS,
+                                TMC5130_IOIN, TMC5130_COOLCONF};
+  int Values[6];
+  uint32_t Frames;
+
+  printf("short read lists of driver %u\n", Which5130);
+  SimSetRegister(Which5130, TMC5130_XACTUAL, -123456);
+
+  Frames=StartLog();
+  ReadTMC5130Multiple(Which5130, Single, Values, 0);
+  CHECK(SimSPIStatistics.Frames==Frames, "%u frames for no register", SimSPIStatistics.Frames-Frames);
+
+  Frames=StartLog();
+  ReadTMC5130Multiple(Which5130, Single, Values, 1);
+  CHECK(SimSPIStatistics.Frames-Frames==2, "%u frames for one register", SimSPIStatistics.Frames-Frames);
+  CHECK(Values[0]==-123456, "XACTUAL %d", Values[0]);
+
+  Frames=StartLog();
+  ReadTMC5130Multiple(Which5130, WriteOnly, Values, 2);
+  CHECK(SimSPIStatistics.Frames==Frames, "%u frames for write-only registers", SimSPIStatistics.Frames-Frames);
+  CHECK(Values[0]==TestValue(Which5130, TMC5130_IHOLD_IRUN) && Values[1]==TestValue(Which5130, TMC5130_TPOWERDOWN),
+        "write-only values 0x%08x 0x%08x", Values[0], Values[1]);
+
+  Frames=StartLog();
+  ReadTMC5130Multiple(Which5130, Mixed, Values, 6);
+  CHECK(SimSPIStatistics.Frames-Frames==3, "%u frames for two readable registers", SimSPIStatistics.Frames-Frames);
+  CHECK(Values[1]==-123456, "XACTUAL %d", Values[1]);
+  CHECK(Values[4]==SimGetRegister(Which5130, TMC5130_IOIN), "IOIN 0x%08x", Values[4]);
+  CHECK(Values[0]==TestValue(Which5130, TMC5130_IHOLD_IRUN) && Values[2]==TestValue(Which5130, TMC5130_TPWMTHRS) &&
+        Values[3]==Values[2] && Values[5]==TestValue(Which5130, TMC5130_COOLCONF), "write-only values in mixed list");
+}
+
+
+/***************************************************************//**
+   \fn TestCrossDriver(void)
+   \brief Interleaved reads of all drivers
+********************************************************************/
+static void TestCrossDriver(void)
+{
+  static const uint8_t Addresses[]={TMC5130_XACTUAL, TMC5130_XENC, TMC5130_XTARGET};
+  int Values[3];
+  uint32_t i, j;
+  int Value;
+
+  printf("interleaved reads of %u drivers\n", N_O_DRIVERS);
+  for(i=0; i<N_O_DRIVERS; i++)
+  {
+    SimSetRegister(i, TMC5130_XACTUAL, 1000*(i+1));
+    SimSetRegister(i, TMC5130_XENC, -2000*(i+1));
+    SimSetRegister(i, TMC5130_XTARGET, 1000*(i+1));
+  }
+
+  for(j=0; j<2; j++)
+  {
+    for(i=0; i<N_O_DRIVERS; i++)
+    {
+      Value=ReadTMC5130Int(N_O_DRIVERS-1-i, TMC5130_XACTUAL);
+      CHECK(Value==1000*(int) (N_O_DRIVERS-i), "XACTUAL of driver %u: %d", N_O_DRIVERS-1-i, Value);
+      ReadTMC5130Multiple(i, Addresses, Values, 3);
+      CHECK(Values[0]==1000*(int) (i+1) && Values[1]==-2000*(int) (i+1) && Values[2]==1000*(int) (i+1),
+            "driver %u: %d %d %d", i, Values[0], Values[1], Values[2]);
+    }
+  }
+}
+
+
+/***************************************************************//**
+   \fn TestWriteOrder(void)
+   \brief Posted and deferred writes have to reach the driver before
+          a following read
+********************************************************************/
+static void TestWriteOrder(void)
+{
+  static const uint8_t Addresses[]={TMC5130_GCONF, TMC5130_XACTUAL};
+  int Values[2];
+  uint32_t i;
+  uint32_t Reads;
+
+  printf("posted and deferred writes before reads\n");
+  for(i=0; i<N_O_DRIVERS; i++) PostTMC5130Write(i, TMC5130_XACTUAL, 5000+i);
+  for(i=0; i<N_O_DRIVERS; i++)
+  {
+    CHECK(ReadTMC5130Int(i, TMC5130_XACTUAL)==(int) (5000+i), "posted XACTUAL of driver %u", i);
+  }
+
+  for(i=0; i<N_O_DRIVERS; i++)
+  {
+    InvalidateTMC5130Shadow(i);
+    WriteTMC5130Deferred(i, TMC5130_GCONF, 0x104+i);
+  }
+  StartLog();
+  ReadTMC5130Multiple(0, Addresses, Values, 2);
+  CHECK(Values[0]==0x104 && SimGetRegister(0, TMC5130_GCONF)==0x104, "deferred GCONF 0x%08x", Values[0]);
+  for(i=0, Reads=0; i<SimGetDatagramCount(); i++)
+  {
+    if(Log[i].Which5130!=0) continue;
+    if(!Log[i].Write) Reads++;
+    else CHECK(Reads==0, "deferred write after a read");
+  }
+  FlushAllTMC5130Writes();
+  SimAdvance(SIM_CYCLES_PER_MS);
+  for(i=0; i<N_O_DRIVERS; i++)
+    CHECK(SimGetRegister(i, TMC5130_GCONF)==(int) (0x104+i), "GCONF of driver %u 0x%08x", i, SimGetRegister(i, TMC5130_GCONF));
+}
+
+
+/***************************************************************//**
+   \fn TestVelocity(uint8_t Which5130)
+   \brief VACTUAL in negative direction has to be sign extended
+********************************************************************/
+static void TestVelocity(uint8_t Which5130)
+{
+  static const uint8_t Addresses[]={TMC5130_VACTUAL, TMC5130_XACTUAL};
+  int Values[2];
+  int Value;
+
+  printf("VACTUAL of driver %u\n", Which5130);
+  WriteTMC5130Int(Which5130, TMC5130_AMAX, 5000);
+  WriteTMC5130Int(Which5130, TMC5130_VMAX, 200000);
+  WriteTMC5130Int(Which5130, TMC5130_RAMPMODE, TMC5130_MODE_VELNEG);
+  SimAdvance(SIM_CYCLES_PER_MS*50);
+
+  //still accelerating, so the value changes a little during the read
+  Value=ReadTMC5130Int(Which5130, TMC5130_VACTUAL);
+  CHECK(Value<0 && abs(Value-SignExtend24(SimGetRegister(Which5130, TMC5130_VACTUAL)))<100, "VACTUAL %d", Value);
+  ReadTMC5130Multiple(Which5130, Addresses, Values, 2);
+  CHECK(Values[0]<0 && Values[0]>=-200000, "VACTUAL (multiple) %d", Values[0]);
+
+  SimAdvance(SIM_CYCLES_PER_MS*1000);
+  Value=ReadTMC5130Int(Which5130, TMC5130_VACTUAL);
+  CHECK(Value==-200000, "VACTUAL at VMAX %d", Value);
+
+  WriteTMC5130Int(Which5130, TMC5130_VMAX, 0);
+  SimAdvance(SIM_CYCLES_PER_MS*2000);
+  CHECK(ReadTMC5130Int(Which5130, TMC5130_VACTUAL)==0, "VACTUAL after stop");
+}
+
+
+/***************************************************************//**
+   \fn TestRampStat(uint8_t Which5130)
+   \brief The event_pos_reached flag stays set until written with 1
+********************************************************************/
+static void TestRampStat(uint8_t Which5130)
+{
+  static const uint8_t Addresses[]={TMC5130_RAMPSTAT, TMC5130_XACTUAL};
+  int Values[2];
+  int Value;
+
+  printf("RAMPSTAT of driver %u\n", Which5130);
+  WriteTMC5130Int(Which5130, TMC5130_RAMPSTAT, TMC5130_RS_SECONDMOVE|TMC5130_RS_EV_POSREACHED|TMC5130_RS_EV_STOP_SG|TMC5130_RS_LATCHR|TMC5130_RS_LATCHL);
+  WriteTMC5130Int(Which5130, TMC5130_XACTUAL, 0);
+  WriteTMC5130Int(Which5130, TMC5130_XTARGET, 2000);
+  WriteTMC5130Int(Which5130, TMC5130_AMAX, 20000);
+  WriteTMC5130Int(Which5130, TMC5130_VMAX, 100000);
+  WriteTMC5130Int(Which5130, TMC5130_RAMPMODE, TMC5130_MODE_POSITION);
+  Value=ReadTMC5130Int(Which5130, TMC5130_RAMPSTAT);
+  CHECK(!(Value & TMC5130_RS_EV_POSREACHED), "event before the target has been reached (0x%04x)", Value);
+
+  SimAdvance(SIM_CYCLES_PER_MS*1000);
+  ReadTMC5130Multiple(Which5130, Addresses, Values, 2);
+  CHECK(Values[1]==2000, "XACTUAL %d", Values[1]);
+  CHECK((Values[0] & (TMC5130_RS_EV_POSREACHED|TMC5130_RS_POSREACHED))==(TMC5130_RS_EV_POSREACHED|TMC5130_RS_POSREACHED),
+        "RAMPSTAT 0x%04x at the target", Values[0]);
+
+  //Reading does not clear the event (cleared by the TMC5130, kept by the emulation)
+  Value=ReadTMC5130Int(Which5130, TMC5130_RAMPSTAT);
+  CHECK(Value & TMC5130_RS_EV_POSREACHED, "event lost by reading (0x%04x)", Value);
+#if !defined(DEVTYPE_TMC5160)
+  CHECK(!(SimGetRegister(Which5130, TMC5130_RAMPSTAT) & TMC5130_RS_EV_POSREACHED), "TMC5130 has not cleared the event");
+#endif
+
+  WriteTMC5130Int(Which5130, TMC5130_RAMPSTAT, TMC5130_RS_EV_POSREACHED);
+  Value=ReadTMC5130Int(Which5130, TMC5130_RAMPSTAT);
+  CHECK(!(Value & TMC5130_RS_EV_POSREACHED) && (Value & TMC5130_RS_POSREACHED), "RAMPSTAT 0x%04x after clearing", Value);
+}
+
+
+/***************************************************************//**
+   \fn TestVerify(uint8_t Which5130)
+   \brief VerifyTMC5130Registers() after a reset of one driver
+********************************************************************/
+static void TestVerify(uint8_t Which5130)
+{
+  uint32_t Address;
+  uint32_t i;
+  uint8_t Restored;
+
+  printf("register restore of driver %u\n", Which5130);
+  for(i=0; i<N_O_DRIVERS; i++)
+  {
+    Configure(i);
+    VerifyTMC5130Registers(i);
+  }
+
+  StartLog();
+  for(i=0; i<N_O_DRIVERS; i++) CHECK(!VerifyTMC5130Registers(i), "driver %u restored without reset", i);
+  CHECK(CountDatagrams(Which5130, 1)==0, "writes without reset");
+
+  SimResetTMC5130(Which5130);
+  StartLog();
+  for(i=0; i<N_O_DRIVERS; i++)
+  {
+    Restored=VerifyTMC5130Registers(i);
+    CHECK(Restored==(i==Which5130), "driver %u: restored %d", i, Restored);
+    if(i!=Which5130) CHECK(CountDatagrams(i, 1)==0, "driver %u written", i);
+  }
+  CHECK(!(SimGetRegister(Which5130, TMC5130_GSTAT) & BIT0), "reset flag not cleared");
+  for(Address=0; Address<128; Address++)
+  {
+    //XENC is changed by the driver itself, so it is not restored
+    if(IsTestRegister(Address) && Address!=TMC5130_XENC)
+      CHECK(SimGetRegister(Which5130, Address)==TestValue(Which5130, Address), "register 0x%02x not restored (0x%08x)",
+            Address, SimGetRegister(Which5130, Address));
+  }
+  CHECK(!VerifyTMC5130Registers(Which5130), "restored twice");
+}
+
+
+int main(void)
+{
+  uint32_t i;
+
+  printf("TMC5130 read chain test, %u driver(s)%s\n", N_O_DRIVERS,
+#if defined(DEVTYPE_TMC5160)
+         ", TMC5160"
+#else
+         ""
+#endif
+         );
+
+  for(i=0; i<N_O_DRIVERS; i++) Configure(i);
+  for(i=0; i<N_O_DRIVERS; i++) TestSnapshot(i);
+  TestShortLists(N_O_DRIVERS-1);
+  TestCrossDriver();
+  TestWriteOrder();
+  TestVelocity(0);
+  TestRampStat(N_O_DRIVERS/2);
+  TestVerify(N_O_DRIVERS-1);
+  for(i=0; i<N_O_DRIVERS; i++) TestSnapshot(i);
+
+  printf("%u checks, %u failed, %u frames (%u posted), %u reads, %u writes\n", Checks, Failures,
+         SimSPIStatistics.Frames, SimSPIStatistics.PostedFrames, SimSPIStatistics.Reads, SimSPIStatistics.Writes);
+
+  return Failures>0 ? 2 : 0;
+}
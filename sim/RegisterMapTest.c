@@ -0,0 +1,184 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file RegisterMapTest.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: RegisterMapTest.c
+ *         Description: Host test of the TMC5130/TMC5160 register table
+ *
+ *                      Includes ../TMC5130.c (compiled with
+ *                      -DTMC5130_SIMULATION), so that the tables generated
+ *                      from the register X-macro can be checked directly
+ *                      against the data sheet access rights of the daisy
+ *                      chain model (SimRegisterAccess() in SimTMC5130.c):
+ *                      - the register list (snapshot): every existing
+ *                        register exactly once, ascending addresses
+ *                      - the readable bitmap
+ *                      - the volatile bitmap: registers that are changed
+ *                        by the driver, have event flags or side effects
+ *                        must never be cached, write-only configuration
+ *                        registers must be cached
+ *                      - the MCU owned registers (read from the software
+ *                        copy) must be writable and cached
+ *                      - RAMPSTAT_W1C_BITS against the flags the driver
+ *                        clears (by reading on the TMC5130, by writing 1
+ *                        on the TMC5160) and the emulation of the
+ *                        write-1-clear flags by ReadTMC5130Int()
+ *
+ *                      Build and run (from this directory): make test
+ *                      (RegisterMapTest5130 and RegisterMapTest5160)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include "../TMC5130.c"
+
+static uint32_t Failures;
+static uint32_t Checks;
+
+#define CHECK(Condition, ...) do { Checks++; if(!(Condition)) { Failures++; printf("  FAILED: " __VA_ARGS__); printf("\n"); } } while(0)
+
+
+/***************************************************************//**
+   \fn MustBeVolatile(uint8_t Address)
+   \return TRUE if the software copy of a register must not be used
+           for skipping writes: not writable, changed by the driver
+           itself, event flags or side effects when written
+********************************************************************/
+static uint8_t MustBeVolatile(uint8_t Address)
+{
+  uint8_t Access;
+
+  Access=SimRegisterAccess(Address);
+  if(!(Access & SIM_ACC_W) || (Access & (SIM_ACC_RC|SIM_ACC_WC))) return TRUE;
+
+  switch(Address)
+  {
+    case TMC5130_XACTUAL:   //changed by the ramp generator
+    case TMC5130_XENC:      //changed by the encoder
+#if defined(DEVTYPE_TMC5160)
+    case TMC5160_OTP_PROG:  //programs the OTP memory
+#endif
+      return TRUE;
+
+    default:
+      return FALSE;
+  }
+}
+
+
+/***************************************************************//**
+   \fn TestTables(void)
+   \brief Check the tables generated from the register X-macro
+********************************************************************/
+static void TestTables(void)
+{
+  uint8_t Listed[128];
+  uint32_t Existing;
+  uint32_t Address;
+  uint32_t i;
+  uint8_t Access;
+
+  printf("register table\n");
+  for(i=0; i<128; i++) Listed[i]=0;
+  for(i=0; i<sizeof(TMC5130Registers); i++)
+  {
+    Listed[TMC5130Registers[i]]++;
+    if(i>0) CHECK(TMC5130Registers[i]>TMC5130Registers[i-1], "register list not ascending at 0x%02x", TMC5130Registers[i]);
+    CHECK(TMC5130RegisterSlot[TMC5130Registers[i]]==i+1, "slot of register 0x%02x is %u", TMC5130Registers[i],
+          TMC5130RegisterSlot[TMC5130Registers[i]]);
+  }
+
+  Existing=0;
+  for(Address=0; Address<128; Address++)
+  {
+    Access=SimRegisterAccess(Address);
+    if(Access!=0) Existing++;
+
+    CHECK(Listed[Address]==(Access!=0), "register 0x%02x listed %u times (access 0x%02x)", Address, Listed[Address], Access);
+    CHECK((IS_READABLE(Address)!=0)==((Access & SIM_ACC_R)!=0), "register 0x%02x: readable %d, data sheet %d",
+          Address, IS_READABLE(Address)!=0, (Access & SIM_ACC_R)!=0);
+    if(Access!=0)
+    {
+      CHECK(IS_VOLATILE(Address)==MustBeVolatile(Address), "register 0x%02x: volatile %d, expected %d",
+            Address, IS_VOLATILE(Address), MustBeVolatile(Address));
+    }
+    else
+    {
+      CHECK(IS_VOLATILE(Address), "unknown register 0x%02x cached", Address);
+      CHECK(TMC5130RegisterSlot[Address]==SLOT_NONE, "unknown register 0x%02x has a slot", Address);
+    }
+    if(IsMCUOwnedRegister(Address))
+    {
+      CHECK((Access & SIM_ACC_W) && !IS_VOLATILE(Address), "MCU owned register 0x%02x not writable or volatile", Address);
+    }
+  }
+  CHECK(Existing==TMC5130_SNAPSHOT_SIZE, "%u registers in the data sheet, TMC5130_SNAPSHOT_SIZE %u", Existing, TMC5130_SNAPSHOT_SIZE);
+}
+
+
+/***************************************************************//**
+   \fn TestRampStat(void)
+   \brief Event flags of RAMPSTAT: cleared flags of the driver and
+          the write-1-clear emulation of the firmware
+********************************************************************/
+static void TestRampStat(void)
+{
+  uint32_t Bit;
+  int Cleared;
+  int Value;
+
+  printf("RAMPSTAT event flags\n");
+
+  //Which flags does the driver clear?
+  SimSetRegister(0, TMC5130_RAMPSTAT, 0x3fff);
+  Value=SimGetRegister(0, TMC5130_RAMPSTAT);
+#if defined(DEVTYPE_TMC5160)
+  WriteTMC5130Int(0, TMC5130_RAMPSTAT, 0x3fff);
+#else
+  ReadTMC5130Int(0, TMC5130_RAMPSTAT);
+#endif
+  Cleared=Value & ~SimGetRegister(0, TMC5130_RAMPSTAT);
+  CHECK(Cleared==RAMPSTAT_W1C_BITS, "driver clears 0x%04x, RAMPSTAT_W1C_BITS 0x%04x", Cleared, RAMPSTAT_W1C_BITS);
+
+  //Every event flag has to stay set until it is written with 1, and only this flag is cleared then
+  for(Bit=0; Bit<14; Bit++)
+  {
+    if(!(RAMPSTAT_W1C_BITS & (1UL<<Bit))) continue;
+
+    SimSetRegister(0, TMC5130_RAMPSTAT, RAMPSTAT_W1C_BITS);
+    Value=ReadTMC5130Int(0, TMC5130_RAMPSTAT);
+    Value=ReadTMC5130Int(0, TMC5130_RAMPSTAT);
+    CHECK((Value & RAMPSTAT_W1C_BITS)==RAMPSTAT_W1C_BITS, "flags 0x%04x lost by reading", ~Value & RAMPSTAT_W1C_BITS);
+
+    WriteTMC5130Int(0, TMC5130_RAMPSTAT, 1UL<<Bit);
+    Value=ReadTMC5130Int(0, TMC5130_RAMPSTAT);
+    CHECK((Value & RAMPSTAT_W1C_BITS)==(RAMPSTAT_W1C_BITS & ~(1UL<<Bit)), "0x%04x after clearing bit %u", Value, Bit);
+
+    WriteTMC5130Int(0, TMC5130_RAMPSTAT, RAMPSTAT_W1C_BITS);
+    Value=ReadTMC5130Int(0, TMC5130_RAMPSTAT);
+    CHECK(!(Value & RAMPSTAT_W1C_BITS), "0x%04x after clearing all flags", Value);
+  }
+}
+
+
+int main(void)
+{
+#if defined(DEVTYPE_TMC5160)
+  printf("TMC5160 register map test\n");
+#else
+  printf("TMC5130 register map test\n");
+#endif
+
+  TestTables();
+  TestRampStat();
+
+  printf("%u checks, %u failed\n", Checks, Failures);
+
+  return Failures>0 ? 2 : 0;
+}
@@ -0,0 +1,197 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file SPITimingBenchmark.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: SPITimingBenchmark.c
+ *         Description: Time per datagram of the TMC5130 access functions
+ *
+ *                      Runs the access functions of ../TMC5130.c against
+ *                      the daisy chain model (SimTMC5130.c) with 1MHz and
+ *                      4MHz SPI clock and reports per access:
+ *                      - CPU time: time the caller is blocked plus the
+ *                        time of the SPI interrupts
+ *                      - latency: until the last frame has been shifted
+ *
+ *                      The times are derived from the timing model of
+ *                      SimTMC5130.c: a frame takes 8 SPI clocks per byte
+ *                      on the bus, a blocking frame SIM_SPI_SETUP_CYCLES
+ *                      of extra CPU time, a posted frame
+ *                      SIM_ASYNC_START_CYCLES for starting it and
+ *                      SIM_ASYNC_IRQ_CYCLES for its interrupt. The time
+ *                      of the code of TMC5130.c itself is not included
+ *                      (it runs natively on the host).
+ *
+ *                      Build and run (from this directory):
+ *                      make benchmark (SPITimingBenchmark1 and 3)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include "max32660.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "TMC5130.h"
+#include "SimTMC5130.h"
+
+#define REPEAT 100   //!< accesses per measurement
+
+static TSimDatagram Log[REPEAT*64];
+
+//! Registers of the burst measurements (cached, so written values have to change)
+static const uint8_t WriteRegisters[8]=
+{
+  TMC5130_VSTART, TMC5130_A1, TMC5130_V1, TMC5130_AMAX, TMC5130_VMAX, TMC5130_DMAX, TMC5130_D1, TMC5130_VSTOP
+};
+
+//! Registers of the read measurements (volatile, so always read from the driver)
+static const uint8_t ReadRegisters[8]=
+{
+  TMC5130_GSTAT, TMC5130_IOIN, TMC5130_TSTEP, TMC5130_XACTUAL, TMC5130_VACTUAL, TMC5130_RAMPSTAT, TMC5130_MSCNT, TMC5130_DRVSTATUS
+};
+
+//! Result of a measurement
+typedef struct
+{
+  double CPU;       //!< CPU time per access (µs)
+  double Latency;   //!< time until the last frame has been sent (µs)
+  double Frames;    //!< frames per access
+} TTiming;
+
+//! Accesses to be measured
+typedef enum
+{
+  WRITE_BLOCKING,
+  WRITE_POSTED,
+  READ_SINGLE,
+  BURST_BLOCKING,
+  BURST_POSTED,
+  READ_SINGLE8,
+  READ_MULTIPLE8,
+  N_ACCESSES
+} TAccess;
+
+static const char *AccessNames[N_ACCESSES]=
+{
+  "write, blocking (WriteTMC5130Int)",
+  "write, posted (PostTMC5130Write)",
+  "read (ReadTMC5130Int)",
+  "8 writes, blocking",
+  "8 writes, posted",
+  "8 reads, ReadTMC5130Int",
+  "8 reads, ReadTMC5130Multiple",
+};
+
+
+/***************************************************************//**
+   \fn Access(TAccess Access, uint32_t n)
+   \brief Do one access (n makes every written value different)
+********************************************************************/
+static void Access(TAccess Access, uint32_t n)
+{
+  int Values[8];
+  uint32_t i;
+
+  switch(Access)
+  {
+    case WRITE_BLOCKING:
+      WriteTMC5130Int(0, TMC5130_VMAX, n);
+      break;
+
+    case WRITE_POSTED:
+      PostTMC5130Write(0, TMC5130_VMAX, n);
+      break;
+
+    case READ_SINGLE:
+      ReadTMC5130Int(0, TMC5130_XACTUAL);
+      break;
+
+    case BURST_BLOCKING:
+      for(i=0; i<8; i++) WriteTMC5130Int(0, WriteRegisters[i], n+i);
+      break;
+
+    case BURST_POSTED:
+      for(i=0; i<8; i++) PostTMC5130Write(0, WriteRegisters[i], n+i);
+      break;
+
+    case READ_SINGLE8:
+      for(i=0; i<8; i++) Values[i]=ReadTMC5130Int(0, ReadRegisters[i]);
+      break;
+
+    case READ_MULTIPLE8:
+      ReadTMC5130Multiple(0, ReadRegisters, Values, 8);
+      break;
+
+    default:
+      break;
+  }
+  (void) Values;
+}
+
+
+/***************************************************************//**
+   \fn Measure(TAccess AccessType, uint32_t SPIClock)
+   \brief Measure an access (average of REPEAT accesses)
+********************************************************************/
+static TTiming Measure(TAccess AccessType, uint32_t SPIClock)
+{
+  TTiming Result;
+  TSimSPIStatistics Start;
+  uint64_t Begin;
+  uint64_t Blocked;
+  uint64_t Latency;
+  uint32_t Count;
+  uint32_t n;
+
+  SimSetSPIClock(SPIClock);
+  Blocked=0;
+  Latency=0;
+  Start=SimSPIStatistics;
+  for(n=0; n<REPEAT; n++)
+  {
+    SimAdvance(SIM_CYCLES_PER_MS);   //all posted writes done
+
+    SimSetDatagramLog(Log, sizeof(Log)/sizeof(Log[0]));
+    Begin=SimCycles;
+    Access(AccessType, 1000*n+1);
+    Blocked+=SimCycles-Begin;
+    SimAdvance(SIM_CYCLES_PER_MS);
+
+    Count=SimGetDatagramCount();
+    if(Count>0) Latency+=Log[Count-1].Time-Begin;
+  }
+  SimSetDatagramLog(NULL, 0);
+
+  //Interrupts while the caller was blocked are already in Blocked
+  Result.CPU=(double) (Blocked+SimSPIStatistics.InterruptCycles-Start.InterruptCycles)/REPEAT/(SIM_CPU_CLOCK/1000000);
+  Result.Latency=(double) Latency/REPEAT/(SIM_CPU_CLOCK/1000000);
+  Result.Frames=(double) (SimSPIStatistics.Frames-Start.Frames)/REPEAT;
+
+  return Result;
+}
+
+
+int main(void)
+{
+  static const uint32_t Clocks[2]={1000000, 4000000};
+  TTiming Timing[2];
+  uint32_t Type;
+  uint32_t i;
+
+  printf("Time per access, %u driver(s) (%u bytes per frame), CPU %lu MHz\n", N_O_MOTORS, 5*N_O_MOTORS, SIM_CPU_CLOCK/1000000);
+  printf("%-36s %29s %29s\n", "", "1 MHz", "4 MHz");
+  printf("%-36s %8s %11s %8s %8s %11s %8s\n", "", "CPU/µs", "latency/µs", "frames", "CPU/µs", "latency/µs", "frames");
+  for(Type=0; Type<N_ACCESSES; Type++)
+  {
+    for(i=0; i<2; i++) Timing[i]=Measure(Type, Clocks[i]);
+    printf("%-36s %8.1f %11.1f %8.1f %8.1f %11.1f %8.1f\n", AccessNames[Type],
+           Timing[0].CPU, Timing[0].Latency, Timing[0].Frames, Timing[1].CPU, Timing[1].Latency, Timing[1].Frames);
+  }
+
+  return 0;
+}
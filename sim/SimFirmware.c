@@ -0,0 +1,333 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file SimFirmware.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: SimFirmware.c
+ *         Description: Host simulation of the whole firmware
+ *
+ *                      Runs the unchanged firmware (all modules except
+ *                      Homebus.c and SysTick.c, HomebusSlave.c compiled
+ *                      with -Dmain=FirmwareMain) as a coroutine against
+ *                      the daisy chain model of SimTMC5130.c and the
+ *                      emulated flash of SimFlash.c. The other
+ *                      peripherals are stubbed here:
+ *                      - Homebus: HomebusGetData() returns the command
+ *                        given to SimCommand() and hands control back to
+ *                        the test after every main loop pass,
+ *                        HomebusSendData() collects the reply frames
+ *                        (transmission time is not modelled).
+ *                      - TMR0 (PVT interpolator) runs as the periodic
+ *                        interrupt of SimTMC5130.c.
+ *                      - GPIO: the DIAG inputs are inactive (high).
+ *                      - I2C: the MAX31875 reads 25°C.
+ *
+ *                      Every main loop pass costs SIM_LOOP_CYCLES of CPU
+ *                      time plus the time of its SPI accesses.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "max32660.h"
+#include "mxc_errors.h"
+#include "gpio.h"
+#include "tmr.h"
+#include "i2c.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "Homebus.h"
+#include "Globals.h"
+#include "SimTMC5130.h"
+#include "SimFirmware.h"
+
+#define SIM_STACK_SIZE     (1024*1024)   //!< stack of the firmware coroutine
+#define SIM_REPLY_TIMEOUT  10000         //!< main loop passes to wait for a reply
+
+void FirmwareMain();                     //main() of HomebusSlave.c
+void TMR0_IRQHandler(void);
+
+static ucontext_t HarnessContext;
+static ucontext_t FirmwareContext;
+static uint8_t *FirmwareStack;
+static uint32_t LoopCount;
+
+static uint8_t CommandFrame[9];          //!< command for the next HomebusGetData() call
+static uint8_t CommandPending;
+static uint8_t ReplyFrames[SIM_REPLY_FRAMES][9];
+static uint32_t ReplyCount;
+
+static uint32_t GPIOOutputs;
+static uint32_t TimerCompare;
+
+
+/***************************************************************//**
+   \fn FirmwareEntry(void)
+   \brief Start function of the firmware coroutine
+********************************************************************/
+static void FirmwareEntry(void)
+{
+  FirmwareMain();
+
+  fprintf(stderr, "SimFirmware: main() has returned\n");
+  exit(1);
+}
+
+
+/***************************************************************//**
+   \fn SimFirmwareStart(void)
+   \brief Start the firmware and run its initialisation
+********************************************************************/
+void SimFirmwareStart(void)
+{
+  FirmwareStack=malloc(SIM_STACK_SIZE);
+  getcontext(&FirmwareContext);
+  FirmwareContext.uc_stack.ss_sp=FirmwareStack;
+  FirmwareContext.uc_stack.ss_size=SIM_STACK_SIZE;
+  FirmwareContext.uc_link=NULL;
+  makecontext(&FirmwareContext, FirmwareEntry, 0);
+
+  swapcontext(&HarnessContext, &FirmwareContext);
+}
+
+
+/***************************************************************//**
+   \fn SimRunLoop(uint32_t Passes)
+   \brief Let the firmware run some main loop passes
+********************************************************************/
+void SimRunLoop(uint32_t Passes)
+{
+  while(Passes-- > 0) swapcontext(&HarnessContext, &FirmwareContext);
+}
+
+
+/***************************************************************//**
+   \fn SimRunTime(uint32_t Milliseconds)
+   \brief Let the firmware run for some time
+********************************************************************/
+void SimRunTime(uint32_t Milliseconds)
+{
+  uint64_t End;
+
+  End=SimCycles+(uint64_t) Milliseconds*SIM_CYCLES_PER_MS;
+  while(SimCycles<End) swapcontext(&HarnessContext, &FirmwareContext);
+}
+
+
+/***************************************************************//**
+   \fn SimGetLoopCount(void)
+   \return Number of main loop passes so far
+********************************************************************/
+uint32_t SimGetLoopCount(void)
+{
+  return LoopCount;
+}
+
+
+/***************************************************************//**
+   \fn SimCommand(uint8_t Opcode, uint8_t Type, uint8_t Motor, int Value, int *ReplyValue)
+   \brief Send a TMCL command to the firmware and wait for the reply
+   \param ReplyValue: value of the (first) reply frame (NULL: not needed)
+   \return Status of the (first) reply frame, 0 if there is no reply
+
+   All frames of the reply are kept (see SimGetReplyFrames()).
+********************************************************************/
+uint8_t SimCommand(uint8_t Opcode, uint8_t Type, uint8_t Motor, int Value, int *ReplyValue)
+{
+  uint32_t Passes;
+  uint32_t Count;
+  uint32_t i;
+
+  CommandFrame[0]=ModuleAddress;
+  CommandFrame[1]=Opcode;
+  CommandFrame[2]=Type;
+  CommandFrame[3]=Motor;
+  CommandFrame[4]=Value >> 24;
+  CommandFrame[5]=Value >> 16;
+  CommandFrame[6]=Value >> 8;
+  CommandFrame[7]=Value & 0xff;
+  CommandFrame[8]=0;
+  for(i=0; i<8; i++) CommandFrame[8]+=CommandFrame[i];
+  CommandPending=TRUE;
+  ReplyCount=0;
+
+  //Run until the reply is complete (no more frames in a pass)
+  for(Passes=0; Passes<SIM_REPLY_TIMEOUT; Passes++)
+  {
+    Count=ReplyCount;
+    SimRunLoop(1);
+    if(ReplyCount>0 && ReplyCount==Count && !CommandPending) break;
+  }
+  if(ReplyCount==0) return 0;
+
+  if(ReplyValue!=NULL)
+    *ReplyValue=(ReplyFrames[0][4]<<24)|(ReplyFrames[0][5]<<16)|(ReplyFrames[0][6]<<8)|ReplyFrames[0][7];
+
+  return ReplyFrames[0][2];
+}
+
+
+/***************************************************************//**
+   \fn SimGetReplyFrames(uint8_t (**Frames)[9])
+   \brief Get all frames of the last reply
+   \return Number of frames
+********************************************************************/
+uint32_t SimGetReplyFrames(uint8_t (**Frames)[9])
+{
+  *Frames=ReplyFrames;
+  return ReplyCount;
+}
+
+
+/* Homebus (replaces ../Homebus.c) */
+void HomebusInit(uint32_t Baudrate, uint8_t LineCode)
+{
+  (void) Baudrate; (void) LineCode;
+}
+
+uint8_t HomebusGetData(uint8_t *data)
+{
+  //End of a main loop pass: back to the test
+  SimAdvance(SIM_LOOP_CYCLES);
+  LoopCount++;
+  swapcontext(&FirmwareContext, &HarnessContext);
+
+  if(!CommandPending) return FALSE;
+
+  memcpy(data, CommandFrame, 9);
+  CommandPending=FALSE;
+
+  return TRUE;
+}
+
+void HomebusSendData(uint8_t *data)
+{
+  if(ReplyCount<SIM_REPLY_FRAMES) memcpy(ReplyFrames[ReplyCount], data, 9);
+  ReplyCount++;
+}
+
+uint8_t HomebusSendBusy(void)
+{
+  //Main loop pass sending a further frame of a special reply
+  SimAdvance(SIM_LOOP_CYCLES);
+  LoopCount++;
+
+  return FALSE;
+}
+
+uint32_t GetHomebusOverrunCount(void)
+{
+  return 0;
+}
+
+
+/* GPIO driver */
+int GPIO_Config(const gpio_cfg_t *cfg)
+{
+  (void) cfg;
+  return E_NO_ERROR;
+}
+
+uint32_t GPIO_InGet(const gpio_cfg_t *cfg)
+{
+  return cfg->mask;   //DIAG outputs inactive (high)
+}
+
+void GPIO_OutSet(const gpio_cfg_t *cfg)
+{
+  GPIOOutputs|=cfg->mask;
+}
+
+void GPIO_OutClr(const gpio_cfg_t *cfg)
+{
+  GPIOOutputs&= ~cfg->mask;
+}
+
+uint32_t GPIO_OutGet(const gpio_cfg_t *cfg)
+{
+  return GPIOOutputs & cfg->mask;
+}
+
+int GPIO_IntConfig(const gpio_cfg_t *cfg, gpio_int_mode_t mode, gpio_int_pol_t pol)
+{
+  (void) cfg; (void) mode; (void) pol;
+  return E_NO_ERROR;
+}
+
+void GPIO_IntEnable(const gpio_cfg_t *cfg)
+{
+  (void) cfg;
+}
+
+void GPIO_IntClr(const gpio_cfg_t *cfg)
+{
+  (void) cfg;
+}
+
+void GPIO_RegisterCallback(const gpio_cfg_t *cfg, gpio_callback_fn callback, void *cbdata)
+{
+  (void) cfg; (void) callback; (void) cbdata;
+}
+
+void GPIO_Handler(unsigned int port)
+{
+  (void) port;
+}
+
+
+/* TMR driver (TMR0: PVT interpolator) */
+int TMR_Init(mxc_tmr_regs_t *tmr, tmr_pres_t pres, const sys_cfg_tmr_t *sys_cfg)
+{
+  (void) tmr; (void) pres; (void) sys_cfg;
+  return E_NO_ERROR;
+}
+
+int TMR_Config(mxc_tmr_regs_t *tmr, const tmr_cfg_t *cfg)
+{
+  (void) tmr;
+  TimerCompare=cfg->cmp_cnt;
+  return E_NO_ERROR;
+}
+
+void TMR_Enable(mxc_tmr_regs_t *tmr)
+{
+  (void) tmr;
+  SimSetTimerInterrupt(TMR0_IRQHandler, (uint64_t) TimerCompare*(SIM_CPU_CLOCK/PeripheralClock));
+}
+
+void TMR_IntClear(mxc_tmr_regs_t *tmr)
+{
+  (void) tmr;
+}
+
+
+/* I2C driver (MAX31875) */
+int I2C_Init(mxc_i2c_regs_t *i2c, i2c_speed_t i2cspeed, const sys_cfg_i2c_t *sys_cfg)
+{
+  (void) i2c; (void) i2cspeed; (void) sys_cfg;
+  return E_NO_ERROR;
+}
+
+int I2C_MasterWrite(mxc_i2c_regs_t *i2c, uint8_t addr, const uint8_t *data, int len, int restart)
+{
+  (void) i2c; (void) addr; (void) data; (void) restart;
+  return len;
+}
+
+int I2C_MasterRead(mxc_i2c_regs_t *i2c, uint8_t addr, uint8_t *data, int len, int restart)
+{
+  (void) i2c; (void) addr; (void) restart;
+  if(len>=2)
+  {
+    data[0]=25;   //25°C
+    data[1]=0;
+  }
+  return len;
+}
@@ -0,0 +1,31 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file SimFirmware.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: SimFirmware.h
+ *         Description: Host simulation of the whole firmware (see SimFirmware.c)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __SIM_FIRMWARE_H
+#define __SIM_FIRMWARE_H
+
+#include <stdint.h>
+
+#define SIM_LOOP_CYCLES   1500    //!< CPU time of one main loop pass besides the SPI accesses (estimate)
+#define SIM_REPLY_FRAMES  64      //!< maximum number of frames of a reply kept by SimCommand()
+
+void SimFirmwareStart(void);
+void SimRunLoop(uint32_t Passes);
+void SimRunTime(uint32_t Milliseconds);
+uint32_t SimGetLoopCount(void);
+uint8_t SimCommand(uint8_t Opcode, uint8_t Type, uint8_t Motor, int Value, int *ReplyValue);
+uint32_t SimGetReplyFrames(uint8_t (**Frames)[9]);
+
+#endif
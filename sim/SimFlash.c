@@ -0,0 +1,215 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file SimFlash.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: SimFlash.c
+ *         Description: Emulated flash of the parameter store
+ *
+ *                      Replaces the FLC driver for ../ParamStore.c. The
+ *                      pages of the parameter store are mapped at their
+ *                      real address (PS_START), as ParamStore.c reads the
+ *                      flash through pointers. Like the real flash a
+ *                      write can only clear bits, an erase sets the whole
+ *                      page to 0xff. Erases are counted per page.
+ *
+ *                      SimFlashPowerFail() emulates a reset during a
+ *                      flash operation: the selected operation is torn
+ *                      (a write programs a random part of its bits or
+ *                      all of them, an erase erases only a random part
+ *                      of the page) and all further operations fail
+ *                      until SimFlashPowerOn().
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "max32660.h"
+#include "mxc_errors.h"
+#include "flc.h"
+#include "ParamStore.h"
+#include "SimFlash.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define SIM_FLASH_SIZE (PS_PAGES*MXC_FLASH_PAGE_SIZE)
+
+TSimFlashStatistics SimFlashStatistics;
+
+static uint8_t *Flash;                     //!< emulated pages (mapped at PS_START)
+static uint32_t PageErases[PS_PAGES];      //!< erase cycles of every page
+static uint8_t FailArmed;                  //!< a power failure is pending
+static uint32_t FailCountdown;             //!< operations until the power failure
+static uint8_t PowerDown;                  //!< power has failed, all operations fail
+static uint32_t RandomState;               //!< state of the random generator for torn operations
+
+
+/***************************************************************//**
+   \fn SimFlashInit(void)
+   \brief Map the emulated flash at PS_START (erased)
+
+   Only the first call maps the memory, the flash contents are kept
+   over further calls (like over a reset of the MCU).
+********************************************************************/
+void SimFlashInit(void)
+{
+  void *Memory;
+
+  if(Flash!=NULL) return;
+
+  Memory=mmap((void *) PS_START, SIM_FLASH_SIZE, PROT_READ|PROT_WRITE,
+              MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE, -1, 0);
+  if(Memory!=(void *) PS_START)
+  {
+    fprintf(stderr, "SimFlash: cannot map the flash at 0x%08lx\n", (unsigned long) PS_START);
+    exit(1);
+  }
+  Flash=Memory;
+  memset(Flash, 0xff, SIM_FLASH_SIZE);
+}
+
+
+/***************************************************************//**
+   \fn SimFlashPageErases(uint32_t Page)
+   \return Number of erase cycles of a page (0..PS_PAGES-1)
+********************************************************************/
+uint32_t SimFlashPageErases(uint32_t Page)
+{
+  return (Page<PS_PAGES) ? PageErases[Page] : 0;
+}
+
+
+/***************************************************************//**
+   \fn SimFlashPowerFail(uint32_t Operations, uint32_t Seed)
+   \brief Let the power fail during a flash operation
+   \param Operations: number of operations completed before the torn one
+   \param Seed: seed of the random part of the torn operation
+********************************************************************/
+void SimFlashPowerFail(uint32_t Operations, uint32_t Seed)
+{
+  FailArmed=TRUE;
+  FailCountdown=Operations;
+  RandomState=Seed|1;
+}
+
+
+/***************************************************************//**
+   \fn SimFlashPowerOn(void)
+   \brief Power on again after a power failure (cancels a pending one)
+********************************************************************/
+void SimFlashPowerOn(void)
+{
+  FailArmed=FALSE;
+  PowerDown=FALSE;
+}
+
+
+/***************************************************************//**
+   \fn SimFlashPowerIsDown(void)
+   \return TRUE if the power has failed (see SimFlashPowerFail())
+********************************************************************/
+uint8_t SimFlashPowerIsDown(void)
+{
+  return PowerDown;
+}
+
+
+static uint32_t Random(void)
+{
+  RandomState^=RandomState<<13;
+  RandomState^=RandomState>>17;
+  RandomState^=RandomState<<5;
+
+  return RandomState;
+}
+
+//! TRUE if the power fails during this operation
+static uint8_t PowerFails(void)
+{
+  if(!FailArmed) return FALSE;
+  if(FailCountdown>0)
+  {
+    FailCountdown--;
+    return FALSE;
+  }
+  FailArmed=FALSE;
+  PowerDown=TRUE;
+  SimFlashStatistics.PowerFails++;
+
+  return TRUE;
+}
+
+
+/* FLC driver (only the functions used by the firmware) */
+int FLC_Init(const sys_cfg_flc_t *sys_cfg)
+{
+  (void) sys_cfg;
+  SimFlashInit();
+
+  return E_NO_ERROR;
+}
+
+int FLC_PageErase(uint32_t address)
+{
+  uint32_t Offset;
+
+  if(address<PS_START || address>=PS_START+SIM_FLASH_SIZE || (address % MXC_FLASH_PAGE_SIZE)!=0) return E_BAD_PARAM;
+
+  if(PowerDown) return E_BAD_STATE;
+
+  Offset=address-PS_START;
+  PageErases[Offset/MXC_FLASH_PAGE_SIZE]++;
+  SimFlashStatistics.Erases++;
+  if(PowerFails())
+  {
+    //Torn erase: every word erased with a random probability, the others keep some of their zero bits
+    uint32_t *Word;
+    uint32_t Erased;
+    uint32_t i;
+
+    Word=(uint32_t *) (Flash+Offset);
+    Erased=Random() & 0xff;
+    for(i=0; i<MXC_FLASH_PAGE_SIZE/4; i++)
+    {
+      if((Random() & 0xff)<Erased) Word[i]=0xffffffff;
+      else if(Random() & 1) Word[i]|=Random();
+    }
+    return E_BAD_STATE;
+  }
+  memset(Flash+Offset, 0xff, MXC_FLASH_PAGE_SIZE);
+
+  return E_NO_ERROR;
+}
+
+int FLC_Write128(uint32_t address, uint32_t *data)
+{
+  uint32_t *Target;
+  uint32_t i;
+  uint8_t Complete;
+
+  if(address<PS_START || address+16>PS_START+SIM_FLASH_SIZE || (address & 0x0f)!=0) return E_BAD_PARAM;
+
+  if(PowerDown) return E_BAD_STATE;
+
+  Target=(uint32_t *) (Flash+(address-PS_START));
+  SimFlashStatistics.Writes++;
+  if(PowerFails())
+  {
+    //Torn write: only a random part of the bits is programmed (every fourth time all of them)
+    Complete=(Random() % 4)==0;
+    for(i=0; i<4; i++) Target[i]&=data[i] | (Complete ? 0 : Random());
+    return E_BAD_STATE;
+  }
+  for(i=0; i<4; i++) Target[i]&=data[i];
+
+  return E_NO_ERROR;
+}
@@ -0,0 +1,37 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file SimFlash.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: SimFlash.h
+ *         Description: Emulated flash of the parameter store (see SimFlash.c)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __SIM_FLASH_H
+#define __SIM_FLASH_H
+
+#include <stdint.h>
+
+//! Flash statistics
+typedef struct
+{
+  uint32_t Erases;          //!< page erase cycles
+  uint32_t Writes;          //!< 128 bit writes
+  uint32_t PowerFails;      //!< torn operations (see SimFlashPowerFail())
+} TSimFlashStatistics;
+
+extern TSimFlashStatistics SimFlashStatistics;
+
+void SimFlashInit(void);
+uint32_t SimFlashPageErases(uint32_t Page);
+void SimFlashPowerFail(uint32_t Operations, uint32_t Seed);
+void SimFlashPowerOn(void);
+uint8_t SimFlashPowerIsDown(void);
+
+#endif
@@ -0,0 +1,886 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file SimTMC5130.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: SimTMC5130.c
+ *         Description: Host simulation of the TMC5130 daisy chain
+ *
+ *                      Used together with ../TMC5130.c compiled with
+ *                      -DTMC5130_SIMULATION (and -Ihost before ../lib/inc):
+ *
+ *                      - Simulated time (CPU cycles of the MAX32660) for
+ *                        GetSysTimer() and GetCycleCounter(). Time only
+ *                        advances by SPI transfers, interrupts, polling
+ *                        of GetSysTimer() and SimAdvance().
+ *                      - Interrupts: completion of posted SPI frames
+ *                        (SPIMSS_MasterTransAsync()) and one periodic
+ *                        timer. They are delivered when they are due and
+ *                        __enable_irq() is not locked.
+ *                      - The daisy chain: every driver has a 40 bit shift
+ *                        register and receives the datagram that is in it
+ *                        when the frame ends, so the slot assignment of
+ *                        the firmware is checked, not assumed. A read
+ *                        returns its data with the next datagram, a write
+ *                        echoes the written data with the next datagram.
+ *                      - The registers of one driver with the access
+ *                        rights of the data sheet (TMC5130 or TMC5160,
+ *                        -DDEVTYPE_TMC5160), read-clear and write-1-clear
+ *                        flags and the SPI status byte.
+ *                      - A simple ramp generator (positioning and velocity
+ *                        mode, VMAX and AMAX only) for XACTUAL, VACTUAL
+ *                        and the status flags.
+ *
+ *                      Timing model (estimates, not measured): a blocking
+ *                      frame takes SIM_SPI_SETUP_CYCLES plus 8 SPI clocks
+ *                      per byte, starting a posted frame takes
+ *                      SIM_ASYNC_START_CYCLES of CPU time and its
+ *                      completion interrupt SIM_ASYNC_IRQ_CYCLES.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "max32660.h"
+#include "spimss.h"
+#include "mxc_errors.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "TMC5130.h"
+#include "SysTick.h"
+#include "SimTMC5130.h"
+
+#define SIM_SPI_SETUP_CYCLES    60     //!< CPU cycles per blocking frame besides the transfer (FIFO setup, slave select)
+#define SIM_ASYNC_START_CYCLES  250    //!< CPU cycles of SPIMSS_MasterTransAsync()
+#define SIM_ASYNC_IRQ_CYCLES    400    //!< CPU cycles of the SPI interrupt (SPIMSS driver and callback)
+#define SIM_TIMER_IRQ_CYCLES    60     //!< CPU cycles of the timer interrupt
+#define SIM_POLL_CYCLES         20     //!< CPU cycles per call of GetSysTimer()
+#define SIM_MOTION_STEP_CYCLES  960    //!< time step of the ramp generator model (10µs)
+
+#if defined(TMC5130_FCLK)
+#define SIM_FCLK ((double) TMC5130_FCLK)
+#elif defined(DEVTYPE_TMC5160)
+#define SIM_FCLK 12000000.0            //!< internal clock of the TMC5160 (typical)
+#else
+#define SIM_FCLK 12500000.0            //!< internal clock of the TMC5130 (typical)
+#endif
+#define SIM_VELOCITY_UNIT (SIM_FCLK/16777216.0)                        //!< pps per internal velocity unit
+#define SIM_ACCELERATION_UNIT (SIM_FCLK*SIM_FCLK/2199023255552.0)     //!< pps/s per internal acceleration unit (fClk^2/2^41)
+
+#define RAMPSTAT_EVENT_FLAGS (BIT12|BIT7|BIT6|BIT3|BIT2)   //!< R+C (TMC5130) or R+WC (TMC5160) flags of RAMP_STAT
+
+//! State of one simulated driver
+typedef struct
+{
+  int Registers[128];        //!< written values and event flags
+  uint32_t ReplyData;        //!< data sent with the next datagram
+  double Position;           //!< XACTUAL (microsteps)
+  double Velocity;           //!< actual velocity (pps)
+  uint8_t TargetReached;     //!< TRUE while XACTUAL==XTARGET in positioning mode
+  uint64_t MotionTime;       //!< time up to which the ramp generator has been calculated
+} TSimDriver;
+
+uint64_t SimCycles;                       //!< simulated time (CPU cycles)
+TSimSPIStatistics SimSPIStatistics;
+uint32_t SystemCoreClock=SIM_CPU_CLOCK;
+mxc_spimss_regs_t SimSPIMSSRegisters;     //!< dummy SPIMSS registers (see host/max32660.h)
+
+static TSimDriver Drivers[N_O_DRIVERS];
+static uint8_t DriversInitialised;
+static uint32_t SPIClock=TMC5130_SPI_FREQUENCY;
+static uint8_t IrqLocked;
+static uint8_t InInterrupt;
+
+static spimss_req_t *AsyncRequest;        //!< posted frame being sent (NULL: none)
+static uint64_t AsyncDue;                 //!< end of the posted frame
+static uint32_t AsyncStartPeriod;         //!< every n-th start fails (0: never)
+static uint32_t AsyncCompletionPeriod;    //!< every n-th completion fails (0: never)
+static uint32_t AsyncStartCount;
+static uint32_t AsyncCompletionCount;
+
+static void (*TimerHandler)(void);
+static uint64_t TimerPeriod;
+static uint64_t TimerDue;
+
+static TSimDatagram *DatagramLog;
+static uint32_t DatagramLogSize;
+static uint32_t DatagramCount;
+
+static void DeliverInterrupts(void);
+
+
+/***************************************************************//**
+   \fn SimRegisterAccess(uint8_t Address)
+   \brief Access rights of a register according to the data sheet
+   \return SIM_ACC_xxx flags (0: register does not exist)
+
+   This table is kept independent of the register table of
+   ../TMC5130.c, so that the two can be checked against each other.
+********************************************************************/
+uint8_t SimRegisterAccess(uint8_t Address)
+{
+  switch(Address)
+  {
+    case 0x00: return SIM_ACC_R|SIM_ACC_W;       //GCONF
+    case 0x01: return SIM_ACC_R|SIM_ACC_WC;      //GSTAT
+    case 0x02: return SIM_ACC_R;                 //IFCNT
+    case 0x03: return SIM_ACC_W;                 //SLAVECONF
+    case 0x04: return SIM_ACC_R;                 //IOIN
+    case 0x05: return SIM_ACC_W;                 //X_COMPARE
+#if defined(DEVTYPE_TMC5160)
+    case 0x06: return SIM_ACC_W;                 //OTP_PROG
+    case 0x07: return SIM_ACC_R;                 //OTP_READ
+    case 0x08: return SIM_ACC_R|SIM_ACC_W;       //FACTORY_CONF
+    case 0x09:                                   //SHORT_CONF
+    case 0x0A:                                   //DRV_CONF
+    case 0x0B: return SIM_ACC_W;                 //GLOBAL_SCALER
+    case 0x0C: return SIM_ACC_R;                 //OFFSET_READ
+#endif
+    case 0x10:                                   //IHOLD_IRUN
+    case 0x11: return SIM_ACC_W;                 //TPOWERDOWN
+    case 0x12: return SIM_ACC_R;                 //TSTEP
+    case 0x13:                                   //TPWMTHRS
+    case 0x14:                                   //TCOOLTHRS
+    case 0x15: return SIM_ACC_W;                 //THIGH
+    case 0x20:                                   //RAMPMODE
+    case 0x21: return SIM_ACC_R|SIM_ACC_W;       //XACTUAL
+    case 0x22: return SIM_ACC_R;                 //VACTUAL
+    case 0x23: case 0x24: case 0x25: case 0x26:  //VSTART, A1, V1, AMAX
+    case 0x27: case 0x28: case 0x2A: case 0x2B:  //VMAX, DMAX, D1, VSTOP
+    case 0x2C: return SIM_ACC_W;                 //TZEROWAIT
+    case 0x2D: return SIM_ACC_R|SIM_ACC_W;       //XTARGET
+    case 0x33: return SIM_ACC_W;                 //VDCMIN
+    case 0x34: return SIM_ACC_R|SIM_ACC_W;       //SW_MODE
+#if defined(DEVTYPE_TMC5160)
+    case 0x35: return SIM_ACC_R|SIM_ACC_WC;      //RAMP_STAT
+#else
+    case 0x35: return SIM_ACC_R|SIM_ACC_RC;      //RAMP_STAT
+#endif
+    case 0x36: return SIM_ACC_R;                 //XLATCH
+    case 0x38:                                   //ENCMODE
+    case 0x39: return SIM_ACC_R|SIM_ACC_W;       //X_ENC
+    case 0x3A: return SIM_ACC_W;                 //ENC_CONST
+#if defined(DEVTYPE_TMC5160)
+    case 0x3B: return SIM_ACC_R|SIM_ACC_WC;      //ENC_STATUS
+#else
+    case 0x3B: return SIM_ACC_R|SIM_ACC_RC;      //ENC_STATUS
+#endif
+    case 0x3C: return SIM_ACC_R;                 //ENC_LATCH
+#if defined(DEVTYPE_TMC5160)
+    case 0x3D: return SIM_ACC_W;                 //ENC_DEVIATION
+#endif
+    case 0x60: case 0x61: case 0x62: case 0x63:  //MSLUT0..3
+    case 0x64: case 0x65: case 0x66: case 0x67:  //MSLUT4..7
+    case 0x68:                                   //MSLUTSEL
+    case 0x69: return SIM_ACC_W;                 //MSLUTSTART
+    case 0x6A:                                   //MSCNT
+    case 0x6B: return SIM_ACC_R;                 //MSCURACT
+    case 0x6C: return SIM_ACC_R|SIM_ACC_W;       //CHOPCONF
+    case 0x6D:                                   //COOLCONF
+    case 0x6E: return SIM_ACC_W;                 //DCCTRL
+    case 0x6F: return SIM_ACC_R;                 //DRV_STATUS
+    case 0x70: return SIM_ACC_W;                 //PWMCONF
+    case 0x71: return SIM_ACC_R;                 //PWM_SCALE
+#if defined(DEVTYPE_TMC5160)
+    case 0x72: return SIM_ACC_R;                 //PWM_AUTO
+#else
+    case 0x72: return SIM_ACC_W;                 //ENCM_CTRL
+#endif
+    case 0x73: return SIM_ACC_R;                 //LOST_STEPS
+    default:   return 0;
+  }
+}
+
+
+/***************************************************************//**
+   \fn EventFlagMask(uint8_t Address)
+   \return Flags of a register that are cleared by reading or by
+           writing 1 (see SIM_ACC_RC and SIM_ACC_WC)
+********************************************************************/
+static uint32_t EventFlagMask(uint8_t Address)
+{
+  switch(Address)
+  {
+    case 0x01: return BIT2|BIT1|BIT0;
+    case 0x35: return RAMPSTAT_EVENT_FLAGS;
+#if defined(DEVTYPE_TMC5160)
+    case 0x3B: return BIT1|BIT0;
+#else
+    case 0x3B: return BIT0;
+#endif
+    default:   return 0;
+  }
+}
+
+
+/***************************************************************//**
+   \fn SimRegisterWriteMask(uint8_t Address)
+   \brief Implemented bits of a register according to the data sheet
+   \return Mask of the bits a write sets (the others read as 0)
+
+   Values written to a register are truncated to these bits, as the
+   driver does. This makes writes of values that do not fit into a
+   register field visible to the tests.
+********************************************************************/
+uint32_t SimRegisterWriteMask(uint8_t Address)
+{
+  switch(Address)
+  {
+#if defined(DEVTYPE_TMC5160)
+    case 0x00: return 0x0003ffff;                //GCONF
+    case 0x09: return 0x00070f0f;                //SHORT_CONF
+    case 0x0A: return 0x003f0f1f;                //DRV_CONF
+    case 0x0B: return 0x000000ff;                //GLOBAL_SCALER
+#else
+    case 0x00: return 0x0001ffff;                //GCONF
+#endif
+    case 0x03: return 0x00000fff;                //SLAVECONF
+    case 0x10: return 0x000f1f1f;                //IHOLD_IRUN
+    case 0x11: return 0x000000ff;                //TPOWERDOWN
+    case 0x13:                                   //TPWMTHRS
+    case 0x14:                                   //TCOOLTHRS
+    case 0x15: return 0x000fffff;                //THIGH
+    case 0x20: return 0x00000003;                //RAMPMODE
+    case 0x23: return 0x0003ffff;                //VSTART
+    case 0x24: return 0x0000ffff;                //A1
+    case 0x25: return 0x000fffff;                //V1
+    case 0x26: return 0x0000ffff;                //AMAX
+    case 0x27: return 0x007fffff;                //VMAX
+    case 0x28: return 0x0000ffff;                //DMAX
+    case 0x2A: return 0x0000ffff;                //D1
+    case 0x2B: return 0x0003ffff;                //VSTOP
+    case 0x2C: return 0x0000ffff;                //TZEROWAIT
+    case 0x33: return 0x007fffff;                //VDCMIN
+    case 0x34: return 0x00000fff;                //SW_MODE
+    case 0x38: return 0x000007ff;                //ENCMODE
+#if defined(DEVTYPE_TMC5160)
+    case 0x3D: return 0x000fffff;                //ENC_DEVIATION
+#endif
+    case 0x69: return 0x00ff00ff;                //MSLUTSTART
+    case 0x6D: return 0x01ffffff;                //COOLCONF
+    case 0x6E: return 0x00ff03ff;                //DCCTRL
+#if !defined(DEVTYPE_TMC5160)
+    case 0x70: return 0x003fffff;                //PWMCONF
+    case 0x72: return 0x00000003;                //ENCM_CTRL
+#endif
+    default:   return 0xffffffff;
+  }
+}
+
+
+/***************************************************************//**
+   \fn SimResetTMC5130(uint8_t Which5130)
+   \brief Power-on reset of one driver (reset values of the data sheet)
+********************************************************************/
+void SimResetTMC5130(uint8_t Which5130)
+{
+  static const int MSLUTDefaults[10]={0xAAAAB554, 0x4A9554AA, 0x24492929, 0x10104222, 0xFBFFFFFF,
+                                      0xB5BB777D, 0x49295556, 0x00404222, 0xFFFF8056, 0x00F70000};
+  TSimDriver *Driver;
+  uint32_t i;
+
+  Driver=&Drivers[Which5130];
+  memset(Driver, 0, sizeof(*Driver));
+  Driver->MotionTime=SimCycles;
+  Driver->TargetReached=TRUE;
+
+  Driver->Registers[TMC5130_GSTAT]=BIT0;
+  Driver->Registers[TMC5130_ENC_CONST]=0x00010000;
+  for(i=0; i<10; i++) Driver->Registers[TMC5130_MSLUT0+i]=MSLUTDefaults[i];
+#if defined(DEVTYPE_TMC5160)
+  Driver->Registers[TMC5130_GCONF]=BIT3;
+  Driver->Registers[TMC5130_IOIN]=0x30<<24;
+  Driver->Registers[TMC5160_FACTORY_CONF]=0x0F;
+  Driver->Registers[TMC5160_OFFSET_READ]=0x8080;
+  Driver->Registers[TMC5130_CHOPCONF]=0x10410150;
+  Driver->Registers[TMC5130_PWMCONF]=0xC40C001E;
+  Driver->Registers[TMC5130_TPOWERDOWN]=10;
+#else
+  Driver->Registers[TMC5130_IOIN]=0x11<<24;
+  Driver->Registers[TMC5130_PWMCONF]=0x00050480;
+#endif
+}
+
+
+/***************************************************************//**
+   \fn InitDrivers(void)
+   \brief Power-on reset of all drivers before their first use
+********************************************************************/
+static void InitDrivers(void)
+{
+  uint32_t i;
+
+  if(DriversInitialised) return;
+
+  for(i=0; i<N_O_DRIVERS; i++) SimResetTMC5130(i);
+  DriversInitialised=TRUE;
+}
+
+
+/***************************************************************//**
+   \fn TargetVelocity(const TSimDriver *Driver)
+   \return Velocity (pps) the ramp generator is heading for
+********************************************************************/
+static double TargetVelocity(const TSimDriver *Driver)
+{
+  double VMax;
+  double Distance;
+  double Acceleration;
+  double Limit;
+
+  VMax=(Driver->Registers[TMC5130_VMAX] & 0x7fffff)*SIM_VELOCITY_UNIT;
+  switch(Driver->Registers[TMC5130_RAMPMODE] & 0x03)
+  {
+    case TMC5130_MODE_POSITION:
+      Distance=(double) Driver->Registers[TMC5130_XTARGET]-Driver->Position;
+      Acceleration=(Driver->Registers[TMC5130_AMAX] & 0xffff)*SIM_ACCELERATION_UNIT;
+      Limit=(Acceleration>0) ? sqrt(2.0*Acceleration*fabs(Distance)) : VMax;
+      if(Limit>VMax) Limit=VMax;
+      return (Distance>=0) ? Limit : -Limit;
+
+    case TMC5130_MODE_VELPOS:
+      return VMax;
+
+    case TMC5130_MODE_VELNEG:
+      return -VMax;
+
+    default:
+      return Driver->Velocity;
+  }
+}
+
+
+/***************************************************************//**
+   \fn UpdateMotion(TSimDriver *Driver)
+   \brief Run the ramp generator model up to the actual time
+********************************************************************/
+static void UpdateMotion(TSimDriver *Driver)
+{
+  uint64_t Cycles;
+  double Dt;
+  double Target;
+  double DeltaV;
+  double Before;
+  int XTarget;
+
+  while(Driver->MotionTime<SimCycles)
+  {
+    Cycles=SimCycles-Driver->MotionTime;
+    if(Cycles>SIM_MOTION_STEP_CYCLES) Cycles=SIM_MOTION_STEP_CYCLES;
+    Driver->MotionTime+=Cycles;
+    Dt=(double) Cycles/SIM_CPU_CLOCK;
+
+    Target=TargetVelocity(Driver);
+    DeltaV=(Driver->Registers[TMC5130_AMAX] & 0xffff)*SIM_ACCELERATION_UNIT*Dt;
+    if(DeltaV<=0 || fabs(Target-Driver->Velocity)<=DeltaV)
+      Driver->Velocity=Target;
+    else
+      Driver->Velocity+=(Target>Driver->Velocity) ? DeltaV : -DeltaV;
+
+    Before=Driver->Position;
+    Driver->Position+=Driver->Velocity*Dt;
+
+    if((Driver->Registers[TMC5130_RAMPMODE] & 0x03)==TMC5130_MODE_POSITION)
+    {
+      //Stop exactly at the target (also when it has been passed in this step)
+      XTarget=Driver->Registers[TMC5130_XTARGET];
+      if((Before<=XTarget && Driver->Position>=XTarget) || (Before>=XTarget && Driver->Position<=XTarget) ||
+         fabs(Driver->Position-XTarget)<0.5)
+      {
+        if(fabs(Driver->Velocity)<=DeltaV+SIM_VELOCITY_UNIT || DeltaV<=0)
+        {
+          Driver->Position=XTarget;
+          Driver->Velocity=0;
+        }
+      }
+    }
+
+    //event_pos_reached is set when the target is reached
+    if((Driver->Registers[TMC5130_RAMPMODE] & 0x03)==TMC5130_MODE_POSITION &&
+       Driver->Velocity==0 && Driver->Position==Driver->Registers[TMC5130_XTARGET])
+    {
+      if(!Driver->TargetReached) Driver->Registers[TMC5130_RAMPSTAT]|=TMC5130_RS_EV_POSREACHED;
+      Driver->TargetReached=TRUE;
+    }
+    else Driver->TargetReached=FALSE;
+  }
+}
+
+
+/***************************************************************//**
+   \fn ReadRegisterValue(const TSimDriver *Driver, uint8_t Address)
+   \return Value read from a register (0 for registers that cannot be read)
+********************************************************************/
+static int ReadRegisterValue(const TSimDriver *Driver, uint8_t Address)
+{
+  int Value;
+  int Velocity;
+
+  if(!(SimRegisterAccess(Address) & SIM_ACC_R)) return 0;
+
+  Velocity=(int) lround(Driver->Velocity/SIM_VELOCITY_UNIT);
+  switch(Address)
+  {
+    case TMC5130_XACTUAL:
+      return (int) lround(Driver->Position);
+
+    case TMC5130_VACTUAL:
+      return Velocity & 0xffffff;
+
+    case TMC5130_TSTEP:
+      return (Velocity==0) ? 0xfffff : (int) (SIM_FCLK/fabs(Driver->Velocity)) & 0xfffff;
+
+    case TMC5130_RAMPSTAT:
+      Value=Driver->Registers[TMC5130_RAMPSTAT] & RAMPSTAT_EVENT_FLAGS;
+      if(Velocity==0) Value|=TMC5130_RS_VZERO;
+      if(Driver->Velocity==TargetVelocity(Driver)) Value|=TMC5130_RS_VELREACHED;
+      if((Driver->Registers[TMC5130_RAMPMODE] & 0x03)==TMC5130_MODE_POSITION &&
+         lround(Driver->Position)==Driver->Registers[TMC5130_XTARGET]) Value|=TMC5130_RS_POSREACHED;
+      return Value;
+
+    case TMC5130_DRVSTATUS:
+      //stst, actual current (IRUN or IHOLD) and a constant load value
+      if(Velocity==0)
+        return BIT31|((Driver->Registers[TMC5130_IHOLD_IRUN] & 0x1f)<<16)|300;
+      else
+        return (((Driver->Registers[TMC5130_IHOLD_IRUN]>>8) & 0x1f)<<16)|300;
+
+    default:
+      return Driver->Registers[Address];
+  }
+}
+
+
+/***************************************************************//**
+   \fn StatusByte(const TSimDriver *Driver)
+   \return SPI status byte of a driver (TMC5130_SPI_xxx)
+********************************************************************/
+static uint8_t StatusByte(const TSimDriver *Driver)
+{
+  uint8_t Status;
+  int RampStat;
+  int DrvStatus;
+
+  RampStat=ReadRegisterValue(Driver, TMC5130_RAMPSTAT);
+  DrvStatus=ReadRegisterValue(Driver, TMC5130_DRVSTATUS);
+
+  Status=0;
+  if(Driver->Registers[TMC5130_GSTAT] & BIT0) Status|=TMC5130_SPI_RESET;
+  if(Driver->Registers[TMC5130_GSTAT] & BIT1) Status|=TMC5130_SPI_DRIVER_ERROR;
+  if(DrvStatus & BIT24) Status|=TMC5130_SPI_SG2;
+  if(DrvStatus & BIT31) Status|=TMC5130_SPI_STANDSTILL;
+  if(RampStat & TMC5130_RS_VELREACHED) Status|=TMC5130_SPI_VELREACHED;
+  if(RampStat & TMC5130_RS_POSREACHED) Status|=TMC5130_SPI_POSREACHED;
+  if(RampStat & TMC5130_RS_STOPL) Status|=TMC5130_SPI_STOPL;
+  if(RampStat & TMC5130_RS_STOPR) Status|=TMC5130_SPI_STOPR;
+
+  return Status;
+}
+
+
+/***************************************************************//**
+   \fn ExecuteDatagram(uint8_t Which5130, const uint8_t *Datagram, uint8_t Posted)
+   \brief Evaluate the datagram received by a driver at the end of a frame
+********************************************************************/
+static void ExecuteDatagram(uint8_t Which5130, const uint8_t *Datagram, uint8_t Posted)
+{
+  TSimDriver *Driver;
+  TSimDatagram *Entry;
+  uint8_t Address;
+  uint8_t Access;
+  int Value;
+
+  Driver=&Drivers[Which5130];
+  Address=Datagram[0] & 0x7f;
+  Access=SimRegisterAccess(Address);
+  Value=(Datagram[1]<<24)|(Datagram[2]<<16)|(Datagram[3]<<8)|Datagram[4];
+
+  if(Datagram[0] & TMC5130_WRITE)
+  {
+    SimSPIStatistics.Writes++;
+    Driver->ReplyData=Value;
+    Driver->Registers[TMC5130_IFCNT]=(Driver->Registers[TMC5130_IFCNT]+1) & 0xff;
+    if(Access & SIM_ACC_WC)
+      Driver->Registers[Address]&= ~(Value & EventFlagMask(Address));
+    else if(Access & SIM_ACC_W)
+      SimSetRegister(Which5130, Address, Value & SimRegisterWriteMask(Address));
+  }
+  else
+  {
+    SimSPIStatistics.Reads++;
+    Driver->ReplyData=ReadRegisterValue(Driver, Address);
+    if(Access & SIM_ACC_RC) Driver->Registers[Address]&= ~EventFlagMask(Address);
+  }
+
+  if(DatagramCount<DatagramLogSize)
+  {
+    Entry=&DatagramLog[DatagramCount];
+    Entry->Time=SimCycles;
+    Entry->Frame=SimSPIStatistics.Frames;
+    Entry->Which5130=Which5130;
+    Entry->Address=Address;
+    Entry->Write=(Datagram[0] & TMC5130_WRITE)!=0;
+    Entry->Posted=Posted;
+    Entry->Value=(Datagram[0] & TMC5130_WRITE) ? Value : (int) Driver->ReplyData;
+  }
+  DatagramCount++;
+}
+
+
+/***************************************************************//**
+   \fn ShiftFrame(const uint8_t *TxData, uint8_t *RxData, uint32_t Length, uint8_t Posted)
+   \brief Shift a frame through the daisy chain
+
+   Driver 0 gets the bytes from MOSI, the last driver sends to MISO.
+   Each driver loads its status byte and reply data into its shift
+   register when the frame starts and evaluates the content of the
+   shift register when the frame ends.
+********************************************************************/
+static void ShiftFrame(const uint8_t *TxData, uint8_t *RxData, uint32_t Length, uint8_t Posted)
+{
+  uint8_t Shift[N_O_DRIVERS][5];
+  uint8_t In, Out;
+  uint32_t i, j;
+
+  InitDrivers();
+
+  for(i=0; i<N_O_DRIVERS; i++)
+  {
+    UpdateMotion(&Drivers[i]);
+    Shift[i][0]=StatusByte(&Drivers[i]);
+    Shift[i][1]=Drivers[i].ReplyData >> 24;
+    Shift[i][2]=Drivers[i].ReplyData >> 16;
+    Shift[i][3]=Drivers[i].ReplyData >> 8;
+    Shift[i][4]=Drivers[i].ReplyData & 0xff;
+  }
+
+  for(j=0; j<Length; j++)
+  {
+    In=TxData[j];
+    for(i=0; i<N_O_DRIVERS; i++)
+    {
+      Out=Shift[i][0];
+      memmove(&Shift[i][0], &Shift[i][1], 4);
+      Shift[i][4]=In;
+      In=Out;
+    }
+    RxData[j]=In;
+  }
+
+  SimSPIStatistics.Frames++;
+  if(Posted) SimSPIStatistics.PostedFrames++;
+  for(i=0; i<N_O_DRIVERS; i++) ExecuteDatagram(i, Shift[i], Posted);
+}
+
+
+/***************************************************************//**
+   \fn FrameCycles(uint32_t Length)
+   \return Duration of a frame on the SPI bus (CPU cycles)
+********************************************************************/
+static uint64_t FrameCycles(uint32_t Length)
+{
+  return ((uint64_t) Length*8*SIM_CPU_CLOCK+SPIClock-1)/SPIClock;
+}
+
+
+/***************************************************************//**
+   \fn SimulateTMC5130Frame(const uint8_t *TxData, uint8_t *RxData, uint32_t Length)
+   \brief Blocking transfer (replaces the SPIMSS access of ShiftTMC5130Frame())
+********************************************************************/
+void SimulateTMC5130Frame(const uint8_t *TxData, uint8_t *RxData, uint32_t Length)
+{
+  SimCycles+=SIM_SPI_SETUP_CYCLES+FrameCycles(Length);
+  SimSPIStatistics.BusyCycles+=FrameCycles(Length);
+  ShiftFrame(TxData, RxData, Length, InInterrupt);
+}
+
+
+/***************************************************************//**
+   \fn DeliverInterrupts(void)
+   \brief Run the interrupt handlers that are due
+********************************************************************/
+static void DeliverInterrupts(void)
+{
+  spimss_req_t *Request;
+  uint64_t Start;
+  int Error;
+  uint32_t i;
+
+  if(IrqLocked || InInterrupt) return;
+
+  for(;;)
+  {
+    if(AsyncRequest!=NULL && SimCycles>=AsyncDue)
+    {
+      Request=AsyncRequest;
+      AsyncRequest=NULL;
+      InInterrupt=TRUE;
+      Start=SimCycles;
+      SimCycles+=SIM_ASYNC_IRQ_CYCLES;
+
+      AsyncCompletionCount++;
+      if(AsyncCompletionPeriod>0 && AsyncCompletionCount%AsyncCompletionPeriod==0)
+      {
+        //Failed transfer: the drivers do not take over the frame
+        Error=E_COMM_ERR;
+        SimSPIStatistics.AsyncCompletionFailures++;
+        for(i=0; i<Request->len; i++) ((uint8_t *) Request->rx_data)[i]=0xff;
+      }
+      else
+      {
+        Error=E_NO_ERROR;
+        ShiftFrame(Request->tx_data, Request->rx_data, Request->len, TRUE);
+      }
+      Request->callback(Request, Error);
+
+      SimSPIStatistics.InterruptCycles+=SimCycles-Start;
+      InInterrupt=FALSE;
+    }
+    else if(TimerHandler!=NULL && SimCycles>=TimerDue)
+    {
+      TimerDue+=TimerPeriod;
+      InInterrupt=TRUE;
+      SimCycles+=SIM_TIMER_IRQ_CYCLES;
+      TimerHandler();
+      InInterrupt=FALSE;
+    }
+    else break;
+  }
+}
+
+
+/***************************************************************//**
+   \fn NextInterruptTime(void)
+   \return Time of the next interrupt (UINT64_MAX: none)
+********************************************************************/
+static uint64_t NextInterruptTime(void)
+{
+  uint64_t Next;
+
+  Next=UINT64_MAX;
+  if(AsyncRequest!=NULL) Next=AsyncDue;
+  if(TimerHandler!=NULL && TimerDue<Next) Next=TimerDue;
+
+  return Next;
+}
+
+
+/***************************************************************//**
+   \fn SimAdvance(uint64_t Cycles)
+   \brief Let time pass (e.g. CPU time of the main loop)
+********************************************************************/
+void SimAdvance(uint64_t Cycles)
+{
+  uint64_t End;
+  uint64_t Next;
+
+  End=SimCycles+Cycles;
+  for(;;)
+  {
+    Next=NextInterruptTime();
+    if(IrqLocked || InInterrupt || Next>End) break;
+    if(Next>SimCycles) SimCycles=Next;
+    DeliverInterrupts();
+  }
+  if(SimCycles<End) SimCycles=End;
+}
+
+
+/***************************************************************//**
+   \fn SimWaitForInterrupt(void)
+   \brief Busy wait of the firmware for the SPI interrupt
+
+   Jumps to the next interrupt. Waiting without any pending interrupt
+   or with interrupts locked would hang the firmware, so the
+   simulation stops there.
+********************************************************************/
+void SimWaitForInterrupt(void)
+{
+  uint64_t Next;
+
+  Next=NextInterruptTime();
+  if(IrqLocked || InInterrupt || Next==UINT64_MAX)
+  {
+    fprintf(stderr, "SimTMC5130: firmware waits for an interrupt that cannot come (locked %d, in interrupt %d)\n",
+            IrqLocked, InInterrupt);
+    abort();
+  }
+
+  if(Next>SimCycles) SimCycles=Next;
+  DeliverInterrupts();
+}
+
+
+/***************************************************************//**
+   \fn SimSetTimerInterrupt(void (*Handler)(void), uint64_t PeriodCycles)
+   \brief Start a periodic interrupt (NULL: stop it)
+********************************************************************/
+void SimSetTimerInterrupt(void (*Handler)(void), uint64_t PeriodCycles)
+{
+  TimerHandler=Handler;
+  TimerPeriod=PeriodCycles;
+  TimerDue=SimCycles+PeriodCycles;
+}
+
+
+/***************************************************************//**
+   \fn SimGetRegister(uint8_t Which5130, uint8_t Address)
+   \return Register content of a driver (without read side effects;
+           also for registers that cannot be read)
+********************************************************************/
+int SimGetRegister(uint8_t Which5130, uint8_t Address)
+{
+  InitDrivers();
+  UpdateMotion(&Drivers[Which5130]);
+
+  if(SimRegisterAccess(Address) & SIM_ACC_R) return ReadRegisterValue(&Drivers[Which5130], Address);
+
+  return Drivers[Which5130].Registers[Address];
+}
+
+
+/***************************************************************//**
+   \fn SimSetRegister(uint8_t Which5130, uint8_t Address, int Value)
+   \brief Set a register of a driver (also used for received writes)
+********************************************************************/
+void SimSetRegister(uint8_t Which5130, uint8_t Address, int Value)
+{
+  TSimDriver *Driver;
+
+  InitDrivers();
+  Driver=&Drivers[Which5130];
+  UpdateMotion(Driver);
+
+  Address&=0x7f;
+  Driver->Registers[Address]=Value;
+  if(Address==TMC5130_XACTUAL) Driver->Position=Value;
+}
+
+
+/***************************************************************//**
+   \fn SimSetSPIClock(uint32_t Frequency)
+   \brief Set the SPI clock (Hz, default: TMC5130_SPI_FREQUENCY)
+********************************************************************/
+void SimSetSPIClock(uint32_t Frequency)
+{
+  SPIClock=Frequency;
+}
+
+uint32_t SimGetSPIClock(void)
+{
+  return SPIClock;
+}
+
+
+/***************************************************************//**
+   \fn SimSetAsyncFailures(uint32_t StartPeriod, uint32_t CompletionPeriod)
+   \brief Inject failures of the SPIMSS driver
+   \param StartPeriod: every n-th SPIMSS_MasterTransAsync() fails (0: never)
+   \param CompletionPeriod: every n-th posted frame completes with an error (0: never)
+********************************************************************/
+void SimSetAsyncFailures(uint32_t StartPeriod, uint32_t CompletionPeriod)
+{
+  AsyncStartPeriod=StartPeriod;
+  AsyncCompletionPeriod=CompletionPeriod;
+  AsyncStartCount=0;
+  AsyncCompletionCount=0;
+}
+
+
+/***************************************************************//**
+   \fn SimSetDatagramLog(TSimDatagram *Log, uint32_t Size)
+   \brief Record the received datagrams (NULL: stop recording)
+
+   Also resets the datagram counter.
+********************************************************************/
+void SimSetDatagramLog(TSimDatagram *Log, uint32_t Size)
+{
+  DatagramLog=Log;
+  DatagramLogSize=(Log!=NULL) ? Size : 0;
+  DatagramCount=0;
+}
+
+uint32_t SimGetDatagramCount(void)
+{
+  return DatagramCount;
+}
+
+
+/* Simulated time (replaces ../SysTick.c) */
+void InitSysTick(void)
+{
+}
+
+uint32_t GetSysTimer(void)
+{
+  SimCycles+=SIM_POLL_CYCLES;
+  DeliverInterrupts();
+
+  return SimCycles/SIM_CYCLES_PER_MS;
+}
+
+uint32_t GetCycleCounter(void)
+{
+  return (uint32_t) SimCycles;
+}
+
+
+/* Interrupt lock (see host/core_cmFunc.h) */
+void __disable_irq(void)
+{
+  IrqLocked=TRUE;
+}
+
+void __enable_irq(void)
+{
+  IrqLocked=FALSE;
+  DeliverInterrupts();
+}
+
+void SimEnableIRQ(IRQn_Type IRQn)
+{
+  (void) IRQn;
+}
+
+
+/* SPIMSS driver (only the functions used by the firmware) */
+int SPIMSS_Init(mxc_spimss_regs_t *spi, unsigned mode, unsigned freq, const sys_cfg_spimss_t *sys_cfg)
+{
+  (void) spi; (void) mode; (void) sys_cfg;
+  SPIClock=freq;
+
+  return E_NO_ERROR;
+}
+
+int SPIMSS_MasterTransAsync(mxc_spimss_regs_t *spi, spimss_req_t *req)
+{
+  (void) spi;
+
+  if(AsyncRequest!=NULL) return E_BUSY;
+
+  SimCycles+=SIM_ASYNC_START_CYCLES;
+  AsyncStartCount++;
+  if(AsyncStartPeriod>0 && AsyncStartCount%AsyncStartPeriod==0)
+  {
+    SimSPIStatistics.AsyncStartFailures++;
+    return E_BUSY;
+  }
+
+  AsyncRequest=req;
+  AsyncDue=SimCycles+FrameCycles(req->len);
+  SimSPIStatistics.BusyCycles+=FrameCycles(req->len);
+
+  return E_NO_ERROR;
+}
+
+void SPIMSS_Handler(mxc_spimss_regs_t *spi)
+{
+  (void) spi;
+}
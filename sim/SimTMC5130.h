@@ -0,0 +1,80 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file SimTMC5130.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: SimTMC5130.h
+ *         Description: Host simulation of the TMC5130 daisy chain
+ *
+ *                      Included by ../TMC5130.c when it is compiled with
+ *                      -DTMC5130_SIMULATION (see SimTMC5130.c).
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __SIM_TMC5130_H
+#define __SIM_TMC5130_H
+
+#include <stdint.h>
+
+#define SIM_CPU_CLOCK 96000000UL   //!< core clock of the MAX32660 (Hz)
+#define SIM_CYCLES_PER_MS (SIM_CPU_CLOCK/1000)
+
+//Register access according to the data sheet (SimRegisterAccess())
+#define SIM_ACC_R   0x01    //!< can be read
+#define SIM_ACC_W   0x02    //!< can be written
+#define SIM_ACC_RC  0x04    //!< event flags are cleared by reading
+#define SIM_ACC_WC  0x08    //!< event flags are cleared by writing 1
+
+//! Datagram received by a driver (see SimSetDatagramLog())
+typedef struct
+{
+  uint64_t Time;        //!< end of the frame (CPU cycles)
+  uint32_t Frame;       //!< number of the frame
+  uint8_t Which5130;    //!< position of the driver in the daisy chain
+  uint8_t Address;      //!< register address (without write bit)
+  uint8_t Write;        //!< TRUE: write datagram
+  uint8_t Posted;       //!< TRUE: frame sent by the SPI interrupt (posted writes)
+  int Value;            //!< value written (write) or requested register value (read)
+} TSimDatagram;
+
+//! SPI statistics
+typedef struct
+{
+  uint32_t Frames;           //!< frames shifted through the daisy chain
+  uint32_t PostedFrames;     //!< frames sent by the SPI interrupt
+  uint32_t Writes;           //!< write datagrams
+  uint32_t Reads;            //!< read datagrams (including the GCONF reads of unused slots)
+  uint32_t AsyncStartFailures;       //!< SPIMSS_MasterTransAsync() calls that failed (injected)
+  uint32_t AsyncCompletionFailures;  //!< posted frames completed with an error (injected)
+  uint64_t BusyCycles;       //!< time the SPI bus was busy (CPU cycles)
+  uint64_t InterruptCycles;  //!< CPU time used by the SPI interrupt (CPU cycles)
+} TSimSPIStatistics;
+
+extern uint64_t SimCycles;
+extern TSimSPIStatistics SimSPIStatistics;
+
+void SimAdvance(uint64_t Cycles);
+void SimWaitForInterrupt(void);
+void SimSetTimerInterrupt(void (*Handler)(void), uint64_t PeriodCycles);
+void SimulateTMC5130Frame(const uint8_t *TxData, uint8_t *RxData, uint32_t Length);
+
+void SimResetTMC5130(uint8_t Which5130);
+uint8_t SimRegisterAccess(uint8_t Address);
+uint32_t SimRegisterWriteMask(uint8_t Address);
+int SimGetRegister(uint8_t Which5130, uint8_t Address);
+void SimSetRegister(uint8_t Which5130, uint8_t Address, int Value);
+void SimSetSPIClock(uint32_t Frequency);
+uint32_t SimGetSPIClock(void);
+void SimSetAsyncFailures(uint32_t StartPeriod, uint32_t CompletionPeriod);
+void SimSetDatagramLog(TSimDatagram *Log, uint32_t Size);
+uint32_t SimGetDatagramCount(void);
+
+//Waiting for the SPI interrupt in ../TMC5130.c
+#define WAIT_FOR_SPI_INTERRUPT() SimWaitForInterrupt()
+
+#endif
@@ -0,0 +1,503 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file TMCLProgramTest.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: TMCLProgramTest.c
+ *         Description: Test of the stand-alone TMCL program interpreter (../TMCL.c)
+ *
+ *                      Runs the whole firmware (see SimFirmware.c),
+ *                      downloads sample programs (commands 132/133),
+ *                      runs them (commands 131/129/130) and checks the
+ *                      results through the user variables (GGP bank 2),
+ *                      the application status (command 135) and the
+ *                      simulated drivers:
+ *                      - download, read back (134), memory overflow
+ *                      - CALC/CALCX arithmetic, AGP/GGP, loop with JC NZ
+ *                      - COMP and all comparison conditions of JC
+ *                      - CSUB/RSUB, stack overflow and underflow
+ *                      - MVP with WAIT POS, WAIT TICKS, WAIT timeout with
+ *                        JC ETO and CLE
+ *                      - stop by an invalid command, STOP, step mode and
+ *                        program commands in direct mode
+ *
+ *                      It also reports the execution rate of a program
+ *                      loop (program commands per second of simulated
+ *                      time, see TMCL_PROGRAM_BUDGET).
+ *
+ *                      Build and run (from this directory):
+ *                      make test (TMCLProgramTest3)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "max32660.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "TMC5130.h"
+#include "TMCL.h"
+#include "GlobalParameters.h"
+#include "SimTMC5130.h"
+#include "SimFirmware.h"
+
+#define TEST_MOTOR  (N_O_MOTORS-1)   //!< axis moved by the programs
+#define RESULT      3                //!< user variable set by the comparison programs
+
+static uint32_t Failures;
+static uint32_t Checks;
+
+#define CHECK(Condition, ...) do { Checks++; if(!(Condition)) { Failures++; printf("  FAILED: " __VA_ARGS__); printf("\n"); } } while(0)
+
+//! One command of a program
+typedef struct
+{
+  uint8_t Opcode;
+  uint8_t Type;
+  uint8_t Motor;
+  int Value;
+} TInstruction;
+
+#define N_INSTRUCTIONS(Program) (sizeof(Program)/sizeof(Program[0]))
+
+//! Sum of 1..10 in user variable 1 (user variable 0 counts down)
+static const TInstruction SumProgram[]=
+{
+  {TMCL_CALC,  CALC_LOAD, 0, 0},
+  {TMCL_AGP,   1, GP_BANK_USER_VARS, 0},
+  {TMCL_CALC,  CALC_LOAD, 0, 10},
+  {TMCL_AGP,   0, GP_BANK_USER_VARS, 0},
+  {TMCL_GGP,   0, GP_BANK_USER_VARS, 0},    //4: loop
+  {TMCL_CALCX, CALC_LOAD, 0, 0},
+  {TMCL_GGP,   1, GP_BANK_USER_VARS, 0},
+  {TMCL_CALCX, CALC_ADD, 0, 0},
+  {TMCL_AGP,   1, GP_BANK_USER_VARS, 0},
+  {TMCL_GGP,   0, GP_BANK_USER_VARS, 0},
+  {TMCL_CALC,  CALC_SUB, 0, 1},
+  {TMCL_AGP,   0, GP_BANK_USER_VARS, 0},
+  {TMCL_JC,    JC_NZ, 0, 4},
+  {TMCL_STOP,  0, 0, 0},
+};
+
+//! Accumulator 1, doubled by two subroutine calls, result in user variable 4
+static const TInstruction SubroutineProgram[]=
+{
+  {TMCL_CALC,  CALC_LOAD, 0, 1},
+  {TMCL_CSUB,  0, 0, 5},
+  {TMCL_CSUB,  0, 0, 5},
+  {TMCL_AGP,   4, GP_BANK_USER_VARS, 0},
+  {TMCL_STOP,  0, 0, 0},
+  {TMCL_CALC,  CALC_MUL, 0, 2},             //5: subroutine
+  {TMCL_RSUB,  0, 0, 0},
+};
+
+//! Endless recursion (stack overflow)
+static const TInstruction RecursionProgram[]=
+{
+  {TMCL_CSUB,  0, 0, 0},
+};
+
+//! RSUB without CSUB (stack underflow)
+static const TInstruction UnderflowProgram[]=
+{
+  {TMCL_RSUB,  0, 0, 0},
+  {TMCL_STOP,  0, 0, 0},
+};
+
+//! Move, wait until the target is reached, actual position in user variable 5
+static const TInstruction MoveProgram[]=
+{
+  {TMCL_SAP,   4, TEST_MOTOR, 50000},
+  {TMCL_SAP,   5, TEST_MOTOR, 100000},
+  {TMCL_MVP,   MVP_ABS, TEST_MOTOR, 5000},
+  {TMCL_WAIT,  WAIT_POS, TEST_MOTOR, 0},
+  {TMCL_GAP,   1, TEST_MOTOR, 0},
+  {TMCL_AGP,   5, GP_BANK_USER_VARS, 0},
+  {TMCL_STOP,  0, 0, 0},
+};
+
+//! 200ms wait
+static const TInstruction TicksProgram[]=
+{
+  {TMCL_WAIT,  WAIT_TICKS, 0, 20},
+  {TMCL_STOP,  0, 0, 0},
+};
+
+//! WAIT POS with timeout: user variable 6 = 1 after a timeout, flags cleared again
+static const TInstruction TimeoutProgram[]=
+{
+  {TMCL_SAP,   4, TEST_MOTOR, 1000},
+  {TMCL_MVP,   MVP_REL, TEST_MOTOR, 100000},
+  {TMCL_WAIT,  WAIT_POS, TEST_MOTOR, 5},
+  {TMCL_JC,    JC_ETO, 0, 6},
+  {TMCL_SGP,   6, GP_BANK_USER_VARS, 0},
+  {TMCL_STOP,  0, 0, 0},
+  {TMCL_SGP,   6, GP_BANK_USER_VARS, 1},    //6: timeout
+  {TMCL_CLE,   CLE_ETO, 0, 0},
+  {TMCL_MST,   0, TEST_MOTOR, 0},
+  {TMCL_STOP,  0, 0, 0},
+};
+
+//! Invalid opcode: the program stops there
+static const TInstruction InvalidProgram[]=
+{
+  {TMCL_SGP,   7, GP_BANK_USER_VARS, 1},
+  {99,         0, 0, 0},
+  {TMCL_SGP,   7, GP_BANK_USER_VARS, 2},
+  {TMCL_STOP,  0, 0, 0},
+};
+
+//! Endless counting loop (execution rate)
+static const TInstruction CountProgram[]=
+{
+  {TMCL_CALC,  CALC_ADD, 0, 1},
+  {TMCL_JA,    0, 0, 0},
+};
+
+
+/***************************************************************//**
+   \fn Download(const TInstruction *Program, uint32_t Count, uint32_t Address)
+   \brief Download a program (commands 132 and 133)
+********************************************************************/
+static void Download(const TInstruction *Program, uint32_t Count, uint32_t Address)
+{
+  uint8_t Status;
+  uint32_t i;
+  int End;
+
+  CHECK(SimCommand(TMCL_DownloadStart, 0, 0, Address, NULL)==REPLY_OK, "download start");
+  for(i=0; i<Count; i++)
+  {
+    Status=SimCommand(Program[i].Opcode, Program[i].Type, Program[i].Motor, Program[i].Value, NULL);
+    CHECK(Status==REPLY_CMD_LOADED, "command %u not loaded (%u)", i, Status);
+  }
+  CHECK(SimCommand(TMCL_DownloadEnd, 0, 0, 0, &End)==REPLY_OK, "download end");
+  CHECK(End==(int) (Address+Count), "download ends at %d instead of %u", End, Address+Count);
+}
+
+
+/***************************************************************//**
+   \fn GetStatus(uint8_t Type)
+   \return Application status (command 135)
+********************************************************************/
+static int GetStatus(uint8_t Type)
+{
+  int Value;
+
+  Value= -1;
+  SimCommand(TMCL_GetStatus, Type, 0, 0, &Value);
+
+  return Value;
+}
+
+
+/***************************************************************//**
+   \fn GetUserVariable(uint8_t Number)
+   \return User variable (GGP bank 2)
+********************************************************************/
+static int GetUserVariable(uint8_t Number)
+{
+  int Value;
+
+  Value=0;
+  SimCommand(TMCL_GGP, Number, GP_BANK_USER_VARS, 0, &Value);
+
+  return Value;
+}
+
+
+/***************************************************************//**
+   \fn Run(const TInstruction *Program, uint32_t Count, uint32_t Timeout)
+   \brief Download a program, reset and run it until it ends
+   \param Timeout: maximum run time (ms)
+   \return Run time (ms of simulated time)
+********************************************************************/
+static double Run(const TInstruction *Program, uint32_t Count, uint32_t Timeout)
+{
+  uint64_t Start;
+  uint32_t Time;
+
+  Download(Program, Count, 0);
+  CHECK(SimCommand(TMCL_ApplReset, 0, 0, 0, NULL)==REPLY_OK, "reset");
+  Start=SimCycles;
+  CHECK(SimCommand(TMCL_ApplRun, 0, 0, 0, NULL)==REPLY_OK, "run");
+  for(Time=0; Time<Timeout && GetStatus(0)==TM_RUN; Time++) SimRunTime(1);
+  CHECK(Time<Timeout, "program still running after %u ms (address %d)", Timeout, GetStatus(1));
+
+  return (double) (SimCycles-Start)/SIM_CYCLES_PER_MS;
+}
+
+
+/***************************************************************//**
+   \fn TestDownload(void)
+   \brief Download, read back and program memory overflow
+********************************************************************/
+static void TestDownload(void)
+{
+  uint8_t (*Frames)[9];
+  uint32_t i;
+  int Address;
+
+  printf("download\n");
+  Download(SumProgram, N_INSTRUCTIONS(SumProgram), 0);
+  for(i=0; i<N_INSTRUCTIONS(SumProgram); i++)
+  {
+    CHECK(SimCommand(TMCL_ReadMem, 0, 0, i, &Address)==REPLY_OK && Address==(int) i, "read memory %u", i);
+    CHECK(SimGetReplyFrames(&Frames)==2, "read memory %u: not two frames", i);
+    CHECK(Frames[1][1]==SumProgram[i].Opcode && Frames[1][2]==SumProgram[i].Type && Frames[1][3]==SumProgram[i].Motor &&
+          ((Frames[1][4]<<24)|(Frames[1][5]<<16)|(Frames[1][6]<<8)|Frames[1][7])==SumProgram[i].Value,
+          "command %u read back as %u %u %u", i, Frames[1][1], Frames[1][2], Frames[1][3]);
+  }
+
+  CHECK(SimCommand(TMCL_DownloadStart, 0, 0, TMCL_MEM_SIZE, NULL)==REPLY_INVALID_VALUE, "download start beyond the memory");
+  CHECK(SimCommand(TMCL_DownloadStart, 0, 0, TMCL_MEM_SIZE-1, NULL)==REPLY_OK, "download start at the end");
+  CHECK(SimCommand(TMCL_STOP, 0, 0, 0, NULL)==REPLY_CMD_LOADED, "last address not loaded");
+  CHECK(SimCommand(TMCL_STOP, 0, 0, 0, NULL)==REPLY_MAX_EXCEEDED, "program memory overflow not detected");
+  CHECK(SimCommand(TMCL_DownloadEnd, 0, 0, 0, &Address)==REPLY_OK && Address==TMCL_MEM_SIZE, "download end");
+  CHECK(SimCommand(TMCL_DownloadEnd, 0, 0, 0, NULL)==REPLY_CMD_NOT_AVAILABLE, "download end without download start");
+
+  //Program flow commands are not available in direct mode
+  CHECK(SimCommand(TMCL_JA, 0, 0, 0, NULL)==REPLY_CMD_NOT_AVAILABLE, "JA in direct mode");
+  CHECK(SimCommand(TMCL_CSUB, 0, 0, 0, NULL)==REPLY_CMD_NOT_AVAILABLE, "CSUB in direct mode");
+  CHECK(SimCommand(TMCL_STOP, 0, 0, 0, NULL)==REPLY_CMD_NOT_AVAILABLE, "STOP in direct mode");
+}
+
+
+/***************************************************************//**
+   \fn TestArithmetic(void)
+   \brief Loop with CALC/CALCX/AGP/GGP and JC NZ
+********************************************************************/
+static void TestArithmetic(void)
+{
+  printf("arithmetic loop\n");
+  Run(SumProgram, N_INSTRUCTIONS(SumProgram), 1000);
+  CHECK(GetUserVariable(1)==55, "sum %d instead of 55", GetUserVariable(1));
+  CHECK(GetUserVariable(0)==0, "counter %d instead of 0", GetUserVariable(0));
+  CHECK(GetStatus(2)==0 && (GetStatus(4) & FLAG_ZERO), "accumulator %d, flags 0x%x", GetStatus(2), GetStatus(4));
+  CHECK(GetStatus(1)==N_INSTRUCTIONS(SumProgram), "ended at %d", GetStatus(1));
+  CHECK(GetStatus(3)==1, "X register %d instead of 1", GetStatus(3));
+}
+
+
+/***************************************************************//**
+   \fn TestComparison(void)
+   \brief COMP and JC with all comparison conditions
+********************************************************************/
+static void TestComparison(void)
+{
+  static const int Operands[][2]={{5, 5}, {4, 5}, {6, 5}, {-1, 0}, {INT32_MIN, INT32_MAX}};
+  static const char *Names[]={"ZE", "NZ", "EQ", "NE", "GT", "GE", "LT", "LE"};
+  TInstruction Program[7]=
+  {
+    {TMCL_CALC, CALC_LOAD, 0, 0},
+    {TMCL_COMP, 0, 0, 0},
+    {TMCL_JC,   0, 0, 5},
+    {TMCL_SGP,  RESULT, GP_BANK_USER_VARS, 0},
+    {TMCL_STOP, 0, 0, 0},
+    {TMCL_SGP,  RESULT, GP_BANK_USER_VARS, 1},     //5: jumped
+    {TMCL_STOP, 0, 0, 0},
+  };
+  uint32_t i;
+  uint8_t Condition;
+  int a, b;
+  int Expected;
+
+  printf("comparisons\n");
+  for(i=0; i<sizeof(Operands)/sizeof(Operands[0]); i++)
+  {
+    a=Operands[i][0];
+    b=Operands[i][1];
+    for(Condition=JC_EQ; Condition<=JC_LE; Condition++)
+    {
+      switch(Condition)
+      {
+        case JC_EQ: Expected=a==b; break;
+        case JC_NE: Expected=a!=b; break;
+        case JC_GT: Expected=a>b;  break;
+        case JC_GE: Expected=a>=b; break;
+        case JC_LT: Expected=a<b;  break;
+        default:    Expected=a<=b; break;
+      }
+      Program[0].Value=a;
+      Program[1].Value=b;
+      Program[2].Type=Condition;
+      Run(Program, N_INSTRUCTIONS(Program), 1000);
+      CHECK(GetUserVariable(RESULT)==Expected, "%d JC %s %d: %s", a, Names[Condition], b, Expected ? "no jump":"jump");
+    }
+  }
+
+  //Zero flag of CALC
+  for(a=-1; a<=1; a++)
+  {
+    for(Condition=JC_ZE; Condition<=JC_NZ; Condition++)
+    {
+      Program[0].Value=a;
+      Program[1].Opcode=TMCL_CALC;
+      Program[1].Type=CALC_ADD;
+      Program[1].Value=1;
+      Program[2].Type=Condition;
+      Expected=(Condition==JC_ZE) ? (a+1==0) : (a+1!=0);
+      Run(Program, N_INSTRUCTIONS(Program), 1000);
+      CHECK(GetUserVariable(RESULT)==Expected, "%d+1 JC %s: %s", a, Names[Condition], Expected ? "no jump":"jump");
+    }
+  }
+
+  //Unknown condition: no jump, the program goes on
+  Program[2].Type=JC_ESD+1;
+  Run(Program, N_INSTRUCTIONS(Program), 1000);
+  CHECK(GetUserVariable(RESULT)==0 && GetStatus(1)==5, "unknown condition: ended at %d", GetStatus(1));
+}
+
+
+/***************************************************************//**
+   \fn TestSubroutines(void)
+   \brief CSUB/RSUB, stack overflow and underflow
+********************************************************************/
+static void TestSubroutines(void)
+{
+  printf("subroutines\n");
+  Run(SubroutineProgram, N_INSTRUCTIONS(SubroutineProgram), 1000);
+  CHECK(GetUserVariable(4)==4, "result %d instead of 4", GetUserVariable(4));
+  CHECK(GetStatus(5)==0, "stack depth %d after the program", GetStatus(5));
+  CHECK(GetStatus(1)==5, "ended at %d", GetStatus(1));
+
+  Run(RecursionProgram, N_INSTRUCTIONS(RecursionProgram), 1000);
+  CHECK(GetStatus(0)==TM_IDLE, "recursion not stopped");
+  CHECK(GetStatus(5)==TMCL_STACK_DEPTH, "stack depth %d after the overflow", GetStatus(5));
+
+  Run(UnderflowProgram, N_INSTRUCTIONS(UnderflowProgram), 1000);
+  CHECK(GetStatus(0)==TM_IDLE && GetStatus(1)==1, "stack underflow: address %d", GetStatus(1));
+}
+
+
+/***************************************************************//**
+   \fn TestWait(void)
+   \brief MVP with WAIT POS, WAIT TICKS and WAIT with timeout
+********************************************************************/
+static void TestWait(void)
+{
+  uint32_t Time;
+  double RunTime;
+
+  printf("motion and WAIT\n");
+  SimSetRegister(WHICH_5130(TEST_MOTOR), TMC5130_XACTUAL, 0);
+  CHECK(SimCommand(TMCL_SAP, 1, TEST_MOTOR, 0, NULL)==REPLY_OK, "position 0");
+  Download(MoveProgram, N_INSTRUCTIONS(MoveProgram), 0);
+  CHECK(SimCommand(TMCL_ApplReset, 0, 0, 0, NULL)==REPLY_OK, "reset");
+  CHECK(SimCommand(TMCL_ApplRun, 0, 0, 0, NULL)==REPLY_OK, "run");
+  SimRunTime(20);
+  CHECK(GetStatus(0)==TM_RUN && GetStatus(1)==4, "not waiting at the WAIT command (mode %d, address %d)", GetStatus(0), GetStatus(1));
+  CHECK(SimGetRegister(WHICH_5130(TEST_MOTOR), TMC5130_XACTUAL)<5000, "target already reached");
+  for(Time=0; Time<5000 && GetStatus(0)==TM_RUN; Time+=10) SimRunTime(10);
+  CHECK(GetStatus(0)==TM_IDLE, "move program not finished");
+  CHECK(SimGetRegister(WHICH_5130(TEST_MOTOR), TMC5130_XACTUAL)==5000, "position %d", SimGetRegister(WHICH_5130(TEST_MOTOR), TMC5130_XACTUAL));
+  CHECK(GetUserVariable(5)==5000, "position read by the program: %d", GetUserVariable(5));
+
+  RunTime=Run(TicksProgram, N_INSTRUCTIONS(TicksProgram), 1000);
+  CHECK(RunTime>=200.0 && RunTime<215.0, "WAIT 20 ticks took %.1f ms", RunTime);
+
+  RunTime=Run(TimeoutProgram, N_INSTRUCTIONS(TimeoutProgram), 1000);
+  CHECK(GetUserVariable(6)==1, "timeout not detected");
+  CHECK(!(GetStatus(4) & FLAG_ERROR_TIMEOUT), "timeout flag not cleared");
+  CHECK(RunTime>=50.0 && RunTime<65.0, "WAIT with 5 ticks timeout took %.1f ms", RunTime);
+}
+
+
+/***************************************************************//**
+   \fn TestStop(void)
+   \brief Invalid command, step mode, stop and continue
+********************************************************************/
+static void TestStop(void)
+{
+  int Value;
+
+  printf("stop and step mode\n");
+  CHECK(SimCommand(TMCL_SGP, 7, GP_BANK_USER_VARS, 0, NULL)==REPLY_OK, "SGP");
+  Run(InvalidProgram, N_INSTRUCTIONS(InvalidProgram), 1000);
+  CHECK(GetUserVariable(7)==1, "user variable 7 = %d", GetUserVariable(7));
+  CHECK(GetStatus(0)==TM_IDLE && GetStatus(1)==2, "invalid command: mode %d, address %d", GetStatus(0), GetStatus(1));
+
+  //Step mode: one command per ApplStep
+  Download(SumProgram, N_INSTRUCTIONS(SumProgram), 0);
+  CHECK(SimCommand(TMCL_ApplReset, 0, 0, 0, NULL)==REPLY_OK, "reset");
+  CHECK(SimCommand(TMCL_ApplStep, 0, 0, 0, NULL)==REPLY_OK, "step");
+  SimRunLoop(5);
+  CHECK(GetStatus(1)==1, "first step: address %d", GetStatus(1));
+  CHECK(SimCommand(TMCL_ApplStep, 0, 0, 0, NULL)==REPLY_OK, "step");
+  SimRunLoop(5);
+  CHECK(GetStatus(1)==2, "second step: address %d", GetStatus(1));
+  CHECK(SimCommand(TMCL_ApplStep, 0, 0, 0, NULL)==REPLY_OK, "step");
+  SimRunLoop(5);
+  CHECK(GetStatus(1)==3 && GetStatus(2)==10, "third step: address %d, accumulator %d", GetStatus(1), GetStatus(2));
+
+  //Continue from the actual address
+  CHECK(SimCommand(TMCL_ApplRun, 0, 0, 0, NULL)==REPLY_OK, "continue");
+  SimRunTime(10);
+  CHECK(GetStatus(0)==TM_IDLE && GetUserVariable(1)==55, "continued program: mode %d, sum %d", GetStatus(0), GetUserVariable(1));
+
+  //Stop an endless loop and start at an address
+  Download(CountProgram, N_INSTRUCTIONS(CountProgram), 0);
+  CHECK(SimCommand(TMCL_ApplRun, 1, 0, 0, NULL)==REPLY_OK, "run from address 0");
+  SimRunTime(10);
+  CHECK(GetStatus(0)==TM_RUN, "loop not running");
+  CHECK(SimCommand(TMCL_ApplStop, 0, 0, 0, NULL)==REPLY_OK, "stop");
+  Value=GetStatus(2);
+  SimRunTime(10);
+  CHECK(GetStatus(0)==TM_IDLE && GetStatus(2)==Value, "loop not stopped");
+  CHECK(SimCommand(TMCL_ApplRun, 1, 0, TMCL_MEM_SIZE, NULL)==REPLY_INVALID_VALUE, "run from an address beyond the memory");
+}
+
+
+/***************************************************************//**
+   \fn MeasureRate(void)
+   \brief Execution rate of a program loop
+   \return Program commands per second
+********************************************************************/
+static double MeasureRate(void)
+{
+  uint64_t Start;
+  uint32_t Passes;
+  int Count;
+
+  Download(CountProgram, N_INSTRUCTIONS(CountProgram), 0);
+  CHECK(SimCommand(TMCL_ApplReset, 0, 0, 0, NULL)==REPLY_OK, "reset");
+  CHECK(SimCommand(TMCL_ApplRun, 0, 0, 0, NULL)==REPLY_OK, "run");
+  Start=SimCycles;
+  Passes=SimGetLoopCount();
+  SimRunTime(1000);
+  CHECK(SimCommand(TMCL_ApplStop, 0, 0, 0, NULL)==REPLY_OK, "stop");
+  Count=GetStatus(2);
+  Passes=SimGetLoopCount()-Passes;
+  printf("count loop: %d passes through the loop in %.0f ms, %u main loop passes\n",
+         Count, (double) (SimCycles-Start)/SIM_CYCLES_PER_MS, Passes);
+
+  return 2.0*Count*SIM_CPU_CLOCK/(SimCycles-Start);
+}
+
+
+int main(void)
+{
+  double Rate;
+
+  printf("TMCL program test: %u axes\n", N_O_MOTORS);
+  SimFirmwareStart();
+  SimRunLoop(100);
+
+  TestDownload();
+  TestArithmetic();
+  TestComparison();
+  TestSubroutines();
+  TestWait();
+  TestStop();
+  Rate=MeasureRate();
+
+  printf("%.0f program commands/s (%u per main loop pass)\n", Rate, TMCL_PROGRAM_BUDGET);
+  printf("%u checks, %u failed\n", Checks, Failures);
+
+  return Failures>0 ? 2 : 0;
+}
@@ -0,0 +1,337 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file WriteTraceTest.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: WriteTraceTest.c
+ *         Description: Replay of a command trace against the whole firmware
+ *
+ *                      Sends the TMCL commands of a trace file (default:
+ *                      CommandTrace.txt) to the firmware (see
+ *                      SimFirmware.c) and reports the write datagrams
+ *                      sent to the drivers and the writes skipped by the
+ *                      software copy (GetTMC5130SavedWriteCount()).
+ *
+ *                      Checks for every MVP command: when RAMPMODE is
+ *                      switched to positioning mode, XTARGET of this
+ *                      driver already has the new target (the motor must
+ *                      never start towards the old target). After
+ *                      WAITPOS the axes must be at their targets.
+ *
+ *                      Build and run (from this directory): make test
+ *                      (WriteTraceTest3, three axes)
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "max32660.h"
+#include "bits.h"
+#include "HomebusSlave.h"
+#include "TMC5130.h"
+#include "TMCL.h"
+#include "SimTMC5130.h"
+#include "SimFirmware.h"
+
+#define LOG_SIZE       10000
+#define MAX_LINES      1000
+#define WAIT_TIMEOUT   20000    //!< ms
+
+//! Mnemonics of the trace file
+static const struct
+{
+  const char *Name;
+  uint8_t Opcode;
+} Mnemonics[]=
+{
+  {"ROR", TMCL_ROR},
+  {"ROL", TMCL_ROL},
+  {"MST", TMCL_MST},
+  {"MVP", TMCL_MVP},
+  {"SAP", TMCL_SAP},
+  {"GAP", TMCL_GAP},
+  {"SGP", TMCL_SGP},
+  {"GGP", TMCL_GGP},
+  {"SCO", TMCL_SCO},
+  {"GCO", TMCL_GCO}
+};
+
+static char Lines[MAX_LINES][128];
+static uint32_t LineNumbers[MAX_LINES];
+static uint32_t LineCount;
+
+static TSimDatagram Log[LOG_SIZE];
+static int Coordinates[N_O_MOTORS][TMCL_COORDINATES];
+static int Targets[N_O_MOTORS];
+
+static uint32_t Commands;
+static uint32_t Moves;
+static uint32_t RampModeChecks;
+static uint32_t Failures;
+static uint32_t Checks;
+
+#define CHECK(Condition, ...) do { Checks++; if(!(Condition)) { Failures++; printf("  FAILED: " __VA_ARGS__); printf("\n"); } } while(0)
+
+
+/***************************************************************//**
+   \fn ReadTrace(const char *FileName)
+   \brief Read the trace file (comments and empty lines removed)
+********************************************************************/
+static void ReadTrace(const char *FileName)
+{
+  FILE *File;
+  char Line[128];
+  char *Comment;
+  uint32_t Number;
+
+  File=fopen(FileName, "r");
+  if(File==NULL)
+  {
+    printf("cannot open %s\n", FileName);
+    exit(1);
+  }
+
+  Number=0;
+  while(fgets(Line, sizeof(Line), File)!=NULL)
+  {
+    Number++;
+    if((Comment=strchr(Line, '#'))!=NULL) *Comment=0;
+    if(strspn(Line, " \t\r\n")==strlen(Line)) continue;
+    if(LineCount>=MAX_LINES)
+    {
+      printf("%s: too many lines\n", FileName);
+      exit(1);
+    }
+
+    strcpy(Lines[LineCount], Line);
+    LineNumbers[LineCount++]=Number;
+  }
+  fclose(File);
+}
+
+
+/***************************************************************//**
+   \fn CheckMove(uint8_t Axes, const int *XTargetBefore)
+   \brief Check the datagrams of an MVP command
+   \param Axes: bit mask of the moved axes
+   \param XTargetBefore: XTARGET of every driver before the command
+********************************************************************/
+static void CheckMove(uint8_t Axes, const int *XTargetBefore, uint32_t LineNumber)
+{
+  int XTarget[N_O_MOTORS];
+  uint32_t Count;
+  uint32_t Axis;
+  uint32_t i;
+
+  for(Axis=0; Axis<N_O_MOTORS; Axis++) XTarget[Axis]=XTargetBefore[Axis];
+
+  Count=SimGetDatagramCount();
+  CHECK(Count<LOG_SIZE, "line %u: datagram log full", LineNumber);
+  for(i=0; i<Count && i<LOG_SIZE; i++)
+  {
+    if(!Log[i].Write || Log[i].Which5130>=N_O_MOTORS) continue;
+
+    Axis=Log[i].Which5130;
+    if(Log[i].Address==TMC5130_XTARGET) XTarget[Axis]=Log[i].Value;
+    if(Log[i].Address==TMC5130_RAMPMODE && Log[i].Value==TMC5130_MODE_POSITION)
+    {
+      RampModeChecks++;
+      CHECK(Axes & (1<<Axis), "line %u: RAMPMODE of axis %u written", LineNumber, Axis);
+      CHECK(XTarget[Axis]==Targets[Axis], "line %u: axis %u switched to positioning with XTARGET %d instead of %d",
+            LineNumber, Axis, XTarget[Axis], Targets[Axis]);
+    }
+  }
+
+  for(Axis=0; Axis<N_O_MOTORS; Axis++)
+  {
+    if(!(Axes & (1<<Axis))) continue;
+
+    CHECK(SimGetRegister(WHICH_5130(Axis), TMC5130_RAMPMODE)==TMC5130_MODE_POSITION, "line %u: axis %u not in positioning mode",
+          LineNumber, Axis);
+    CHECK(SimGetRegister(WHICH_5130(Axis), TMC5130_XTARGET)==Targets[Axis], "line %u: XTARGET of axis %u is %d instead of %d",
+          LineNumber, Axis, SimGetRegister(WHICH_5130(Axis), TMC5130_XTARGET), Targets[Axis]);
+  }
+}
+
+
+/***************************************************************//**
+   \fn ExecuteCommand(const char *Line, uint32_t LineNumber)
+   \brief Send one TMCL command of the trace to the firmware
+********************************************************************/
+static void ExecuteCommand(const char *Line, uint32_t LineNumber)
+{
+  char Name[16];
+  char Type[16], Motor[16], Value[16];
+  int XTargetBefore[N_O_MOTORS];
+  uint8_t Opcode;
+  uint8_t Axes;
+  uint8_t Status;
+  int Reply;
+  uint32_t Axis;
+  uint32_t i;
+  int t, m, v;
+
+  if(sscanf(Line, "%15s %15s %15s %15s", Name, Type, Motor, Value)!=4)
+  {
+    printf("line %u: syntax error\n", LineNumber);
+    exit(1);
+  }
+  for(i=0; i<sizeof(Mnemonics)/sizeof(Mnemonics[0]); i++)
+    if(strcmp(Name, Mnemonics[i].Name)==0) break;
+  if(i==sizeof(Mnemonics)/sizeof(Mnemonics[0]))
+  {
+    printf("line %u: unknown command %s\n", LineNumber, Name);
+    exit(1);
+  }
+  Opcode=Mnemonics[i].Opcode;
+  t=strtol(Type, NULL, 0);
+  m=strtol(Motor, NULL, 0);
+  v=strtol(Value, NULL, 0);
+
+  //Axes moved by MVP and their new targets
+  Axes=0;
+  if(Opcode==TMCL_MVP)
+  {
+    if(t==MVP_COORD && (m & MVP_MULTI_AXIS)) Axes=m & ~MVP_MULTI_AXIS & ((1<<N_O_MOTORS)-1);
+    else if(m<N_O_MOTORS) Axes=1<<m;
+
+    for(Axis=0; Axis<N_O_MOTORS; Axis++)
+    {
+      XTargetBefore[Axis]=SimGetRegister(WHICH_5130(Axis), TMC5130_XTARGET);
+      if(!(Axes & (1<<Axis))) continue;
+
+      if(t==MVP_ABS) Targets[Axis]=v;
+      else if(t==MVP_REL) Targets[Axis]=XTargetBefore[Axis]+v;
+      else if(t==MVP_COORD && v>=0 && v<TMCL_COORDINATES) Targets[Axis]=Coordinates[Axis][v];
+    }
+  }
+  if(Opcode==TMCL_SCO && m<N_O_MOTORS && t>=0 && t<TMCL_COORDINATES) Coordinates[m][t]=v;
+
+  SimSetDatagramLog(Log, LOG_SIZE);
+  Status=SimCommand(Opcode, t, m, v, &Reply);
+  SimRunLoop(20);   //posted writes
+  Commands++;
+  CHECK(Status==REPLY_OK, "line %u: %s returned status %u", LineNumber, Name, Status);
+
+  if(Opcode==TMCL_MVP)
+  {
+    Moves++;
+    CheckMove(Axes, XTargetBefore, LineNumber);
+  }
+  SimSetDatagramLog(NULL, 0);
+}
+
+
+/***************************************************************//**
+   \fn WaitPosition(uint8_t Axes, uint32_t LineNumber)
+   \brief Poll until the axes have reached their targets
+********************************************************************/
+static void WaitPosition(uint8_t Axes, uint32_t LineNumber)
+{
+  uint32_t Time;
+  uint32_t Axis;
+  int Reached;
+
+  for(Time=0; Time<WAIT_TIMEOUT; Time+=10)
+  {
+    SimRunTime(10);
+    for(Axis=0; Axis<N_O_MOTORS; Axis++)
+    {
+      if(!(Axes & (1<<Axis))) continue;
+
+      SimCommand(TMCL_GAP, 8, Axis, 0, &Reached);
+      Commands++;
+      if(!Reached) break;
+    }
+    if(Axis==N_O_MOTORS) break;
+  }
+
+  for(Axis=0; Axis<N_O_MOTORS; Axis++)
+  {
+    if(!(Axes & (1<<Axis))) continue;
+
+    CHECK(SimGetRegister(WHICH_5130(Axis), TMC5130_XACTUAL)==Targets[Axis], "line %u: axis %u at %d instead of %d",
+          LineNumber, Axis, SimGetRegister(WHICH_5130(Axis), TMC5130_XACTUAL), Targets[Axis]);
+  }
+}
+
+
+/***************************************************************//**
+   \fn ReplayTrace(uint32_t First, uint32_t Last)
+   \brief Execute the lines First..Last-1 of the trace
+********************************************************************/
+static void ReplayTrace(uint32_t First, uint32_t Last)
+{
+  char Word[16];
+  uint32_t Line;
+  uint32_t End;
+  uint32_t Nesting;
+  int Value;
+  int i;
+
+  for(Line=First; Line<Last; Line++)
+  {
+    Value=0;
+    sscanf(Lines[Line], "%15s %i", Word, &Value);
+
+    if(strcmp(Word, "WAITPOS")==0) WaitPosition(Value, LineNumbers[Line]);
+    else if(strcmp(Word, "DELAY")==0) SimRunTime(Value);
+    else if(strcmp(Word, "REPEAT")==0)
+    {
+      Nesting=0;
+      for(End=Line+1; End<Last; End++)
+      {
+        sscanf(Lines[End], "%15s", Word);
+        if(strcmp(Word, "REPEAT")==0) Nesting++;
+        else if(strcmp(Word, "END")==0 && Nesting--==0) break;
+      }
+      if(End==Last)
+      {
+        printf("line %u: END missing\n", LineNumbers[Line]);
+        exit(1);
+      }
+
+      for(i=0; i<Value; i++) ReplayTrace(Line+1, End);
+      Line=End;
+    }
+    else ExecuteCommand(Lines[Line], LineNumbers[Line]);
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  TSimSPIStatistics Start;
+  uint32_t Saved;
+  uint32_t Sent;
+  uint64_t Cycles;
+
+  printf("Command trace replay: %u axes\n", N_O_MOTORS);
+  ReadTrace(argc>1 ? argv[1] : "CommandTrace.txt");
+
+  SimFirmwareStart();
+  SimRunLoop(100);
+
+  Start=SimSPIStatistics;
+  Saved=GetTMC5130SavedWriteCount();
+  Cycles=SimCycles;
+  ReplayTrace(0, LineCount);
+  Saved=GetTMC5130SavedWriteCount()-Saved;
+  Sent=SimSPIStatistics.Writes-Start.Writes;
+
+  printf("%u commands (%u MVP, %u RAMPMODE switches checked), %.1f s\n", Commands, Moves, RampModeChecks,
+         (double) (SimCycles-Cycles)/SIM_CPU_CLOCK);
+  printf("register writes: %u requested, %u sent, %u skipped (%.1f%%)\n", Sent+Saved, Sent, Saved,
+         100.0*Saved/(Sent+Saved));
+  printf("frames: %u (%u posted), read datagrams: %u\n", SimSPIStatistics.Frames-Start.Frames,
+         SimSPIStatistics.PostedFrames-Start.PostedFrames, SimSPIStatistics.Reads-Start.Reads);
+  printf("%u checks, %u failed\n", Checks, Failures);
+
+  return Failures>0 ? 2 : 0;
+}
@@ -0,0 +1,29 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file core_cmFunc.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: core_cmFunc.h
+ *         Description: Host replacement of the CMSIS core functions
+ *
+ *                      Used instead of lib/inc/core_cmFunc.h when the
+ *                      firmware is compiled for the host simulation
+ *                      (sim/host comes first in the include path). The
+ *                      interrupt lock is simulated by SimTMC5130.c:
+ *                      __enable_irq() delivers simulated interrupts
+ *                      that have become due while it was locked.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __CORE_CMFUNC_H
+#define __CORE_CMFUNC_H
+
+void __enable_irq(void);
+void __disable_irq(void);
+
+#endif
@@ -0,0 +1,36 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file max32660.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: max32660.h
+ *         Description: Host wrapper of the MAX32660 device header
+ *
+ *                      Includes lib/inc/max32660.h and redirects the
+ *                      peripherals that the firmware accesses directly
+ *                      (SPIMSS registers, NVIC) to the host simulation,
+ *                      as their real addresses do not exist on the host.
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __SIM_MAX32660_H
+#define __SIM_MAX32660_H
+
+#include_next "max32660.h"
+#include "spimss_regs.h"
+
+extern mxc_spimss_regs_t SimSPIMSSRegisters;
+
+#undef MXC_SPIMSS
+#define MXC_SPIMSS (&SimSPIMSSRegisters)
+
+void SimEnableIRQ(IRQn_Type IRQn);
+
+#define NVIC_EnableIRQ(IRQn) SimEnableIRQ(IRQn)
+
+#endif
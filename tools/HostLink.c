@@ -0,0 +1,396 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file HostLink.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: HostLink.c
+ *         Description: Master side of the Homebus link (host tools)
+ *
+ *                      Sends TMCL command frames to the module and
+ *                      receives its replies via a serial port (Linux,
+ *                      e.g. a USB/UART adapter with a Homebus
+ *                      transceiver), using the line code selected on
+ *                      the module (global parameter 128). The tools
+ *                      can also use a simulated link instead (see the
+ *                      Sim... members of THostLink).
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include "Homebus.h"
+#include "HostLink.h"
+
+//! Baud rates of the module (GP_BAUDRATE) supported by termios
+static const struct
+{
+  uint32_t Baudrate;
+  speed_t Speed;
+} Speeds[]=
+{
+  {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600},
+  {115200, B115200}, {230400, B230400}, {500000, B500000}, {1000000, B1000000}
+};
+
+
+/***************************************************************//**
+   \fn EncodeFrame(uint8_t *Raw, const uint8_t *Frame)
+   \brief Homebus line code (same as Homebus_data_encode() in ../Homebus.c)
+********************************************************************/
+static void EncodeFrame(uint8_t *Raw, const uint8_t *Frame)
+{
+  int i;
+
+  for(i=0; i<HL_FRAME_LENGTH; i++)
+  {
+    Raw[2*i]=((Frame[i] & 0x08)<<4)+((Frame[i] & 0x04)<<3)+((Frame[i] & 0x02)<<2)+((Frame[i] & 0x01)<<1)+0x55;
+    Raw[2*i+1]=(Frame[i] & 0x80)+((Frame[i] & 0x40)>>1)+((Frame[i] & 0x20)>>2)+((Frame[i] & 0x10)>>3)+0x55;
+  }
+}
+
+
+/***************************************************************//**
+   \fn DecodeFrame(uint8_t *Frame, const uint8_t *Raw)
+   \brief Homebus line code (same as Homebus_data_decode() in ../Homebus.c)
+********************************************************************/
+static void DecodeFrame(uint8_t *Frame, const uint8_t *Raw)
+{
+  int i;
+
+  for(i=0; i<HL_FRAME_LENGTH; i++)
+  {
+    Frame[i]=((Raw[2*i] & 0x80)>>4)+((Raw[2*i] & 0x20)>>3)+((Raw[2*i] & 0x08)>>2)+((Raw[2*i] & 0x02)>>1)+
+             (Raw[2*i+1] & 0x80)+((Raw[2*i+1] & 0x20)<<1)+((Raw[2*i+1] & 0x08)<<2)+((Raw[2*i+1] & 0x02)<<3);
+  }
+}
+
+
+/***************************************************************//**
+   \fn RawLength(const THostLink *Link)
+   \return Number of bytes of a frame on the line
+********************************************************************/
+static int RawLength(const THostLink *Link)
+{
+  return (Link->LineCode==HB_LINE_RAW) ? HL_FRAME_LENGTH : 2*HL_FRAME_LENGTH;
+}
+
+
+/***************************************************************//**
+   \fn ReadBytes(THostLink *Link, uint8_t *Data, int Count, uint32_t TimeoutUs)
+   \brief Read from the serial port
+   \return Number of bytes read before the timeout, -1 on error
+********************************************************************/
+static int ReadBytes(THostLink *Link, uint8_t *Data, int Count, uint32_t TimeoutUs)
+{
+  struct pollfd Poll;
+  uint64_t End;
+  uint64_t Now;
+  int Received;
+  int Result;
+
+  Received=0;
+  End=HostLinkTime(Link)+TimeoutUs;
+  while(Received<Count)
+  {
+    Now=HostLinkTime(Link);
+    if(Now>=End) break;
+
+    Poll.fd=Link->Handle;
+    Poll.events=POLLIN;
+    Result=poll(&Poll, 1, (int) ((End-Now+999)/1000));
+    if(Result<0)
+    {
+      if(errno==EINTR) continue;
+      return -1;
+    }
+    if(Result==0) break;
+
+    Result=read(Link->Handle, Data+Received, Count-Received);
+    if(Result<0)
+    {
+      if(errno==EINTR || errno==EAGAIN) continue;
+      return -1;
+    }
+    Received+=Result;
+  }
+
+  return Received;
+}
+
+
+/***************************************************************//**
+   \fn OpenHostLink(THostLink *Link, const char *Device, uint32_t Baudrate, uint8_t LineCode, uint8_t Echo)
+   \brief Open the serial port
+   \param Link: link to be initialised
+   \param Device: serial port (e.g. /dev/ttyUSB0)
+   \param Baudrate: baud rate of the module
+   \param LineCode: line code of the module (HB_LINE_xxx)
+   \param Echo: 1 if the adapter echoes the sent data
+   \return 0: OK, -1: error (message printed)
+
+   The module and host addresses are set to the defaults of the
+   firmware and can be changed afterwards.
+********************************************************************/
+int OpenHostLink(THostLink *Link, const char *Device, uint32_t Baudrate, uint8_t LineCode, uint8_t Echo)
+{
+  struct termios Tio;
+  size_t i;
+
+  memset(Link, 0, sizeof(*Link));
+  Link->Handle= -1;
+  Link->Baudrate=Baudrate;
+  Link->LineCode=LineCode;
+  Link->Echo=Echo;
+  Link->ModuleAddress=1;
+  Link->HostAddress=2;
+
+  for(i=0; i<sizeof(Speeds)/sizeof(Speeds[0]); i++)
+    if(Speeds[i].Baudrate==Baudrate) break;
+  if(i==sizeof(Speeds)/sizeof(Speeds[0]))
+  {
+    fprintf(stderr, "baud rate %u not supported\n", (unsigned) Baudrate);
+    return -1;
+  }
+
+  Link->Handle=open(Device, O_RDWR|O_NOCTTY);
+  if(Link->Handle<0)
+  {
+    perror(Device);
+    return -1;
+  }
+
+  if(tcgetattr(Link->Handle, &Tio)<0)
+  {
+    perror(Device);
+    close(Link->Handle);
+    Link->Handle= -1;
+    return -1;
+  }
+  cfmakeraw(&Tio);
+  Tio.c_cflag|=CLOCAL|CREAD;
+  Tio.c_cflag&= ~(CSTOPB|PARENB|CRTSCTS);
+  Tio.c_cc[VMIN]=0;
+  Tio.c_cc[VTIME]=0;
+  cfsetispeed(&Tio, Speeds[i].Speed);
+  cfsetospeed(&Tio, Speeds[i].Speed);
+  if(tcsetattr(Link->Handle, TCSANOW, &Tio)<0)
+  {
+    perror(Device);
+    close(Link->Handle);
+    Link->Handle= -1;
+    return -1;
+  }
+  tcflush(Link->Handle, TCIOFLUSH);
+
+  return 0;
+}
+
+
+/***************************************************************//**
+   \fn CloseHostLink(THostLink *Link)
+   \brief Close the serial port
+********************************************************************/
+void CloseHostLink(THostLink *Link)
+{
+  if(Link->Handle>=0) close(Link->Handle);
+  Link->Handle= -1;
+}
+
+
+/***************************************************************//**
+   \fn HostLinkFrameTime(const THostLink *Link)
+   \return Time needed for sending one frame (µs, 10 bits per byte)
+********************************************************************/
+uint32_t HostLinkFrameTime(const THostLink *Link)
+{
+  return (uint32_t) ((RawLength(Link)*10ULL*1000000+Link->Baudrate-1)/Link->Baudrate);
+}
+
+
+/***************************************************************//**
+   \fn HostLinkTime(THostLink *Link)
+   \return Time (µs, monotonic or simulated)
+********************************************************************/
+uint64_t HostLinkTime(THostLink *Link)
+{
+  struct timespec Now;
+
+  if(Link->SimTime) return Link->SimTime(Link);
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (uint64_t) Now.tv_sec*1000000+Now.tv_nsec/1000;
+}
+
+
+/***************************************************************//**
+   \fn HostLinkWaitUntil(THostLink *Link, uint64_t Time)
+   \brief Wait until the given time (µs, see HostLinkTime())
+********************************************************************/
+void HostLinkWaitUntil(THostLink *Link, uint64_t Time)
+{
+  uint64_t Now;
+
+  if(Link->SimWait)
+  {
+    Link->SimWait(Link, Time);
+    return;
+  }
+
+  for(;;)
+  {
+    Now=HostLinkTime(Link);
+    if(Now>=Time) break;
+    if(Time-Now>2000) usleep((useconds_t) (Time-Now-1000));
+  }
+}
+
+
+/***************************************************************//**
+   \fn BuildCommandFrame(const THostLink *Link, uint8_t *Frame, uint8_t Opcode, uint8_t Type, uint8_t Motor, uint32_t Value)
+   \brief Build a TMCL command frame (with checksum)
+********************************************************************/
+void BuildCommandFrame(const THostLink *Link, uint8_t *Frame, uint8_t Opcode, uint8_t Type, uint8_t Motor, uint32_t Value)
+{
+  int i;
+
+  Frame[0]=Link->ModuleAddress;
+  Frame[1]=Opcode;
+  Frame[2]=Type;
+  Frame[3]=Motor;
+  Frame[4]=Value>>24;
+  Frame[5]=Value>>16;
+  Frame[6]=Value>>8;
+  Frame[7]=Value;
+  Frame[8]=0;
+  for(i=0; i<8; i++) Frame[8]+=Frame[i];
+}
+
+
+/***************************************************************//**
+   \fn SendFrame(THostLink *Link, const uint8_t *Frame)
+   \brief Send a frame (9 bytes, encoded according to the line code)
+   \return 0: OK, -1: error
+********************************************************************/
+int SendFrame(THostLink *Link, const uint8_t *Frame)
+{
+  uint8_t Raw[2*HL_FRAME_LENGTH];
+  uint8_t Echo[2*HL_FRAME_LENGTH];
+  int Length;
+
+  if(Link->SimSend)
+  {
+    Link->SimSend(Link, Frame);
+    return 0;
+  }
+
+  Length=RawLength(Link);
+  if(Link->LineCode==HB_LINE_RAW)
+    memcpy(Raw, Frame, HL_FRAME_LENGTH);
+  else
+    EncodeFrame(Raw, Frame);
+
+  if(write(Link->Handle, Raw, Length)!=Length) return -1;
+  tcdrain(Link->Handle);
+
+  if(Link->Echo)
+  {
+    if(ReadBytes(Link, Echo, Length, 2*HostLinkFrameTime(Link)+10000)!=Length) return -1;
+  }
+
+  return 0;
+}
+
+
+/***************************************************************//**
+   \fn ReceiveFrame(THostLink *Link, uint8_t *Frame, uint32_t TimeoutUs)
+   \brief Receive a frame
+   \param Frame: buffer for the decoded frame (9 bytes)
+   \param TimeoutUs: timeout (µs)
+   \return 1: frame received, 0: timeout (incomplete data is
+           discarded), -1: error
+********************************************************************/
+int ReceiveFrame(THostLink *Link, uint8_t *Frame, uint32_t TimeoutUs)
+{
+  uint8_t Raw[2*HL_FRAME_LENGTH];
+  int Length;
+  int Received;
+
+  if(Link->SimReceive) return Link->SimReceive(Link, Frame, TimeoutUs);
+
+  Length=RawLength(Link);
+  Received=ReadBytes(Link, Raw, Length, TimeoutUs);
+  if(Received<0) return -1;
+  if(Received<Length)
+  {
+    tcflush(Link->Handle, TCIFLUSH);
+    return 0;
+  }
+
+  if(Link->LineCode==HB_LINE_RAW)
+    memcpy(Frame, Raw, HL_FRAME_LENGTH);
+  else
+    DecodeFrame(Frame, Raw);
+
+  return 1;
+}
+
+
+/***************************************************************//**
+   \fn CheckReplyFrame(const THostLink *Link, const uint8_t *Frame)
+   \return 1 if the frame is a reply of the module with correct checksum
+********************************************************************/
+int CheckReplyFrame(const THostLink *Link, const uint8_t *Frame)
+{
+  uint8_t Checksum;
+  int i;
+
+  Checksum=0;
+  for(i=0; i<8; i++) Checksum+=Frame[i];
+
+  return Checksum==Frame[8] && Frame[0]==Link->HostAddress && Frame[1]==Link->ModuleAddress;
+}
+
+
+/***************************************************************//**
+   \fn FrameValue(const uint8_t *Frame)
+   \return Value of a reply frame (bytes 4..7, MSB first)
+********************************************************************/
+uint32_t FrameValue(const uint8_t *Frame)
+{
+  return ((uint32_t) Frame[4]<<24)|((uint32_t) Frame[5]<<16)|((uint32_t) Frame[6]<<8)|Frame[7];
+}
+
+
+/***************************************************************//**
+   \fn SendCommand(THostLink *Link, uint8_t Opcode, uint8_t Type, uint8_t Motor, uint32_t Value, uint8_t *Status, uint32_t *Reply)
+   \brief Send a command and receive the (standard) reply
+   \param Status: pointer to variable for the status (may be NULL)
+   \param Reply: pointer to variable for the reply value (may be NULL)
+   \return 0: OK, -1: no valid reply within 100ms
+********************************************************************/
+int SendCommand(THostLink *Link, uint8_t Opcode, uint8_t Type, uint8_t Motor, uint32_t Value,
+                uint8_t *Status, uint32_t *Reply)
+{
+  uint8_t Frame[HL_FRAME_LENGTH];
+
+  BuildCommandFrame(Link, Frame, Opcode, Type, Motor, Value);
+  if(SendFrame(Link, Frame)<0) return -1;
+  if(ReceiveFrame(Link, Frame, 100000)!=1 || !CheckReplyFrame(Link, Frame)) return -1;
+
+  if(Status) *Status=Frame[2];
+  if(Reply) *Reply=FrameValue(Frame);
+
+  return 0;
+}
@@ -0,0 +1,53 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file HostLink.h ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: HostLink.h
+ *         Description: Master side of the Homebus link (host tools)
+ *
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#ifndef __HOST_LINK_H
+#define __HOST_LINK_H
+
+#include <stdint.h>
+
+#define HL_FRAME_LENGTH 9    //!< length of a TMCL command or reply frame
+
+//! Connection to the module (serial port or simulation)
+typedef struct THostLink
+{
+  int Handle;                 //!< file descriptor of the serial port (-1: simulation)
+  uint32_t Baudrate;          //!< baud rate (bps)
+  uint8_t LineCode;           //!< HB_LINE_ENCODED or HB_LINE_RAW
+  uint8_t Echo;               //!< 1: the adapter echoes the sent bytes (discarded)
+  uint8_t ModuleAddress;      //!< address of the module
+  uint8_t HostAddress;        //!< host address (expected in the replies)
+  void *SimContext;           //!< context of the simulation
+  void (*SimSend)(struct THostLink *Link, const uint8_t *Frame);                    //!< simulation: send a frame
+  int (*SimReceive)(struct THostLink *Link, uint8_t *Frame, uint32_t TimeoutUs);    //!< simulation: receive a frame
+  uint64_t (*SimTime)(struct THostLink *Link);                                       //!< simulation: time (µs)
+  void (*SimWait)(struct THostLink *Link, uint64_t Time);                           //!< simulation: wait until the time (µs)
+} THostLink;
+
+int OpenHostLink(THostLink *Link, const char *Device, uint32_t Baudrate, uint8_t LineCode, uint8_t Echo);
+void CloseHostLink(THostLink *Link);
+uint32_t HostLinkFrameTime(const THostLink *Link);
+uint64_t HostLinkTime(THostLink *Link);
+void HostLinkWaitUntil(THostLink *Link, uint64_t Time);
+void BuildCommandFrame(const THostLink *Link, uint8_t *Frame, uint8_t Opcode, uint8_t Type, uint8_t Motor, uint32_t Value);
+int SendFrame(THostLink *Link, const uint8_t *Frame);
+int ReceiveFrame(THostLink *Link, uint8_t *Frame, uint32_t TimeoutUs);
+int CheckReplyFrame(const THostLink *Link, const uint8_t *Frame);
+int SendCommand(THostLink *Link, uint8_t Opcode, uint8_t Type, uint8_t Motor, uint32_t Value,
+                uint8_t *Status, uint32_t *Reply);
+uint32_t FrameValue(const uint8_t *Frame);
+
+#endif
@@ -0,0 +1,520 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file LinkTestHost.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: LinkTestHost.c
+ *         Description: Master for the Homebus link test (see ../LinkTest.c)
+ *
+ *                      Sweeps the offered frame rate. For every rate the
+ *                      loopback mode is started (LT_START), a number of
+ *                      pattern frames is sent (LT_PATTERN, sequence
+ *                      number in the motor byte, xorshift patterns), the
+ *                      loopback mode is stopped and the counters of the
+ *                      module are read (LT_RESULT). Printed per rate:
+ *                        - achieved frame rate and goodput (pattern bits
+ *                          echoed correctly per second)
+ *                        - BER to the module, estimated from the frames
+ *                          the module has not received correctly (lost
+ *                          or wrong pattern, 72 bits per frame; a frame
+ *                          with checksum error is counted as lost with
+ *                          the next good frame)
+ *                        - BER from the module: wrong bits in the
+ *                          replies (compared with the nearest possible
+ *                          reply)
+ *                        - invalid replies (missing or wrong), lost frames,
+ *                          out of order and with checksum error as
+ *                          counted by the module, round trip time in the
+ *                          module (reply sent => next frame received)
+ *
+ *                      With -S the module is simulated (../LinkTest.c
+ *                      behind a channel with the given bit error rate,
+ *                      simulated time), e.g. for checking the tool:
+ *                        ./LinkTestHost -S 1e-4
+ *                      With a real module:
+ *                        ./LinkTestHost -b 230400 /dev/ttyUSB0
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "Homebus.h"
+#include "TMCL.h"
+#include "LinkTest.h"
+#include "HostLink.h"
+
+#define DEFAULT_SEED     0x12345678    //!< seed of the pattern generator
+#define DEFAULT_FRAMES   2000          //!< pattern frames per rate
+#define MODULE_CLOCK_MHZ 96            //!< CPU clock of the module (round trip time in cycles)
+#define SIM_LATENCY_US   30            //!< simulation: time from command received to reply sent
+
+//! Offered frame rates of the sweep (frames/s, 0: as fast as possible)
+static const uint32_t DefaultRates[]={50, 100, 200, 500, 1000, 2000, 0};
+
+//! Simulated module and channel
+typedef struct
+{
+  uint64_t Time;                 //!< simulated time (µs)
+  double BitErrorRate;           //!< bit error rate of the channel (both directions)
+  uint64_t Random;               //!< state of the random generator of the channel
+  uint8_t Reply[HL_FRAME_LENGTH];   //!< reply of the module on its way to the master
+  uint8_t ReplyPending;          //!< 1: Reply is on its way
+  uint64_t ReplyTime;            //!< time when the reply has been received completely
+} TSimModule;
+
+static TSimModule SimModule;
+
+
+/***************************************************************//**
+   \fn NextPattern(uint32_t Pattern)
+   \brief Pattern generator (same xorshift as in ../LinkTest.c)
+********************************************************************/
+static uint32_t NextPattern(uint32_t Pattern)
+{
+  Pattern^=Pattern << 13;
+  Pattern^=Pattern >> 17;
+  Pattern^=Pattern << 5;
+
+  return Pattern;
+}
+
+
+/* Time base of ../LinkTest.c in the simulation */
+uint32_t GetSysTimer(void)
+{
+  return (uint32_t) (SimModule.Time/1000);
+}
+
+uint32_t GetCycleCounter(void)
+{
+  return (uint32_t) (SimModule.Time*MODULE_CLOCK_MHZ);
+}
+
+
+/***************************************************************//**
+   \fn SimRandom(void)
+   \return Uniformly distributed random number 0..1 (channel model)
+********************************************************************/
+static double SimRandom(void)
+{
+  SimModule.Random^=SimModule.Random<<13;
+  SimModule.Random^=SimModule.Random>>7;
+  SimModule.Random^=SimModule.Random<<17;
+
+  return (SimModule.Random>>11)*(1.0/9007199254740992.0);
+}
+
+
+/***************************************************************//**
+   \fn SimChannel(uint8_t *Frame)
+   \brief Flip every bit of the frame with the bit error rate
+********************************************************************/
+static void SimChannel(uint8_t *Frame)
+{
+  int i, j;
+
+  if(SimModule.BitErrorRate<=0) return;
+  for(i=0; i<HL_FRAME_LENGTH; i++)
+    for(j=0; j<8; j++)
+      if(SimRandom()<SimModule.BitErrorRate) Frame[i]^=1<<j;
+}
+
+
+/***************************************************************//**
+   \fn SimSend(THostLink *Link, const uint8_t *Frame)
+   \brief Simulation: the module receives a frame and replies
+
+   The command handling is the one of LinkTest() and ProcessCommand()
+   in ../TMCL.c (only the link test command is supported).
+********************************************************************/
+static void SimSend(THostLink *Link, const uint8_t *Frame)
+{
+  uint8_t Command[HL_FRAME_LENGTH];
+  uint8_t Checksum;
+  uint8_t Status;
+  uint32_t Value;
+  uint32_t Result;
+  int i;
+
+  memcpy(Command, Frame, HL_FRAME_LENGTH);
+  SimChannel(Command);
+  SimModule.Time+=HostLinkFrameTime(Link);
+  SimModule.ReplyPending=0;
+
+  ProcessLinkTest();
+  if(Command[0]!=Link->ModuleAddress) return;
+
+  Checksum=0;
+  for(i=0; i<8; i++) Checksum+=Command[i];
+  Status=REPLY_OK;
+  Value=((uint32_t) Command[4]<<24)|((uint32_t) Command[5]<<16)|((uint32_t) Command[6]<<8)|Command[7];
+  if(Checksum!=Command[8])
+  {
+    LinkTestChecksumError();
+    Status=REPLY_CHKERR;
+    Command[1]=0;
+    Value=0;
+  }
+  else if(Command[1]!=TMCL_LinkTest)
+  {
+    Status=REPLY_INVALID_CMD;
+  }
+  else
+  {
+    switch(Command[2])
+    {
+      case LT_START:
+        StartLinkTest(Value);
+        break;
+
+      case LT_PATTERN:
+        if(LinkTestActive())
+        {
+          if(!LinkTestPattern(Command[3], Value)) Status=REPLY_INVALID_VALUE;
+        }
+        else Status=REPLY_CMD_NOT_AVAILABLE;
+        break;
+
+      case LT_STOP:
+        StopLinkTest();
+        break;
+
+      case LT_RESULT:
+        if(GetLinkTestResult(Command[3], &Result))
+          Value=Result;
+        else
+          Status=REPLY_INVALID_VALUE;
+        break;
+
+      default:
+        Status=REPLY_WRONG_TYPE;
+        break;
+    }
+  }
+
+  SimModule.Time+=SIM_LATENCY_US;
+  SimModule.Reply[0]=Link->HostAddress;
+  SimModule.Reply[1]=Link->ModuleAddress;
+  SimModule.Reply[2]=Status;
+  SimModule.Reply[3]=Command[1];
+  SimModule.Reply[4]=Value>>24;
+  SimModule.Reply[5]=Value>>16;
+  SimModule.Reply[6]=Value>>8;
+  SimModule.Reply[7]=Value;
+  SimModule.Reply[8]=0;
+  for(i=0; i<8; i++) SimModule.Reply[8]+=SimModule.Reply[i];
+  if(Command[1]==TMCL_LinkTest) LinkTestReplySent();
+
+  SimChannel(SimModule.Reply);
+  SimModule.ReplyPending=1;
+  SimModule.ReplyTime=SimModule.Time+HostLinkFrameTime(Link);
+}
+
+
+/***************************************************************//**
+   \fn SimReceive(THostLink *Link, uint8_t *Frame, uint32_t TimeoutUs)
+   \brief Simulation: receive the reply of the module
+********************************************************************/
+static int SimReceive(THostLink *Link, uint8_t *Frame, uint32_t TimeoutUs)
+{
+  (void) Link;
+
+  if(SimModule.ReplyPending && SimModule.ReplyTime<=SimModule.Time+TimeoutUs)
+  {
+    SimModule.Time=SimModule.ReplyTime;
+    SimModule.ReplyPending=0;
+    memcpy(Frame, SimModule.Reply, HL_FRAME_LENGTH);
+    return 1;
+  }
+
+  SimModule.Time+=TimeoutUs;
+  return 0;
+}
+
+
+static uint64_t SimTime(THostLink *Link)
+{
+  (void) Link;
+  return SimModule.Time;
+}
+
+
+static void SimWait(THostLink *Link, uint64_t Time)
+{
+  (void) Link;
+  if(Time>SimModule.Time) SimModule.Time=Time;
+}
+
+
+/***************************************************************//**
+   \fn ReadResult(THostLink *Link, uint8_t Index, uint32_t *Result)
+   \brief Read a result of the module (LT_RESULT), three attempts
+   \return 0: OK, -1: no valid reply
+********************************************************************/
+static int ReadResult(THostLink *Link, uint8_t Index, uint32_t *Result)
+{
+  uint8_t Status;
+  int i;
+
+  for(i=0; i<3; i++)
+  {
+    if(SendCommand(Link, TMCL_LinkTest, LT_RESULT, Index, 0, &Status, Result)==0 &&
+       (Status==REPLY_OK || Status==REPLY_OK_EVENT)) return 0;
+  }
+
+  return -1;
+}
+
+
+/***************************************************************//**
+   \fn ReplyBitDistance(const THostLink *Link, const uint8_t *Frame, uint32_t Pattern)
+   \brief Wrong bits in the reply to a pattern frame
+   \return Number of bits differing from the nearest possible reply
+
+   Possible replies: the pattern echoed with status REPLY_OK or
+   REPLY_INVALID_VALUE (the module has received a wrong pattern) and
+   the reply to a frame with checksum error. Taking the nearest one
+   keeps the errors on the way to the module out of the count.
+********************************************************************/
+static uint32_t ReplyBitDistance(const THostLink *Link, const uint8_t *Frame, uint32_t Pattern)
+{
+  static const uint8_t Status[3]={REPLY_OK, REPLY_INVALID_VALUE, REPLY_CHKERR};
+  uint8_t Expected[HL_FRAME_LENGTH];
+  uint32_t Distance;
+  uint32_t Min;
+  int i, j;
+
+  Min=8*HL_FRAME_LENGTH;
+  for(i=0; i<3; i++)
+  {
+    Expected[0]=Link->HostAddress;
+    Expected[1]=Link->ModuleAddress;
+    Expected[2]=Status[i];
+    Expected[3]=(Status[i]==REPLY_CHKERR) ? 0 : TMCL_LinkTest;
+    Expected[4]=(Status[i]==REPLY_CHKERR) ? 0 : Pattern>>24;
+    Expected[5]=(Status[i]==REPLY_CHKERR) ? 0 : Pattern>>16;
+    Expected[6]=(Status[i]==REPLY_CHKERR) ? 0 : Pattern>>8;
+    Expected[7]=(Status[i]==REPLY_CHKERR) ? 0 : Pattern;
+    Expected[8]=0;
+    for(j=0; j<8; j++) Expected[8]+=Expected[j];
+
+    Distance=0;
+    for(j=0; j<HL_FRAME_LENGTH; j++) Distance+=__builtin_popcount(Frame[j]^Expected[j]);
+    if(Distance<Min) Min=Distance;
+  }
+
+  return Min;
+}
+
+
+/***************************************************************//**
+   \fn RunRate(THostLink *Link, uint32_t Rate, uint32_t Frames, uint32_t Seed)
+   \brief Link test with one offered frame rate
+   \param Rate: frames/s (0: next frame right after the reply)
+   \param Frames: number of pattern frames
+   \param Seed: seed of the pattern generator
+   \return 0: OK, -1: module does not answer
+********************************************************************/
+static int RunRate(THostLink *Link, uint32_t Rate, uint32_t Frames, uint32_t Seed)
+{
+  uint8_t Frame[HL_FRAME_LENGTH];
+  uint8_t Status;
+  uint32_t Pattern;
+  uint32_t Results[LTR_OUT_OF_ORDER+1];
+  uint32_t NoReply;
+  uint32_t BadReply;
+  uint32_t GoodFrames;
+  uint32_t ReplyBitErrors;
+  uint32_t Replies;
+  uint32_t FrameErrors;
+  uint64_t Start;
+  uint64_t Elapsed;
+  uint32_t Timeout;
+  uint32_t i;
+  int Result;
+  double Seconds;
+
+  if(SendCommand(Link, TMCL_LinkTest, LT_START, 0, Seed, &Status, NULL)<0)
+  {
+    fprintf(stderr, "no reply to LT_START\n");
+    return -1;
+  }
+
+  NoReply=0;
+  BadReply=0;
+  GoodFrames=0;
+  ReplyBitErrors=0;
+  Replies=0;
+  Pattern=Seed;
+  Timeout=2*HostLinkFrameTime(Link)+5000;
+  Start=HostLinkTime(Link);
+  for(i=0; i<Frames; i++)
+  {
+    if(Rate>0) HostLinkWaitUntil(Link, Start+(uint64_t) i*1000000/Rate);
+
+    BuildCommandFrame(Link, Frame, TMCL_LinkTest, LT_PATTERN, i & 0xff, Pattern);
+    if(SendFrame(Link, Frame)<0) return -1;
+
+    Result=ReceiveFrame(Link, Frame, Timeout);
+    if(Result<0) return -1;
+    if(Result==0)
+    {
+      NoReply++;
+    }
+    else
+    {
+      Replies++;
+      ReplyBitErrors+=ReplyBitDistance(Link, Frame, Pattern);
+      if(!CheckReplyFrame(Link, Frame) || Frame[3]!=TMCL_LinkTest)
+        BadReply++;
+      else if((Frame[2]==REPLY_OK || Frame[2]==REPLY_OK_EVENT) && FrameValue(Frame)==Pattern)
+        GoodFrames++;
+    }
+    Pattern=NextPattern(Pattern);
+  }
+  Elapsed=HostLinkTime(Link)-Start;
+
+  SendCommand(Link, TMCL_LinkTest, LT_STOP, 0, 0, NULL, NULL);
+  for(i=0; i<=LTR_OUT_OF_ORDER; i++)
+  {
+    if(ReadResult(Link, i, &Results[i])<0)
+    {
+      fprintf(stderr, "LT_RESULT %u: no reply\n", (unsigned) i);
+      return -1;
+    }
+  }
+
+  //Frames not received correctly by the module (the lost frames include
+  //the frames with checksum error, the frames after the last good one
+  //are not counted as lost)
+  FrameErrors=Results[LTR_LOST_FRAMES]+Results[LTR_BAD_FRAMES]+(Frames-Results[LTR_FRAMES]-Results[LTR_LOST_FRAMES]-Results[LTR_OUT_OF_ORDER]);
+
+  Seconds=Elapsed/1e6;
+  if(Rate>0) printf("%8u", (unsigned) Rate); else printf("%8s", "max");
+  printf(" %8.0f %10.0f %10.2e %10.2e %7u %6u %6u %6u %6u %8.0f\n",
+         Frames/Seconds, GoodFrames*32.0/Seconds,
+         1.0-pow(1.0-(double) FrameErrors/Frames, 1.0/(8*HL_FRAME_LENGTH)),
+         Replies>0 ? (double) ReplyBitErrors/(Replies*8.0*HL_FRAME_LENGTH) : 0.0,
+         (unsigned) (NoReply+BadReply), (unsigned) Results[LTR_LOST_FRAMES],
+         (unsigned) Results[LTR_OUT_OF_ORDER], (unsigned) Results[LTR_CHKERR],
+         (unsigned) Results[LTR_BAD_FRAMES], (double) Results[LTR_RTT_AVG]/MODULE_CLOCK_MHZ);
+
+  return 0;
+}
+
+
+static void Usage(void)
+{
+  fprintf(stderr,
+          "usage: LinkTestHost [options] <serial port>\n"
+          "       LinkTestHost [options] -S <bit error rate>\n"
+          "  -b <baud>     baud rate of the module (default 230400)\n"
+          "  -r            raw line code (default: Homebus encoded)\n"
+          "  -e            the adapter echoes the sent data\n"
+          "  -a <address>  module address (default 1)\n"
+          "  -h <address>  host address (default 2)\n"
+          "  -n <frames>   pattern frames per rate (default %d)\n"
+          "  -s <seed>     seed of the pattern generator\n"
+          "  -R <rate>     offered frame rate (frames/s, 0: maximum), can be repeated\n",
+          DEFAULT_FRAMES);
+}
+
+
+int main(int argc, char *argv[])
+{
+  THostLink Link;
+  uint32_t Rates[32];
+  uint32_t RateCount;
+  uint32_t Baudrate;
+  uint32_t Frames;
+  uint32_t Seed;
+  uint8_t LineCode;
+  uint8_t Echo;
+  uint8_t ModuleAddress;
+  uint8_t HostAddress;
+  double BitErrorRate;
+  int Simulate;
+  uint32_t i;
+  int c;
+
+  Baudrate=230400;
+  LineCode=HB_LINE_ENCODED;
+  Echo=0;
+  ModuleAddress=1;
+  HostAddress=2;
+  Frames=DEFAULT_FRAMES;
+  Seed=DEFAULT_SEED;
+  RateCount=0;
+  Simulate=0;
+  BitErrorRate=0;
+
+  while((c=getopt(argc, argv, "b:rea:h:n:s:R:S:"))!= -1)
+  {
+    switch(c)
+    {
+      case 'b': Baudrate=strtoul(optarg, NULL, 0); break;
+      case 'r': LineCode=HB_LINE_RAW; break;
+      case 'e': Echo=1; break;
+      case 'a': ModuleAddress=strtoul(optarg, NULL, 0); break;
+      case 'h': HostAddress=strtoul(optarg, NULL, 0); break;
+      case 'n': Frames=strtoul(optarg, NULL, 0); break;
+      case 's': Seed=strtoul(optarg, NULL, 0); break;
+      case 'R':
+        if(RateCount<sizeof(Rates)/sizeof(Rates[0])) Rates[RateCount++]=strtoul(optarg, NULL, 0);
+        break;
+      case 'S': Simulate=1; BitErrorRate=atof(optarg); break;
+      default: Usage(); return 1;
+    }
+  }
+  if(Seed==0 || Frames==0 || (!Simulate && optind!=argc-1))
+  {
+    Usage();
+    return 1;
+  }
+  if(RateCount==0)
+  {
+    for(i=0; i<sizeof(DefaultRates)/sizeof(DefaultRates[0]); i++) Rates[RateCount++]=DefaultRates[i];
+  }
+
+  if(Simulate)
+  {
+    memset(&Link, 0, sizeof(Link));
+    Link.Handle= -1;
+    Link.Baudrate=Baudrate;
+    Link.LineCode=LineCode;
+    Link.SimContext=&SimModule;
+    Link.SimSend=SimSend;
+    Link.SimReceive=SimReceive;
+    Link.SimTime=SimTime;
+    Link.SimWait=SimWait;
+    SimModule.BitErrorRate=BitErrorRate;
+    SimModule.Random=0x9e3779b97f4a7c15ULL;
+  }
+  else if(OpenHostLink(&Link, argv[optind], Baudrate, LineCode, Echo)<0) return 1;
+  Link.ModuleAddress=ModuleAddress;
+  Link.HostAddress=HostAddress;
+
+  if(Simulate)
+    printf("simulated module, channel BER %.1e, ", BitErrorRate);
+  printf("%u baud, %s line code, %u frames per rate, frame time %u us\n", (unsigned) Baudrate,
+         LineCode==HB_LINE_RAW ? "raw":"encoded", (unsigned) Frames, (unsigned) HostLinkFrameTime(&Link));
+  printf("offered frames/s    goodput     BER to   BER from  invalid   lost  order chkerr    bad RTT (us)\n");
+  printf("  (1/s)              (bit/s)     module     module  replies\n");
+  for(i=0; i<RateCount; i++)
+  {
+    if(RunRate(&Link, Rates[i], Frames, Seed)<0) break;
+  }
+
+  CloseHostLink(&Link);
+
+  return 0;
+}
@@ -0,0 +1,492 @@
+/*******************************************************************************
+* Copyright © 2026 Analog Devices, Inc.
+*******************************************************************************/
+
+/** \file RegisterDumpDecode.c ***********************************************************
+ *
+ *             Project: Homebus Reference Design
+ *            Filename: RegisterDumpDecode.c
+ *         Description: Read and decode a TMC5130/TMC5160 register dump
+ *
+ *                      Sends the RegisterDump command (157) to the module,
+ *                      receives the reply (header frame with the number of
+ *                      registers, then one frame per register, see
+ *                      RegisterDump() in ../TMCL.c) and prints every
+ *                      register with its name, its value and its bit
+ *                      fields. Registers that cannot be read are marked
+ *                      as software copy (last value written).
+ *
+ *                      The frames can also be read from a file (one frame
+ *                      per line, 9 hex bytes, '#' starts a comment), e.g.
+ *                      one saved before with -x:
+ *                        ./RegisterDumpDecode -x /dev/ttyUSB0 >dump.txt
+ *                        ./RegisterDumpDecode -f dump.txt
+ *
+ *    Revision History:
+ *                    2026_10_18    Rev 1.00    File created
+ *
+ *  -------------------------------------------------------------------- */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "Homebus.h"
+#include "TMCL.h"
+#include "HostLink.h"
+
+#define MAX_DUMP_FRAMES  TMCL_MAX_REPLY_FRAMES
+
+#define DEV_5130  1      //!< register or field exists on the TMC5130
+#define DEV_5160  2      //!< register or field exists on the TMC5160
+#define DEV_BOTH  (DEV_5130|DEV_5160)
+
+//! Register name
+typedef struct
+{
+  uint8_t Address;
+  uint8_t Devices;       //!< DEV_xxx
+  uint8_t Signed;        //!< width of a signed value (0: unsigned)
+  const char *Name;
+} TRegisterName;
+
+//! Bit field of a register
+typedef struct
+{
+  uint8_t Address;
+  uint8_t Devices;       //!< DEV_xxx
+  uint8_t Shift;
+  uint8_t Width;
+  uint8_t Signed;        //!< 1: two's complement
+  const char *Name;
+} TRegisterField;
+
+static const TRegisterName RegisterNames[]=
+{
+  {0x00, DEV_BOTH, 0, "GCONF"},       {0x01, DEV_BOTH, 0, "GSTAT"},
+  {0x02, DEV_BOTH, 0, "IFCNT"},       {0x03, DEV_BOTH, 0, "SLAVECONF"},
+  {0x04, DEV_BOTH, 0, "IOIN"},        {0x05, DEV_BOTH, 32, "X_COMPARE"},
+  {0x06, DEV_5160, 0, "OTP_PROG"},    {0x07, DEV_5160, 0, "OTP_READ"},
+  {0x08, DEV_5160, 0, "FACTORY_CONF"},{0x09, DEV_5160, 0, "SHORT_CONF"},
+  {0x0A, DEV_5160, 0, "DRV_CONF"},    {0x0B, DEV_5160, 0, "GLOBAL_SCALER"},
+  {0x0C, DEV_5160, 0, "OFFSET_READ"},
+  {0x10, DEV_BOTH, 0, "IHOLD_IRUN"},  {0x11, DEV_BOTH, 0, "TPOWERDOWN"},
+  {0x12, DEV_BOTH, 0, "TSTEP"},       {0x13, DEV_BOTH, 0, "TPWMTHRS"},
+  {0x14, DEV_BOTH, 0, "TCOOLTHRS"},   {0x15, DEV_BOTH, 0, "THIGH"},
+  {0x20, DEV_BOTH, 0, "RAMPMODE"},    {0x21, DEV_BOTH, 32, "XACTUAL"},
+  {0x22, DEV_BOTH, 24, "VACTUAL"},    {0x23, DEV_BOTH, 0, "VSTART"},
+  {0x24, DEV_BOTH, 0, "A1"},          {0x25, DEV_BOTH, 0, "V1"},
+  {0x26, DEV_BOTH, 0, "AMAX"},        {0x27, DEV_BOTH, 0, "VMAX"},
+  {0x28, DEV_BOTH, 0, "DMAX"},        {0x2A, DEV_BOTH, 0, "D1"},
+  {0x2B, DEV_BOTH, 0, "VSTOP"},       {0x2C, DEV_BOTH, 0, "TZEROWAIT"},
+  {0x2D, DEV_BOTH, 32, "XTARGET"},    {0x33, DEV_BOTH, 0, "VDCMIN"},
+  {0x34, DEV_BOTH, 0, "SW_MODE"},     {0x35, DEV_BOTH, 0, "RAMP_STAT"},
+  {0x36, DEV_BOTH, 32, "XLATCH"},     {0x38, DEV_BOTH, 0, "ENCMODE"},
+  {0x39, DEV_BOTH, 32, "X_ENC"},      {0x3A, DEV_BOTH, 0, "ENC_CONST"},
+  {0x3B, DEV_BOTH, 0, "ENC_STATUS"},  {0x3C, DEV_BOTH, 32, "ENC_LATCH"},
+  {0x3D, DEV_5160, 0, "ENC_DEVIATION"},
+  {0x60, DEV_BOTH, 0, "MSLUT0"},      {0x61, DEV_BOTH, 0, "MSLUT1"},
+  {0x62, DEV_BOTH, 0, "MSLUT2"},      {0x63, DEV_BOTH, 0, "MSLUT3"},
+  {0x64, DEV_BOTH, 0, "MSLUT4"},      {0x65, DEV_BOTH, 0, "MSLUT5"},
+  {0x66, DEV_BOTH, 0, "MSLUT6"},      {0x67, DEV_BOTH, 0, "MSLUT7"},
+  {0x68, DEV_BOTH, 0, "MSLUTSEL"},    {0x69, DEV_BOTH, 0, "MSLUTSTART"},
+  {0x6A, DEV_BOTH, 0, "MSCNT"},       {0x6B, DEV_BOTH, 0, "MSCURACT"},
+  {0x6C, DEV_BOTH, 0, "CHOPCONF"},    {0x6D, DEV_BOTH, 0, "COOLCONF"},
+  {0x6E, DEV_BOTH, 0, "DCCTRL"},      {0x6F, DEV_BOTH, 0, "DRV_STATUS"},
+  {0x70, DEV_BOTH, 0, "PWMCONF"},     {0x71, DEV_BOTH, 0, "PWM_SCALE"},
+  {0x72, DEV_5130, 0, "ENCM_CTRL"},   {0x72, DEV_5160, 0, "PWM_AUTO"},
+  {0x73, DEV_BOTH, 0, "LOST_STEPS"}
+};
+
+static const TRegisterField RegisterFields[]=
+{
+  //GCONF
+  {0x00, DEV_5130, 0, 1, 0, "I_scale_analog"}, {0x00, DEV_5160, 0, 1, 0, "recalibrate"},
+  {0x00, DEV_5130, 1, 1, 0, "internal_Rsense"}, {0x00, DEV_5160, 1, 1, 0, "faststandstill"},
+  {0x00, DEV_BOTH, 2, 1, 0, "en_pwm_mode"},
+  {0x00, DEV_5130, 3, 1, 0, "enc_commutation"}, {0x00, DEV_5160, 3, 1, 0, "multistep_filt"},
+  {0x00, DEV_BOTH, 4, 1, 0, "shaft"},           {0x00, DEV_BOTH, 5, 1, 0, "diag0_error"},
+  {0x00, DEV_BOTH, 6, 1, 0, "diag0_otpw"},      {0x00, DEV_BOTH, 7, 1, 0, "diag0_stall"},
+  {0x00, DEV_BOTH, 8, 1, 0, "diag1_stall"},     {0x00, DEV_BOTH, 9, 1, 0, "diag1_index"},
+  {0x00, DEV_BOTH, 10, 1, 0, "diag1_onstate"},  {0x00, DEV_BOTH, 11, 1, 0, "diag1_steps_skipped"},
+  {0x00, DEV_BOTH, 12, 1, 0, "diag0_int_pushpull"}, {0x00, DEV_BOTH, 13, 1, 0, "diag1_poscomp_pushpull"},
+  {0x00, DEV_BOTH, 14, 1, 0, "small_hysteresis"}, {0x00, DEV_BOTH, 15, 1, 0, "stop_enable"},
+  {0x00, DEV_BOTH, 16, 1, 0, "direct_mode"},    {0x00, DEV_BOTH, 17, 1, 0, "test_mode"},
+  //GSTAT
+  {0x01, DEV_BOTH, 0, 1, 0, "reset"}, {0x01, DEV_BOTH, 1, 1, 0, "drv_err"}, {0x01, DEV_BOTH, 2, 1, 0, "uv_cp"},
+  //IOIN
+  {0x04, DEV_BOTH, 0, 1, 0, "REFL_STEP"}, {0x04, DEV_BOTH, 1, 1, 0, "REFR_DIR"},
+  {0x04, DEV_BOTH, 2, 1, 0, "ENCB_DCEN_CFG4"}, {0x04, DEV_BOTH, 3, 1, 0, "ENCA_DCIN_CFG5"},
+  {0x04, DEV_BOTH, 4, 1, 0, "DRV_ENN"}, {0x04, DEV_BOTH, 5, 1, 0, "ENC_N_DCO"},
+  {0x04, DEV_BOTH, 6, 1, 0, "SD_MODE"}, {0x04, DEV_BOTH, 7, 1, 0, "SWCOMP_IN"},
+  {0x04, DEV_BOTH, 24, 8, 0, "VERSION"},
+  //TMC5160 driver configuration
+  {0x09, DEV_5160, 0, 4, 0, "S2VS_LEVEL"}, {0x09, DEV_5160, 8, 4, 0, "S2G_LEVEL"},
+  {0x09, DEV_5160, 16, 2, 0, "SHORTFILTER"}, {0x09, DEV_5160, 18, 1, 0, "shortdelay"},
+  {0x0A, DEV_5160, 0, 5, 0, "BBMTIME"}, {0x0A, DEV_5160, 8, 4, 0, "BBMCLKS"},
+  {0x0A, DEV_5160, 16, 2, 0, "OTSELECT"}, {0x0A, DEV_5160, 18, 2, 0, "DRVSTRENGTH"},
+  {0x0A, DEV_5160, 20, 2, 0, "FILT_ISENSE"},
+  {0x0B, DEV_5160, 0, 8, 0, "GLOBALSCALER"},
+  {0x0C, DEV_5160, 0, 8, 0, "PHASE_B"}, {0x0C, DEV_5160, 8, 8, 0, "PHASE_A"},
+  //IHOLD_IRUN
+  {0x10, DEV_BOTH, 0, 5, 0, "IHOLD"}, {0x10, DEV_BOTH, 8, 5, 0, "IRUN"}, {0x10, DEV_BOTH, 16, 4, 0, "IHOLDDELAY"},
+  //SW_MODE
+  {0x34, DEV_BOTH, 0, 1, 0, "stop_l_enable"}, {0x34, DEV_BOTH, 1, 1, 0, "stop_r_enable"},
+  {0x34, DEV_BOTH, 2, 1, 0, "pol_stop_l"}, {0x34, DEV_BOTH, 3, 1, 0, "pol_stop_r"},
+  {0x34, DEV_BOTH, 4, 1, 0, "swap_lr"}, {0x34, DEV_BOTH, 5, 1, 0, "latch_l_active"},
+  {0x34, DEV_BOTH, 6, 1, 0, "latch_l_inactive"}, {0x34, DEV_BOTH, 7, 1, 0, "latch_r_active"},
+  {0x34, DEV_BOTH, 8, 1, 0, "latch_r_inactive"}, {0x34, DEV_BOTH, 9, 1, 0, "en_latch_encoder"},
+  {0x34, DEV_BOTH, 10, 1, 0, "sg_stop"}, {0x34, DEV_BOTH, 11, 1, 0, "en_softstop"},
+  //RAMP_STAT
+  {0x35, DEV_BOTH, 0, 1, 0, "status_stop_l"}, {0x35, DEV_BOTH, 1, 1, 0, "status_stop_r"},
+  {0x35, DEV_BOTH, 2, 1, 0, "status_latch_l"}, {0x35, DEV_BOTH, 3, 1, 0, "status_latch_r"},
+  {0x35, DEV_BOTH, 4, 1, 0, "event_stop_l"}, {0x35, DEV_BOTH, 5, 1, 0, "event_stop_r"},
+  {0x35, DEV_BOTH, 6, 1, 0, "event_stop_sg"}, {0x35, DEV_BOTH, 7, 1, 0, "event_pos_reached"},
+  {0x35, DEV_BOTH, 8, 1, 0, "velocity_reached"}, {0x35, DEV_BOTH, 9, 1, 0, "position_reached"},
+  {0x35, DEV_BOTH, 10, 1, 0, "vzero"}, {0x35, DEV_BOTH, 11, 1, 0, "t_zerowait_active"},
+  {0x35, DEV_BOTH, 12, 1, 0, "second_move"}, {0x35, DEV_BOTH, 13, 1, 0, "status_sg"},
+  //ENC_STATUS
+  {0x3B, DEV_BOTH, 0, 1, 0, "n_event"}, {0x3B, DEV_5160, 1, 1, 0, "deviation_warn"},
+  //MSCNT, MSCURACT
+  {0x6A, DEV_BOTH, 0, 10, 0, "MSCNT"},
+  {0x6B, DEV_BOTH, 0, 9, 1, "CUR_A"}, {0x6B, DEV_BOTH, 16, 9, 1, "CUR_B"},
+  //CHOPCONF
+  {0x6C, DEV_BOTH, 0, 4, 0, "toff"}, {0x6C, DEV_BOTH, 4, 3, 0, "hstrt"}, {0x6C, DEV_BOTH, 7, 4, 0, "hend"},
+  {0x6C, DEV_BOTH, 11, 1, 0, "fd3"}, {0x6C, DEV_BOTH, 12, 1, 0, "disfdcc"},
+  {0x6C, DEV_5130, 13, 1, 0, "rndtf"}, {0x6C, DEV_BOTH, 14, 1, 0, "chm"},
+  {0x6C, DEV_BOTH, 15, 2, 0, "tbl"}, {0x6C, DEV_5130, 17, 1, 0, "vsense"},
+  {0x6C, DEV_BOTH, 18, 1, 0, "vhighfs"}, {0x6C, DEV_BOTH, 19, 1, 0, "vhighchm"},
+  {0x6C, DEV_5130, 20, 4, 0, "sync"}, {0x6C, DEV_5160, 20, 4, 0, "tpfd"},
+  {0x6C, DEV_BOTH, 24, 4, 0, "mres"}, {0x6C, DEV_BOTH, 28, 1, 0, "intpol"},
+  {0x6C, DEV_BOTH, 29, 1, 0, "dedge"}, {0x6C, DEV_BOTH, 30, 1, 0, "diss2g"},
+  {0x6C, DEV_5160, 31, 1, 0, "diss2vs"},
+  //COOLCONF
+  {0x6D, DEV_BOTH, 0, 4, 0, "semin"}, {0x6D, DEV_BOTH, 5, 2, 0, "seup"},
+  {0x6D, DEV_BOTH, 8, 4, 0, "semax"}, {0x6D, DEV_BOTH, 13, 2, 0, "sedn"},
+  {0x6D, DEV_BOTH, 15, 1, 0, "seimin"}, {0x6D, DEV_BOTH, 16, 7, 1, "sgt"},
+  {0x6D, DEV_BOTH, 24, 1, 0, "sfilt"},
+  //DCCTRL
+  {0x6E, DEV_BOTH, 0, 10, 0, "DC_TIME"}, {0x6E, DEV_BOTH, 16, 8, 0, "DC_SG"},
+  //DRV_STATUS
+  {0x6F, DEV_BOTH, 0, 10, 0, "SG_RESULT"},
+  {0x6F, DEV_5160, 12, 1, 0, "s2vsa"}, {0x6F, DEV_5160, 13, 1, 0, "s2vsb"},
+  {0x6F, DEV_BOTH, 14, 1, 0, "stealth"}, {0x6F, DEV_BOTH, 15, 1, 0, "fsactive"},
+  {0x6F, DEV_BOTH, 16, 5, 0, "CS_ACTUAL"}, {0x6F, DEV_BOTH, 24, 1, 0, "stallGuard"},
+  {0x6F, DEV_BOTH, 25, 1, 0, "ot"}, {0x6F, DEV_BOTH, 26, 1, 0, "otpw"},
+  {0x6F, DEV_BOTH, 27, 1, 0, "s2ga"}, {0x6F, DEV_BOTH, 28, 1, 0, "s2gb"},
+  {0x6F, DEV_BOTH, 29, 1, 0, "ola"}, {0x6F, DEV_BOTH, 30, 1, 0, "olb"},
+  {0x6F, DEV_BOTH, 31, 1, 0, "stst"},
+  //PWMCONF
+  {0x70, DEV_5130, 0, 8, 0, "PWM_AMPL"}, {0x70, DEV_5160, 0, 8, 0, "PWM_OFS"},
+  {0x70, DEV_BOTH, 8, 8, 0, "PWM_GRAD"}, {0x70, DEV_BOTH, 16, 2, 0, "pwm_freq"},
+  {0x70, DEV_BOTH, 18, 1, 0, "pwm_autoscale"},
+  {0x70, DEV_5130, 19, 1, 0, "pwm_symmetric"}, {0x70, DEV_5160, 19, 1, 0, "pwm_autograd"},
+  {0x70, DEV_BOTH, 20, 2, 0, "freewheel"},
+  {0x70, DEV_5160, 24, 4, 0, "PWM_REG"}, {0x70, DEV_5160, 28, 4, 0, "PWM_LIM"},
+  //PWM_SCALE, PWM_AUTO
+  {0x71, DEV_BOTH, 0, 8, 0, "PWM_SCALE_SUM"}, {0x71, DEV_5160, 16, 9, 1, "PWM_SCALE_AUTO"},
+  {0x72, DEV_5160, 0, 8, 0, "PWM_OFS_AUTO"}, {0x72, DEV_5160, 16, 8, 0, "PWM_GRAD_AUTO"},
+  //LOST_STEPS
+  {0x73, DEV_BOTH, 0, 20, 0, "LOST_STEPS"}
+};
+
+
+/***************************************************************//**
+   \fn FindRegister(uint8_t Address, uint8_t Device)
+   \return Name entry of the register (NULL: unknown)
+********************************************************************/
+static const TRegisterName *FindRegister(uint8_t Address, uint8_t Device)
+{
+  size_t i;
+
+  for(i=0; i<sizeof(RegisterNames)/sizeof(RegisterNames[0]); i++)
+    if(RegisterNames[i].Address==Address && (RegisterNames[i].Devices & Device)) return &RegisterNames[i];
+
+  return NULL;
+}
+
+
+/***************************************************************//**
+   \fn PrintRegister(uint8_t Address, uint8_t Readable, uint32_t Value, uint8_t Device)
+   \brief Print one register of the dump with its bit fields
+********************************************************************/
+static void PrintRegister(uint8_t Address, uint8_t Readable, uint32_t Value, uint8_t Device)
+{
+  const TRegisterName *Register;
+  const TRegisterField *Field;
+  uint32_t FieldValue;
+  int32_t SignedValue;
+  size_t i;
+  int Column;
+
+  Register=FindRegister(Address, Device);
+  printf("0x%02X %-14s 0x%08X %-5s", Address, Register ? Register->Name : "?", (unsigned) Value,
+         Readable ? "read" : "copy");
+  if(Register && Register->Signed>0)
+  {
+    SignedValue=(int32_t) (Value<<(32-Register->Signed))>>(32-Register->Signed);
+    printf(" %d", (int) SignedValue);
+  }
+  else if(Register)
+  {
+    printf(" %u", (unsigned) Value);
+  }
+  printf("\n");
+
+  Column=0;
+  for(i=0; i<sizeof(RegisterFields)/sizeof(RegisterFields[0]); i++)
+  {
+    Field=&RegisterFields[i];
+    if(Field->Address!=Address || !(Field->Devices & Device)) continue;
+
+    FieldValue=(Value>>Field->Shift) & ((Field->Width<32) ? (1UL<<Field->Width)-1 : 0xffffffffUL);
+    if(Field->Width==1 && FieldValue==0) continue;    //only set flags are printed
+
+    if(Column==0) printf("      ");
+    if(Field->Signed && (FieldValue & (1UL<<(Field->Width-1))))
+      Column+=printf(" %s=%d", Field->Name, (int) FieldValue-(1<<Field->Width));
+    else if(Field->Width==1)
+      Column+=printf(" %s", Field->Name);
+    else
+      Column+=printf(" %s=%u", Field->Name, (unsigned) FieldValue);
+    if(Column>64)
+    {
+      printf("\n");
+      Column=0;
+    }
+  }
+  if(Column>0) printf("\n");
+}
+
+
+/***************************************************************//**
+   \fn ReadFramesFromFile(const char *Name, uint8_t Frames[][HL_FRAME_LENGTH])
+   \brief Read frames saved with -x (or logged by a bus monitor)
+   \return Number of frames, -1 on error
+********************************************************************/
+static int ReadFramesFromFile(const char *Name, uint8_t Frames[][HL_FRAME_LENGTH])
+{
+  FILE *File;
+  char Line[256];
+  char *Position;
+  char *End;
+  unsigned long Byte;
+  int Count;
+  int i;
+
+  File=strcmp(Name, "-")==0 ? stdin : fopen(Name, "r");
+  if(File==NULL)
+  {
+    perror(Name);
+    return -1;
+  }
+
+  Count=0;
+  while(fgets(Line, sizeof(Line), File) && Count<MAX_DUMP_FRAMES)
+  {
+    Position=strchr(Line, '#');
+    if(Position) *Position=0;
+
+    Position=Line;
+    for(i=0; i<HL_FRAME_LENGTH; i++)
+    {
+      Byte=strtoul(Position, &End, 16);
+      if(End==Position || Byte>0xff) break;
+      Frames[Count][i]=Byte;
+      Position=End;
+    }
+    if(i==HL_FRAME_LENGTH)
+      Count++;
+    else if(i>0)
+      fprintf(stderr, "%s: invalid line ignored: %s", Name, Line);
+  }
+
+  if(File!=stdin) fclose(File);
+
+  return Count;
+}
+
+
+/***************************************************************//**
+   \fn ReadFramesFromModule(THostLink *Link, uint8_t Motor, uint8_t Frames[][HL_FRAME_LENGTH])
+   \brief Send the RegisterDump command and receive the reply
+   \return Number of frames, -1 on error
+
+   The module sends one frame per main loop iteration, so the
+   timeout per frame is generous.
+********************************************************************/
+static int ReadFramesFromModule(THostLink *Link, uint8_t Motor, uint8_t Frames[][HL_FRAME_LENGTH])
+{
+  uint8_t Command[HL_FRAME_LENGTH];
+  uint32_t Count;
+  uint32_t i;
+
+  BuildCommandFrame(Link, Command, TMCL_RegisterDump, 0, Motor, 0);
+  if(SendFrame(Link, Command)<0 || ReceiveFrame(Link, Frames[0], 100000)!=1)
+  {
+    fprintf(stderr, "no reply\n");
+    return -1;
+  }
+  if(!CheckReplyFrame(Link, Frames[0]))
+  {
+    fprintf(stderr, "invalid reply\n");
+    return -1;
+  }
+  if(Frames[0][2]!=REPLY_OK && Frames[0][2]!=REPLY_OK_EVENT) return 1;
+
+  Count=FrameValue(Frames[0]);
+  if(Count>=MAX_DUMP_FRAMES)
+  {
+    fprintf(stderr, "invalid number of registers %u\n", (unsigned) Count);
+    return -1;
+  }
+  for(i=1; i<=Count; i++)
+  {
+    if(ReceiveFrame(Link, Frames[i], 100000)!=1)
+    {
+      fprintf(stderr, "frame %u of %u missing\n", (unsigned) i, (unsigned) Count);
+      return i;
+    }
+  }
+
+  return Count+1;
+}
+
+
+/***************************************************************//**
+   \fn DecodeDump(uint8_t Frames[][HL_FRAME_LENGTH], int Count, uint8_t Device)
+   \brief Check and print a dump
+   \return Number of invalid frames
+********************************************************************/
+static int DecodeDump(uint8_t Frames[][HL_FRAME_LENGTH], int Count, uint8_t Device)
+{
+  uint8_t Checksum;
+  int Errors;
+  int i, j;
+
+  if(Count<1) return 1;
+  if(Frames[0][3]!=TMCL_RegisterDump)
+  {
+    fprintf(stderr, "first frame is not a RegisterDump reply\n");
+    return 1;
+  }
+  if(Frames[0][2]!=REPLY_OK && Frames[0][2]!=REPLY_OK_EVENT)
+  {
+    fprintf(stderr, "RegisterDump failed, status %u\n", Frames[0][2]);
+    return 1;
+  }
+
+  printf("%u registers%s\n", (unsigned) FrameValue(Frames[0]),
+         Frames[0][2]==REPLY_OK_EVENT ? " (events pending)" : "");
+  if(FrameValue(Frames[0])!=(uint32_t) Count-1)
+    printf("%d register frames received\n", Count-1);
+
+  Errors=0;
+  for(i=1; i<Count; i++)
+  {
+    Checksum=0;
+    for(j=0; j<8; j++) Checksum+=Frames[i][j];
+    if(Checksum!=Frames[i][8])
+    {
+      printf("0x%02X checksum error\n", Frames[i][2]);
+      Errors++;
+      continue;
+    }
+    PrintRegister(Frames[i][2], Frames[i][3], FrameValue(Frames[i]), Device);
+  }
+
+  return Errors;
+}
+
+
+static void Usage(void)
+{
+  fprintf(stderr,
+          "usage: RegisterDumpDecode [options] <serial port>\n"
+          "       RegisterDumpDecode [options] -f <file>\n"
+          "  -t 5130|5160  driver type (default 5130)\n"
+          "  -m <motor>    motor (default 0)\n"
+          "  -x            print the frames (hex) instead of decoding them\n"
+          "  -b <baud>     baud rate of the module (default 230400)\n"
+          "  -r            raw line code (default: Homebus encoded)\n"
+          "  -e            the adapter echoes the sent data\n"
+          "  -a <address>  module address (default 1)\n"
+          "  -h <address>  host address (default 2)\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+  static uint8_t Frames[MAX_DUMP_FRAMES][HL_FRAME_LENGTH];
+  THostLink Link;
+  const char *FileName;
+  uint32_t Baudrate;
+  uint8_t LineCode;
+  uint8_t Echo;
+  uint8_t ModuleAddress;
+  uint8_t HostAddress;
+  uint8_t Motor;
+  uint8_t Device;
+  int Hex;
+  int Count;
+  int i, j;
+  int c;
+
+  FileName=NULL;
+  Baudrate=230400;
+  LineCode=HB_LINE_ENCODED;
+  Echo=0;
+  ModuleAddress=1;
+  HostAddress=2;
+  Motor=0;
+  Device=DEV_5130;
+  Hex=0;
+
+  while((c=getopt(argc, argv, "t:m:xf:b:rea:h:"))!= -1)
+  {
+    switch(c)
+    {
+      case 't': Device=(strtoul(optarg, NULL, 10)==5160) ? DEV_5160 : DEV_5130; break;
+      case 'm': Motor=strtoul(optarg, NULL, 0); break;
+      case 'x': Hex=1; break;
+      case 'f': FileName=optarg; break;
+      case 'b': Baudrate=strtoul(optarg, NULL, 0); break;
+      case 'r': LineCode=HB_LINE_RAW; break;
+      case 'e': Echo=1; break;
+      case 'a': ModuleAddress=strtoul(optarg, NULL, 0); break;
+      case 'h': HostAddress=strtoul(optarg, NULL, 0); break;
+      default: Usage(); return 1;
+    }
+  }
+
+  if(FileName!=NULL && optind==argc)
+  {
+    Count=ReadFramesFromFile(FileName, Frames);
+  }
+  else if(FileName==NULL && optind==argc-1)
+  {
+    if(OpenHostLink(&Link, argv[optind], Baudrate, LineCode, Echo)<0) return 1;
+    Link.ModuleAddress=ModuleAddress;
+    Link.HostAddress=HostAddress;
+    Count=ReadFramesFromModule(&Link, Motor, Frames);
+    CloseHostLink(&Link);
+  }
+  else
+  {
+    Usage();
+    return 1;
+  }
+  if(Count<0) return 1;
+
+  if(Hex)
+  {
+    for(i=0; i<Count; i++)
+    {
+      for(j=0; j<HL_FRAME_LENGTH; j++) printf("%02X%s", Frames[i][j], j<HL_FRAME_LENGTH-1 ? " " : "\n");
+    }
+    return 0;
+  }
+
+  return DecodeDump(Frames, Count, Device)>0 ? 2 : 0;
+}